@@ -0,0 +1,69 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#ifndef CCB_BBDO_CODEC_HH
+#define CCB_BBDO_CODEC_HH
+
+#include <vector>
+
+#include "com/centreon/broker/bbdo/string_table.hh"
+#include "com/centreon/broker/io/event_info.hh"
+
+CCB_BEGIN()
+
+namespace bbdo {
+/**
+ *  @class codec codec.hh "com/centreon/broker/bbdo/codec.hh"
+ *  @brief BBDO encoder and decoder of one event type.
+ *
+ *  It is built once from the mapping of the event type: entries that are not
+ *  serialized are dropped, the offset of each property in the object is
+ *  computed and an encoder and a decoder instantiated for the property type
+ *  are chosen. Serializing an event is then a straight walk through these
+ *  steps, without virtual call nor switch on the property type.
+ *
+ *  The produced payload is the same as the one of the mapping interpretation
+ *  it replaces. If a string table is given, strings are encoded with it,
+ *  their steps have no encoder nor decoder.
+ */
+class codec {
+  struct step {
+    size_t offset;
+    void (*encode)(const char* field, std::vector<char>& buffer);
+    uint32_t (*decode)(char* field, const char* buffer, uint32_t size);
+  };
+  std::vector<step> _steps;
+  /* Bytes used by the properties with a fixed size. */
+  size_t _fixed_size;
+  string_table* _strings;
+
+ public:
+  codec(const io::event_info& info,
+        bool binary_double,
+        string_table* strings = nullptr);
+  ~codec() noexcept = default;
+  codec(const codec&) = delete;
+  codec& operator=(const codec&) = delete;
+  void serialize(const io::data& e, std::vector<char>& buffer) const;
+  void unserialize(io::data& e, const char* buffer, uint32_t size) const;
+};
+}  // namespace bbdo
+
+CCB_END()
+
+#endif  // !CCB_BBDO_CODEC_HH
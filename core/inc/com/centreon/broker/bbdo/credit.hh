@@ -0,0 +1,66 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#ifndef CCB_BBDO_CREDIT_HH
+#define CCB_BBDO_CREDIT_HH
+
+#include "com/centreon/broker/bbdo/internal.hh"
+#include "com/centreon/broker/io/data.hh"
+#include "com/centreon/broker/io/event_info.hh"
+#include "com/centreon/broker/io/events.hh"
+#include "com/centreon/broker/mapping/entry.hh"
+#include "com/centreon/broker/namespace.hh"
+
+CCB_BEGIN()
+
+namespace bbdo {
+/**
+ *  @class credit credit.hh "com/centreon/broker/bbdo/credit.hh"
+ *  @brief An ack event giving also a window to the peer.
+ *
+ *  It replaces ack events when the ack window extension is negotiated. The
+ *  peer may have up to window events not acknowledged yet.
+ */
+class credit : public io::data {
+ public:
+  credit();
+  credit(uint32_t acknowledged_events, uint32_t window);
+  ~credit() noexcept = default;
+  credit(credit const&) = delete;
+  credit& operator=(credit const&) = delete;
+
+  /**
+   *  Get the event type.
+   *
+   *  @return The event type.
+   */
+  constexpr static uint32_t static_type() {
+    return io::events::data_type<io::events::bbdo, bbdo::de_credit>::value;
+  }
+
+  uint32_t acknowledged_events;
+  uint32_t window;
+
+  static mapping::entry const entries[];
+  static io::event_info::event_operations const operations;
+};
+}  // namespace bbdo
+
+CCB_END()
+
+#endif  // !CCB_BBDO_CREDIT_HH
@@ -27,12 +27,31 @@
 #define BBDO_VERSION_MINOR 0
 #define BBDO_VERSION_PATCH 0
 constexpr uint32_t BBDO_HEADER_SIZE = 16u;
+/* Extension negotiated between peers to send doubles as 8 bytes IEEE-754
+ * values in network byte order instead of strings. */
+constexpr const char* BBDO_BINARY_DOUBLE_EXTENSION = "BINARY_DOUBLE";
+/* Extension negotiated between peers to send several events in one BBDO
+ * packet, called a frame. */
+constexpr const char* BBDO_BATCH_EXTENSION = "BATCH";
+/* Extension negotiated between peers to send repeated strings as indexes in
+ * a table, see bbdo::string_table. */
+constexpr const char* BBDO_STRING_TABLE_EXTENSION = "STRING_TABLE";
+/* Extension negotiated between peers to replace acks by credits, giving the
+ * number of events the peer may send without acknowledgement. */
+constexpr const char* BBDO_ACK_WINDOW_EXTENSION = "ACK_WINDOW";
+/* The compression codecs accepted by a peer are announced as extensions
+ * named COMPRESSION_<CODEC> beside the COMPRESSION one, and a zstd
+ * dictionary as COMPRESSION_ZSTD_DICT_<id>. */
+constexpr const char* BBDO_COMPRESSION_EXTENSION = "COMPRESSION";
+constexpr const char* BBDO_COMPRESSION_CODEC_PREFIX = "COMPRESSION_";
+/* Size of the header of each event in a frame: type and size. */
+constexpr uint32_t BBDO_BATCH_RECORD_HEADER_SIZE = 6u;
 
 CCB_BEGIN()
 
 namespace bbdo {
 // Data elements.
-enum { de_version_response = 1, de_ack, de_stop };
+enum { de_version_response = 1, de_ack, de_stop, de_batch, de_credit };
 
 // Load/unload of BBDO protocol.
 void load();
@@ -19,10 +19,16 @@
 #ifndef CCB_BBDO_STREAM_HH
 #define CCB_BBDO_STREAM_HH
 
+#include <chrono>
 #include <deque>
 #include <list>
+#include <memory>
+#include <unordered_map>
 
+#include "com/centreon/broker/bbdo/codec.hh"
+#include "com/centreon/broker/io/buffer_chain.hh"
 #include "com/centreon/broker/io/extension.hh"
+#include "com/centreon/broker/io/raw.hh"
 #include "com/centreon/broker/io/stream.hh"
 
 CCB_BEGIN()
@@ -49,6 +55,10 @@ namespace bbdo {
  *    the _ack_limit, an ack message is sent to the peer and this value is reset to 0. When the peer receives
  *    this ack message, it releases the corresponding events.
  *  * _acknowledged_events: represents the number of events correctly received by the peer after calls to write().
+ *
+ *  An ack message is also sent when the oldest unacknowledged event is older than _ack_delay. When the
+ *  ack window extension is negotiated, ack messages are replaced by credit messages also giving the number of
+ *  events the peer may send without acknowledgement. write() then waits for credits when this window is full.
  */
 class stream : public io::stream {
   class buffer {
@@ -66,7 +76,7 @@ class stream : public io::stream {
            uint32_t dest_id,
            std::vector<char>&& v)
         : _event_id(event_id), _source_id(source_id), _dest_id(dest_id) {
-      _buf.push_back(v);
+      _buf.push_back(std::move(v));
     }
     buffer(const buffer&) = delete;
     buffer(buffer&& other)
@@ -95,6 +105,11 @@ class stream : public io::stream {
     }
 
     std::vector<char> to_vector() {
+      if (_buf.size() == 1) {
+        std::vector<char> retval(std::move(_buf.front()));
+        _buf.clear();
+        return retval;
+      }
       size_t s = 0;
       for (auto& v : _buf)
         s += v.size();
@@ -106,33 +121,41 @@ class stream : public io::stream {
       return retval;
     }
 
-    void push_back(std::vector<char>&& v) { _buf.push_back(v); }
+    void push_back(std::vector<char>&& v) { _buf.push_back(std::move(v)); }
     uint32_t get_event_id() const { return _event_id; }
   };
 
   /* input */
-  /* If during a packet reading, we get several ones, this vector is useful
-   * to keep in cache all but the first one. It will be read before a call
-   * to _read_packet(). */
-  std::vector<char> _packet;
+  /* Buffers received from the substream and not parsed yet. Packets are
+   * parsed in place, and consumed by moving a cursor. */
+  io::buffer_chain _packet;
 
   /* We could get parts of BBDO packets in the wrong order, this deque is useful
    * to paste parts together in the good order. */
   std::deque<buffer> _buffer;
   int32_t _skipped;
+  /* Events of the last frame read, not returned yet. */
+  std::deque<std::shared_ptr<io::data>> _burst;
 
   // void _buffer_must_have_unprocessed(int bytes, time_t deadline =
   // (time_t)-1);
   void _read_packet(size_t size, time_t deadline = (time_t)-1);
+  size_t _skip_corrupted();
 
   bool _is_input;
   bool _coarse;
   bool _negotiate;
   bool _negotiated;
+  /* Doubles are sent as binary values, see BBDO_BINARY_DOUBLE_EXTENSION. */
+  bool _binary_double;
+  /* Events are sent in frames, see BBDO_BATCH_EXTENSION. */
+  bool _batch;
   int _timeout;
   uint32_t _acknowledged_events;
   uint32_t _ack_limit;
   uint32_t _events_received_since_last_ack;
+  std::chrono::milliseconds _ack_delay;
+  std::chrono::steady_clock::time_point _last_ack;
   /**
    * It is possible to mix bbdo stream with others like tls or compression.
    * This list of extensions provides a simple access to others ones with
@@ -140,10 +163,79 @@ class stream : public io::stream {
    */
   std::list<std::shared_ptr<io::extension>> _extensions;
 
-  void _write(std::shared_ptr<io::data> const& d);
+  /* Codecs of the event types already met, by event type. */
+  std::unordered_map<uint32_t, std::unique_ptr<codec>> _read_codecs;
+  std::unordered_map<uint32_t, std::unique_ptr<codec>> _write_codecs;
+  /* Strings tables, see BBDO_STRING_TABLE_EXTENSION. They are used by the
+   * codecs. */
+  std::unique_ptr<string_table> _read_strings;
+  std::unique_ptr<string_table> _write_strings;
+
+  /* output, when the batch extension is enabled */
+  /* Serialized events not written to the substream yet. The last frame of
+   * this buffer is still open if _frame_pos is not npos. */
+  std::shared_ptr<io::raw> _pending;
+  std::chrono::steady_clock::time_point _pending_since;
+  size_t _frame_pos;
+  uint32_t _frame_source_id;
+  uint32_t _frame_destination_id;
+  std::vector<char> _record;
+  /* The pending buffer is written when it reaches this size or when its
+   * first event is older than _batch_delay. */
+  size_t _batch_size;
+  std::chrono::milliseconds _batch_delay;
+  uint64_t _frames_written;
+  uint64_t _frame_events_written;
+
+  /* Credit based flow control, see BBDO_ACK_WINDOW_EXTENSION. */
+  bool _ack_window;
+  /* input: the window advertised to the peer is computed from the rate
+   * events are read at (events/s) and from the muxers memory usage. */
+  uint32_t _window_max;
+  uint32_t _window_sent;
+  double _read_rate;
+  /* Events read while waiting for credits, they are returned by read(). */
+  std::deque<std::shared_ptr<io::data>> _held;
+  /* output: _peer_window is 0 until the peer sends its first credit. */
+  uint32_t _peer_window;
+  uint64_t _events_written;
+  uint64_t _events_acknowledged_by_peer;
+  uint64_t _window_waits;
+  /* Count of events written and when, to measure the ack round trip time. */
+  std::deque<std::pair<uint64_t, std::chrono::steady_clock::time_point>>
+      _write_marks;
+  std::chrono::microseconds _ack_rtt;
+
+  const codec& _get_codec(
+      uint32_t type,
+      const io::event_info& info,
+      std::unordered_map<uint32_t, std::unique_ptr<codec>>& codecs,
+      string_table* strings);
+  bool _serialize(const io::data& e, std::vector<char>& data);
+  bool _batch_event(const io::data& e);
+  void _close_frame();
+  void _flush_pending();
+  void _write_pending();
+  io::data* _unserialize(uint32_t event_type,
+                         uint32_t source_id,
+                         uint32_t destination_id,
+                         char const* buffer,
+                         uint32_t size);
+  bool _write(std::shared_ptr<io::data> const& d);
   bool _read_any(std::shared_ptr<io::data>& d, time_t deadline);
+  bool _handle_control(const std::shared_ptr<io::data>& d);
+  void _event_read();
+  void _events_written_now(uint32_t count);
+  bool _window_full() const;
+  void _wait_for_credit();
+  uint32_t _window() const;
   void _send_event_stop_and_wait_for_ack();
   std::string _get_extension_names(bool mandatory) const;
+  bool _negotiate_compression(const io::extension& ext,
+                              const std::list<std::string>& peer_ext,
+                              const std::list<std::string>& our_ext,
+                              const std::list<std::string>& running_config,
+                              bool is_acceptor);
 
  public:
   enum negotiation_type { negotiate_first = 1, negotiate_second, negotiated };
@@ -162,8 +254,13 @@ class stream : public io::stream {
   void set_coarse(bool coarse);
   void set_negotiate(bool negotiate);
   void set_timeout(int timeout);
+  void set_string_table(uint16_t capacity);
+  void reset_string_table();
   void statistics(nlohmann::json& tree) const override;
   int write(std::shared_ptr<io::data> const& d) override;
+  int32_t write_batch(
+      const std::vector<std::shared_ptr<io::data>>& d) override;
+  bool write_ready() const override;
   void acknowledge_events(uint32_t events);
   void send_event_acknowledgement();
   std::list<std::string> get_running_config();
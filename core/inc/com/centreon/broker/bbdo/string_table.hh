@@ -0,0 +1,92 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+#ifndef CCB_BBDO_STRING_TABLE_HH
+#define CCB_BBDO_STRING_TABLE_HH
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "com/centreon/broker/namespace.hh"
+
+CCB_BEGIN()
+
+namespace bbdo {
+/**
+ *  @class string_table string_table.hh
+ *  "com/centreon/broker/bbdo/string_table.hh"
+ *  @brief Table of the strings already sent on a BBDO stream.
+ *
+ *  When the string table extension is enabled, each end of a stream keeps a
+ *  table for writing and a table for reading. A string sent for the second
+ *  time is added to the table with an index chosen by the writer, and then
+ *  sent as this index while it stays in the table.
+ *
+ *  The strings are encoded this way:
+ *  * a string that does not begin with one of the tags below is sent as
+ *    usual, with its terminating '\0'.
+ *  * tag_ref, index on 2 bytes: the string of the table at this index.
+ *  * tag_def, index on 2 bytes, string: a string to store in the table.
+ *  * tag_esc, string: a string beginning with a tag byte.
+ *  * tag_reset, then one of the above: the table is emptied first.
+ *
+ *  The table is bounded, when it is full the slots are reused in turn.
+ */
+class string_table {
+ public:
+  enum tag : char { tag_ref = 1, tag_def, tag_esc, tag_reset };
+  /* Shorter strings are not worth an index. */
+  static constexpr size_t min_length = 4;
+  /* Longer strings are never stored. */
+  static constexpr size_t max_length = 2048;
+
+ private:
+  const uint16_t _capacity;
+  std::vector<std::string> _strings;
+
+  /* Writer side: index of each stored string, hashes of the strings met once
+   * and next slot to use. */
+  std::unordered_map<std::string, uint16_t> _index;
+  std::unordered_set<size_t> _seen;
+  uint16_t _next;
+  bool _reset;
+
+  /* Statistics. */
+  uint64_t _refs;
+  uint64_t _strings_count;
+  uint64_t _unresolved;
+
+ public:
+  explicit string_table(uint16_t capacity);
+  ~string_table() noexcept = default;
+  string_table(const string_table&) = delete;
+  string_table& operator=(const string_table&) = delete;
+  void encode(const std::string& str, std::vector<char>& buffer);
+  uint32_t decode(std::string& str, const char* buffer, uint32_t size);
+  void reset();
+  uint16_t capacity() const { return _capacity; }
+  uint64_t refs() const { return _refs; }
+  uint64_t strings() const { return _strings_count; }
+  uint64_t unresolved() const { return _unresolved; }
+};
+}  // namespace bbdo
+
+CCB_END()
+
+#endif  // !CCB_BBDO_STRING_TABLE_HH
@@ -0,0 +1,67 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#ifndef CCB_COMPRESSION_LZ4_HH
+#define CCB_COMPRESSION_LZ4_HH
+
+#include <cstddef>
+#include <vector>
+#include "com/centreon/broker/namespace.hh"
+
+union LZ4_stream_u;
+
+CCB_BEGIN()
+
+namespace compression {
+/**
+ *  @class lz4 lz4.hh "com/centreon/broker/compression/lz4.hh"
+ *  @brief Binding around the lz4 library.
+ *
+ *  Compress and uncompress data. Each block is compressed with the last
+ *  64kB of the previous ones as history, so blocks must be uncompressed in
+ *  the order they were compressed. Blocks have the same format as zlib ones,
+ *  the uncompressed size on 4 bytes followed by the compressed data.
+ *
+ *  Both sides keep their history in a buffer followed by the block being
+ *  compressed or uncompressed. When it is full, the last 64kB are moved to
+ *  its beginning.
+ */
+class lz4 {
+  LZ4_stream_u* _stream;
+  std::vector<char> _cbuffer;
+  size_t _chistory;
+  std::vector<char> _dbuffer;
+  size_t _dhistory;
+
+  static bool _make_room(std::vector<char>& buffer,
+                           size_t& history,
+                           size_t size);
+
+ public:
+  lz4();
+  ~lz4() noexcept;
+  lz4(const lz4&) = delete;
+  lz4& operator=(const lz4&) = delete;
+  std::vector<char> compress(std::vector<char> const& data);
+  std::vector<char> uncompress(unsigned char const* data, unsigned long nbytes);
+};
+}  // namespace compression
+
+CCB_END()
+
+#endif  // !CCB_COMPRESSION_LZ4_HH
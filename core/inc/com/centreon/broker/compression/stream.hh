@@ -19,25 +19,54 @@
 #ifndef CCB_COMPRESSION_STREAM_HH
 #define CCB_COMPRESSION_STREAM_HH
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <vector>
-#include "com/centreon/broker/compression/stack_array.hh"
+#include "com/centreon/broker/io/buffer_chain.hh"
+#include "com/centreon/broker/io/raw.hh"
 #include "com/centreon/broker/io/stream.hh"
 #include "com/centreon/broker/namespace.hh"
 
 CCB_BEGIN()
 
 namespace compression {
+class lz4;
+class zstd;
+
 /**
  *  @class stream stream.hh "com/centreon/broker/compression/stream.hh"
  *  @brief Compression stream.
  *
  *  Compress and uncompress data.
+ *
+ *  Data are compressed with zlib, each block alone, or with zstd or lz4 that
+ *  keep the history of the previous blocks. The codec is chosen during the
+ *  BBDO negotiation. Files use independent zstd blocks instead, see
+ *  set_independent_blocks().
+ *
+ *  In pipelined mode, full write buffers are compressed by the thread pool
+ *  while the writer goes on, and the compressed blocks are written to the
+ *  substream in order by the writer thread on its next calls. zlib blocks
+ *  are compressed in parallel, zstd and lz4 ones one after the other since
+ *  they depend on each other. On the read side, the block following the one
+ *  returned is uncompressed by the pool while the caller decodes it. A
+ *  thread of the pool never waits for these jobs, they may be queued behind
+ *  it: there, the blocks are compressed and uncompressed inline.
  */
 class stream : public io::stream {
  public:
+  enum codec { zlib_codec, zstd_codec, lz4_codec };
   static size_t const max_data_size;
+  static size_t const max_pipelined_blocks;
+  static uint32_t const independent_block_flag;
 
-  stream(int level = -1, size_t size = 0);
+  stream(int level = -1,
+         size_t size = 0,
+         codec c = zlib_codec,
+         const std::string& dictionary = std::string());
   ~stream() noexcept;
   stream(const stream&) = delete;
   stream& operator=(const stream&) = delete;
@@ -46,17 +75,65 @@ class stream : public io::stream {
   bool read(std::shared_ptr<io::data>& d,
             time_t deadline = (time_t)-1) override;
   void statistics(nlohmann::json& tree) const override;
+  void set_independent_blocks();
+  void set_pipelined(bool pipelined);
+  void unread(std::shared_ptr<io::raw> data);
   int write(std::shared_ptr<io::data> const& d) override;
 
  private:
+  /* A block compressed or uncompressed by the pool. */
+  struct block {
+    std::vector<char> data;
+    size_t size = 0;
+    bool started = false;
+    bool done = false;
+    std::exception_ptr error;
+  };
+
+  /* Shared with the pool jobs, that may run once the stream is destroyed
+   * when they have nothing left to do. */
+  struct pipeline {
+    std::mutex m;
+    std::condition_variable cv;
+    /* Compression jobs posted to the pool and not finished. */
+    size_t workers = 0;
+    /* Jobs using the stream. */
+    size_t running = 0;
+    /* A zstd or lz4 block is being compressed. */
+    bool compressing = false;
+    std::deque<std::shared_ptr<block>> to_compress;
+  };
+
+  std::vector<char> _compress(std::vector<char> const& data);
+  void _compress_pending(std::unique_lock<std::mutex>& lck);
   void _flush();
-  void _get_data(int size, time_t timeout);
+  uint32_t _front_block_size(bool& independent);
+  void _prefetch();
+  void _write_block(std::vector<char>&& data, size_t size);
+  void _wait_compressed(const block& b, std::unique_lock<std::mutex>& lck);
+  void _write_blocks(size_t max_pending);
+  void _get_data(size_t size, time_t timeout);
+  std::vector<char> _uncompress(unsigned char const* data,
+                                unsigned long nbytes,
+                                bool independent);
 
+  codec _codec;
+  std::unique_ptr<zstd> _zstd;
+  std::unique_ptr<lz4> _lz4;
+  uint64_t _uncompressed_bytes;
+  uint64_t _compressed_bytes;
   int _level;
-  stack_array _rbuffer;
+  io::buffer_chain _rbuffer;
   bool _shutdown;
   size_t _size;
   std::vector<char> _wbuffer;
+  bool _independent_blocks;
+
+  bool _pipelined;
+  size_t _max_workers;
+  std::shared_ptr<pipeline> _pipeline;
+  std::deque<std::shared_ptr<block>> _blocks;
+  std::shared_ptr<block> _next_block;
 };
 }  // namespace compression
 
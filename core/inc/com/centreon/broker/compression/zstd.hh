@@ -0,0 +1,73 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#ifndef CCB_COMPRESSION_ZSTD_HH
+#define CCB_COMPRESSION_ZSTD_HH
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "com/centreon/broker/namespace.hh"
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+CCB_BEGIN()
+
+namespace compression {
+/**
+ *  @class zstd zstd.hh "com/centreon/broker/compression/zstd.hh"
+ *  @brief Binding around the zstd library.
+ *
+ *  Compress and uncompress data. Contrary to zlib, the contexts are kept
+ *  between blocks: each block is compressed with the history of the previous
+ *  ones, so blocks must be uncompressed in the order they were compressed.
+ *  Blocks have the same format as zlib ones, the uncompressed size on 4
+ *  bytes followed by the compressed data.
+ *
+ *  compress_block() and uncompress_block() work on independent frames with a
+ *  checksum instead, for files whose beginning may be removed.
+ */
+class zstd {
+  ZSTD_CCtx_s* _cctx;
+  ZSTD_DCtx_s* _dctx;
+  /* Contexts of independent blocks, created on first use. */
+  ZSTD_CCtx_s* _bcctx;
+  ZSTD_DCtx_s* _bdctx;
+  int _level;
+
+ public:
+  zstd(int compression_level, const std::string& dictionary = std::string());
+  ~zstd() noexcept;
+  zstd(const zstd&) = delete;
+  zstd& operator=(const zstd&) = delete;
+  std::vector<char> compress(std::vector<char> const& data);
+  std::vector<char> uncompress(unsigned char const* data, unsigned long nbytes);
+  std::vector<char> compress_block(std::vector<char> const& data);
+  std::vector<char> uncompress_block(unsigned char const* data,
+                                     unsigned long nbytes);
+
+  static uint32_t dictionary_id(const std::string& dictionary);
+  static std::string train_dictionary(const std::vector<std::string>& samples,
+                                      size_t capacity);
+};
+}  // namespace compression
+
+CCB_END()
+
+#endif  // !CCB_COMPRESSION_ZSTD_HH
@@ -48,12 +48,17 @@ class state {
   std::string _command_protocol;
   std::list<endpoint> _endpoints;
   int _event_queue_max_size;
+  int64_t _event_queues_total_size;
   std::string _module_dir;
   std::list<std::string> _module_list;
   std::map<std::string, std::string> _params;
   int _poller_id;
   std::string _poller_name;
   size_t _pool_size;
+  bool _pool_feeders;
+  int _pool_feeders_concurrency;
+  bool _queue_files_mmap;
+  std::string _queue_files_sync;
 
   struct log {
     std::string directory;
@@ -88,6 +93,8 @@ class state {
   std::list<endpoint> const& endpoints() const noexcept;
   void event_queue_max_size(int val) noexcept;
   int event_queue_max_size() const noexcept;
+  void event_queues_total_size(int64_t val) noexcept;
+  int64_t event_queues_total_size() const noexcept;
   std::string const& module_directory() const noexcept;
   void module_directory(std::string const& dir);
   std::list<std::string>& module_list() noexcept;
@@ -99,6 +106,14 @@ class state {
   int poller_id() const noexcept;
   void pool_size(int size) noexcept;
   int pool_size() const noexcept;
+  void pool_feeders(bool enabled) noexcept;
+  bool pool_feeders() const noexcept;
+  void pool_feeders_concurrency(int val) noexcept;
+  int pool_feeders_concurrency() const noexcept;
+  void queue_files_mmap(bool enabled) noexcept;
+  bool queue_files_mmap() const noexcept;
+  void queue_files_sync(const std::string& sync);
+  const std::string& queue_files_sync() const noexcept;
   void poller_name(std::string const& name);
   std::string const& poller_name() const noexcept;
   log& log_conf();
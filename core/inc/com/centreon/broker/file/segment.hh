@@ -0,0 +1,82 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#ifndef CCB_FILE_SEGMENT_HH
+#define CCB_FILE_SEGMENT_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "com/centreon/broker/namespace.hh"
+
+CCB_BEGIN()
+
+namespace file {
+/**
+ *  @class segment segment.hh "com/centreon/broker/file/segment.hh"
+ *  @brief A file part of a splitter, preallocated and mapped in memory.
+ *
+ *  Segments have the layout of the files written with stdio by the
+ *  splitter: an 8 bytes header followed by data. Reads and writes are copies
+ *  from and to the mapping.
+ *
+ *  While a segment is preallocated, the file is bigger than its data, so the
+ *  header contains a magic number and the end of the data. When the segment
+ *  is closed, the file is truncated to its data and the header gets back its
+ *  stdio content. If broker is stopped before, recover() does the same job.
+ */
+class segment {
+  const std::string _path;
+  int _fd;
+  char* _data;
+  /* Size of the mapping. */
+  size_t _capacity;
+  /* Offset of the end of the data. */
+  size_t _end;
+  /* Offset up to which the data have been synced to disk. */
+  size_t _synced;
+  /* True if the file is bigger than its data. */
+  bool _preallocated;
+  /* True to sync the data to disk when the segment is closed. */
+  const bool _sync_on_close;
+
+  void _write_header();
+
+ public:
+  static constexpr size_t header_size = 2 * sizeof(uint32_t);
+
+  segment(const std::string& path, size_t capacity, bool sync_on_close = false);
+  ~segment() noexcept;
+  segment(const segment&) = delete;
+  segment& operator=(const segment&) = delete;
+
+  size_t capacity() const;
+  size_t end() const;
+  size_t read(size_t offset, void* buffer, size_t size) const;
+  void reserve(size_t capacity);
+  void sync();
+  void write(size_t offset, const void* buffer, size_t size);
+
+  static void recover(const std::string& path);
+};
+}  // namespace file
+
+CCB_END()
+
+#endif  // !CCB_FILE_SEGMENT_HH
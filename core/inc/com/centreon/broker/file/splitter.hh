@@ -19,11 +19,13 @@
 #ifndef CCB_FILE_SPLITTER_HH
 #define CCB_FILE_SPLITTER_HH
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
 
 #include "com/centreon/broker/file/fs_file.hh"
+#include "com/centreon/broker/file/segment.hh"
 #include "com/centreon/broker/namespace.hh"
 
 CCB_BEGIN()
@@ -63,9 +65,30 @@ namespace file {
  *  A third mutex id_m is set essentially when it is time to open a file. It
  *  is the _wid and _rid lock. _rmutex and _wmutex are set while it is locked.
  *
+ *  If mmap segments are enabled, files are preallocated to the max file size
+ *  and mapped in memory (see segment), _rsegment and _wsegment then replace
+ *  _rfile and _wfile, with the same sharing rules. How often the mapped data
+ *  are synced to disk is given by the sync mode.
+ *
  *  FIXME: Maybe a better algorithm would allow us to avoid it.
  */
 class splitter : public fs_file {
+ public:
+  enum sync_mode {
+    /* Data are written to disk by the kernel, as with stdio. */
+    sync_none,
+    /* Data are synced after each write, a block of events. */
+    sync_batch,
+    /* Data are synced by writes done at least the interval after the
+     * previous sync. */
+    sync_interval
+  };
+
+ private:
+  static bool _mmap_segments;
+  static sync_mode _segments_sync;
+  static uint32_t _segments_sync_interval;
+
   bool _auto_delete;
   std::string _base_path;
   long _max_file_size;
@@ -81,8 +104,17 @@ class splitter : public fs_file {
   std::mutex _mutex2;
   std::mutex _id_m;
 
+  bool _mmap;
+  std::shared_ptr<segment> _rsegment;
+  std::shared_ptr<segment> _wsegment;
+  const sync_mode _sync;
+  const std::chrono::milliseconds _sync_interval;
+  std::chrono::steady_clock::time_point _last_sync;
+
   void _open_read_file();
   void _open_write_file();
+  long _read_segment(void* buffer, long max_size);
+  long _write_segment(void const* buffer, long size);
 
  public:
   splitter(std::string const& path,
@@ -100,6 +132,7 @@ class splitter : public fs_file {
   long tell() override;
   long write(void const* buffer, long size) override;
   void flush() override;
+  void switch_file();
 
   std::string get_file_path(int id = 0) const;
   long get_max_file_size() const;
@@ -107,6 +140,11 @@ class splitter : public fs_file {
   long get_roffset() const;
   int32_t get_wid() const;
   long get_woffset() const;
+
+  static void mmap_segments(bool enabled,
+                            sync_mode sync = sync_none,
+                            uint32_t sync_interval = 0) noexcept;
+  static bool mmap_segments() noexcept;
 };
 }  // namespace file
 
@@ -45,9 +45,12 @@ class stream : public io::stream {
   ~stream();
   stream(const stream&) = delete;
   stream& operator=(const stream&) = delete;
+  int flush() override;
   std::string peer() const override;
   bool read(std::shared_ptr<io::data>& d, time_t deadline) override;
   void remove_all_files();
+  bool may_switch_file(long size) const;
+  void switch_file();
   void statistics(nlohmann::json& tree) const override;
   int32_t write(std::shared_ptr<io::data> const& d) override;
   int32_t stop() override;
@@ -0,0 +1,90 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#ifndef CCB_IO_BUFFER_CHAIN_HH
+#define CCB_IO_BUFFER_CHAIN_HH
+
+#include <deque>
+#include <memory>
+
+#include "com/centreon/broker/io/raw.hh"
+
+CCB_BEGIN()
+
+namespace io {
+/**
+ *  @brief A part of a raw buffer. It keeps a reference on the buffer, so
+ *  its data stay valid as long as the slice exists.
+ */
+struct slice {
+  std::shared_ptr<raw> buffer;
+  const char* data;
+  size_t size;
+};
+
+/**
+ *  @class buffer_chain buffer_chain.hh "com/centreon/broker/io/buffer_chain.hh"
+ *  @brief Chain of raw buffers read from a stream and consumed from the
+ *  front.
+ *
+ *  Buffers are appended without copy, they are shared with the stream that
+ *  produced them. Consumption moves a cursor on the first buffer, it never
+ *  moves the remaining data. Bytes are only copied when a caller needs a
+ *  contiguous range spanning several buffers, and then only this range is
+ *  copied.
+ */
+class buffer_chain {
+  struct segment {
+    std::shared_ptr<raw> buffer;
+    size_t pos;
+  };
+  std::deque<segment> _segments;
+  size_t _size;
+
+ public:
+  buffer_chain() : _size{0} {}
+  buffer_chain(const buffer_chain&) = delete;
+  buffer_chain& operator=(const buffer_chain&) = delete;
+  ~buffer_chain() noexcept = default;
+  void push(std::shared_ptr<raw> buffer);
+  const char* contiguous(size_t size);
+  void consume(size_t size);
+  slice take(size_t size);
+  const char* front(size_t& size) const;
+  size_t peek(char* dst, size_t size) const;
+  void clear();
+
+  /**
+   *  Get the number of bytes in the chain.
+   *
+   *  @return A size.
+   */
+  size_t size() const { return _size; }
+
+  /**
+   *  Tell if the chain is empty.
+   *
+   *  @return true if there is no byte to consume.
+   */
+  bool empty() const { return _size == 0; }
+};
+}  // namespace io
+
+CCB_END()
+
+#endif  // !CCB_IO_BUFFER_CHAIN_HH
@@ -19,6 +19,7 @@
 #ifndef CCB_IO_DATA_HH
 #define CCB_IO_DATA_HH
 
+#include <atomic>
 #include <cstdint>
 #include "com/centreon/broker/namespace.hh"
 
@@ -36,6 +37,10 @@ namespace io {
  */
 class data {
   const uint32_t _type;
+  mutable std::atomic<uint32_t> _memory_size;
+
+ protected:
+  virtual uint32_t _compute_memory_size() const;
 
  public:
   data() = delete;
@@ -44,6 +49,7 @@ class data {
   virtual ~data();
   data& operator=(data const& other);
   uint32_t type() const noexcept;
+  uint32_t memory_size() const;
 
   uint32_t source_id;
   uint32_t destination_id;
@@ -38,6 +38,9 @@ namespace io {
  *  Raw byte array.
  */
 class raw : public data {
+ protected:
+  uint32_t _compute_memory_size() const override;
+
  public:
   raw();
   raw(raw const& r);
@@ -23,12 +23,17 @@
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <vector>
 
 #include "com/centreon/broker/io/data.hh"
 #include "com/centreon/broker/namespace.hh"
 
 CCB_BEGIN()
 
+namespace misc {
+class waker;
+}
+
 namespace io {
 /**
  *  @class stream stream.hh "com/centreon/broker/io/stream.hh"
@@ -49,6 +54,30 @@ namespace io {
  *  account any buffering, or underlayer) to the end device. If that
  *  information is not available or meaningful, it should always return '1'.
  *
+ *  The write_batch() method sends several events at once. By default, it
+ *  just calls write() for each of them, but streams able to amortize their
+ *  work (serialization, locks, system calls) over several events should
+ *  override it. It returns the number of acknowledged events like write().
+ *
+ *  The set_read_waker() method gives a waker that the stream notifies each
+ *  time new data may be read, so a reader does not have to poll it. By
+ *  default, it is given to the substream. It returns false if the stream
+ *  cannot notify readers.
+ *
+ *  The native_handle() method gives the socket under the stream, once the
+ *  data already written are sent, so that an upper layer can hand some of
+ *  its work to the kernel. It returns -1 by default.
+ *
+ *  The shard() method gives the pool shard running the connection under
+ *  the stream, so that the work done for this stream stays on it. By
+ *  default, it is the shard of the substream, -1 if there is none.
+ *
+ *  The write_ready() method tells if a write would be accepted without
+ *  waiting for the peer. Writers running on the io_context of the
+ *  connection cannot wait for it, they check this method before writing and
+ *  come back when their read waker is notified. By default, it is the
+ *  answer of the substream, true if there is none.
+ *
  *  Behind a stream, we can have threads doing complicated things. Before
  *  destroying a stream, we have to stop all these threads correctly, to flush
  *  pending events, all these things are the purpose of the stop() internal
@@ -67,15 +96,20 @@ class stream {
   stream(const stream&) = delete;
   stream& operator=(const stream&) = delete;
   virtual int flush();
+  virtual int native_handle();
   virtual std::string peer() const;
   virtual bool read(std::shared_ptr<io::data>& d,
                     time_t deadline = (time_t)-1) = 0;
+  virtual bool set_read_waker(const std::shared_ptr<misc::waker>& waker);
   virtual void set_substream(std::shared_ptr<stream> substream);
+  virtual int shard() const;
   std::shared_ptr<stream> get_substream();
   virtual void statistics(nlohmann::json& tree) const;
   virtual void update();
   bool validate(std::shared_ptr<io::data> const& d, std::string const& error);
   virtual int write(std::shared_ptr<data> const& d) = 0;
+  virtual int32_t write_batch(const std::vector<std::shared_ptr<data>>& d);
+  virtual bool write_ready() const;
   const std::string& get_name() const { return _name; }
 };
 }  // namespace io
@@ -20,7 +20,9 @@
 #define CCB_MAPPING_ENTRY_HH
 
 #include <cassert>
+#include <cstring>
 #include <memory>
+#include <type_traits>
 
 #include "com/centreon/broker/mapping/property.hh"
 
@@ -40,6 +42,28 @@ class entry {
   source* _source;
   const source::source_type _type;
 
+  /* A copy of the member pointer, and a function returning the address of
+   * the member in an object. Contrary to the source getters and setters,
+   * they let code knowing the member type at compile time use it directly. */
+  typename std::aligned_storage<2 * sizeof(void*), alignof(void*)>::type
+      _member;
+  void* (*_address)(const entry& e, io::data& d);
+
+  template <typename T, typename M>
+  void _set_member(M(T::*prop)) {
+    static_assert(sizeof(prop) <= sizeof(_member),
+                  "member pointer too big to be stored in a mapping entry");
+    memcpy(&_member, &prop, sizeof(prop));
+    _address = &entry::_address_of<T, M>;
+  }
+
+  template <typename T, typename M>
+  static void* _address_of(const entry& e, io::data& d) {
+    M T::*prop;
+    memcpy(&prop, &e._member, sizeof(prop));
+    return &(static_cast<T&>(d).*prop);
+  }
+
  public:
   enum attribute {
     always_valid = 0,
@@ -67,7 +91,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new sproperty<T>(prop, max_len)),
-        _type(source::STRING) {}
+        _type(source::STRING) {
+    _set_member(prop);
+  }
 
   /**
    *  @brief Boolean constructor.
@@ -86,7 +112,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new property<T>(prop)),
-        _type(source::BOOL) {}
+        _type(source::BOOL) {
+    _set_member(prop);
+  }
 
   /**
    *  @brief Double constructor.
@@ -105,7 +133,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new property<T>(prop)),
-        _type(source::DOUBLE) {}
+        _type(source::DOUBLE) {
+    _set_member(prop);
+  }
 
   /**
    *  @brief Unsigned integer constructor.
@@ -124,7 +154,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new property<T>(prop)),
-        _type(source::UINT) {}
+        _type(source::UINT) {
+    _set_member(prop);
+  }
 
   /**
    *  @brief Unsigned integer constructor.
@@ -143,7 +175,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new property<T>(prop)),
-        _type(source::ULONG) {}
+        _type(source::ULONG) {
+    _set_member(prop);
+  }
 
   /**
    *  @brief Integer constructor.
@@ -162,7 +196,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new property<T>(prop)),
-        _type(source::INT) {}
+        _type(source::INT) {
+    _set_member(prop);
+  }
 
   /**
    *  @brief Unsigned short constructor.
@@ -181,7 +217,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new property<T>(prop)),
-        _type(source::USHORT) {}
+        _type(source::USHORT) {
+    _set_member(prop);
+  }
 
   /**
    *  @brief Short constructor.
@@ -200,7 +238,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new property<T>(prop)),
-        _type(source::SHORT) {}
+        _type(source::SHORT) {
+    _set_member(prop);
+  }
 
   /**
    *  @brief Time constructor.
@@ -218,7 +258,9 @@ class entry {
         _name_v2(name),
         _serialize(serialize),
         _source(new property<T>(prop)),
-        _type(source::TIME) {}
+        _type(source::TIME) {
+    _set_member(prop);
+  }
 
   /**
    *  Default constructor.
@@ -228,7 +270,8 @@ class entry {
         _name_v2(nullptr),
         _serialize(false),
         _source(nullptr),
-        _type(source::UNKNOWN) {}
+        _type(source::UNKNOWN),
+        _address(nullptr) {}
 
   entry(const entry&) = delete;
   entry(entry&& other)
@@ -236,7 +279,9 @@ class entry {
         _name_v2(other._name_v2),
         _serialize(other._serialize),
         _source(other._source),
-        _type(other._type) {
+        _type(other._type),
+        _member(other._member),
+        _address(other._address) {
     other._source = nullptr;
   }
 
@@ -274,6 +319,15 @@ class entry {
    *  @return Entry type.
    */
   uint32_t get_type() const { return _type; }
+  /**
+   *  Get the address of the property in an object. The pointed type is
+   *  given by get_type().
+   *
+   *  @param[in] d  Object to work on.
+   *
+   *  @return The address of the property.
+   */
+  void* get_address(io::data& d) const { return _address(*this, d); }
   uint32_t get_uint(const io::data& d) const;
   uint64_t get_ulong(const io::data& d) const;
   unsigned short get_ushort(const io::data& d) const;
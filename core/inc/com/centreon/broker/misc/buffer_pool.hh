@@ -0,0 +1,85 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+#ifndef CCB_MISC_BUFFER_POOL_HH
+#define CCB_MISC_BUFFER_POOL_HH
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/namespace.hh"
+
+CCB_BEGIN()
+
+namespace misc {
+
+/**
+ * @brief Pool of byte buffers used to receive data from sockets.
+ *
+ * A reader gets a buffer, receives data directly in it and gives it to the
+ * upper streams with make_raw(). The returned io::raw owns the buffer, no
+ * copy is done, and when it is destroyed (usually when the BBDO decoder has
+ * consumed it), the buffer comes back here with its capacity, so the next
+ * read does not allocate memory.
+ *
+ * Free buffers are sorted by size class, powers of two from min_buffer_size
+ * to max_buffer_size. A buffer is allocated with the capacity of its class
+ * and only reused for sizes of this class, so a small read never holds a
+ * big buffer. Bigger buffers are allocated to the exact size and not kept.
+ */
+class buffer_pool {
+ public:
+  /* Smallest size class. */
+  static constexpr size_t min_buffer_size = 4096;
+  /* Buffers bigger than this are not kept. */
+  static constexpr size_t max_buffer_size = 262144;
+  /* Maximum number of free buffers kept in each size class. */
+  static constexpr size_t max_free_buffers = 16;
+
+ private:
+  static constexpr size_t size_classes = 7;
+  static_assert(min_buffer_size << (size_classes - 1) == max_buffer_size,
+                "size classes must go from min to max buffer size");
+
+  mutable std::mutex _m;
+  std::array<std::vector<std::vector<char>>, size_classes> _free;
+  std::atomic<uint64_t> _allocated;
+  std::atomic<uint64_t> _reused;
+
+  buffer_pool();
+  ~buffer_pool() = delete;
+
+ public:
+
+  static buffer_pool& instance();
+  buffer_pool(const buffer_pool&) = delete;
+  buffer_pool& operator=(const buffer_pool&) = delete;
+
+  std::vector<char> get(size_t size);
+  std::shared_ptr<io::raw> make_raw(std::vector<char>&& buffer);
+  void release(std::vector<char>&& buffer);
+  void statistics(nlohmann::json& tree) const;
+};
+}  // namespace misc
+
+CCB_END()
+
+#endif /* !CCB_MISC_BUFFER_POOL_HH */
@@ -21,6 +21,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 
 #include "com/centreon/broker/namespace.hh"
 
@@ -99,6 +100,28 @@ class mfifo {
     return retval;
   }
 
+  /**
+   * @brief Push several elements coming from idx input source with the
+   * mutex locked only once and returns the number of elements already
+   * acknowledged.
+   *
+   * @param idx The input source
+   * @param v The elements to add
+   *
+   * @return The number of elements to ack.
+   */
+  int32_t push(uint32_t idx, const std::vector<T>& v) {
+    std::lock_guard<std::mutex> lk(_fifo_m);
+    for (auto& e : v) {
+      _pending_elements++;
+      _timeline[idx].push_back(false);
+      _events.emplace_back(std::make_tuple(e, idx, &_timeline[idx].back()));
+    }
+    int32_t retval = _ack[idx];
+    _ack[idx] = 0;
+    return retval;
+  }
+
   int32_t get_acks(uint32_t idx) {
     std::lock_guard<std::mutex> lk(_fifo_m);
     int32_t retval = _ack[idx];
@@ -0,0 +1,192 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+#ifndef CCB_MISC_MPSC_RING_HH
+#define CCB_MISC_MPSC_RING_HH
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "com/centreon/broker/namespace.hh"
+
+CCB_BEGIN()
+
+namespace misc {
+
+/**
+ * @brief Bounded lock-free ring with several producers and one consumer.
+ *
+ * Each cell of the ring owns a sequence number. A producer reserves a slot
+ * by incrementing _tail with a compare and swap, it fills it and then
+ * publishes it by setting the cell sequence to pos + 1. The consumer reads
+ * cells in order from _head and gives them back to producers by setting their
+ * sequence to pos + capacity.
+ *
+ * Since slots are reserved in a global order, all the elements pushed by a
+ * same thread are popped in the order they were pushed.
+ *
+ * The consumer side is not thread safe, it is up to the caller to guarantee
+ * that only one thread pops at a time (the owner of the consumer role may
+ * change, as long as the change is synchronized).
+ *
+ * @tparam T The type of stored elements. It must be default constructible
+ * and movable.
+ */
+template <typename T>
+class mpsc_ring {
+  struct cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  const size_t _mask;
+  std::unique_ptr<cell[]> _cells;
+
+  /* _tail is written by all the producers whereas _head is only used by the
+   * consumer. We keep them on different cache lines to avoid false sharing. */
+  char _pad0[64];
+  std::atomic<size_t> _tail;
+  char _pad1[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> _head;
+  char _pad2[64 - sizeof(std::atomic<size_t>)];
+
+  static size_t _round_capacity(size_t capacity) {
+    size_t retval = 2;
+    while (retval < capacity)
+      retval <<= 1;
+    return retval;
+  }
+
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param capacity The ring capacity, rounded up to a power of two.
+   */
+  explicit mpsc_ring(size_t capacity)
+      : _mask{_round_capacity(capacity) - 1},
+        _cells{new cell[_mask + 1]},
+        _tail{0},
+        _head{0} {
+    for (size_t i = 0; i <= _mask; ++i)
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  mpsc_ring(const mpsc_ring&) = delete;
+  mpsc_ring& operator=(const mpsc_ring&) = delete;
+  ~mpsc_ring() noexcept = default;
+
+  /**
+   * @brief Push a new element at the end of the ring. This method can be
+   * called concurrently by any number of threads.
+   *
+   * @param v The element to push.
+   *
+   * @return true on success, false if the ring is full.
+   */
+  bool try_push(const T& v) {
+    size_t pos = _tail.load(std::memory_order_relaxed);
+    for (;;) {
+      cell& c = _cells[pos & _mask];
+      size_t seq = c.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (_tail.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          c.value = v;
+          c.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0)
+        return false;
+      else
+        pos = _tail.load(std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Pop the first element of the ring. Only the consumer can call it.
+   *
+   * @param v The popped element.
+   *
+   * @return true on success, false if no element is ready.
+   */
+  bool try_pop(T& v) {
+    size_t pos = _head.load(std::memory_order_relaxed);
+    cell& c = _cells[pos & _mask];
+    size_t seq = c.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0)
+      return false;
+    v = std::move(c.value);
+    c.value = T();
+    c.sequence.store(pos + _mask + 1, std::memory_order_release);
+    _head.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /**
+   * @brief Pop up to max elements and append them to out. Only the consumer
+   * can call it.
+   *
+   * @param out The vector to fill.
+   * @param max The maximum number of elements to pop.
+   *
+   * @return The number of popped elements.
+   */
+  size_t pop_bulk(std::vector<T>& out, size_t max) {
+    size_t retval = 0;
+    T v;
+    while (retval < max && try_pop(v)) {
+      out.emplace_back(std::move(v));
+      ++retval;
+    }
+    return retval;
+  }
+
+  /**
+   * @brief Tell if the next element to pop is ready. It is only meaningful
+   * for the consumer, the answer is immediately outdated for producers.
+   *
+   * @return true if there is nothing to pop.
+   */
+  bool empty() const {
+    size_t pos = _head.load(std::memory_order_relaxed);
+    const cell& c = _cells[pos & _mask];
+    return static_cast<intptr_t>(c.sequence.load(std::memory_order_acquire)) -
+               static_cast<intptr_t>(pos + 1) <
+           0;
+  }
+
+  /**
+   * @brief An approximation of the number of elements in the ring.
+   *
+   * @return A size.
+   */
+  size_t size() const {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t head = _head.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  size_t capacity() const { return _mask + 1; }
+};
+}  // namespace misc
+
+CCB_END()
+
+#endif /* !CCB_MISC_MPSC_RING_HH */
@@ -0,0 +1,108 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+#ifndef CCB_MISC_WAKER_HH
+#define CCB_MISC_WAKER_HH
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "com/centreon/broker/namespace.hh"
+
+CCB_BEGIN()
+
+namespace misc {
+
+/**
+ * @brief Readiness notification shared by a consumer thread and the objects
+ * it reads from.
+ *
+ * Producers call notify() each time they have something new to read. The
+ * consumer gets the current sequence before polling its sources, and if
+ * nothing was available, it waits for the sequence to change. So a
+ * notification sent between the poll and the wait is never lost.
+ *
+ * A consumer that does not own a thread can instead register a callback,
+ * called by notify().
+ */
+class waker {
+  std::mutex _m;
+  std::condition_variable _cv;
+  uint64_t _sequence;
+  std::function<void()> _callback;
+
+ public:
+  waker() : _sequence{0} {}
+  waker(const waker&) = delete;
+  waker& operator=(const waker&) = delete;
+
+  /**
+   * @brief Get the current sequence, to call before polling the sources.
+   *
+   * @return A sequence number to give to wait_for().
+   */
+  uint64_t sequence() {
+    std::lock_guard<std::mutex> lck(_m);
+    return _sequence;
+  }
+
+  /**
+   * @brief Wake up the consumer.
+   */
+  void notify() {
+    std::lock_guard<std::mutex> lck(_m);
+    ++_sequence;
+    _cv.notify_all();
+    if (_callback)
+      _callback();
+  }
+
+  /**
+   * @brief Set the function called on each notification. It is called with
+   * the waker locked, so it must be short and must not use the waker. Once
+   * this method returns, the previous callback is not called anymore.
+   *
+   * @param callback The function to call, nullptr to remove it.
+   */
+  void set_callback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lck(_m);
+    _callback = std::move(callback);
+  }
+
+  /**
+   * @brief Wait for a notification sent after sequence was got.
+   *
+   * @param seen The sequence returned by sequence() before polling.
+   * @param timeout The maximum duration to wait.
+   *
+   * @return true if a notification was received, false on timeout.
+   */
+  template <typename Rep, typename Period>
+  bool wait_for(uint64_t seen,
+                const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<std::mutex> lck(_m);
+    return _cv.wait_for(lck, timeout,
+                        [this, seen] { return _sequence != seen; });
+  }
+};
+}  // namespace misc
+
+CCB_END()
+
+#endif /* !CCB_MISC_WAKER_HH */
@@ -19,11 +19,15 @@
 #ifndef CCB_MULTIPLEXING_ENGINE_HH
 #define CCB_MULTIPLEXING_ENGINE_HH
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <unordered_map>
+#include <vector>
 
+#include "com/centreon/broker/misc/mpsc_ring.hh"
 #include "com/centreon/broker/multiplexing/hooker.hh"
 #include "com/centreon/broker/namespace.hh"
 #include "com/centreon/broker/persistent_cache.hh"
@@ -65,6 +69,15 @@ class muxer;
  *    written to a cache file ...unprocessed... This file will be re-read at the
  *    next broker start.
  *
+ *  Publishers do not take any lock. Events are pushed into a lock-free ring
+ *  (_ingest) and then dispatched by batches. The dispatch role is owned by
+ *  one publisher at a time (the one that gets _dispatching). The others just
+ *  leave their events in the ring, the dispatcher will handle them. Since
+ *  the ring is a FIFO, events from a same publisher are dispatched in the
+ *  order they were published. When the ring is full, publishers wait for
+ *  _engine_m, publish the ring content and push their event again, so it
+ *  still comes after their previous ones.
+ *
  *  @see muxer
  */
 class engine {
@@ -74,6 +87,12 @@ class engine {
   // Data queue.
   std::queue<std::shared_ptr<io::data>> _kiew;
 
+  // Ingest ring filled by publishers and drained by the dispatcher.
+  misc::mpsc_ring<std::shared_ptr<io::data>> _ingest;
+  std::atomic_bool _dispatching;
+  // Batch of events being dispatched (only used by the dispatcher).
+  std::vector<std::shared_ptr<io::data>> _batch;
+
   // Hooks
   std::vector<std::pair<hooker*, bool>> _hooks;
   std::vector<std::pair<hooker*, bool>>::iterator _hooks_begin;
@@ -84,6 +103,9 @@ class engine {
 
   // Subscriber.
   std::vector<muxer*> _muxers;
+  /* Routing table: for each event type, the muxers whose write filters
+   * accept it. It is rebuilt each time muxers or their filters change. */
+  std::unordered_map<uint32_t, std::vector<muxer*>> _routes;
   std::mutex _muxers_m;
 
   // Statistics.
@@ -92,18 +114,25 @@ class engine {
 
   static std::mutex _load_m;
 
-  engine();
+  engine(size_t ingest_size);
   std::string _cache_file_path() const;
+  void _dispatch();
+  void _drain_ingest();
   void _nop(std::shared_ptr<io::data> const& d);
   void _send_to_subscribers();
   void _write(std::shared_ptr<io::data> const& d);
   void _write_to_cache_file(std::shared_ptr<io::data> const& d);
   void _publish(std::shared_ptr<io::data> const& d);
+  void _push_to_full_ingest(const std::shared_ptr<io::data>& d);
+  void _update_routes();
 
   void (engine::*_write_func)(std::shared_ptr<io::data> const&);
 
  public:
-  static void load();
+  /* Default size of the ingest ring. */
+  static constexpr size_t ingest_ring_size = 16384;
+
+  static void load(size_t ingest_size = ingest_ring_size);
   static void unload();
   static engine& instance();
 
@@ -119,6 +148,7 @@ class engine {
   void unhook(hooker& h);
   void subscribe(muxer* subscriber);
   void unsubscribe(muxer* subscriber);
+  void update_routes();
 };
 }  // namespace multiplexing
 
@@ -19,14 +19,18 @@
 #ifndef CCB_MULTIPLEXING_MUXER_HH
 #define CCB_MULTIPLEXING_MUXER_HH
 
+#include <atomic>
 #include <condition_variable>
-#include <list>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
+#include "com/centreon/broker/misc/waker.hh"
 #include "com/centreon/broker/namespace.hh"
 #include "com/centreon/broker/persistent_file.hh"
 
@@ -47,27 +51,80 @@ namespace multiplexing {
 class muxer : public io::stream {
  public:
   typedef std::unordered_set<uint32_t> filters;
+  /* Maximum number of events read at once by feeders and failovers. */
+  static constexpr size_t read_batch_size = 512;
+  /* Number of events the spill thread keeps decoded from the queue file
+   * before they fit in the event queue. */
+  static constexpr size_t read_ahead_size = 1024;
+  /* Maximum delay in milliseconds before the spill thread retries to access
+   * a failing queue file. */
+  static constexpr uint32_t max_spill_retry_delay = 30000;
 
  private:
   std::condition_variable _cv;
-  std::list<std::shared_ptr<io::data>> _events;
+  /* Queued events. The deque is a segmented array, so pushing, popping and
+   * accessing any event are done in constant time without an allocation per
+   * event. Events before _pos are sent but not acknowledged yet, events from
+   * _pos are not sent yet. */
+  std::deque<std::shared_ptr<io::data>> _events;
   uint32_t _events_size;
   static uint32_t _event_queue_max_size;
+
+  /* Memory budget shared by all the muxers. When the events of all the
+   * muxers use more than _event_queues_total_size bytes, the muxers with the
+   * biggest and oldest queues are elected to spill to their queue files. */
+  static uint64_t _event_queues_total_size;
+  static std::atomic<uint64_t> _total_resident_bytes;
+  static std::atomic<time_t> _last_election;
+  static std::mutex _muxers_m;
+  static std::vector<muxer*> _muxers;
+
+  /* Memory used by the events of this muxer that are in memory: the event
+   * queue, the read ahead and the spill buffers. */
+  std::atomic<uint64_t> _resident_bytes;
+  /* Last time events were acknowledged or the queue was empty. */
+  std::atomic<time_t> _last_progress;
+  std::atomic_bool _spill_elected;
+  time_t _last_stats_update;
+  /* The queue file. Once the muxer is built, it is only accessed by the spill
+   * thread, _file_m is there for statistics(). */
   std::unique_ptr<persistent_file> _file;
+  mutable std::mutex _file_m;
   mutable std::mutex _mutex;
   std::string _name;
   bool _persistent;
-  std::list<std::shared_ptr<io::data>>::iterator _pos;
+  size_t _pos;
   filters _read_filters;
   filters _write_filters;
   std::string _read_filters_str;
   std::string _write_filters_str;
+  std::shared_ptr<misc::waker> _waker;
+
+  /* When the event queue is full, events are not in _events anymore but
+   * in this order: _prefetched, the queue file, the batch being written by
+   * the spill thread and _spill. _overflow is true as long as one of them
+   * may contain events, new events are then appended to _spill. */
+  bool _overflow;
+  std::deque<std::shared_ptr<io::data>> _spill;
+  std::deque<std::shared_ptr<io::data>> _prefetched;
+  std::condition_variable _spill_cv;
+  bool _spill_exit;
+  std::thread _spill_thread;
 
+  void _add_resident_bytes(int64_t size);
   void _clean();
+  static void _elect_spilling_muxers();
+  void _fill_from_prefetched();
   void _get_event_from_file(std::shared_ptr<io::data>& event);
   std::string _memory_file() const;
   void _push_to_queue(std::shared_ptr<io::data> const& event);
+  uint32_t _queue_limit() const;
   std::string _queue_file() const;
+  void _spill_loop();
+  void _start_spill_thread();
+  void _update_stats(bool force);
+  void _write_to_file(std::shared_ptr<io::data> const& event,
+                      std::vector<std::shared_ptr<io::data>>& read_back);
 
  public:
   muxer(std::string const& name, bool persistent = false);
@@ -77,12 +134,20 @@ class muxer : public io::stream {
   void ack_events(int count);
   static void event_queue_max_size(uint32_t max) noexcept;
   static uint32_t event_queue_max_size() noexcept;
+  static void event_queues_total_size(uint64_t size) noexcept;
+  static uint64_t event_queues_total_size() noexcept;
+  static uint64_t total_resident_bytes() noexcept;
+  uint64_t resident_bytes() const noexcept;
   void publish(std::shared_ptr<io::data> const event);
   bool read(std::shared_ptr<io::data>& event, time_t deadline) override;
+  bool read_batch(std::vector<std::shared_ptr<io::data>>& events,
+                  size_t max,
+                  time_t deadline);
   void set_read_filters(filters const& fltrs);
+  void set_waker(const std::shared_ptr<misc::waker>& waker);
   void set_write_filters(filters const& fltrs);
   filters const& get_read_filters() const;
-  filters const& get_write_filters() const;
+  filters get_write_filters() const;
   const std::string& get_read_filters_str() const;
   const std::string& get_write_filters_str() const;
   uint32_t get_event_queue_size() const;
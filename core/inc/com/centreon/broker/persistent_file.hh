@@ -25,25 +25,52 @@
 
 CCB_BEGIN()
 
+namespace bbdo {
+class stream;
+}
+
 /**
  *  @class persistent_file persistent_file.hh
  * "com/centreon/broker/persistent_file.hh"
  *  @brief On-disk file.
  *
  *  On-disk file that uses multiple streams to write serialized data.
- *  It uses BBDO, compression and file streams.
+ *  It uses BBDO, compression and file streams. Events are packed in
+ *  independent zstd blocks, files written with one zlib block per event by
+ *  previous versions are still read.
+ *
+ *  Events are only on disk once their block is written. Until then, a
+ *  crash loses them. flush() writes the current block even if it is not
+ *  full, and it is done by write() at most max_buffer_delay seconds after
+ *  the first event of a block (see set_max_buffer_delay()). A block written early is smaller and
+ *  compresses less, so flush() is not called after each event.
+ *
+ *  When its reading catches up with its writing, the file is removed. The
+ *  events not written yet are still read but the next writes throw
+ *  exceptions::shutdown, a new persistent_file must be opened for them.
  */
 class persistent_file : public io::stream {
   std::shared_ptr<file::stream> _splitter;
+  std::shared_ptr<bbdo::stream> _bbdo;
+  const long _switch_margin;
+  /* Time of the first event written since the last flush, 0 if none. */
+  time_t _buffered_since;
+  int _max_buffer_delay;
 
  public:
-  persistent_file(const std::string& path);
+  /* Events are kept in memory until their compression block is full, by
+   * default at most for this number of seconds. */
+  static constexpr int max_buffer_delay = 2;
+
+  persistent_file(const std::string& path, long max_file_size = 100000000);
   ~persistent_file() noexcept = default;
   persistent_file(const persistent_file&) = delete;
   persistent_file& operator=(const persistent_file&) = delete;
   bool read(std::shared_ptr<io::data>& d,
             time_t deadline = (time_t)-1) override;
+  int flush() override;
   void remove_all_files();
+  void set_max_buffer_delay(int delay);
   void statistics(nlohmann::json& tree) const override;
   int32_t write(const std::shared_ptr<io::data>& d) override;
   int32_t stop() override;
@@ -61,6 +61,12 @@ CCB_BEGIN()
  * This duration is stored in _latency.
  *
  * We can see a steady_timer in the class, its goal is to cadence this check.
+ *
+ * Besides the shared io_context, the pool can start shards. A shard is an
+ * io_context run by a single thread pinned to one cpu. Sharded TCP acceptors
+ * give each of their connections to a shard, so that everything done for a
+ * connection stays on the same core. Shards are started with start_shards()
+ * and are never stopped before the pool.
  */
 class pool {
   static pool* _instance;
@@ -79,6 +85,19 @@ class pool {
   asio::steady_timer _timer;
   std::atomic_bool _stats_running;
 
+  struct shard {
+    asio::io_context io_context;
+    std::unique_ptr<asio::io_context::work> worker;
+    std::thread thread;
+    std::atomic<int32_t> connections;
+    shard()
+        : io_context(1),
+          worker(new asio::io_context::work(io_context)),
+          connections{0} {}
+  };
+  std::vector<std::unique_ptr<shard>> _shards;
+  mutable std::mutex _shards_m;
+
   pool(size_t size);
   ~pool() noexcept;
   void _stop();
@@ -93,6 +112,12 @@ class pool {
   static pool& instance();
   static asio::io_context& io_context();
 
+  size_t start_shards(size_t count);
+  asio::io_context& shard_context(size_t index);
+  size_t get_shards_count() const;
+  void add_shard_connections(size_t index, int32_t count);
+  int32_t get_shard_connections(size_t index) const;
+
   void start_stats(ThreadPool* stats);
   void stop_stats();
 
@@ -26,6 +26,7 @@
 #include <vector>
 #include "com/centreon/broker/io/endpoint.hh"
 #include "com/centreon/broker/io/stream.hh"
+#include "com/centreon/broker/misc/waker.hh"
 #include "com/centreon/broker/multiplexing/subscriber.hh"
 #include "com/centreon/broker/namespace.hh"
 #include "com/centreon/broker/processing/acceptor.hh"
@@ -102,6 +103,9 @@ class failover : public endpoint {
   volatile time_t _retry_interval;
   std::shared_ptr<multiplexing::subscriber> _subscriber;
   volatile bool _update;
+  /* Notified by the stream and the muxer when they have data. It is shared
+   * with the failover of this failover since they use the same muxer. */
+  std::shared_ptr<misc::waker> _waker;
 
   // Status.
   std::string _status;
@@ -21,12 +21,17 @@
 
 #include <atomic>
 #include <climits>
+#include <asio.hpp>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <string>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include "com/centreon/broker/misc/shared_mutex.hh"
+#include "com/centreon/broker/misc/waker.hh"
 #include "com/centreon/broker/multiplexing/subscriber.hh"
 #include "com/centreon/broker/namespace.hh"
 #include "com/centreon/broker/processing/stat_visitable.hh"
@@ -44,10 +49,42 @@ namespace processing {
  *  @brief Feed events from a source to a destination.
  *
  *  Take events from a source and send them to a destination.
+ *
+ *  By default, each feeder runs its event loop in its own thread. In pool
+ *  mode, there is no thread per feeder: each time its stream or its muxer
+ *  has data, the feeder is queued and then runs a slice of at most
+ *  slice_steps steps on the asio pool. The number of slices running at the
+ *  same time is bounded and feeders are served in a round robin way, so a
+ *  busy peer cannot starve the others nor the pool. If the client
+ *  connection runs on a shard of the pool, slices run on that shard too.
+ *  A slice never waits for the peer: when the client is not ready for
+ *  writes, the events are kept and sent by a later slice, and the client is
+ *  stopped on a thread of its own since it waits for the ack of the peer.
  */
 class feeder : public stat_visitable {
   enum state { stopped, running, finished };
-  // Condition variable used when waiting for the thread to finish
+  /* Maximum number of steps (a stream read and a muxer batch) in a slice. */
+  static constexpr uint32_t slice_steps = 16;
+
+  static bool _pool_mode;
+  static uint32_t _max_concurrent_slices;
+
+  /* Pool mode scheduler, everything here is protected by _sched_m. */
+  static std::mutex _sched_m;
+  static std::deque<feeder*> _ready;
+  static std::unordered_set<feeder*> _async_feeders;
+  static uint32_t _running_slices;
+  static std::unique_ptr<asio::steady_timer> _sched_timer;
+  static uint32_t _sched_ticks;
+  bool _async;
+  bool _queued;
+  bool _slice_running;
+  bool _rerun;
+  /* Where slices are posted: the shard of the client, or the shared pool. */
+  asio::io_context* _slice_context;
+  std::condition_variable _slice_cv;
+
+  /* The event loop thread, or in pool mode the thread stopping the client. */
   std::unique_ptr<std::thread> _thread;
   state _state;
   mutable std::mutex _state_m;
@@ -57,11 +94,30 @@ class feeder : public stat_visitable {
 
   std::unique_ptr<io::stream> _client;
   multiplexing::subscriber _subscriber;
+  /* Notified by the client stream and the muxer when they have data. */
+  std::shared_ptr<misc::waker> _waker;
+
+  /* Event loop state. */
+  bool _stream_can_read;
+  bool _muxer_can_read;
+  bool _stream_notifies;
+  time_t _fill_stats_time;
+  std::vector<std::shared_ptr<io::data>> _events;
+  /* Events were written to the client since its last flush. */
+  bool _unflushed;
 
   // This mutex is used for the stat thread.
   mutable misc::shared_mutex _client_m;
 
   void _callback() noexcept;
+  void _start_loop();
+  bool _step();
+  void _finish() noexcept;
+  bool _slice() noexcept;
+  void _schedule();
+  static void _pump();
+  static void _slice_done(feeder* f, bool again);
+  static void _tick(const asio::error_code& ec);
 
  protected:
   const std::string& _get_read_filters() const override;
@@ -79,6 +135,9 @@ class feeder : public stat_visitable {
   feeder& operator=(const feeder&) = delete;
   bool is_finished() const noexcept;
   const char* get_state() const;
+
+  static void pool_mode(bool enabled, uint32_t max_concurrent_slices = 0);
+  static bool pool_mode() noexcept;
 };
 }  // namespace processing
 
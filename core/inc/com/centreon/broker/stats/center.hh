@@ -78,6 +78,12 @@ class center {
   bool unregister_mysql_connection(SqlConnectionStats* connection);
   void get_sql_connection_stats(uint32_t index, SqlConnectionStats* response);
   void get_conflict_manager_stats(ConflictManagerStats* response);
+  void update_muxer(const std::string& name,
+                    uint64_t resident_bytes,
+                    uint32_t queued_events,
+                    bool spilling,
+                    uint64_t total_resident_bytes);
+  void unregister_muxer(const std::string& name);
   // bool unregister_endpoint(const std::string& name);
   // bool unregister_feeder(EndpointStats* ep_stats, const std::string& name);
   // bool unregister_mysql_manager(void);
@@ -0,0 +1,431 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/bbdo/codec.hh"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+#include <memory>
+
+#include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/broker/mapping/entry.hh"
+#include "com/centreon/exceptions/msg_fmt.hh"
+
+using namespace com::centreon::exceptions;
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::bbdo;
+
+namespace {
+/**
+ *  Append a 32 bits integer in network byte order.
+ */
+inline void put_uint32(uint32_t value, std::vector<char>& buffer) {
+  value = htonl(value);
+  const char* v = reinterpret_cast<const char*>(&value);
+  buffer.insert(buffer.end(), v, v + sizeof(value));
+}
+
+/**
+ *  Append a 64 bits integer in network byte order.
+ */
+inline void put_uint64(uint64_t value, std::vector<char>& buffer) {
+  put_uint32(value >> 32, buffer);
+  put_uint32(value & 0xffffffff, buffer);
+}
+
+/**
+ *  Read a 32 bits integer in network byte order.
+ */
+inline uint32_t get_uint32(const char* buffer) {
+  uint32_t value;
+  memcpy(&value, buffer, sizeof(value));
+  return ntohl(value);
+}
+
+/**
+ *  Read a 64 bits integer in network byte order.
+ */
+inline uint64_t get_uint64(const char* buffer) {
+  uint64_t value = get_uint32(buffer);
+  value <<= 32;
+  value |= get_uint32(buffer + sizeof(uint32_t));
+  return value;
+}
+
+/**
+ *  Encoder and decoder of a property. The specializations give the BBDO
+ *  representation of each property type.
+ */
+template <typename M, bool binary = false>
+struct wire;
+
+template <>
+struct wire<bool> {
+  static constexpr size_t fixed_size = 1;
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    buffer.push_back(*reinterpret_cast<const bool*>(field) ? 1 : 0);
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    if (!size) {
+      log_v2::bbdo()->error(
+          "cannot extract boolean value: 0 bytes left in "
+          "packet");
+      throw msg_fmt(
+          "cannot extract boolean value: "
+          "0 bytes left in packet");
+    }
+    *reinterpret_cast<bool*>(field) = *buffer;
+    return 1;
+  }
+};
+
+template <>
+struct wire<double, false> {
+  static constexpr size_t fixed_size = 0;
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    char str[32];
+    size_t strsz(snprintf(str, sizeof(str), "%f",
+                          *reinterpret_cast<const double*>(field)) +
+                 1);
+    if (strsz > sizeof(str))
+      strsz = sizeof(str);
+    buffer.insert(buffer.end(), str, str + strsz);
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    uint32_t len(strlen(buffer));
+    if (len >= size) {
+      log_v2::bbdo()->error(
+          "cannot extract double value: not terminating '\\0' in remaining "
+          "{} bytes of packet",
+          size);
+      throw msg_fmt(
+          "cannot extract double value: "
+          "not terminating '\\0' in remaining {} bytes of packet",
+          size);
+    }
+    *reinterpret_cast<double*>(field) = strtod(buffer, nullptr);
+    return len + 1;
+  }
+};
+
+/* Binary double extension: IEEE-754 value in network byte order. */
+template <>
+struct wire<double, true> {
+  static constexpr size_t fixed_size = sizeof(uint64_t);
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    uint64_t value;
+    memcpy(&value, field, sizeof(value));
+    put_uint64(value, buffer);
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    if (size < sizeof(uint64_t)) {
+      log_v2::bbdo()->error(
+          "BBDO: cannot extract double value: {} bytes left in packet", size);
+      throw msg_fmt(
+          "BBDO: cannot extract double value: {}"
+          " bytes left in packet",
+          size);
+    }
+    uint64_t value = get_uint64(buffer);
+    memcpy(field, &value, sizeof(value));
+    return sizeof(uint64_t);
+  }
+};
+
+template <>
+struct wire<int> {
+  static constexpr size_t fixed_size = sizeof(uint32_t);
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    put_uint32(*reinterpret_cast<const int*>(field), buffer);
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    if (size < sizeof(uint32_t)) {
+      log_v2::bbdo()->error(
+          "cannot extract integer value: {} bytes left in packet", size);
+      throw msg_fmt(
+          "BBDO: cannot extract integer value: {}"
+          " bytes left in packet",
+          size);
+    }
+    *reinterpret_cast<int*>(field) = get_uint32(buffer);
+    return sizeof(uint32_t);
+  }
+};
+
+template <>
+struct wire<short> {
+  static constexpr size_t fixed_size = sizeof(uint16_t);
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    uint16_t value = htons(*reinterpret_cast<const short*>(field));
+    const char* v = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), v, v + sizeof(value));
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    if (size < sizeof(uint16_t)) {
+      log_v2::bbdo()->error(
+          "BBDO: cannot extract short value: {} bytes left in packet", size);
+      throw msg_fmt(
+          "BBDO: cannot extract short value: {}"
+          " bytes left in packet",
+          size);
+    }
+    uint16_t value;
+    memcpy(&value, buffer, sizeof(value));
+    *reinterpret_cast<short*>(field) = ntohs(value);
+    return sizeof(uint16_t);
+  }
+};
+
+template <>
+struct wire<std::string> {
+  static constexpr size_t fixed_size = 1;
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    const std::string& str = *reinterpret_cast<const std::string*>(field);
+    buffer.insert(buffer.end(), str.c_str(), str.c_str() + str.size() + 1);
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    uint32_t len(strlen(buffer));
+    if (len >= size) {
+      log_v2::bbdo()->error(
+          "BBDO: cannot extract string value: no terminating '\\0' in "
+          "remaining {} bytes left in packet",
+          size);
+
+      throw msg_fmt(
+          "BBDO: cannot extract string value: "
+          "no terminating '\\0' in remaining {} bytes of packet",
+          size);
+    }
+    reinterpret_cast<std::string*>(field)->assign(buffer, len);
+    return len + 1;
+  }
+};
+
+template <>
+struct wire<timestamp> {
+  static constexpr size_t fixed_size = sizeof(uint64_t);
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    put_uint64(reinterpret_cast<const timestamp*>(field)->get_time_t(),
+               buffer);
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    if (size < sizeof(uint64_t)) {
+      log_v2::bbdo()->error(
+          "BBDO: cannot extract timestamp value: {} bytes left in packet",
+          size);
+      throw msg_fmt(
+          "BBDO: cannot extract timestamp value: {}"
+          " bytes left in packet",
+          size);
+    }
+    *reinterpret_cast<timestamp*>(field) = timestamp(get_uint64(buffer));
+    return sizeof(uint64_t);
+  }
+};
+
+template <>
+struct wire<uint32_t> {
+  static constexpr size_t fixed_size = sizeof(uint32_t);
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    put_uint32(*reinterpret_cast<const uint32_t*>(field), buffer);
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    if (size < sizeof(uint32_t)) {
+      log_v2::bbdo()->error(
+          "BBDO: cannot extract uint32_t integer value: {} bytes left in "
+          "packet",
+          size);
+      throw msg_fmt(
+          "BBDO: cannot extract uint32_teger value: {}"
+          " bytes left in packet",
+          size);
+    }
+    *reinterpret_cast<uint32_t*>(field) = get_uint32(buffer);
+    return sizeof(uint32_t);
+  }
+};
+
+template <>
+struct wire<uint64_t> {
+  static constexpr size_t fixed_size = sizeof(uint64_t);
+
+  static void encode(const char* field, std::vector<char>& buffer) {
+    put_uint64(*reinterpret_cast<const uint64_t*>(field), buffer);
+  }
+
+  static uint32_t decode(char* field, const char* buffer, uint32_t size) {
+    if (size < sizeof(uint64_t)) {
+      log_v2::bbdo()->error(
+          "BBDO: cannot extract uint64_t integer value: {} bytes left in "
+          "packet",
+          size);
+      throw msg_fmt(
+          "BBDO: cannot extract uint64_teger value: {}"
+          " bytes left in packet",
+          size);
+    }
+    *reinterpret_cast<uint64_t*>(field) = get_uint64(buffer);
+    return sizeof(uint64_t);
+  }
+};
+}  // namespace
+
+/**
+ *  Constructor.
+ *
+ *  @param[in] info           Event type information, with its mapping.
+ *  @param[in] binary_double  True if doubles are sent as binary values.
+ *  @param[in] strings        Table used to encode strings, may be null. It
+ *                            must live as long as the codec.
+ */
+codec::codec(const io::event_info& info,
+             bool binary_double,
+             string_table* strings)
+    : _fixed_size{0}, _strings{strings} {
+  /* Offsets are computed from an object of the event type, they are the
+   * same for all the objects of the type. */
+  std::unique_ptr<io::data> sample(info.get_operations().constructor());
+  char* base = reinterpret_cast<char*>(sample.get());
+  for (const mapping::entry* current_entry = info.get_mapping();
+       !current_entry->is_null(); ++current_entry) {
+    // Skip entries that should not be serialized.
+    if (!current_entry->get_serialize())
+      continue;
+
+    step s;
+    s.offset = static_cast<char*>(current_entry->get_address(*sample)) - base;
+    switch (current_entry->get_type()) {
+      case mapping::source::BOOL:
+        s.encode = &wire<bool>::encode;
+        s.decode = &wire<bool>::decode;
+        _fixed_size += wire<bool>::fixed_size;
+        break;
+      case mapping::source::DOUBLE:
+        if (binary_double) {
+          s.encode = &wire<double, true>::encode;
+          s.decode = &wire<double, true>::decode;
+          _fixed_size += wire<double, true>::fixed_size;
+        } else {
+          s.encode = &wire<double>::encode;
+          s.decode = &wire<double>::decode;
+        }
+        break;
+      case mapping::source::INT:
+        s.encode = &wire<int>::encode;
+        s.decode = &wire<int>::decode;
+        _fixed_size += wire<int>::fixed_size;
+        break;
+      case mapping::source::SHORT:
+        s.encode = &wire<short>::encode;
+        s.decode = &wire<short>::decode;
+        _fixed_size += wire<short>::fixed_size;
+        break;
+      case mapping::source::STRING:
+        if (strings) {
+          s.encode = nullptr;
+          s.decode = nullptr;
+        } else {
+          s.encode = &wire<std::string>::encode;
+          s.decode = &wire<std::string>::decode;
+        }
+        _fixed_size += wire<std::string>::fixed_size;
+        break;
+      case mapping::source::TIME:
+        s.encode = &wire<timestamp>::encode;
+        s.decode = &wire<timestamp>::decode;
+        _fixed_size += wire<timestamp>::fixed_size;
+        break;
+      case mapping::source::UINT:
+        s.encode = &wire<uint32_t>::encode;
+        s.decode = &wire<uint32_t>::decode;
+        _fixed_size += wire<uint32_t>::fixed_size;
+        break;
+      case mapping::source::ULONG:
+        s.encode = &wire<uint64_t>::encode;
+        s.decode = &wire<uint64_t>::decode;
+        _fixed_size += wire<uint64_t>::fixed_size;
+        break;
+      default:
+        log_v2::bbdo()->error(
+            "BBDO: invalid mapping for object of type '{}': {} is not a "
+            "known type ID",
+            info.get_name(), current_entry->get_type());
+        throw msg_fmt(
+            "BBDO: invalid mapping for object"
+            " of type '{}"
+            "': {}"
+            " is not a known type ID",
+            info.get_name(), current_entry->get_type());
+    }
+    _steps.push_back(s);
+  }
+}
+
+/**
+ *  Serialize the properties of an event.
+ *
+ *  @param[in]  e       Event to serialize, of the codec event type.
+ *  @param[out] buffer  Buffer to which the payload is appended.
+ */
+void codec::serialize(const io::data& e, std::vector<char>& buffer) const {
+  const char* base = reinterpret_cast<const char*>(&e);
+  buffer.reserve(buffer.size() + _fixed_size);
+  for (const step& s : _steps)
+    if (s.encode)
+      s.encode(base + s.offset, buffer);
+    else
+      _strings->encode(
+          *reinterpret_cast<const std::string*>(base + s.offset), buffer);
+}
+
+/**
+ *  Unserialize the properties of an event.
+ *
+ *  @param[out] e       Event to fill, of the codec event type.
+ *  @param[in]  buffer  Payload.
+ *  @param[in]  size    Payload size.
+ */
+void codec::unserialize(io::data& e, const char* buffer, uint32_t size) const {
+  char* base = reinterpret_cast<char*>(&e);
+  for (const step& s : _steps) {
+    uint32_t rb =
+        s.decode ? s.decode(base + s.offset, buffer, size)
+                 : _strings->decode(
+                       *reinterpret_cast<std::string*>(base + s.offset),
+                       buffer, size);
+    buffer += rb;
+    size -= rb;
+  }
+}
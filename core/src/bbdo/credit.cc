@@ -0,0 +1,51 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/bbdo/credit.hh"
+
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::bbdo;
+
+/**
+ *  Default constructor.
+ */
+credit::credit()
+    : io::data(credit::static_type()), acknowledged_events(0), window(0) {}
+
+/**
+ *  Constructor.
+ *
+ * @param acknowledged_events How many events to acknowledge.
+ * @param window              How many events the peer may send without
+ *                            acknowledgement.
+ */
+credit::credit(uint32_t acknowledged_events, uint32_t window)
+    : io::data(credit::static_type()),
+      acknowledged_events(acknowledged_events),
+      window(window) {}
+
+// Mapping.
+mapping::entry const credit::entries[]{
+    mapping::entry(&credit::acknowledged_events, "acknowledged_events"),
+    mapping::entry(&credit::window, "window"), mapping::entry()};
+
+// Operations.
+static io::data* new_credit() {
+  return new credit;
+}
+io::event_info::event_operations const credit::operations = {&new_credit};
@@ -18,8 +18,11 @@
 
 #include "com/centreon/broker/bbdo/factory.hh"
 
+#include <strings.h>
+
 #include "com/centreon/broker/bbdo/acceptor.hh"
 #include "com/centreon/broker/bbdo/connector.hh"
+#include "com/centreon/broker/bbdo/internal.hh"
 #include "com/centreon/broker/config/parser.hh"
 #include "com/centreon/broker/io/protocols.hh"
 #include "com/centreon/broker/log_v2.hh"
@@ -168,5 +171,93 @@ std::list<std::shared_ptr<io::extension>> factory::_extensions(
       retval.push_back(ext);
     }
   }
+
+  /* Binary doubles are handled by the BBDO stream itself. They are used by
+   * default if the peer supports them. */
+  auto it = cfg.params.find("binary_double");
+  if (it == cfg.params.end() ||
+      strncasecmp(it->second.c_str(), "auto", 5) == 0)
+    retval.push_back(std::make_shared<io::extension>(
+        BBDO_BINARY_DOUBLE_EXTENSION, true, false));
+  else if (strncasecmp(it->second.c_str(), "yes", 4) == 0)
+    retval.push_back(std::make_shared<io::extension>(
+        BBDO_BINARY_DOUBLE_EXTENSION, false, true));
+
+  /* Frames of several events are also handled by the BBDO stream. They are
+   * used by default if the peer supports them. */
+  std::shared_ptr<io::extension> batch;
+  it = cfg.params.find("batch");
+  if (it == cfg.params.end() ||
+      strncasecmp(it->second.c_str(), "auto", 5) == 0)
+    batch = std::make_shared<io::extension>(BBDO_BATCH_EXTENSION, true, false);
+  else if (strncasecmp(it->second.c_str(), "yes", 4) == 0)
+    batch = std::make_shared<io::extension>(BBDO_BATCH_EXTENSION, false, true);
+  if (batch) {
+    for (const char* option : {"batch_size", "batch_delay"}) {
+      it = cfg.params.find(option);
+      if (it != cfg.params.end()) {
+        try {
+          batch->mutable_options()[option] =
+              std::to_string(std::stoul(it->second));
+        } catch (const std::exception& e) {
+          log_v2::bbdo()->error(
+              "BBDO: Bad value for {}, it must be an integer.", option);
+        }
+      }
+    }
+    retval.push_back(batch);
+  }
+
+  /* And so are strings tables. */
+  std::shared_ptr<io::extension> strings;
+  it = cfg.params.find("string_table");
+  if (it == cfg.params.end() ||
+      strncasecmp(it->second.c_str(), "auto", 5) == 0)
+    strings = std::make_shared<io::extension>(BBDO_STRING_TABLE_EXTENSION,
+                                              true, false);
+  else if (strncasecmp(it->second.c_str(), "yes", 4) == 0)
+    strings = std::make_shared<io::extension>(BBDO_STRING_TABLE_EXTENSION,
+                                              false, true);
+  if (strings) {
+    it = cfg.params.find("string_table_size");
+    if (it != cfg.params.end()) {
+      try {
+        unsigned long size = std::stoul(it->second);
+        if (size > 0xffff)
+          throw std::out_of_range("string_table_size");
+        strings->mutable_options()["string_table_size"] =
+            std::to_string(size);
+      } catch (const std::exception& e) {
+        log_v2::bbdo()->error(
+            "BBDO: Bad value for string_table_size, it must be an integer "
+            "lower than 65536.");
+      }
+    }
+    retval.push_back(strings);
+  }
+
+  /* And so are credits. */
+  std::shared_ptr<io::extension> window;
+  it = cfg.params.find("ack_window");
+  if (it == cfg.params.end() ||
+      strncasecmp(it->second.c_str(), "auto", 5) == 0)
+    window = std::make_shared<io::extension>(BBDO_ACK_WINDOW_EXTENSION, true,
+                                             false);
+  else if (strncasecmp(it->second.c_str(), "yes", 4) == 0)
+    window = std::make_shared<io::extension>(BBDO_ACK_WINDOW_EXTENSION, false,
+                                             true);
+  if (window) {
+    it = cfg.params.find("ack_window_max");
+    if (it != cfg.params.end()) {
+      try {
+        window->mutable_options()["ack_window_max"] =
+            std::to_string(std::stoul(it->second));
+      } catch (const std::exception& e) {
+        log_v2::bbdo()->error(
+            "BBDO: Bad value for ack_window_max, it must be an integer.");
+      }
+    }
+    retval.push_back(window);
+  }
   return retval;
 }
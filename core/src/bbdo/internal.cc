@@ -19,6 +19,7 @@
 #include "com/centreon/broker/bbdo/internal.hh"
 
 #include "com/centreon/broker/bbdo/ack.hh"
+#include "com/centreon/broker/bbdo/credit.hh"
 #include "com/centreon/broker/bbdo/factory.hh"
 #include "com/centreon/broker/bbdo/stop.hh"
 #include "com/centreon/broker/bbdo/version_response.hh"
@@ -61,6 +62,8 @@ void bbdo::load() {
                    ack::entries);
   e.register_event(io::events::bbdo, bbdo::de_stop, "stop", &stop::operations,
                    stop::entries);
+  e.register_event(io::events::bbdo, bbdo::de_credit, "credit",
+                   &credit::operations, credit::entries);
 
   // Register BBDO protocol.
   io::protocols::instance().reg("BBDO", std::make_shared<bbdo::factory>(), 7,
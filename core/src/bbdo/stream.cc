@@ -24,194 +24,129 @@
 #include <cassert>
 
 #include "com/centreon/broker/bbdo/ack.hh"
+#include "com/centreon/broker/bbdo/codec.hh"
+#include "com/centreon/broker/bbdo/credit.hh"
 #include "com/centreon/broker/bbdo/internal.hh"
 #include "com/centreon/broker/bbdo/stop.hh"
 #include "com/centreon/broker/bbdo/version_response.hh"
+#include "com/centreon/broker/compression/stream.hh"
 #include "com/centreon/broker/exceptions/timeout.hh"
 #include "com/centreon/broker/io/protocols.hh"
 #include "com/centreon/broker/io/raw.hh"
 #include "com/centreon/broker/log_v2.hh"
 #include "com/centreon/broker/misc/misc.hh"
 #include "com/centreon/broker/misc/string.hh"
+#include "com/centreon/broker/multiplexing/muxer.hh"
 #include "com/centreon/exceptions/msg_fmt.hh"
 
 using namespace com::centreon::exceptions;
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::bbdo;
 
-/**
- *  Set a boolean within an object.
- */
-static uint32_t set_boolean(io::data& t,
-                            mapping::entry const& member,
-                            void const* data,
-                            uint32_t size) {
-  if (!size) {
-    log_v2::bbdo()->error(
-        "cannot extract boolean value: 0 bytes left in "
-        "packet");
-    throw msg_fmt(
-        "cannot extract boolean value: "
-        "0 bytes left in packet");
-  }
-  member.set_bool(t, *static_cast<char const*>(data));
-  return 1;
-}
-
-/**
- *  Set a double within an object.
- */
-static uint32_t set_double(io::data& t,
-                           mapping::entry const& member,
-                           void const* data,
-                           uint32_t size) {
-  char const* str(static_cast<char const*>(data));
-  uint32_t len(strlen(str));
-  if (len >= size) {
-    log_v2::bbdo()->error(
-        "cannot extract double value: not terminating '\\0' in remaining "
-        "{} bytes of packet",
-        size);
-    throw msg_fmt(
-        "cannot extract double value: "
-        "not terminating '\\0' in remaining {} bytes of packet",
-        size);
-  }
-  member.set_double(t, strtod(str, nullptr));
-  return len + 1;
-}
-
-/**
- *  Set an integer within an object.
- */
-static uint32_t set_integer(io::data& t,
-                            mapping::entry const& member,
-                            void const* data,
-                            uint32_t size) {
-  if (size < sizeof(uint32_t)) {
-    log_v2::bbdo()->error(
-        "cannot extract integer value: {} bytes left in packet", size);
-    throw msg_fmt(
-        "BBDO: cannot extract integer value: {}"
-        " bytes left in packet",
-        size);
-  }
-  member.set_int(t, ntohl(*static_cast<uint32_t const*>(data)));
-  return sizeof(uint32_t);
-}
+/* Type of the packets containing several events. */
+constexpr uint32_t batch_type =
+    io::events::data_type<io::events::bbdo, bbdo::de_batch>::value;
+/* The window advertised to the peer lets it send the events we read in this
+ * duration (in seconds) at the current rate. */
+constexpr double window_duration = 2.0;
+/* Maximum count of write marks kept to measure the ack round trip time. */
+constexpr size_t max_write_marks = 1024;
 
 /**
- *  Set a short within an object.
- */
-static uint32_t set_short(io::data& t,
-                          mapping::entry const& member,
-                          void const* data,
-                          uint32_t size) {
-  if (size < sizeof(uint16_t)) {
-    log_v2::bbdo()->error(
-        "BBDO: cannot extract short value: {} bytes left in packet", size);
-    throw msg_fmt(
-        "BBDO: cannot extract short value: {}"
-        " bytes left in packet",
-        size);
-  }
-  member.set_short(t, ntohs(*static_cast<uint16_t const*>(data)));
-  return sizeof(uint16_t);
-}
-
-/**
- *  Set a string within an object.
+ *  Write a BBDO header.
+ *
+ *  @param[out] header          Buffer of BBDO_HEADER_SIZE bytes.
+ *  @param[in]  size            Size of the payload following the header.
+ *  @param[in]  type            Type of the packet.
+ *  @param[in]  source_id       Source id.
+ *  @param[in]  destination_id  Destination id.
  */
-static uint32_t set_string(io::data& t,
-                           mapping::entry const& member,
-                           void const* data,
-                           uint32_t size) {
-  char const* str(static_cast<char const*>(data));
-  uint32_t len(strlen(str));
-  if (len >= size) {
-    log_v2::bbdo()->error(
-        "BBDO: cannot extract string value: no terminating '\\0' in remaining "
-        "{} bytes left in packet",
-        size);
-
-    throw msg_fmt(
-        "BBDO: cannot extract string value: "
-        "no terminating '\\0' in remaining {} bytes of packet",
-        size);
-  }
-  member.set_string(t, str);
-  return len + 1;
+static void write_header(char* header,
+                         uint16_t size,
+                         uint32_t type,
+                         uint32_t source_id,
+                         uint32_t destination_id) {
+  *(reinterpret_cast<uint16_t*>(header + 2)) = htons(size);
+  *(reinterpret_cast<uint32_t*>(header + 4)) = htonl(type);
+  *(reinterpret_cast<uint32_t*>(header + 8)) = htonl(source_id);
+  *(reinterpret_cast<uint32_t*>(header + 12)) = htonl(destination_id);
+
+  *(reinterpret_cast<uint16_t*>(header)) =
+      htons(misc::crc16_ccitt(header + 2, BBDO_HEADER_SIZE - 2));
 }
 
 /**
- *  Set a timestamp within an object.
+ *  Write the BBDO header of an event.
+ *
+ *  @param[out] header  Buffer of BBDO_HEADER_SIZE bytes.
+ *  @param[in]  size    Size of the payload following the header.
+ *  @param[in]  e       Serialized event.
  */
-static uint32_t set_timestamp(io::data& t,
-                              mapping::entry const& member,
-                              void const* data,
-                              uint32_t size) {
-  if (size < sizeof(uint64_t)) {
-    log_v2::bbdo()->error(
-        "BBDO: cannot extract timestamp value: {} bytes left in packet", size);
-    throw msg_fmt(
-        "BBDO: cannot extract timestamp value: {}"
-        " bytes left in packet",
-        size);
-  }
-  uint32_t const* ptr(static_cast<uint32_t const*>(data));
-  uint64_t val(ntohl(*ptr));
-  ++ptr;
-  val <<= 32;
-  val |= ntohl(*ptr);
-  member.set_time(t, val);
-  return sizeof(uint64_t);
+static void write_header(char* header, uint16_t size, const io::data& e) {
+  write_header(header, size, e.type(), e.source_id, e.destination_id);
 }
 
 /**
- *  Set an uint32_teger within an object.
+ *  Write the BBDO headers of a serialized event. The payload is already in
+ *  the buffer, after room left for its header. It is split into several
+ *  packets if it is too big.
+ *
+ *  @param[in,out] data   Buffer.
+ *  @param[in]     start  Position of the header in the buffer.
+ *  @param[in]     e      Serialized event.
  */
-static uint32_t set_uint(io::data& t,
-                         mapping::entry const& member,
-                         void const* data,
-                         uint32_t size) {
-  if (size < sizeof(uint32_t)) {
-    log_v2::bbdo()->error(
-        "BBDO: cannot extract uint32_t integer value: {} bytes left in packet",
-        size);
-    throw msg_fmt(
-        "BBDO: cannot extract uint32_teger value: {}"
-        " bytes left in packet",
-        size);
+static void write_packets(std::vector<char>& data,
+                          size_t start,
+                          const io::data& e) {
+  size_t size = data.size() - start - BBDO_HEADER_SIZE;
+  if (size < 0xffff)
+    write_header(&data[start], size, e);
+  else {
+    // Packet splitting: 0xffff bytes packets followed by the remaining.
+    std::vector<char> content(data.begin() + start + BBDO_HEADER_SIZE,
+                              data.end());
+    data.resize(start);
+    data.reserve(start + content.size() +
+                 (content.size() / 0xffff + 1) * BBDO_HEADER_SIZE);
+    auto it = content.begin();
+    for (;;) {
+      size_t len = std::min<size_t>(content.end() - it, 0xffff);
+      size_t h = data.size();
+      data.resize(h + BBDO_HEADER_SIZE);
+      write_header(&data[h], len, e);
+      data.insert(data.end(), it, it + len);
+      it += len;
+      if (len < 0xffff)
+        break;
+    }
   }
-  member.set_uint(t, ntohl(*static_cast<uint32_t const*>(data)));
-  return sizeof(uint32_t);
 }
 
 /**
- *  Set an uint64_teger within an object.
+ *  Get the codec of an event type, it is built the first time the type is
+ *  met.
+ *
+ *  @param[in] type    Event type.
+ *  @param[in] info    Event information.
+ *  @param[in] codecs  Codecs cache, one is used for reading and another one
+ *                     for writing, so that both can be done from different
+ *                     threads.
+ *  @param[in] strings The strings table of the same direction, may be null.
+ *
+ *  @return The codec.
  */
-static uint32_t set_ulong(io::data& t,
-                          mapping::entry const& member,
-                          void const* data,
-                          uint32_t size) {
-  if (size < sizeof(uint64_t)) {
-    log_v2::bbdo()->error(
-        "BBDO: cannot extract uint64_t integer value: {} bytes left in packet",
-        size);
-    throw msg_fmt(
-        "BBDO: cannot extract uint64_teger value: {}"
-        " bytes left in packet",
-        size);
-  }
-
-  const uint32_t* ptr(static_cast<uint32_t const*>(data));
-  uint64_t val(ntohl(*ptr));
-  ++ptr;
-  val <<= 32;
-  val |= ntohl(*ptr);
-
-  member.set_ulong(t, val);
-  return sizeof(uint64_t);
+const codec& stream::_get_codec(
+    uint32_t type,
+    const io::event_info& info,
+    std::unordered_map<uint32_t, std::unique_ptr<codec>>& codecs,
+    string_table* strings) {
+  auto it = codecs.find(type);
+  if (it == codecs.end())
+    it = codecs
+             .emplace(type, std::make_unique<codec>(info, _binary_double,
+                                                    strings))
+             .first;
+  return *it->second;
 }
 
 /**
@@ -225,11 +160,11 @@ static uint32_t set_ulong(io::data& t,
  *
  *  @return Event.
  */
-static io::data* unserialize(uint32_t event_type,
-                             uint32_t source_id,
-                             uint32_t destination_id,
-                             char const* buffer,
-                             uint32_t size) {
+io::data* stream::_unserialize(uint32_t event_type,
+                               uint32_t source_id,
+                               uint32_t destination_id,
+                               char const* buffer,
+                               uint32_t size) {
   // Get event info (operations and mapping).
   io::event_info const* info(io::events::instance().get_event_info(event_type));
   if (info) {
@@ -238,53 +173,19 @@ static io::data* unserialize(uint32_t event_type,
     if (t) {
       t->source_id = source_id;
       t->destination_id = destination_id;
-      // Browse all mapping to unserialize the object.
-      for (const mapping::entry* current_entry = info->get_mapping();
-           !current_entry->is_null(); ++current_entry)
-        // Skip entries that should not be serialized.
-        if (current_entry->get_serialize()) {
-          uint32_t rb;
-          switch (current_entry->get_type()) {
-            case mapping::source::BOOL:
-              rb = set_boolean(*t, *current_entry, buffer, size);
-              break;
-            case mapping::source::DOUBLE:
-              rb = set_double(*t, *current_entry, buffer, size);
-              break;
-            case mapping::source::INT:
-              rb = set_integer(*t, *current_entry, buffer, size);
-              break;
-            case mapping::source::SHORT:
-              rb = set_short(*t, *current_entry, buffer, size);
-              break;
-            case mapping::source::STRING:
-              rb = set_string(*t, *current_entry, buffer, size);
-              break;
-            case mapping::source::TIME:
-              rb = set_timestamp(*t, *current_entry, buffer, size);
-              break;
-            case mapping::source::UINT:
-              rb = set_uint(*t, *current_entry, buffer, size);
-              break;
-            case mapping::source::ULONG:
-              rb = set_ulong(*t, *current_entry, buffer, size);
-              break;
-
-            default:
-              log_v2::bbdo()->error(
-                  "BBDO: invalid mapping for object of type '{0}': {1} is not "
-                  "a known type ID",
-                  info->get_name(), current_entry->get_type());
-              throw msg_fmt(
-                  "BBDO: invalid mapping for "
-                  "object of type '{}"
-                  "': {}"
-                  " is not a known type ID",
-                  info->get_name(), current_entry->get_type());
-          }
-          buffer += rb;
-          size -= rb;
-        }
+      uint64_t unresolved = _read_strings ? _read_strings->unresolved() : 0;
+      _get_codec(event_type, *info, _read_codecs, _read_strings.get())
+          .unserialize(*t, buffer, size);
+      /* An event with a lost string is dropped rather than passed on with an
+       * empty host name or output. It is returned as a null event, like an
+       * unknown event, so that acknowledgements still count it. */
+      if (_read_strings && _read_strings->unresolved() != unresolved) {
+        log_v2::bbdo()->error(
+            "BBDO: event of type {} refers to strings not known, it is "
+            "dropped",
+            event_type);
+        return nullptr;
+      }
       return t.release();
     } else {
       log_v2::bbdo()->error(
@@ -306,216 +207,145 @@ static io::data* unserialize(uint32_t event_type,
 }
 
 /**
- *  Get a boolean from an object.
+ *  Serialize an event in the BBDO protocol.
+ *
+ *  @param[in]  e     Event to serialize.
+ *  @param[out] data  Buffer to which the serialized event is appended.
+ *
+ *  @return true if the event has been serialized.
  */
-static void get_boolean(io::data const& t,
-                        mapping::entry const& member,
-                        std::vector<char>& buffer) {
-  char c(member.get_bool(t) ? 1 : 0);
-  buffer.push_back(c);
-}
+bool stream::_serialize(const io::data& e, std::vector<char>& data) {
+  // Get event info (mapping).
+  const io::event_info* info = io::events::instance().get_event_info(e.type());
+  if (info) {
+    // The payload is written after room left for its header.
+    size_t start = data.size();
+    data.resize(start + BBDO_HEADER_SIZE);
+    _get_codec(e.type(), *info, _write_codecs, _write_strings.get())
+        .serialize(e, data);
+    write_packets(data, start, e);
+    return true;
+  } else {
+    log_v2::bbdo()->info(
+        "BBDO: cannot serialize event of ID {}: event was not registered and "
+        "will therefore be ignored",
+        e.type());
+  }
 
-/**
- *  Get a double from an object.
- */
-static void get_double(io::data const& t,
-                       mapping::entry const& member,
-                       std::vector<char>& buffer) {
-  char str[32];
-  size_t strsz(snprintf(str, sizeof(str), "%f", member.get_double(t)) + 1);
-  if (strsz > sizeof(str))
-    strsz = sizeof(str);
-  std::copy(str, str + strsz, std::back_inserter(buffer));
+  return false;
 }
 
 /**
- *  Get an integer from an object.
+ *  Append an event to the pending buffer. It is added to the open frame if
+ *  it has the same source and destination and if there is room for it,
+ *  otherwise a new frame is opened. Events too big for a frame are written
+ *  as usual packets.
+ *
+ *  @param[in] e  Event to serialize.
+ *
+ *  @return true if the event has been serialized.
  */
-static void get_integer(io::data const& t,
-                        mapping::entry const& member,
-                        std::vector<char>& buffer) {
-  uint32_t value(htonl(member.get_int(t)));
-  char* v(reinterpret_cast<char*>(&value));
-  std::copy(v, v + sizeof(value), std::back_inserter(buffer));
-}
+bool stream::_batch_event(const io::data& e) {
+  const io::event_info* info = io::events::instance().get_event_info(e.type());
+  if (!info) {
+    log_v2::bbdo()->info(
+        "BBDO: cannot serialize event of ID {}: event was not registered and "
+        "will therefore be ignored",
+        e.type());
+    return false;
+  }
 
-/**
- *  Get a short from an object.
- */
-static void get_short(io::data const& t,
-                      mapping::entry const& member,
-                      std::vector<char>& buffer) {
-  uint16_t value(htons(member.get_short(t)));
-  char* v(reinterpret_cast<char*>(&value));
-  std::copy(v, v + sizeof(value), std::back_inserter(buffer));
-}
+  std::vector<char>& data = _pending->get_buffer();
+  if (data.empty())
+    _pending_since = std::chrono::steady_clock::now();
+
+  _record.clear();
+  _get_codec(e.type(), *info, _write_codecs, _write_strings.get())
+      .serialize(e, _record);
+  constexpr size_t max_frame = 0xfffe;
+  if (_record.size() + BBDO_BATCH_RECORD_HEADER_SIZE > max_frame) {
+    /* The event is not serialized again, its strings are already recorded
+     * in the strings table. */
+    _close_frame();
+    size_t start = data.size();
+    data.resize(start + BBDO_HEADER_SIZE);
+    data.insert(data.end(), _record.begin(), _record.end());
+    write_packets(data, start, e);
+    return true;
+  }
 
-/**
- *  Get a string from an object.
- */
-static void get_string(io::data const& t,
-                       mapping::entry const& member,
-                       std::vector<char>& buffer) {
-  std::string const& tmp(member.get_string(t));
-  std::copy(tmp.c_str(), tmp.c_str() + tmp.size() + 1,
-            std::back_inserter(buffer));
+  if (_frame_pos != std::string::npos &&
+      (_frame_source_id != e.source_id ||
+       _frame_destination_id != e.destination_id ||
+       data.size() - _frame_pos - BBDO_HEADER_SIZE +
+               BBDO_BATCH_RECORD_HEADER_SIZE + _record.size() >
+           max_frame))
+    _close_frame();
+
+  if (_frame_pos == std::string::npos) {
+    _frame_pos = data.size();
+    _frame_source_id = e.source_id;
+    _frame_destination_id = e.destination_id;
+    data.resize(_frame_pos + BBDO_HEADER_SIZE);
+    ++_frames_written;
+  }
+
+  size_t pos = data.size();
+  data.resize(pos + BBDO_BATCH_RECORD_HEADER_SIZE);
+  *(reinterpret_cast<uint32_t*>(&data[pos])) = htonl(e.type());
+  *(reinterpret_cast<uint16_t*>(&data[pos + 4])) = htons(_record.size());
+  data.insert(data.end(), _record.begin(), _record.end());
+  ++_frame_events_written;
+  return true;
 }
 
 /**
- *  Get a timestamp from an object.
+ *  Write the header of the open frame, if any.
  */
-static void get_timestamp(io::data const& t,
-                          mapping::entry const& member,
-                          std::vector<char>& buffer) {
-  uint64_t ts(member.get_time(t).get_time_t());
-  uint32_t high{htonl(ts >> 32)};
-  uint32_t low{htonl(ts & 0xffffffff)};
-  char* vh{reinterpret_cast<char*>(&high)};
-  char* vl{reinterpret_cast<char*>(&low)};
-  std::copy(vh, vh + sizeof(high), std::back_inserter(buffer));
-  std::copy(vl, vl + sizeof(low), std::back_inserter(buffer));
+void stream::_close_frame() {
+  if (_frame_pos != std::string::npos) {
+    std::vector<char>& data = _pending->get_buffer();
+    write_header(&data[_frame_pos], data.size() - _frame_pos - BBDO_HEADER_SIZE,
+                 batch_type, _frame_source_id, _frame_destination_id);
+    _frame_pos = std::string::npos;
+  }
 }
 
 /**
- *  Get an uint32_teger from an object.
+ *  Write the pending buffer to the substream.
  */
-static void get_uint(io::data const& t,
-                     mapping::entry const& member,
-                     std::vector<char>& buffer) {
-  uint32_t value{htonl(member.get_uint(t))};
-  char* v{reinterpret_cast<char*>(&value)};
-  std::copy(v, v + sizeof(value), std::back_inserter(buffer));
+void stream::_flush_pending() {
+  _close_frame();
+  if (!_pending->empty()) {
+    log_v2::bbdo()->trace("BBDO: writing {} bytes of frames", _pending->size());
+    /* The buffer is now owned by the substream, a new one is used. */
+    std::shared_ptr<io::raw> pending{std::make_shared<io::raw>()};
+    std::swap(pending, _pending);
+    _substream->write(pending);
+  }
 }
 
 /**
- *  Get an uint64_teger from an object.
+ *  Write the pending buffer to the substream if it is big enough, if it
+ *  waits for too long or if it fills the window of the peer: the peer cannot
+ *  send credits for events it did not get.
  */
-static void get_ulong(io::data const& t,
-                      mapping::entry const& member,
-                      std::vector<char>& buffer) {
-  uint64_t value{member.get_ulong(t)};
-  uint32_t high{htonl(value >> 32)};
-  uint32_t low{htonl(value & 0xffffffff)};
-  char* vh{reinterpret_cast<char*>(&high)};
-  char* vl{reinterpret_cast<char*>(&low)};
-  std::copy(vh, vh + sizeof(high), std::back_inserter(buffer));
-  std::copy(vl, vl + sizeof(low), std::back_inserter(buffer));
+void stream::_write_pending() {
+  if (!_pending->empty() &&
+      (_pending->size() >= _batch_size ||
+       std::chrono::steady_clock::now() - _pending_since >= _batch_delay ||
+       _window_full()))
+    _flush_pending();
 }
 
 /**
- *  Serialize an event in the BBDO protocol.
+ *  Tell if the window given by the peer is full.
  *
- *  @param[in] e  Event to serialize.
- *
- *  @return Serialized event.
+ *  @return true if no more events should be sent before credits come.
  */
-static io::raw* serialize(const io::data& e) {
-  std::deque<std::vector<char>> queue;
-
-  // Get event info (mapping).
-  const io::event_info* info = io::events::instance().get_event_info(e.type());
-  if (info) {
-    // Serialization buffer.
-    queue.emplace_back(std::vector<char>());
-    auto* header = &queue.back();
-    header->resize(BBDO_HEADER_SIZE);
-    queue.emplace_back(std::vector<char>());
-    auto* content = &queue.back();
-
-    // Serialize properties of the object.
-    for (mapping::entry const* current_entry(info->get_mapping());
-         !current_entry->is_null(); ++current_entry) {
-      // Skip entries that should not be serialized.
-      if (current_entry->get_serialize())
-        switch (current_entry->get_type()) {
-          case mapping::source::BOOL:
-            get_boolean(e, *current_entry, *content);
-            break;
-          case mapping::source::DOUBLE:
-            get_double(e, *current_entry, *content);
-            break;
-          case mapping::source::INT:
-            get_integer(e, *current_entry, *content);
-            break;
-          case mapping::source::SHORT:
-            get_short(e, *current_entry, *content);
-            break;
-          case mapping::source::STRING:
-            get_string(e, *current_entry, *content);
-            break;
-          case mapping::source::TIME:
-            get_timestamp(e, *current_entry, *content);
-            break;
-          case mapping::source::UINT:
-            get_uint(e, *current_entry, *content);
-            break;
-          case mapping::source::ULONG:
-            get_ulong(e, *current_entry, *content);
-            break;
-          default:
-            log_v2::bbdo()->error(
-                "BBDO: invalid mapping for object of type '{}': {} is not a "
-                "known type ID",
-                info->get_name(), current_entry->get_type());
-            throw msg_fmt(
-                "BBDO: invalid mapping for object"
-                " of type '{}"
-                "': {}"
-                " is not a known type ID",
-                info->get_name(), current_entry->get_type());
-        }
-
-      // Packet splitting.
-      while (content->size() >= 0xffff) {
-        queue.emplace_back(std::vector<char>());
-        auto* new_header = &queue.back();
-        new_header->resize(BBDO_HEADER_SIZE);
-        queue.emplace_back(content->begin() + 0xffff, content->end());
-        content->resize(0xffff);
-        auto* new_content = &queue.back();
-        *(reinterpret_cast<uint16_t*>(header->data() + 2)) = 0xffff;
-        *(reinterpret_cast<uint32_t*>(header->data() + 4)) = htonl(e.type());
-        *(reinterpret_cast<uint32_t*>(header->data() + 8)) = htonl(e.source_id);
-        *(reinterpret_cast<uint32_t*>(header->data() + 12)) =
-            htonl(e.destination_id);
-
-        *(reinterpret_cast<uint16_t*>(header->data())) =
-            htons(misc::crc16_ccitt(header->data() + 2, BBDO_HEADER_SIZE - 2));
-        content = new_content;
-        header = new_header;
-      }
-    }
-
-    *(reinterpret_cast<uint16_t*>(header->data() + 2)) = htons(content->size());
-    *(reinterpret_cast<uint32_t*>(header->data() + 4)) = htonl(e.type());
-    *(reinterpret_cast<uint32_t*>(header->data() + 8)) = htonl(e.source_id);
-    *(reinterpret_cast<uint32_t*>(header->data() + 12)) =
-        htonl(e.destination_id);
-
-    *(reinterpret_cast<uint16_t*>(header->data())) =
-        htons(misc::crc16_ccitt(header->data() + 2, BBDO_HEADER_SIZE - 2));
-
-    // Finalization: concatenation of all the vectors in the queue.
-    size_t size = 0;
-    for (auto& v : queue)
-      size += v.size();
-
-    // Serialization buffer.
-    std::unique_ptr<io::raw> buffer(new io::raw);
-    std::vector<char>& data(buffer->get_buffer());
-    data.reserve(size);
-    for (auto& v : queue)
-      data.insert(data.end(), v.begin(), v.end());
-
-    return buffer.release();
-  } else {
-    log_v2::bbdo()->info(
-        "BBDO: cannot serialize event of ID {}: event was not registered and "
-        "will therefore be ignored",
-        e.type());
-  }
-
-  return nullptr;
+bool stream::_window_full() const {
+  return _ack_window && _peer_window &&
+         _events_written - _events_acknowledged_by_peer >= _peer_window;
 }
 
 /**
@@ -529,11 +359,32 @@ stream::stream(bool is_input,
       _coarse(false),
       _negotiate{true},
       _negotiated{false},
+      _binary_double{false},
+      _batch{false},
       _timeout(5),
       _acknowledged_events{0},
       _ack_limit(1000),
       _events_received_since_last_ack(0),
-      _extensions{extensions} {}
+      _ack_delay{1000},
+      _last_ack{std::chrono::steady_clock::now()},
+      _extensions{extensions},
+      _pending{std::make_shared<io::raw>()},
+      _frame_pos{std::string::npos},
+      _frame_source_id{0},
+      _frame_destination_id{0},
+      _batch_size{16384},
+      _batch_delay{50},
+      _frames_written{0},
+      _frame_events_written{0},
+      _ack_window{false},
+      _window_max{100000},
+      _window_sent{0},
+      _read_rate{0.0},
+      _peer_window{0},
+      _events_written{0},
+      _events_acknowledged_by_peer{0},
+      _window_waits{0},
+      _ack_rtt{0} {}
 
 /**
  * @brief All the mecanism behind this stream is stopped once this method is
@@ -557,8 +408,21 @@ int32_t stream::stop() {
     }
   }
 
+  try {
+    _flush_pending();
+  } catch (const std::exception& e) {
+    log_v2::bbdo()->error("BBDO: unable to send the last events to peer: {}",
+                          e.what());
+  }
+
   _substream->stop();
 
+  if (!_held.empty())
+    log_v2::bbdo()->info(
+        "BBDO: {} events read while waiting for credits are not acknowledged, "
+        "the peer keeps them",
+        _held.size());
+
   /* We acknowledge peer about received events. */
   log_v2::core()->info("bbdo stream stopped with {} events acknowledged",
                        _events_received_since_last_ack);
@@ -577,6 +441,7 @@ int32_t stream::stop() {
  *  @return Number of acknowledged events.
  */
 int stream::flush() {
+  _flush_pending();
   _substream->flush();
   int retval = _acknowledged_events;
   _acknowledged_events -= retval;
@@ -599,18 +464,33 @@ void stream::_send_event_stop_and_wait_for_ack() {
     std::shared_ptr<io::data> d;
     time_t deadline = time(nullptr) + 5;
 
-    _read_any(d, deadline);
-    if (!d || d->type() != ack::static_type()) {
-      std::string msg;
-      if (d)
-        msg = fmt::format(
-            "BBDO: wrong message received (type {}) - expected ack event",
-            d->type());
-      else
-        msg = fmt::format(
-            "BBDO: no message received from peer. Cannot acknowledge properly "
-            "waiting messages before stopping.");
-      log_v2::bbdo()->error(msg);
+    /* Events sent by the peer before its ack are skipped. They are not
+     * acknowledged, so the peer keeps them. */
+    uint32_t skipped = 0;
+    while (_read_any(d, deadline)) {
+      if (d && (d->type() == ack::static_type() ||
+                d->type() == credit::static_type()))
+        break;
+      if (!_handle_control(d))
+        ++skipped;
+      d.reset();
+    }
+    if (skipped)
+      log_v2::bbdo()->info(
+          "BBDO: {} events received from peer {} while waiting for its ack "
+          "are ignored",
+          skipped, peer());
+
+    if (!d)
+      log_v2::bbdo()->error(
+          "BBDO: no message received from peer. Cannot acknowledge properly "
+          "waiting messages before stopping.");
+    else if (d->type() == credit::static_type()) {
+      log_v2::bbdo()->info(
+          "BBDO: received credit for {} events before finishing",
+          std::static_pointer_cast<credit const>(d)->acknowledged_events);
+      acknowledge_events(
+          std::static_pointer_cast<credit const>(d)->acknowledged_events);
     } else {
       log_v2::bbdo()->info(
           "BBDO: received acknowledgement for {} events before finishing",
@@ -621,6 +501,31 @@ void stream::_send_event_stop_and_wait_for_ack() {
   }
 }
 
+/**
+ *  Get the names announced for the codecs accepted by a compression
+ *  extension.
+ *
+ *  @param[in] ext  The compression extension.
+ *
+ *  @return The names, separated by spaces.
+ */
+static std::string compression_codec_names(const io::extension& ext) {
+  std::string retval;
+  auto it = ext.options().find("codecs");
+  if (it == ext.options().end())
+    return retval;
+  for (auto& codec : misc::string::split(it->second, ' ')) {
+    std::string name{BBDO_COMPRESSION_CODEC_PREFIX};
+    for (char c : codec)
+      name.push_back(toupper(c));
+    retval.append(" ").append(name);
+    auto dict = ext.options().find("zstd_dictionary_id");
+    if (codec == "zstd" && dict != ext.options().end())
+      retval.append(" ").append(name).append("_DICT_").append(dict->second);
+  }
+  return retval;
+}
+
 std::string stream::_get_extension_names(bool mandatory) const {
   std::string retval;
   if (mandatory)
@@ -637,11 +542,92 @@ std::string stream::_get_extension_names(bool mandatory) const {
         if (!retval.empty())
           retval.append(" ");
         retval.append(e->name());
+        if (e->name() == BBDO_COMPRESSION_EXTENSION)
+          retval.append(compression_codec_names(*e));
       }
     }
   return retval;
 }
 
+/**
+ *  Insert a compression stream using the first codec accepted by both peers
+ *  in the order zstd, lz4, zlib. Peers announcing no codec (older versions)
+ *  never apply the compression extension, so neither do we.
+ *
+ *  @param[in] ext             The compression extension.
+ *  @param[in] peer_ext        Extensions announced by the peer.
+ *  @param[in] our_ext         Extensions announced by us.
+ *  @param[in] running_config  Names of the streams already in use.
+ *  @param[in] is_acceptor     true if we negotiate second.
+ *
+ *  @return true if the compression is used.
+ */
+bool stream::_negotiate_compression(
+    const io::extension& ext,
+    const std::list<std::string>& peer_ext,
+    const std::list<std::string>& our_ext,
+    const std::list<std::string>& running_config,
+    bool is_acceptor) {
+  auto announced = [&](const std::string& name) {
+    return std::find(peer_ext.begin(), peer_ext.end(), name) !=
+               peer_ext.end() &&
+           std::find(our_ext.begin(), our_ext.end(), name) != our_ext.end();
+  };
+
+  std::string codec;
+  std::string name;
+  for (const char* c : {"zstd", "lz4", "zlib"}) {
+    name = BBDO_COMPRESSION_CODEC_PREFIX;
+    for (const char* p = c; *p; ++p)
+      name.push_back(toupper(*p));
+    if (announced(name)) {
+      codec = c;
+      break;
+    }
+  }
+  if (codec.empty()) {
+    log_v2::bbdo()->info(
+        "BBDO: no compression codec is supported by both peers, compression "
+        "is not applied");
+    return false;
+  }
+  if (std::find(running_config.begin(), running_config.end(),
+                "compression") != running_config.end()) {
+    log_v2::bbdo()->info("BBDO: extension '{}' already configured",
+                         ext.name());
+    return true;
+  }
+
+  std::unordered_map<std::string, std::string> options{ext.options()};
+  options["codec"] = codec;
+  auto dict = options.find("zstd_dictionary_id");
+  if (codec != "zstd" || dict == options.end() ||
+      !announced(fmt::format("{}_DICT_{}", name, dict->second)))
+    options.erase("compression_dictionary");
+
+  for (auto& p : io::protocols::instance())
+    if (p.first == "compression") {
+      auto s = p.second.endpntfactry->new_stream(_substream, is_acceptor,
+                                                 options);
+      /* The peer may already have sent compressed data after its welcome
+       * packet. */
+      if (!_packet.empty()) {
+        auto r = std::make_shared<io::raw>();
+        r->resize(_packet.size());
+        _packet.peek(r->data(), r->size());
+        _packet.clear();
+        std::static_pointer_cast<compression::stream>(s)->unread(r);
+      }
+      set_substream(s);
+      log_v2::bbdo()->info("BBDO: compressing data with {}{}", codec,
+                           options.count("compression_dictionary")
+                               ? " and a dictionary"
+                               : "");
+      return true;
+    }
+  return false;
+}
+
 /**
  *  Negotiate features with peer.
  *
@@ -732,7 +718,69 @@ void stream::negotiate(stream::negotiation_type neg) {
   log_v2::bbdo()->info("BBDO: we have extensions '{}' and peer has '{}'",
                        extensions, v->extensions);
   std::list<std::string> peer_ext(misc::string::split(v->extensions, ' '));
+  std::list<std::string> our_ext(misc::string::split(extensions, ' '));
   for (auto& ext : _extensions) {
+    /* These extensions are handled by the BBDO stream itself, they are
+     * enabled only if both peers announced them. */
+    if (ext->name() == BBDO_BINARY_DOUBLE_EXTENSION ||
+        ext->name() == BBDO_BATCH_EXTENSION ||
+        ext->name() == BBDO_STRING_TABLE_EXTENSION ||
+        ext->name() == BBDO_ACK_WINDOW_EXTENSION ||
+        ext->name() == BBDO_COMPRESSION_EXTENSION) {
+      bool enabled =
+          std::find(peer_ext.begin(), peer_ext.end(), ext->name()) !=
+              peer_ext.end() &&
+          std::find(our_ext.begin(), our_ext.end(), ext->name()) !=
+              our_ext.end();
+      if (ext->name() == BBDO_BINARY_DOUBLE_EXTENSION) {
+        _binary_double = enabled;
+        // Codecs depend on the doubles encoding.
+        _read_codecs.clear();
+        _write_codecs.clear();
+      } else if (ext->name() == BBDO_STRING_TABLE_EXTENSION) {
+        _flush_pending();
+        uint16_t capacity = 4096;
+        auto it = ext->options().find("string_table_size");
+        if (it != ext->options().end())
+          capacity = std::stoul(it->second);
+        if (enabled)
+          set_string_table(capacity);
+        else {
+          _read_strings.reset();
+          _write_strings.reset();
+          _read_codecs.clear();
+          _write_codecs.clear();
+        }
+      } else if (ext->name() == BBDO_COMPRESSION_EXTENSION) {
+        enabled = enabled && _negotiate_compression(*ext, peer_ext, our_ext,
+                                                    running_config,
+                                                    neg == negotiate_second);
+      } else if (ext->name() == BBDO_ACK_WINDOW_EXTENSION) {
+        _ack_window = enabled;
+        _peer_window = 0;
+        auto it = ext->options().find("ack_window_max");
+        if (it != ext->options().end())
+          _window_max = std::stoul(it->second);
+      } else {
+        _flush_pending();
+        _batch = enabled;
+        auto it = ext->options().find("batch_size");
+        if (it != ext->options().end())
+          _batch_size = std::stoul(it->second);
+        it = ext->options().find("batch_delay");
+        if (it != ext->options().end())
+          _batch_delay = std::chrono::milliseconds(std::stoul(it->second));
+      }
+      if (enabled)
+        log_v2::bbdo()->info("BBDO: applying extension '{}'", ext->name());
+      else if (ext->is_mandatory())
+        log_v2::bbdo()->error(
+            "BBDO: extension '{}' is set to 'yes' in the configuration but "
+            "cannot be activated because of peer configuration.",
+            ext->name());
+      continue;
+    }
+
     // Find matching extension in peer extension list.
     std::list<std::string>::const_iterator peer_it{
         std::find(peer_ext.begin(), peer_ext.end(), ext->name())};
@@ -787,6 +835,10 @@ void stream::negotiate(stream::negotiation_type neg) {
   // Stream has now negotiated.
   _negotiated = true;
   log_v2::bbdo()->trace("Negotiation done.");
+
+  // The peer gets its first window.
+  if (_ack_window)
+    send_event_acknowledgement();
 }
 
 std::list<std::string> stream::get_running_config() {
@@ -799,6 +851,77 @@ std::list<std::string> stream::get_running_config() {
   return retval;
 }
 
+/**
+ *  Handle a control message received from the peer.
+ *
+ *  @param[in] d  Event read.
+ *
+ *  @return true if d was a control message.
+ */
+bool stream::_handle_control(const std::shared_ptr<io::data>& d) {
+  uint32_t event_id(!d ? 0 : d->type());
+  if ((event_id >> 16) != io::events::bbdo)
+    return false;
+
+  // Version response.
+  if ((event_id & 0xffff) == 1) {
+    std::shared_ptr<version_response> version(
+        std::static_pointer_cast<version_response>(d));
+    if (version->bbdo_major != BBDO_VERSION_MAJOR) {
+      log_v2::bbdo()->error(
+          "BBDO: peer is using protocol version {0}.{1}.{2} , whereas we're "
+          "using protocol version "
+          "{3}.{4}.{5}",
+          version->bbdo_major, version->bbdo_minor, version->bbdo_patch,
+          BBDO_VERSION_MAJOR, BBDO_VERSION_MINOR, BBDO_VERSION_PATCH);
+      throw msg_fmt(
+          "BBDO: peer is using protocol version {}.{}.{} "
+          "whereas we're using protocol version {}.{}.{}",
+          version->bbdo_major, version->bbdo_minor, version->bbdo_patch,
+          BBDO_VERSION_MAJOR, BBDO_VERSION_MINOR, BBDO_VERSION_PATCH);
+    }
+    log_v2::bbdo()->info(
+        "BBDO: peer is using protocol version {}.{}.{} , we're using "
+        "version "
+        "{}.{}.{}",
+        version->bbdo_major, version->bbdo_minor, version->bbdo_patch,
+        BBDO_VERSION_MAJOR, BBDO_VERSION_MINOR, BBDO_VERSION_PATCH);
+  } else if ((event_id & 0xffff) == 2) {
+    log_v2::bbdo()->info(
+        "BBDO: received acknowledgement for {} events",
+        std::static_pointer_cast<const ack>(d)->acknowledged_events);
+    acknowledge_events(
+        std::static_pointer_cast<const ack>(d)->acknowledged_events);
+  } else if ((event_id & 0xffff) == 3) {
+    log_v2::bbdo()->info("BBDO: received stop from peer");
+    send_event_acknowledgement();
+  } else if ((event_id & 0xffff) == de_credit) {
+    auto c = std::static_pointer_cast<const credit>(d);
+    log_v2::bbdo()->debug(
+        "BBDO: received credit for {} events with a window of {} events",
+        c->acknowledged_events, c->window);
+    acknowledge_events(c->acknowledged_events);
+    _peer_window = c->window;
+  }
+
+  // Control messages.
+  log_v2::bbdo()->debug(
+      "BBDO: event with ID {} was a control message, launching recursive "
+      "read",
+      event_id);
+  return true;
+}
+
+/**
+ *  Count an event read, an acknowledgement is sent to the peer every
+ *  _ack_limit events.
+ */
+void stream::_event_read() {
+  ++_events_received_since_last_ack;
+  if (_events_received_since_last_ack >= _ack_limit)
+    send_event_acknowledgement();
+}
+
 /**
  *  Read data from stream.
  *
@@ -810,53 +933,18 @@ std::list<std::string> stream::get_running_config() {
  *  @see input::read()
  */
 bool stream::read(std::shared_ptr<io::data>& d, time_t deadline) {
-  // Read event.
-  d.reset();
-
-  bool timed_out(!_read_any(d, deadline));
-  uint32_t event_id(!d ? 0 : d->type());
-  while (!timed_out && ((event_id >> 16) == io::events::bbdo)) {
-    // Version response.
-    if ((event_id & 0xffff) == 1) {
-      std::shared_ptr<version_response> version(
-          std::static_pointer_cast<version_response>(d));
-      if (version->bbdo_major != BBDO_VERSION_MAJOR) {
-        log_v2::bbdo()->error(
-            "BBDO: peer is using protocol version {0}.{1}.{2} , whereas we're "
-            "using protocol version "
-            "{3}.{4}.{5}",
-            version->bbdo_major, version->bbdo_minor, version->bbdo_patch,
-            BBDO_VERSION_MAJOR, BBDO_VERSION_MINOR, BBDO_VERSION_PATCH);
-        throw msg_fmt(
-            "BBDO: peer is using protocol version {}.{}.{} "
-            "whereas we're using protocol version {}.{}.{}",
-            version->bbdo_major, version->bbdo_minor, version->bbdo_patch,
-            BBDO_VERSION_MAJOR, BBDO_VERSION_MINOR, BBDO_VERSION_PATCH);
-      }
-      log_v2::bbdo()->info(
-          "BBDO: peer is using protocol version {}.{}.{} , we're using "
-          "version "
-          "{}.{}.{}",
-          version->bbdo_major, version->bbdo_minor, version->bbdo_patch,
-          BBDO_VERSION_MAJOR, BBDO_VERSION_MINOR, BBDO_VERSION_PATCH);
-    } else if ((event_id & 0xffff) == 2) {
-      log_v2::bbdo()->info(
-          "BBDO: received acknowledgement for {} events",
-          std::static_pointer_cast<const ack>(d)->acknowledged_events);
-      acknowledge_events(
-          std::static_pointer_cast<const ack>(d)->acknowledged_events);
-    } else if ((event_id & 0xffff) == 3) {
-      log_v2::bbdo()->info("BBDO: received stop from peer");
-      send_event_acknowledgement();
-    }
+  bool timed_out(false);
+  // Events read while waiting for credits come first.
+  if (!_held.empty()) {
+    d = std::move(_held.front());
+    _held.pop_front();
+  } else {
+    // Read event.
+    d.reset();
 
-    // Control messages.
-    log_v2::bbdo()->debug(
-        "BBDO: event with ID {} was a control message, launching recursive "
-        "read",
-        event_id);
     timed_out = !_read_any(d, deadline);
-    event_id = !d ? 0 : d->type();
+    while (!timed_out && _handle_control(d))
+      timed_out = !_read_any(d, deadline);
   }
 
   /* If !timed_out, then we have two possibilities:
@@ -864,8 +952,11 @@ bool stream::read(std::shared_ptr<io::data>& d, time_t deadline) {
    *  * an event has been returned but we could not unserialize it.
    */
   if (!timed_out)
-    ++_events_received_since_last_ack;
-  if (_events_received_since_last_ack >= _ack_limit)
+    _event_read();
+  /* Events are not acknowledged too late, even if the peer sends only a few
+   * of them. */
+  if (_events_received_since_last_ack &&
+      std::chrono::steady_clock::now() - _last_ack >= _ack_delay)
     send_event_acknowledgement();
   return !timed_out;
 }
@@ -887,6 +978,13 @@ bool stream::_read_any(std::shared_ptr<io::data>& d, time_t deadline) {
     std::unique_ptr<io::data> e;
     d.reset();
 
+    // Events of a frame already read are returned first.
+    if (!_burst.empty()) {
+      d = std::move(_burst.front());
+      _burst.pop_front();
+      return true;
+    }
+
     for (;;) {
       /* Maybe we have to complete the header. */
       _read_packet(BBDO_HEADER_SIZE, deadline);
@@ -894,7 +992,7 @@ bool stream::_read_any(std::shared_ptr<io::data>& d, time_t deadline) {
       // Packet size is now at least BBDO_HEADER_SIZE and maybe contains
       // already a full BBDO packet.
 
-      const char* pack = _packet.data();
+      const char* pack = _packet.contiguous(BBDO_HEADER_SIZE);
       uint16_t chksum = ntohs(*reinterpret_cast<uint16_t const*>(pack));
       uint32_t packet_size =
           ntohs(*reinterpret_cast<uint16_t const*>(pack + 2));
@@ -918,8 +1016,7 @@ bool stream::_read_any(std::shared_ptr<io::data>& d, time_t deadline) {
               "{:04x}",
               peer(), chksum, expected);
         }
-        ++_skipped;
-        _packet.erase(_packet.begin());
+        _skipped += _skip_corrupted();
         continue;
       } else if (_skipped) {
         log_v2::bbdo()->info(
@@ -933,43 +1030,58 @@ bool stream::_read_any(std::shared_ptr<io::data>& d, time_t deadline) {
       _read_packet(BBDO_HEADER_SIZE + packet_size, deadline);
       // Now, _packet contains at least BBDO_HEADER_SIZE + packet_size bytes.
 
-      std::vector<char> content;
-      if (_packet.size() == BBDO_HEADER_SIZE + packet_size) {
-        log_v2::bbdo()->trace(
-            "packet matches header + content => extracting content");
-        // We remove the header from the packet: FIXME DBR this is not
-        // beautiful...
-
-        content = std::vector<char>(_packet.begin() + BBDO_HEADER_SIZE,
-                                    _packet.end());
-        _packet.clear();
-        // The size should be of only packet_size now.
-      } else {
-        /* we have _packet.size() > BBDO_HEADER_SIZE + packet_size */
-
-        size_t previous_packet_size = _packet.size();
-        // packet contains more than one BBDO packet...
-        content =
-            std::vector<char>(_packet.begin() + BBDO_HEADER_SIZE,
-                              _packet.begin() + BBDO_HEADER_SIZE + packet_size);
-        _packet.erase(_packet.begin(),
-                      _packet.begin() + BBDO_HEADER_SIZE + packet_size);
-        log_v2::bbdo()->trace(
-            "packet longer than header + content => splitting the whole of "
-            "size {} to content of size {} and remaining of size {}",
-            previous_packet_size, content.size(), _packet.size());
-      }
-
-      if (packet_size != 0xffff) {
+      /* The content is not copied, it is a view on the received buffer that
+       * stays valid even if the buffer is consumed. */
+      _packet.consume(BBDO_HEADER_SIZE);
+      io::slice content = _packet.take(packet_size);
+      log_v2::bbdo()->trace(
+          "packet of {} bytes extracted, {} bytes remaining to parse",
+          packet_size, _packet.size());
+
+      if (event_id == batch_type) {
+        /* A frame: each event is preceded by its type and its size, they
+         * all share the source and destination of the frame. */
+        const char* p = content.data;
+        size_t left = content.size;
+        while (left >= BBDO_BATCH_RECORD_HEADER_SIZE) {
+          uint32_t type = ntohl(*reinterpret_cast<uint32_t const*>(p));
+          uint32_t size = ntohs(*reinterpret_cast<uint16_t const*>(p + 4));
+          p += BBDO_BATCH_RECORD_HEADER_SIZE;
+          left -= BBDO_BATCH_RECORD_HEADER_SIZE;
+          if (size > left)
+            break;
+          /* Unknown events are returned as null events, as when they are sent
+           * alone, so that acknowledgements count the same events. */
+          _burst.emplace_back(
+              _unserialize(type, source_id, dest_id, p, size));
+          p += size;
+          left -= size;
+        }
+        if (left)
+          log_v2::bbdo()->error(
+              "peer {} sent an invalid frame, {} bytes are discarded", peer(),
+              left);
+        log_v2::bbdo()->trace("frame of {} bytes with {} events extracted",
+                              packet_size, _burst.size());
+        if (!_burst.empty()) {
+          d = std::move(_burst.front());
+          _burst.pop_front();
+          return true;
+        }
+      } else if (packet_size != 0xffff) {
         // Cool we can work with it!
 
         // Is it the next part of an already known input buffer?
+        std::vector<char> long_content;
         for (auto it = _buffer.begin(); it != _buffer.end(); ++it) {
           auto& b = *it;
           if (b.matches(event_id, source_id, dest_id)) {
             // Good, we've found it.
-            b.push_back(std::move(content));
-            content = b.to_vector();
+            b.push_back(std::vector<char>(content.data,
+                                          content.data + content.size));
+            long_content = b.to_vector();
+            content.data = long_content.data();
+            content.size = long_content.size();
             _buffer.erase(it);
             break;
           }
@@ -990,11 +1102,10 @@ bool stream::_read_any(std::shared_ptr<io::data>& d, time_t deadline) {
           }
         }
 
-        pack = content.data();
-
         // Maybe it is bigger now.
-        packet_size = content.size();
-        d.reset(unserialize(event_id, source_id, dest_id, pack, packet_size));
+        packet_size = content.size;
+        d.reset(_unserialize(event_id, source_id, dest_id, content.data,
+                             packet_size));
         if (d) {
           log_v2::bbdo()->trace("unserialized {} bytes for event of type {}",
                                 BBDO_HEADER_SIZE + packet_size, event_id);
@@ -1007,20 +1118,20 @@ bool stream::_read_any(std::shared_ptr<io::data>& d, time_t deadline) {
         return true;
       } else {
         // Is it the next part of an already known input buffer?
+        std::vector<char> part(content.data, content.data + content.size);
         bool done = false;
         for (auto it = _buffer.begin(); it != _buffer.end(); ++it) {
           auto& b = *it;
           if (b.matches(event_id, source_id, dest_id)) {
             // Good, we've found it.
-            b.push_back(std::move(content));
-            content.clear();
+            b.push_back(std::move(part));
             done = true;
             break;
           }
         }
         if (!done)
           _buffer.emplace_back(
-              buffer(event_id, source_id, dest_id, std::move(content)));
+              buffer(event_id, source_id, dest_id, std::move(part)));
 
         /* There is no reason to have this but no one knows. */
         if (_buffer.size() > 1) {
@@ -1046,12 +1157,74 @@ bool stream::_read_any(std::shared_ptr<io::data>& d, time_t deadline) {
 }
 
 /**
- * @brief Fill the internal _packet vector until it reaches the given size. It
+ *  Tell if a BBDO header starts at the given address, i.e. if its checksum
+ *  is valid.
+ *
+ *  @param[in] header  At least BBDO_HEADER_SIZE bytes.
+ *
+ *  @return true if the checksum matches.
+ */
+static bool valid_header(const char* header) {
+  return ntohs(*reinterpret_cast<uint16_t const*>(header)) ==
+         misc::crc16_ccitt(header + 2, BBDO_HEADER_SIZE - 2);
+}
+
+/**
+ * @brief Skip corrupted bytes at the beginning of _packet, whose first header
+ * has an invalid checksum. Received data are scanned once, looking for the
+ * next position where a valid header starts. The scan stops there, or at the
+ * end of the received data, the last bytes that could begin a header being
+ * kept until more data are read.
+ *
+ * @return The number of skipped bytes.
+ */
+size_t stream::_skip_corrupted() {
+  /* The first byte is known to be corrupted. */
+  _packet.consume(1);
+  size_t retval = 1;
+
+  for (;;) {
+    size_t len;
+    const char* p = _packet.front(len);
+
+    /* Candidates entirely in the first buffer are checked in place. */
+    if (len >= BBDO_HEADER_SIZE) {
+      size_t last = len - BBDO_HEADER_SIZE;
+      for (size_t i = 0; i <= last; ++i)
+        if (valid_header(p + i)) {
+          _packet.consume(i);
+          return retval + i;
+        }
+      _packet.consume(last + 1);
+      retval += last + 1;
+      p = _packet.front(len);
+    }
+
+    /* Candidates spanning several buffers are checked in a copy. */
+    if (_packet.size() < BBDO_HEADER_SIZE)
+      return retval;
+    char tmp[2 * BBDO_HEADER_SIZE - 1];
+    size_t avail = _packet.peek(tmp, len + BBDO_HEADER_SIZE - 1);
+    size_t checked = std::min(len, avail - BBDO_HEADER_SIZE + 1);
+    for (size_t i = 0; i < checked; ++i)
+      if (valid_header(tmp + i)) {
+        _packet.consume(i);
+        return retval + i;
+      }
+    _packet.consume(checked);
+    retval += checked;
+    if (checked < len)
+      return retval;
+  }
+}
+
+/**
+ * @brief Fill the internal _packet chain until it reaches the given size. It
  * may be bigger. The deadline is the limit time after that an exception is
- * thrown. Even if an exception is thrown the vector may begin to be fill, it is
- * just not finished, and so no data are lost. Received packets are BBDO packets
- * or maybe pieces of BBDO packets, so we keep vectors as is because usually a
- * vector should just represent a packet.
+ * thrown. Even if an exception is thrown the chain may begin to be filled, it
+ * is just not finished, and so no data are lost. Received buffers are BBDO
+ * packets or maybe pieces of BBDO packets, they are appended to the chain
+ * without copy.
  *
  * @param size The wanted final size
  * @param deadline A time_t.
@@ -1062,16 +1235,8 @@ void stream::_read_packet(size_t size, time_t deadline) {
     std::shared_ptr<io::data> d;
     bool timeout = !_substream->read(d, deadline);
 
-    if (d && d->type() == io::raw::static_type()) {
-      std::vector<char>& new_v = std::static_pointer_cast<io::raw>(d)->_buffer;
-      if (!new_v.empty()) {
-        if (_packet.size() == 0) {
-          _packet = std::move(new_v);
-          new_v.clear();
-        } else
-          _packet.insert(_packet.end(), new_v.begin(), new_v.end());
-      }
-    }
+    if (d && d->type() == io::raw::static_type())
+      _packet.push(std::static_pointer_cast<io::raw>(d));
     if (timeout) {
       log_v2::bbdo()->trace("_read_packet timeout!!, size = {}, deadline = {}",
                             size, deadline);
@@ -1117,6 +1282,30 @@ void stream::set_timeout(int timeout) {
   _timeout = timeout;
 }
 
+/**
+ *  Encode strings with tables of the given capacity, on both directions. It
+ *  is called when the string table extension is negotiated, or directly if
+ *  the peer is known to support it (retention files).
+ *
+ *  @param[in] capacity  Maximum number of strings in each table.
+ */
+void stream::set_string_table(uint16_t capacity) {
+  _read_strings = std::make_unique<string_table>(capacity);
+  _write_strings = std::make_unique<string_table>(capacity);
+  // Codecs refer to the tables.
+  _read_codecs.clear();
+  _write_codecs.clear();
+}
+
+/**
+ *  Empty the writer strings table, the strings written next do not depend on
+ *  the previous ones.
+ */
+void stream::reset_string_table() {
+  if (_write_strings)
+    _write_strings->reset();
+}
+
 /**
  *  Get statistics.
  *
@@ -1126,21 +1315,124 @@ void stream::statistics(nlohmann::json& tree) const {
   tree["bbdo_input_ack_limit"] = static_cast<double>(_ack_limit);
   tree["bbdo_unacknowledged_events"] =
       static_cast<double>(_events_received_since_last_ack);
+  tree["bbdo_binary_double"] = _binary_double;
+  tree["bbdo_batch"] = _batch;
+  tree["bbdo_string_table"] = static_cast<bool>(_write_strings);
+  if (_write_strings) {
+    tree["bbdo_strings_written"] =
+        static_cast<double>(_write_strings->strings());
+    tree["bbdo_strings_written_as_index"] =
+        static_cast<double>(_write_strings->refs());
+    tree["bbdo_unresolved_strings_read"] =
+        static_cast<double>(_read_strings->unresolved());
+  }
+  tree["bbdo_ack_window"] = _ack_window;
+  tree["bbdo_events_in_flight"] =
+      static_cast<double>(_events_written - _events_acknowledged_by_peer);
+  tree["bbdo_ack_rtt_ms"] = _ack_rtt.count() / 1000.0;
+  if (_ack_window) {
+    tree["bbdo_window_advertised"] = static_cast<double>(_window_sent);
+    tree["bbdo_peer_window"] = static_cast<double>(_peer_window);
+    tree["bbdo_window_waits"] = static_cast<double>(_window_waits);
+  }
+  if (_batch) {
+    tree["bbdo_frames_written"] = static_cast<double>(_frames_written);
+    tree["bbdo_events_per_frame"] =
+        _frames_written ? static_cast<double>(_frame_events_written) /
+                              _frames_written
+                        : 0.0;
+  }
 
   if (_substream)
     _substream->statistics(tree);
 }
 
-void stream::_write(std::shared_ptr<io::data> const& d) {
+/**
+ *  Write an event alone to the substream. Events waiting to be sent in a
+ *  frame are sent before.
+ *
+ *  @param[in] d  Event to send.
+ *
+ *  @return true if the event has been serialized.
+ */
+bool stream::_write(std::shared_ptr<io::data> const& d) {
   assert(d);
+  _flush_pending();
 
   // Check if data exists.
-  std::shared_ptr<io::raw> serialized(serialize(*d));
-  if (serialized) {
+  std::shared_ptr<io::raw> serialized(std::make_shared<io::raw>());
+  if (_serialize(*d, serialized->get_buffer())) {
     log_v2::bbdo()->trace("BBDO: serialized event of type {} to {} bytes",
                           d->type(), serialized->size());
     _substream->write(serialized);
+    return true;
+  }
+  return false;
+}
+
+/**
+ *  Count events written, the ack round trip time is measured from these
+ *  marks.
+ *
+ *  @param[in] count  Number of events written.
+ */
+void stream::_events_written_now(uint32_t count) {
+  if (!_coarse && count) {
+    _events_written += count;
+    if (_write_marks.size() < max_write_marks)
+      _write_marks.emplace_back(_events_written,
+                                std::chrono::steady_clock::now());
+  }
+}
+
+/**
+ *  When the peer gave us a window and it is full, wait for credits before
+ *  writing more events. Events read meanwhile are kept for read(). The wait
+ *  lasts at most _timeout seconds, events are then written anyway.
+ */
+void stream::_wait_for_credit() {
+  if (!_window_full())
+    return;
+
+  // The peer cannot acknowledge events we did not send yet.
+  _flush_pending();
+  ++_window_waits;
+  log_v2::bbdo()->debug("BBDO: {} events in flight, waiting for credits",
+                        _events_written - _events_acknowledged_by_peer);
+  time_t deadline = time(nullptr) + _timeout;
+  while (_events_written - _events_acknowledged_by_peer >= _peer_window) {
+    std::shared_ptr<io::data> d;
+    if (!_read_any(d, deadline)) {
+      log_v2::bbdo()->error(
+          "BBDO: no credit received from peer {} for {}s, writing beyond its "
+          "window of {} events",
+          peer(), _timeout, _peer_window);
+      return;
+    }
+    // Counted when read() returns it, so it is acknowledged only then.
+    if (!_handle_control(d))
+      _held.push_back(d);
+  }
+}
+
+/**
+ *  Compute the window advertised to the peer. It grows with the rate events
+ *  are read at and it shrinks when the muxers memory is nearly exhausted.
+ *
+ *  @return A number of events.
+ */
+uint32_t stream::_window() const {
+  double min_window = 2.0 * _ack_limit;
+  double retval = _read_rate * window_duration;
+  uint64_t budget = multiplexing::muxer::event_queues_total_size();
+  if (budget) {
+    uint64_t used = multiplexing::muxer::total_resident_bytes();
+    retval = used >= budget
+                 ? 0.0
+                 : retval * static_cast<double>(budget - used) / budget;
   }
+  retval = std::min(retval, static_cast<double>(_window_max));
+  return static_cast<uint32_t>(std::max(retval, min_window));
 }
 
 /**
@@ -1151,13 +1443,76 @@ void stream::_write(std::shared_ptr<io::data> const& d) {
  *  @return Number of events acknowledged.
  */
 int32_t stream::write(std::shared_ptr<io::data> const& d) {
-  _write(d);
+  _wait_for_credit();
+  if (_batch) {
+    assert(d);
+    if (_batch_event(*d))
+      _events_written_now(1);
+    _write_pending();
+  } else if (_write(d))
+    _events_written_now(1);
 
   int32_t retval = _acknowledged_events;
   _acknowledged_events -= retval;
   return retval;
 }
 
+/**
+ *  Write several events to stream. They are serialized into one buffer
+ *  given to the substream in one call.
+ *
+ *  @param[in] d Events to send.
+ *
+ *  @return Number of events acknowledged.
+ */
+int32_t stream::write_batch(const std::vector<std::shared_ptr<io::data>>& d) {
+  _wait_for_credit();
+  uint32_t count = 0;
+  if (_batch) {
+    for (auto& e : d) {
+      assert(e);
+      if (_batch_event(*e))
+        ++count;
+    }
+    _events_written_now(count);
+    _write_pending();
+
+    int32_t retval = _acknowledged_events;
+    _acknowledged_events -= retval;
+    return retval;
+  }
+
+  std::shared_ptr<io::raw> serialized(std::make_shared<io::raw>());
+  std::vector<char>& buffer = serialized->get_buffer();
+  for (auto& e : d) {
+    assert(e);
+    if (_serialize(*e, buffer))
+      ++count;
+  }
+  if (!buffer.empty()) {
+    log_v2::bbdo()->trace("BBDO: serialized {} events to {} bytes", d.size(),
+                          buffer.size());
+    _substream->write(serialized);
+  }
+  _events_written_now(count);
+
+  int32_t retval = _acknowledged_events;
+  _acknowledged_events -= retval;
+  return retval;
+}
+
+/**
+ *  Tell if events can be written without waiting. When the window of the
+ *  peer is full, write() waits for credits, so writers that cannot wait
+ *  have to read the stream until the credits come.
+ *
+ *  @return false if the window of the peer is full or if the substream is
+ *          not ready.
+ */
+bool stream::write_ready() const {
+  return !_window_full() && io::stream::write_ready();
+}
+
 /**
  *  Acknowledge a certain amount of events.
  *
@@ -1165,18 +1520,47 @@ int32_t stream::write(std::shared_ptr<io::data> const& d) {
  */
 void stream::acknowledge_events(uint32_t events) {
   _acknowledged_events += events;
+  _events_acknowledged_by_peer += events;
+
+  /* The round trip time is the age of the last write whose events are all
+   * acknowledged. */
+  bool measured = false;
+  std::chrono::steady_clock::time_point written;
+  while (!_write_marks.empty() &&
+         _write_marks.front().first <= _events_acknowledged_by_peer) {
+    written = _write_marks.front().second;
+    _write_marks.pop_front();
+    measured = true;
+  }
+  if (measured) {
+    auto rtt = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - written);
+    _ack_rtt = _ack_rtt.count() ? (7 * _ack_rtt + rtt) / 8 : rtt;
+  }
 }
 
 /**
- *  Send an acknowledgement for all the events received.
+ *  Send an acknowledgement for all the events received. With the ack window
+ *  extension, it is a credit also giving a new window to the peer.
  */
 void stream::send_event_acknowledgement() {
   if (!_coarse) {
     log_v2::core()->debug("send acknowledgement for {} events",
                           _events_received_since_last_ack);
-    std::shared_ptr<ack> acknowledgement(
-        std::make_shared<ack>(_events_received_since_last_ack));
-    _write(acknowledgement);
+    auto now = std::chrono::steady_clock::now();
+    if (_ack_window) {
+      if (_events_received_since_last_ack) {
+        double elapsed = std::max(
+            std::chrono::duration<double>(now - _last_ack).count(), 0.001);
+        double rate = _events_received_since_last_ack / elapsed;
+        _read_rate = _read_rate > 0 ? 0.75 * _read_rate + 0.25 * rate : rate;
+      }
+      _window_sent = _window();
+      _write(std::make_shared<credit>(_events_received_since_last_ack,
+                                      _window_sent));
+    } else
+      _write(std::make_shared<ack>(_events_received_since_last_ack));
     _events_received_since_last_ack = 0;
+    _last_ack = now;
   }
 }
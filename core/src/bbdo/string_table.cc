@@ -0,0 +1,219 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/bbdo/string_table.hh"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+
+#include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/exceptions/msg_fmt.hh"
+
+using namespace com::centreon::exceptions;
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::bbdo;
+
+constexpr size_t string_table::min_length;
+constexpr size_t string_table::max_length;
+
+/**
+ *  Append a string with its terminating '\0'.
+ */
+static void put_string(const std::string& str, std::vector<char>& buffer) {
+  buffer.insert(buffer.end(), str.c_str(), str.c_str() + str.size() + 1);
+}
+
+/**
+ *  Append an index of the table.
+ */
+static void put_index(uint16_t index, std::vector<char>& buffer) {
+  index = htons(index);
+  const char* v = reinterpret_cast<const char*>(&index);
+  buffer.insert(buffer.end(), v, v + sizeof(index));
+}
+
+/**
+ *  Read a string terminated by '\0'.
+ *
+ *  @return The number of bytes read.
+ */
+static uint32_t get_string(std::string& str,
+                           const char* buffer,
+                           uint32_t size) {
+  const char* end = static_cast<const char*>(memchr(buffer, 0, size));
+  if (!end) {
+    log_v2::bbdo()->error(
+        "BBDO: cannot extract string value: no terminating '\\0' in "
+        "remaining {} bytes left in packet",
+        size);
+    throw msg_fmt(
+        "BBDO: cannot extract string value: "
+        "no terminating '\\0' in remaining {} bytes of packet",
+        size);
+  }
+  str.assign(buffer, end - buffer);
+  return end - buffer + 1;
+}
+
+/**
+ *  Read an index of the table.
+ */
+static uint16_t get_index(const char* buffer, uint32_t size) {
+  if (size < sizeof(uint16_t)) {
+    log_v2::bbdo()->error(
+        "BBDO: cannot extract string index: {} bytes left in packet", size);
+    throw msg_fmt("BBDO: cannot extract string index: {} bytes left in packet",
+                  size);
+  }
+  uint16_t index;
+  memcpy(&index, buffer, sizeof(index));
+  return ntohs(index);
+}
+
+/**
+ *  Constructor.
+ *
+ *  @param[in] capacity  Maximum number of strings in the table.
+ */
+string_table::string_table(uint16_t capacity)
+    : _capacity{capacity},
+      _next{0},
+      _reset{true},
+      _refs{0},
+      _strings_count{0},
+      _unresolved{0} {}
+
+/**
+ *  Encode a string, from the writer table.
+ *
+ *  @param[in]  str     The string.
+ *  @param[out] buffer  Buffer to which the encoded string is appended.
+ */
+void string_table::encode(const std::string& str, std::vector<char>& buffer) {
+  ++_strings_count;
+  if (_reset) {
+    buffer.push_back(tag_reset);
+    _strings.clear();
+    _index.clear();
+    _seen.clear();
+    _next = 0;
+    _reset = false;
+  }
+
+  if (_capacity && str.size() >= min_length && str.size() <= max_length) {
+    auto it = _index.find(str);
+    if (it != _index.end()) {
+      ++_refs;
+      buffer.push_back(tag_ref);
+      put_index(it->second, buffer);
+      return;
+    }
+
+    if (_seen.size() >= 4u * _capacity)
+      _seen.clear();
+    size_t hash = std::hash<std::string>()(str);
+    if (!_seen.insert(hash).second) {
+      // Second time this string is met, it is stored.
+      _seen.erase(hash);
+      uint16_t index = _next;
+      _next = (_next + 1u) % _capacity;
+      if (index < _strings.size()) {
+        _index.erase(_strings[index]);
+        _strings[index] = str;
+      } else
+        _strings.push_back(str);
+      _index.emplace(str, index);
+      buffer.push_back(tag_def);
+      put_index(index, buffer);
+      put_string(str, buffer);
+      return;
+    }
+  }
+
+  if (!str.empty() && str[0] >= tag_ref && str[0] <= tag_reset)
+    buffer.push_back(tag_esc);
+  put_string(str, buffer);
+}
+
+/**
+ *  Decode a string, from the reader table.
+ *
+ *  @param[out] str     The decoded string.
+ *  @param[in]  buffer  Encoded data.
+ *  @param[in]  size    Bytes available in buffer.
+ *
+ *  @return The number of bytes read.
+ */
+uint32_t string_table::decode(std::string& str,
+                              const char* buffer,
+                              uint32_t size) {
+  ++_strings_count;
+  uint32_t retval = 0;
+  if (size && *buffer == tag_reset) {
+    _strings.clear();
+    ++buffer;
+    --size;
+    retval = 1;
+  }
+  if (!size) {
+    log_v2::bbdo()->error(
+        "BBDO: cannot extract string value: 0 bytes left in packet");
+    throw msg_fmt("BBDO: cannot extract string value: 0 bytes left in packet");
+  }
+
+  switch (*buffer) {
+    case tag_ref: {
+      ++_refs;
+      uint16_t index = get_index(buffer + 1, size - 1);
+      if (index < _strings.size())
+        str = _strings[index];
+      else {
+        /* The definition was not read, the string is lost. The caller
+         * drops the event, see unresolved(). */
+        log_v2::bbdo()->debug(
+            "BBDO: string {} referenced by the peer is not known", index);
+        ++_unresolved;
+        str.clear();
+      }
+      return retval + 1 + sizeof(uint16_t);
+    }
+    case tag_def: {
+      uint16_t index = get_index(buffer + 1, size - 1);
+      retval += 1 + sizeof(uint16_t);
+      retval += get_string(str, buffer + 1 + sizeof(uint16_t),
+                           size - 1 - sizeof(uint16_t));
+      if (index >= _strings.size())
+        _strings.resize(index + 1u);
+      _strings[index] = str;
+      return retval;
+    }
+    case tag_esc:
+      return retval + 1 + get_string(str, buffer + 1, size - 1);
+    default:
+      return retval + get_string(str, buffer, size);
+  }
+}
+
+/**
+ *  Writer side: empty the table. The reader table is emptied when the next
+ *  string is read.
+ */
+void string_table::reset() {
+  _reset = true;
+}
@@ -19,15 +19,38 @@
 #include "com/centreon/broker/compression/factory.hh"
 
 #include <cstring>
+#include <fstream>
 #include <memory>
+#include <sstream>
 
 #include "com/centreon/broker/compression/opener.hh"
 #include "com/centreon/broker/compression/stream.hh"
+#include "com/centreon/broker/compression/zstd.hh"
 #include "com/centreon/broker/config/parser.hh"
+#include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/broker/misc/string.hh"
+#include "com/centreon/exceptions/msg_fmt.hh"
 
+using namespace com::centreon::exceptions;
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::compression;
 
+/**
+ *  Load a zstd dictionary.
+ *
+ *  @param[in] path  Path of the dictionary file.
+ *
+ *  @return The dictionary.
+ */
+static std::string load_dictionary(const std::string& path) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f)
+    throw msg_fmt("compression: cannot open zstd dictionary '{}'", path);
+  std::ostringstream oss;
+  oss << f.rdbuf();
+  return oss.str();
+}
+
 /**************************************
  *                                     *
  *           Public Methods            *
@@ -45,6 +68,11 @@ using namespace com::centreon::broker::compression;
  *  the broker configuration. This avoids the compression while the negotiation
  *  is running. We will be able to add this endpoint later, following the flag
  *  value.
+ *
+ *  The extension options contain the codecs accepted for this endpoint, in
+ *  preference order ("compression_codec" parameter, zlib by default), the
+ *  compression level and buffer size, the zstd dictionary and whether the
+ *  compression is pipelined ("compression_pipeline" parameter).
  */
 bool factory::has_endpoint(config::endpoint& cfg, io::extension* ext) {
   if (ext) {
@@ -55,6 +83,45 @@ bool factory::has_endpoint(config::endpoint& cfg, io::extension* ext) {
       *ext = io::extension("COMPRESSION", true, false);
     else if (strncasecmp(it->second.c_str(), "yes", 4) == 0)
       *ext = io::extension("COMPRESSION", false, true);
+
+    if (ext->is_optional() || ext->is_mandatory()) {
+      auto& options = ext->mutable_options();
+      std::string codecs;
+      it = cfg.params.find("compression_codec");
+      if (it != cfg.params.end()) {
+        for (auto& c : misc::string::split(it->second, ',')) {
+          std::string codec{misc::string::trim(c)};
+          if (codec == "zstd" || codec == "lz4" || codec == "zlib") {
+            if (!codecs.empty())
+              codecs.append(" ");
+            codecs.append(codec);
+          } else
+            log_v2::core()->error(
+                "compression: unknown codec '{}', it must be zstd, lz4 or "
+                "zlib",
+                codec);
+        }
+      }
+      options["codecs"] = codecs.empty() ? "zlib" : codecs;
+
+      for (const char* option : {"compression_level", "compression_buffer",
+                                 "compression_pipeline"}) {
+        it = cfg.params.find(option);
+        if (it != cfg.params.end())
+          options[option] = it->second;
+      }
+
+      it = cfg.params.find("compression_dictionary");
+      if (it != cfg.params.end()) {
+        try {
+          options["zstd_dictionary_id"] =
+              std::to_string(zstd::dictionary_id(load_dictionary(it->second)));
+          options["compression_dictionary"] = it->second;
+        } catch (const std::exception& e) {
+          log_v2::core()->error("{}, no dictionary is used", e.what());
+        }
+      }
+    }
   }
   return false;
 }
@@ -100,7 +167,8 @@ io::endpoint* factory::new_endpoint(
  *
  *  @param[in] to          Lower-layer stream.
  *  @param[in] is_acceptor Unused.
- *  @param[in] proto_name  Unused.
+ *  @param[in] options     Extension options, the codec is the one chosen
+ *                         during the negotiation.
  *
  *  @return New compression stream.
  */
@@ -109,8 +177,34 @@ std::shared_ptr<io::stream> factory::new_stream(
     bool is_acceptor,
     const std::unordered_map<std::string, std::string>& options) {
   (void)is_acceptor;
-  (void)options;
-  std::shared_ptr<io::stream> s{std::make_shared<stream>()};
+  int level{-1};
+  auto it = options.find("compression_level");
+  if (it != options.end())
+    level = std::stol(it->second);
+
+  size_t size{0};
+  it = options.find("compression_buffer");
+  if (it != options.end())
+    size = std::stoul(it->second);
+
+  stream::codec c{stream::zlib_codec};
+  std::string dictionary;
+  it = options.find("codec");
+  if (it != options.end()) {
+    if (it->second == "zstd") {
+      c = stream::zstd_codec;
+      it = options.find("compression_dictionary");
+      if (it != options.end())
+        dictionary = load_dictionary(it->second);
+    } else if (it->second == "lz4")
+      c = stream::lz4_codec;
+  }
+
+  std::shared_ptr<stream> s{
+      std::make_shared<stream>(level, size, c, dictionary)};
+  it = options.find("compression_pipeline");
+  if (it != options.end())
+    s->set_pipelined(config::parser::parse_boolean(it->second));
   s->set_substream(to);
   return s;
 }
@@ -0,0 +1,145 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/compression/lz4.hh"
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "com/centreon/broker/compression/stream.hh"
+#include "com/centreon/broker/exceptions/corruption.hh"
+#include "com/centreon/exceptions/msg_fmt.hh"
+
+using namespace com::centreon::exceptions;
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::compression;
+
+/* lz4 only refers to the last 64kB. */
+constexpr size_t window_size = 65536;
+/* The history buffers are moved once every this size of data. */
+constexpr size_t buffer_size = 1048576;
+
+/**
+ *  Constructor.
+ */
+lz4::lz4() : _stream{LZ4_createStream()}, _chistory{0}, _dhistory{0} {
+  if (!_stream)
+    throw msg_fmt("compression: cannot create lz4 stream");
+}
+
+/**
+ *  Destructor.
+ */
+lz4::~lz4() noexcept {
+  LZ4_freeStream(_stream);
+}
+
+/**
+ *  Make room for size bytes after the history in buffer. When the buffer is
+ *  too small, only the last 64kB of the history are kept, at its beginning.
+ *
+ *  @param[in,out] buffer   History buffer.
+ *  @param[in,out] history  Size of the history at the beginning of buffer.
+ *  @param[in]     size     Size needed after the history.
+ *
+ *  @return true if the buffer has changed.
+ */
+bool lz4::_make_room(std::vector<char>& buffer, size_t& history, size_t size) {
+  if (history + size <= buffer.size())
+    return false;
+
+  size_t keep = std::min(history, window_size);
+  std::vector<char> b(std::max(buffer_size, keep + size));
+  if (keep)
+    memcpy(b.data(), buffer.data() + history - keep, keep);
+  buffer.swap(b);
+  history = keep;
+  return true;
+}
+
+/**
+ * Compression function
+ *
+ * @param data the data to compress.
+ *
+ * @return The same data compressed.
+ */
+std::vector<char> lz4::compress(std::vector<char> const& data) {
+  if (data.empty())
+    return {'\0', '\0', '\0', '\0'};
+
+  size_t nbytes = data.size();
+  if (nbytes > LZ4_MAX_INPUT_SIZE)
+    throw msg_fmt("compression: cannot compress {} bytes with lz4", nbytes);
+
+  // The block is copied just after the history, lz4 sees them as contiguous.
+  if (_make_room(_cbuffer, _chistory, nbytes))
+    LZ4_loadDict(_stream, _cbuffer.data(), _chistory);
+  char* src = _cbuffer.data() + _chistory;
+  memcpy(src, data.data(), nbytes);
+
+  std::vector<char> retval(LZ4_compressBound(nbytes) + 4);
+  int len = LZ4_compress_fast_continue(_stream, src, retval.data() + 4, nbytes,
+                                       retval.size() - 4, 1);
+  if (len <= 0)
+    throw msg_fmt("compression: cannot compress {} bytes with lz4", nbytes);
+  _chistory += nbytes;
+
+  retval.resize(len + 4);
+  retval[0] = (nbytes >> 24) & 0xff;
+  retval[1] = (nbytes >> 16) & 0xff;
+  retval[2] = (nbytes >> 8) & 0xff;
+  retval[3] = (nbytes & 0xff);
+  return retval;
+}
+
+/**
+ * Uncompress function
+ *
+ * @param data The data to extract.
+ * @param nbytes The data size in bytes.
+ *
+ * @return the extract data
+ */
+std::vector<char> lz4::uncompress(unsigned char const* data,
+                                  unsigned long nbytes) {
+  if (nbytes < 4)
+    throw exceptions::corruption(
+        "compression: attempting to uncompress data with invalid size");
+  size_t expected_size =
+      (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+  if (expected_size > stream::max_data_size)
+    throw exceptions::corruption("compression: data expected size is too big");
+  if (!expected_size)
+    return std::vector<char>();
+
+  _make_room(_dbuffer, _dhistory, expected_size);
+  size_t dict = std::min(_dhistory, window_size);
+  char* dst = _dbuffer.data() + _dhistory;
+  int len = LZ4_decompress_safe_usingDict(
+      reinterpret_cast<const char*>(data) + 4, dst, nbytes - 4, expected_size,
+      dst - dict, dict);
+  if (len < 0 || static_cast<size_t>(len) != expected_size)
+    throw exceptions::corruption(
+        "compression: compressed input data is corrupted, unable to "
+        "uncompress it");
+  _dhistory += len;
+  return std::vector<char>(dst, dst + len);
+}
@@ -18,7 +18,9 @@
 
 #include "com/centreon/broker/compression/stream.hh"
 
+#include "com/centreon/broker/compression/lz4.hh"
 #include "com/centreon/broker/compression/zlib.hh"
+#include "com/centreon/broker/compression/zstd.hh"
 #include "com/centreon/broker/exceptions/corruption.hh"
 #include "com/centreon/broker/exceptions/interrupt.hh"
 #include "com/centreon/broker/exceptions/shutdown.hh"
@@ -26,12 +28,25 @@
 #include "com/centreon/broker/io/events.hh"
 #include "com/centreon/broker/io/raw.hh"
 #include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/broker/pool.hh"
 
 using namespace com::centreon::exceptions;
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::compression;
 
 const size_t stream::max_data_size = 100000000u;
+const size_t stream::max_pipelined_blocks = 8u;
+const uint32_t stream::independent_block_flag = 0x80000000u;
+
+/**
+ *  Tell if the caller is a thread of the pool. Such a thread must not wait
+ *  for a job it posted, the job may be queued behind it.
+ *
+ *  @return true on a thread of the pool.
+ */
+static bool on_pool_thread() {
+  return pool::io_context().get_executor().running_in_this_thread();
+}
 
 /**************************************
  *                                     *
@@ -42,11 +57,31 @@ const size_t stream::max_data_size = 100000000u;
 /**
  *  Constructor.
  *
- *  @param[in] level Compression level.
- *  @param[in] size  Compression buffer size.
+ *  @param[in] level       Compression level.
+ *  @param[in] size        Compression buffer size.
+ *  @param[in] c           Compression codec.
+ *  @param[in] dictionary  zstd dictionary, empty for none.
  */
-stream::stream(int level, size_t size)
-    : io::stream("compression"), _level(level), _shutdown(false), _size(size) {}
+stream::stream(int level,
+               size_t size,
+               codec c,
+               const std::string& dictionary)
+    : io::stream("compression"),
+      _codec{c},
+      _uncompressed_bytes{0},
+      _compressed_bytes{0},
+      _level(level),
+      _shutdown(false),
+      _size(size),
+      _independent_blocks{false},
+      _pipelined{false},
+      _max_workers{1},
+      _pipeline{std::make_shared<pipeline>()} {
+  if (_codec == zstd_codec)
+    _zstd = std::make_unique<zstd>(level, dictionary);
+  else if (_codec == lz4_codec)
+    _lz4 = std::make_unique<lz4>();
+}
 
 /**
  *  Destructor.
@@ -54,10 +89,18 @@ stream::stream(int level, size_t size)
 stream::~stream() noexcept {
   try {
     _flush();
+    _write_blocks(0);
   }
   // Ignore exception whatever the error might be.
   catch (...) {
   }
+  /* Jobs using this stream are waited for, the ones still queued find
+   * nothing to do. */
+  std::unique_lock<std::mutex> lck(_pipeline->m);
+  if (_next_block)
+    _next_block->started = true;
+  _pipeline->to_compress.clear();
+  _pipeline->cv.wait(lck, [this] { return _pipeline->running == 0; });
 }
 
 /**
@@ -73,10 +116,50 @@ bool stream::read(std::shared_ptr<io::data>& data, time_t deadline) {
   data.reset();
 
   try {
+    // The next block may already be uncompressed by the pool.
+    if (_next_block) {
+      std::shared_ptr<block> b{std::move(_next_block)};
+      _next_block.reset();
+      {
+        std::unique_lock<std::mutex> lck(_pipeline->m);
+        /* On a thread of the pool, the job may be queued behind us. If it
+         * did not start, the block is uncompressed below. */
+        if (!b->started && on_pool_thread())
+          b->started = true;
+        else
+          _pipeline->cv.wait(lck, [&b] { return b->done; });
+      }
+      if (b->done) {
+        if (b->error && _codec != zlib_codec && !_independent_blocks) {
+          try {
+            std::rethrow_exception(b->error);
+          } catch (std::exception const& e) {
+            throw msg_fmt("compression: peer {} sent corrupted data: {}",
+                          peer(), e.what());
+          }
+        }
+        if (!b->error && !b->data.empty()) {
+          log_v2::core()->debug(
+              "compression: {:x} uncompressed {} bytes to {} bytes",
+              static_cast<void*>(this), b->size + sizeof(int32_t),
+              b->data.size());
+          _rbuffer.consume(b->size + sizeof(int32_t));
+          std::shared_ptr<io::raw> r(new io::raw);
+          r->get_buffer() = std::move(b->data);
+          data = r;
+          _prefetch();
+          return true;
+        }
+        // A corrupted independent block is processed again below to skip
+        // it.
+      }
+    }
+
     // Process buffer as long as data is corrupted
     // or until an exception occurs.
     bool corrupted(true);
     size_t size(0);
+    bool independent(false);
     int skipped(0);
     while (corrupted) {
       // Get compressed data length.
@@ -85,15 +168,11 @@ bool stream::read(std::shared_ptr<io::data>& data, time_t deadline) {
 
         // We do not have enough data to get the next chunk's size.
         // Stream is shutdown.
-        if (_rbuffer.size() < static_cast<int>(sizeof(int32_t)))
+        if (_rbuffer.size() < sizeof(int32_t))
           throw exceptions::shutdown("no more data to uncompress");
 
         // Extract next chunk's size.
-        {
-          unsigned char const* buff((unsigned char const*)_rbuffer.data());
-          size = static_cast<uint32_t>((buff[0] << 24) | (buff[1] << 16) |
-                                       (buff[2] << 8) | (buff[3]));
-        }
+        size = _front_block_size(independent);
 
         // Check if size is within bounds.
         if (size <= 0 || size > max_data_size) {
@@ -106,7 +185,7 @@ bool stream::read(std::shared_ptr<io::data>& data, time_t deadline) {
             log_v2::core()->error(
                 "compression: peer {} is sending corrupted data", peer());
           ++skipped;
-          _rbuffer.pop(1);
+          _rbuffer.consume(1);
         } else
           corrupted = false;
       }
@@ -119,13 +198,19 @@ bool stream::read(std::shared_ptr<io::data>& data, time_t deadline) {
       // because of substream shutdown. This indicates that data is
       // corrupted because the size is greater than the remaining
       // payload size.
-      if (_rbuffer.size() >= static_cast<int>(size + sizeof(int32_t))) {
+      if (_rbuffer.size() >= size + sizeof(int32_t)) {
         try {
-          r->get_buffer() =
-              zlib::uncompress(reinterpret_cast<unsigned char const*>(
-                                   (_rbuffer.data() + sizeof(int32_t))),
-                               size);
+          r->get_buffer() = _uncompress(
+              reinterpret_cast<unsigned char const*>(
+                  _rbuffer.contiguous(size + sizeof(int32_t)) +
+                  sizeof(int32_t)),
+              size, independent);
         } catch (exceptions::corruption const& e) {
+          /* zstd and lz4 blocks depend on the previous ones, we cannot
+           * resynchronize the stream. */
+          if (_codec != zlib_codec && !_independent_blocks)
+            throw msg_fmt("compression: peer {} sent corrupted data: {}",
+                          peer(), e.what());
           log_v2::core()->debug(e.what());
         }
       }
@@ -139,14 +224,14 @@ bool stream::read(std::shared_ptr<io::data>& data, time_t deadline) {
           log_v2::core()->error(
               "compression: peer {} is sending corrupted data", peer());
         ++skipped;
-        _rbuffer.pop(1);
+        _rbuffer.consume(1);
         corrupted = true;
       } else {
         log_v2::core()->debug(
             "compression: {:x} uncompressed {} bytes to {} bytes",
             static_cast<void*>(this), size + sizeof(int32_t), r->size());
         data = r;
-        _rbuffer.pop(size + sizeof(int32_t));
+        _rbuffer.consume(size + sizeof(int32_t));
         corrupted = false;
       }
     }
@@ -155,6 +240,7 @@ bool stream::read(std::shared_ptr<io::data>& data, time_t deadline) {
           "compression: peer {} sent {} corrupted compressed bytes, resuming "
           "processing",
           peer(), skipped);
+    _prefetch();
   } catch (exceptions::interrupt const& e) {
     (void)e;
     return true;
@@ -162,8 +248,12 @@ bool stream::read(std::shared_ptr<io::data>& data, time_t deadline) {
     (void)e;
     return false;
   } catch (exceptions::shutdown const& e) {
+    /* The substream may have been removed once entirely read, so nothing
+     * must be written to it anymore. */
     _shutdown = true;
     if (!_wbuffer.empty()) {
+      // The reading of a file caught up with its writing, data not written
+      // yet are given directly.
       std::shared_ptr<io::raw> r(new io::raw);
       r.get()->get_buffer() = _wbuffer;
       data = r;
@@ -181,10 +271,58 @@ bool stream::read(std::shared_ptr<io::data>& data, time_t deadline) {
  *  @param[out] buffer Output buffer.
  */
 void stream::statistics(nlohmann::json& tree) const {
+  tree["compression_codec"] = _codec == zstd_codec  ? "zstd"
+                              : _codec == lz4_codec ? "lz4"
+                                                    : "zlib";
+  tree["compression_ratio"] =
+      _uncompressed_bytes
+          ? static_cast<double>(_compressed_bytes) / _uncompressed_bytes
+          : 0.0;
+  tree["compression_pipelined"] = _pipelined;
+  if (_pipelined) {
+    std::lock_guard<std::mutex> lck(_pipeline->m);
+    tree["compression_blocks_waiting"] =
+        static_cast<double>(_pipeline->to_compress.size());
+  }
   if (_substream)
     _substream->statistics(tree);
 }
 
+/**
+ *  Enable the independent blocks mode, used for files whose first blocks
+ *  may be removed: each block is a zstd frame with a checksum that does not
+ *  depend on the previous ones, flagged in its size. Blocks without the flag
+ *  are read as zlib ones, so files written before this mode are still read.
+ *  It must be set before the first write.
+ */
+void stream::set_independent_blocks() {
+  _independent_blocks = true;
+  if (!_zstd)
+    _zstd = std::make_unique<zstd>(_level);
+}
+
+/**
+ *  Enable or disable the pipelined mode. It must be set before the first
+ *  write.
+ *
+ *  @param[in] pipelined  True to compress and uncompress blocks in the pool.
+ */
+void stream::set_pipelined(bool pipelined) {
+  _pipelined = pipelined;
+  if (_codec == zlib_codec)
+    _max_workers = std::max<size_t>(1, pool::instance().get_pool_size() / 2);
+}
+
+/**
+ *  Give back data read from the substream by the upper layer before this
+ *  stream was inserted. They are read before the next data of the substream.
+ *
+ *  @param[in] data  Compressed data.
+ */
+void stream::unread(std::shared_ptr<io::raw> data) {
+  _rbuffer.push(std::move(data));
+}
+
 /**
  *  Flush the stream.
  *
@@ -192,6 +330,7 @@ void stream::statistics(nlohmann::json& tree) const {
  */
 int stream::flush() {
   _flush();
+  _write_blocks(0);
   return 0;
 }
 
@@ -202,6 +341,7 @@ int stream::flush() {
  */
 int32_t stream::stop() {
   _flush();
+  _write_blocks(0);
   return 0;
 }
 
@@ -244,13 +384,16 @@ int stream::write(std::shared_ptr<io::data> const& d) {
       // Send compressed data if size limit is reached.
       if (_wbuffer.size() >= _size)
         _flush();
+      else if (!_blocks.empty())
+        _write_blocks(max_pipelined_blocks);
     }
   }
   return 1;
 }
 
 /**
- *  Flush data accumulated in write buffer.
+ *  Flush data accumulated in write buffer. In pipelined mode, the buffer is
+ *  given to the pool and only the blocks already compressed are written.
  */
 void stream::_flush() {
   // Check for shutdown stream.
@@ -261,36 +404,219 @@ void stream::_flush() {
         "shutdown");
 
   if (_wbuffer.size() > 0) {
-    // Compress data.
-    std::shared_ptr<io::raw> compressed(new io::raw);
-    std::vector<char>& data(compressed->get_buffer());
-    data = std::move(zlib::compress(_wbuffer, _level));
-    log_v2::core()->debug(
-        "compression: {:x} compressed {} bytes to {} bytes (level {})",
-        static_cast<void*>(this), _wbuffer.size(), compressed->size(), _level);
-    _wbuffer.clear();
-
-    // Add compressed data size.
-    unsigned char buffer[4];
-    uint32_t size(compressed->size());
-    buffer[0] = (size >> 24) & 0xFF;
-    buffer[1] = (size >> 16) & 0xFF;
-    buffer[2] = (size >> 8) & 0xFF;
-    buffer[3] = size & 0xFF;
-    data.insert(data.begin(), buffer, buffer + 4);
-
-    // Send compressed data.
-    _substream->write(compressed);
+    if (_pipelined) {
+      std::shared_ptr<block> b{std::make_shared<block>()};
+      b->size = _wbuffer.size();
+      b->data = std::move(_wbuffer);
+      _wbuffer.clear();
+      _blocks.push_back(b);
+      {
+        std::unique_lock<std::mutex> lck(_pipeline->m);
+        _pipeline->to_compress.push_back(b);
+        if (on_pool_thread())
+          // A job would be queued behind this very thread.
+          _compress_pending(lck);
+        else if (_pipeline->workers < _max_workers) {
+          ++_pipeline->workers;
+          std::shared_ptr<pipeline> p{_pipeline};
+          asio::post(pool::io_context(), [this, p] {
+            std::unique_lock<std::mutex> lck(p->m);
+            if (!p->to_compress.empty())
+              _compress_pending(lck);
+            --p->workers;
+          });
+        }
+      }
+      _write_blocks(max_pipelined_blocks);
+    } else {
+      std::vector<char> data{_compress(_wbuffer)};
+      size_t size{_wbuffer.size()};
+      _wbuffer.clear();
+      _write_block(std::move(data), size);
+    }
+  }
+}
+
+/**
+ *  Compress a block with the codec of the stream.
+ *
+ *  @param[in] data  The block.
+ *
+ *  @return The compressed data.
+ */
+std::vector<char> stream::_compress(std::vector<char> const& data) {
+  if (_independent_blocks)
+    return _zstd->compress_block(data);
+  else if (_codec == zstd_codec)
+    return _zstd->compress(data);
+  else if (_codec == lz4_codec)
+    return _lz4->compress(data);
+  return zlib::compress(data, _level);
+}
+
+/**
+ *  Compress the blocks given by the writer, from a pool job or inline from a
+ *  thread of the pool. Since zstd and lz4 blocks depend on the previous
+ *  ones, only one thread at a time compresses them.
+ *
+ *  @param[in] lck  Lock of the pipeline, it must be held.
+ */
+void stream::_compress_pending(std::unique_lock<std::mutex>& lck) {
+  pipeline& p{*_pipeline};
+  bool sequential{_codec != zlib_codec};
+  while (!p.to_compress.empty() && !(sequential && p.compressing)) {
+    std::shared_ptr<block> b{std::move(p.to_compress.front())};
+    p.to_compress.pop_front();
+    p.compressing = sequential;
+    ++p.running;
+    lck.unlock();
+    std::vector<char> data;
+    std::exception_ptr error;
+    try {
+      data = _compress(b->data);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lck.lock();
+    b->data = std::move(data);
+    b->error = error;
+    b->done = true;
+    if (sequential)
+      p.compressing = false;
+    --p.running;
+    p.cv.notify_all();
+  }
+}
+
+/**
+ *  Wait for a block to be compressed. On a thread of the pool, the job
+ *  compressing it may be queued behind us, so we compress it ourselves.
+ *
+ *  @param[in] b    The block.
+ *  @param[in] lck  Lock of the pipeline, it must be held.
+ */
+void stream::_wait_compressed(const block& b,
+                              std::unique_lock<std::mutex>& lck) {
+  bool pool_thread{on_pool_thread()};
+  while (!b.done) {
+    if (pool_thread)
+      _compress_pending(lck);
+    if (!b.done)
+      _pipeline->cv.wait(lck);
+  }
+}
+
+/**
+ *  Write a compressed block to the substream, with its size.
+ *
+ *  @param[in] data  The compressed block.
+ *  @param[in] size  Its uncompressed size.
+ */
+void stream::_write_block(std::vector<char>&& data, size_t size) {
+  std::shared_ptr<io::raw> compressed(new io::raw);
+  compressed->get_buffer() = std::move(data);
+  _uncompressed_bytes += size;
+  _compressed_bytes += compressed->size() + 4;
+  log_v2::core()->debug(
+      "compression: {:x} compressed {} bytes to {} bytes (level {})",
+      static_cast<void*>(this), size, compressed->size(), _level);
+
+  // Add compressed data size.
+  unsigned char buffer[4];
+  uint32_t csize(compressed->size());
+  if (_independent_blocks)
+    csize |= independent_block_flag;
+  buffer[0] = (csize >> 24) & 0xFF;
+  buffer[1] = (csize >> 16) & 0xFF;
+  buffer[2] = (csize >> 8) & 0xFF;
+  buffer[3] = csize & 0xFF;
+  compressed->get_buffer().insert(compressed->get_buffer().begin(), buffer,
+                                  buffer + 4);
+
+  // Send compressed data.
+  _substream->write(compressed);
+}
+
+/**
+ *  Write the blocks compressed by the pool to the substream, in order.
+ *
+ *  @param[in] max_pending  The number of blocks that can stay in the
+ *                          pipeline, we wait for the others to be compressed.
+ */
+void stream::_write_blocks(size_t max_pending) {
+  while (!_blocks.empty()) {
+    std::shared_ptr<block> b{_blocks.front()};
+    {
+      std::unique_lock<std::mutex> lck(_pipeline->m);
+      if (!b->done) {
+        if (_blocks.size() <= max_pending)
+          break;
+        _wait_compressed(*b, lck);
+      }
+    }
+    _blocks.pop_front();
+    if (b->error)
+      std::rethrow_exception(b->error);
+    _write_block(std::move(b->data), b->size);
   }
 }
 
+/**
+ *  In pipelined mode, if the next block is already in the read buffer, give
+ *  it to the pool to uncompress it while the caller processes the current
+ *  one. A thread of the pool uncompresses it itself on its next read.
+ */
+void stream::_prefetch() {
+  if (!_pipelined || _next_block || _rbuffer.size() < sizeof(int32_t) ||
+      on_pool_thread())
+    return;
+
+  bool independent;
+  size_t size{_front_block_size(independent)};
+  if (size <= 0 || size > max_data_size ||
+      _rbuffer.size() < size + sizeof(int32_t))
+    return;
+
+  std::shared_ptr<block> b{std::make_shared<block>()};
+  b->size = size;
+  char const* p{_rbuffer.contiguous(size + sizeof(int32_t)) +
+                sizeof(int32_t)};
+  b->data.assign(p, p + size);
+  _next_block = b;
+
+  std::shared_ptr<pipeline> pipe{_pipeline};
+  asio::post(pool::io_context(), [this, pipe, b, independent] {
+    std::unique_lock<std::mutex> lck(pipe->m);
+    // The reader took it back.
+    if (b->started)
+      return;
+    b->started = true;
+    ++pipe->running;
+    lck.unlock();
+    std::vector<char> data;
+    std::exception_ptr error;
+    try {
+      data = _uncompress(reinterpret_cast<unsigned char const*>(b->data.data()),
+                         b->data.size(), independent);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lck.lock();
+    b->data = std::move(data);
+    b->error = error;
+    b->done = true;
+    --pipe->running;
+    pipe->cv.notify_all();
+  });
+}
+
 /**
  *  Get data with a size.
  *
  *  @param[in]  size       Data size to get.
  *  @param[in]  deadline   Timeout.
  */
-void stream::_get_data(int size, time_t deadline) {
+void stream::_get_data(size_t size, time_t deadline) {
   try {
     while (_rbuffer.size() < size) {
       std::shared_ptr<io::data> d;
@@ -298,10 +624,8 @@ void stream::_get_data(int size, time_t deadline) {
         throw exceptions::timeout();
       else if (!d)
         throw exceptions::interrupt();
-      else if (d->type() == io::raw::static_type()) {
-        std::shared_ptr<io::raw> r(std::static_pointer_cast<io::raw>(d));
-        _rbuffer.push(r->get_buffer());
-      }
+      else if (d->type() == io::raw::static_type())
+        _rbuffer.push(std::static_pointer_cast<io::raw>(d));
     }
   }
   // If the substream is shutdown, just indicates it and return already
@@ -311,3 +635,49 @@ void stream::_get_data(int size, time_t deadline) {
     _shutdown = true;
   }
 }
+
+/**
+ *  Get the size of the block at the front of the read buffer, that must
+ *  contain at least 4 bytes.
+ *
+ *  @param[out] independent  Set to true if the block was written in
+ *                           independent blocks mode.
+ *
+ *  @return The block size.
+ */
+uint32_t stream::_front_block_size(bool& independent) {
+  unsigned char const* buff(reinterpret_cast<unsigned char const*>(
+      _rbuffer.contiguous(sizeof(int32_t))));
+  uint32_t retval = static_cast<uint32_t>((buff[0] << 24) | (buff[1] << 16) |
+                                          (buff[2] << 8) | (buff[3]));
+  /* Other streams never write this bit since it is above max_data_size, a
+   * block having it is corrupted for them. */
+  independent = _independent_blocks && (retval & independent_block_flag);
+  if (independent)
+    retval &= ~independent_block_flag;
+  return retval;
+}
+
+/**
+ *  Uncompress a block with the codec of the stream.
+ *
+ *  @param[in] data         The block.
+ *  @param[in] nbytes       The block size in bytes.
+ *  @param[in] independent  True if it was written in independent blocks
+ *                          mode, otherwise it is a zlib block for such
+ *                          streams.
+ *
+ *  @return The uncompressed data.
+ */
+std::vector<char> stream::_uncompress(unsigned char const* data,
+                                      unsigned long nbytes,
+                                      bool independent) {
+  if (_independent_blocks)
+    return independent ? _zstd->uncompress_block(data, nbytes)
+                       : zlib::uncompress(data, nbytes);
+  else if (_codec == zstd_codec)
+    return _zstd->uncompress(data, nbytes);
+  else if (_codec == lz4_codec)
+    return _lz4->uncompress(data, nbytes);
+  return zlib::uncompress(data, nbytes);
+}
@@ -0,0 +1,268 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/compression/zstd.hh"
+
+#include <zdict.h>
+#include <zstd.h>
+
+#include "com/centreon/broker/compression/stream.hh"
+#include "com/centreon/broker/exceptions/corruption.hh"
+#include "com/centreon/exceptions/msg_fmt.hh"
+
+using namespace com::centreon::exceptions;
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::compression;
+
+/**
+ *  Constructor.
+ *
+ *  @param[in] compression_level  The compression level, -1 for the zstd
+ *                                default one.
+ *  @param[in] dictionary         A dictionary trained on similar data, used
+ *                                by both the compression and the
+ *                                decompression. Empty for no dictionary.
+ */
+zstd::zstd(int compression_level, const std::string& dictionary)
+    : _cctx{ZSTD_createCCtx()},
+      _dctx{ZSTD_createDCtx()},
+      _bcctx{nullptr},
+      _bdctx{nullptr} {
+  if (!_cctx || !_dctx) {
+    ZSTD_freeCCtx(_cctx);
+    ZSTD_freeDCtx(_dctx);
+    throw msg_fmt("compression: cannot create zstd contexts");
+  }
+  if (compression_level == -1)
+    compression_level = ZSTD_CLEVEL_DEFAULT;
+  _level = compression_level;
+  ZSTD_CCtx_setParameter(_cctx, ZSTD_c_compressionLevel, compression_level);
+  if (!dictionary.empty()) {
+    size_t res =
+        ZSTD_CCtx_loadDictionary(_cctx, dictionary.data(), dictionary.size());
+    if (!ZSTD_isError(res))
+      res =
+          ZSTD_DCtx_loadDictionary(_dctx, dictionary.data(), dictionary.size());
+    if (ZSTD_isError(res)) {
+      ZSTD_freeCCtx(_cctx);
+      ZSTD_freeDCtx(_dctx);
+      throw msg_fmt("compression: cannot load zstd dictionary: {}",
+                    ZSTD_getErrorName(res));
+    }
+  }
+}
+
+/**
+ *  Destructor.
+ */
+zstd::~zstd() noexcept {
+  ZSTD_freeCCtx(_cctx);
+  ZSTD_freeDCtx(_dctx);
+  ZSTD_freeCCtx(_bcctx);
+  ZSTD_freeDCtx(_bdctx);
+}
+
+/**
+ * Compression function. The block is flushed, so it can be uncompressed as
+ * soon as it is received.
+ *
+ * @param data the data to compress.
+ *
+ * @return The same data compressed.
+ */
+std::vector<char> zstd::compress(std::vector<char> const& data) {
+  if (data.empty())
+    return {'\0', '\0', '\0', '\0'};
+
+  size_t nbytes = data.size();
+  std::vector<char> retval(ZSTD_compressBound(nbytes) + 4);
+  ZSTD_inBuffer in{data.data(), nbytes, 0};
+  ZSTD_outBuffer out{retval.data() + 4, retval.size() - 4, 0};
+  size_t remaining;
+  do {
+    remaining = ZSTD_compressStream2(_cctx, &out, &in, ZSTD_e_flush);
+    if (ZSTD_isError(remaining))
+      throw msg_fmt("compression: cannot compress {} bytes with zstd: {}",
+                    nbytes, ZSTD_getErrorName(remaining));
+    if (remaining) {
+      retval.resize(retval.size() + remaining);
+      out.dst = retval.data() + 4;
+      out.size = retval.size() - 4;
+    }
+  } while (remaining);
+
+  retval.resize(out.pos + 4);
+  retval[0] = (nbytes >> 24) & 0xff;
+  retval[1] = (nbytes >> 16) & 0xff;
+  retval[2] = (nbytes >> 8) & 0xff;
+  retval[3] = (nbytes & 0xff);
+  return retval;
+}
+
+/**
+ * Uncompress function
+ *
+ * @param data The data to extract.
+ * @param nbytes The data size in bytes.
+ *
+ * @return the extract data
+ */
+std::vector<char> zstd::uncompress(unsigned char const* data,
+                                   unsigned long nbytes) {
+  if (nbytes < 4)
+    throw exceptions::corruption(
+        "compression: attempting to uncompress data with invalid size");
+  size_t expected_size =
+      (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+  if (expected_size > stream::max_data_size)
+    throw exceptions::corruption("compression: data expected size is too big");
+  std::vector<char> retval(expected_size);
+  if (!expected_size)
+    return retval;
+
+  ZSTD_inBuffer in{data + 4, nbytes - 4, 0};
+  ZSTD_outBuffer out{retval.data(), retval.size(), 0};
+  while (in.pos < in.size) {
+    size_t res = ZSTD_decompressStream(_dctx, &out, &in);
+    if (ZSTD_isError(res))
+      throw exceptions::corruption(
+          "compression: compressed input data is corrupted, unable to "
+          "uncompress it: {}",
+          ZSTD_getErrorName(res));
+    if (out.pos == out.size && in.pos < in.size)
+      break;
+  }
+  if (in.pos != in.size || out.pos != out.size)
+    throw exceptions::corruption(
+        "compression: uncompressed data size does not match the expected "
+        "one");
+  return retval;
+}
+
+/**
+ *  Compress a block alone, in a zstd frame with a checksum. It does not use
+ *  nor change the history of the streaming context.
+ *
+ *  @param[in] data  The data to compress.
+ *
+ *  @return The uncompressed size on 4 bytes followed by the frame.
+ */
+std::vector<char> zstd::compress_block(std::vector<char> const& data) {
+  if (data.empty())
+    return {'\0', '\0', '\0', '\0'};
+
+  size_t nbytes = data.size();
+  std::vector<char> retval(ZSTD_compressBound(nbytes) + 4);
+  if (!_bcctx) {
+    _bcctx = ZSTD_createCCtx();
+    if (!_bcctx)
+      throw msg_fmt("compression: cannot create zstd context");
+    ZSTD_CCtx_setParameter(_bcctx, ZSTD_c_compressionLevel, _level);
+    ZSTD_CCtx_setParameter(_bcctx, ZSTD_c_checksumFlag, 1);
+  }
+  size_t size = ZSTD_compress2(_bcctx, retval.data() + 4, retval.size() - 4,
+                               data.data(), nbytes);
+  if (ZSTD_isError(size))
+    throw msg_fmt("compression: cannot compress {} bytes with zstd: {}",
+                  nbytes, ZSTD_getErrorName(size));
+  retval.resize(size + 4);
+  retval[0] = (nbytes >> 24) & 0xff;
+  retval[1] = (nbytes >> 16) & 0xff;
+  retval[2] = (nbytes >> 8) & 0xff;
+  retval[3] = (nbytes & 0xff);
+  return retval;
+}
+
+/**
+ *  Uncompress a block made by compress_block().
+ *
+ *  @param[in] data    The data to extract.
+ *  @param[in] nbytes  The data size in bytes.
+ *
+ *  @return The extracted data.
+ */
+std::vector<char> zstd::uncompress_block(unsigned char const* data,
+                                         unsigned long nbytes) {
+  if (nbytes < 4)
+    throw exceptions::corruption(
+        "compression: attempting to uncompress data with invalid size");
+  size_t expected_size =
+      (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+  if (expected_size > stream::max_data_size)
+    throw exceptions::corruption("compression: data expected size is too big");
+  std::vector<char> retval(expected_size);
+  if (!expected_size)
+    return retval;
+
+  if (!_bdctx) {
+    _bdctx = ZSTD_createDCtx();
+    if (!_bdctx)
+      throw msg_fmt("compression: cannot create zstd context");
+  }
+  size_t size = ZSTD_decompressDCtx(_bdctx, retval.data(), retval.size(),
+                                    data + 4, nbytes - 4);
+  if (ZSTD_isError(size))
+    throw exceptions::corruption(
+        "compression: compressed input data is corrupted, unable to "
+        "uncompress it: {}",
+        ZSTD_getErrorName(size));
+  if (size != expected_size)
+    throw exceptions::corruption(
+        "compression: uncompressed data size does not match the expected "
+        "one");
+  return retval;
+}
+
+/**
+ *  Get the ID of a dictionary. Both peers must use the same dictionary.
+ *
+ *  @param[in] dictionary  A zstd dictionary.
+ *
+ *  @return Its ID, 0 if it has none.
+ */
+uint32_t zstd::dictionary_id(const std::string& dictionary) {
+  return ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+}
+
+/**
+ *  Train a dictionary on samples of the data to compress, for example the
+ *  blocks written by a compression stream on a recorded poller connection.
+ *
+ *  @param[in] samples   Samples of data.
+ *  @param[in] capacity  Maximum size of the dictionary.
+ *
+ *  @return The dictionary.
+ */
+std::string zstd::train_dictionary(const std::vector<std::string>& samples,
+                                   size_t capacity) {
+  std::string buffer;
+  std::vector<size_t> sizes;
+  sizes.reserve(samples.size());
+  for (auto& s : samples) {
+    buffer.append(s);
+    sizes.push_back(s.size());
+  }
+  std::string retval(capacity, '\0');
+  size_t size = ZDICT_trainFromBuffer(&retval[0], capacity, buffer.data(),
+                                      sizes.data(), sizes.size());
+  if (ZDICT_isError(size))
+    throw msg_fmt("compression: cannot train zstd dictionary: {}",
+                  ZDICT_getErrorName(size));
+  retval.resize(size);
+  return retval;
+}
@@ -26,11 +26,13 @@
 
 #include "com/centreon/broker/config/applier/endpoint.hh"
 #include "com/centreon/broker/config/applier/modules.hh"
+#include "com/centreon/broker/file/splitter.hh"
 #include "com/centreon/broker/instance_broadcast.hh"
 #include "com/centreon/broker/io/data.hh"
 #include "com/centreon/broker/log_v2.hh"
 #include "com/centreon/broker/multiplexing/engine.hh"
 #include "com/centreon/broker/multiplexing/muxer.hh"
+#include "com/centreon/broker/processing/feeder.hh"
 #include "com/centreon/broker/vars.hh"
 #include "com/centreon/exceptions/msg_fmt.hh"
 
@@ -125,6 +127,33 @@ void state::apply(com::centreon::broker::config::state const& s, bool run_mux) {
   // Event queue max size (used to limit memory consumption).
   com::centreon::broker::multiplexing::muxer::event_queue_max_size(
       s.event_queue_max_size());
+  com::centreon::broker::multiplexing::muxer::event_queues_total_size(
+      s.event_queues_total_size());
+
+  // Feeders running on the thread pool instead of their own thread.
+  com::centreon::broker::processing::feeder::pool_mode(
+      s.pool_feeders(), s.pool_feeders_concurrency());
+
+  // Queue files preallocated and mapped in memory.
+  {
+    file::splitter::sync_mode sync = file::splitter::sync_none;
+    uint32_t interval = 0;
+    const std::string& value = s.queue_files_sync();
+    if (value == "batch")
+      sync = file::splitter::sync_batch;
+    else if (value != "none") {
+      char* endptr = nullptr;
+      unsigned long ms = strtoul(value.c_str(), &endptr, 10);
+      if (value.empty() || *endptr)
+        throw msg_fmt(
+            "state applier: queue_files_sync is not valid: it must be 'none', "
+            "'batch' or a duration in milliseconds, not '{}'",
+            value);
+      sync = file::splitter::sync_interval;
+      interval = ms;
+    }
+    file::splitter::mmap_segments(s.queue_files_mmap(), sync, interval);
+  }
 
   com::centreon::broker::config::state st = s;
 
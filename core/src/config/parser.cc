@@ -167,6 +167,30 @@ state parser::parse(std::string const& file) {
                                       &state::event_queue_max_size,
                                       &json::is_number, &json::get<int>))
           ;
+        else if (get_conf<bool, state>({it.key(), it.value()},
+                                       "pool_feeders", retval,
+                                       &state::pool_feeders, &json::is_boolean,
+                                       &json::get<bool>))
+          ;
+        else if (get_conf<int, state>({it.key(), it.value()},
+                                      "pool_feeders_concurrency", retval,
+                                      &state::pool_feeders_concurrency,
+                                      &json::is_number, &json::get<int>))
+          ;
+        else if (get_conf<int64_t, state>(
+                     {it.key(), it.value()}, "event_queues_total_size", retval,
+                     &state::event_queues_total_size, &json::is_number,
+                     &json::get<int64_t>))
+          ;
+        else if (get_conf<bool, state>({it.key(), it.value()},
+                                       "queue_files_mmap", retval,
+                                       &state::queue_files_mmap,
+                                       &json::is_boolean, &json::get<bool>))
+          ;
+        else if (get_conf<state>({it.key(), it.value()}, "queue_files_sync",
+                                 retval, &state::queue_files_sync,
+                                 &json::is_string))
+          ;
         else if (it.key() == "output") {
           if (it.value().is_array()) {
             for (json const& node : it.value()) {
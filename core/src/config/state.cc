@@ -28,8 +28,13 @@ state::state()
       _rpc_port{0},
       _command_protocol{"json"},
       _event_queue_max_size{10000},
+      _event_queues_total_size{0},
       _poller_id{0},
       _pool_size{0},
+      _pool_feeders{false},
+      _pool_feeders_concurrency{0},
+      _queue_files_mmap{false},
+      _queue_files_sync{"none"},
       _log_conf{"/var/log/centreon-broker", "", 0, {}} {}
 
 /**
@@ -46,12 +51,17 @@ state::state(const state& other)
       _command_protocol(other._command_protocol),
       _endpoints(other._endpoints),
       _event_queue_max_size(other._event_queue_max_size),
+      _event_queues_total_size(other._event_queues_total_size),
       _module_dir(other._module_dir),
       _module_list(other._module_list),
       _params(other._params),
       _poller_id(other._poller_id),
       _poller_name(other._poller_name),
-      _pool_size(other._pool_size) {}
+      _pool_size(other._pool_size),
+      _pool_feeders(other._pool_feeders),
+      _pool_feeders_concurrency(other._pool_feeders_concurrency),
+      _queue_files_mmap(other._queue_files_mmap),
+      _queue_files_sync(other._queue_files_sync) {}
 
 /**
  *  Destructor.
@@ -75,12 +85,17 @@ state& state::operator=(state const& other) {
     _command_protocol = other._command_protocol;
     _endpoints = other._endpoints;
     _event_queue_max_size = other._event_queue_max_size;
+    _event_queues_total_size = other._event_queues_total_size;
     _module_dir = other._module_dir;
     _module_list = other._module_list;
     _params = other._params;
     _poller_id = other._poller_id;
     _poller_name = other._poller_name;
     _pool_size = other._pool_size;
+    _pool_feeders = other._pool_feeders;
+    _pool_feeders_concurrency = other._pool_feeders_concurrency;
+    _queue_files_mmap = other._queue_files_mmap;
+    _queue_files_sync = other._queue_files_sync;
   }
   return *this;
 }
@@ -97,12 +112,17 @@ void state::clear() {
   _command_protocol = "json";
   _endpoints.clear();
   _event_queue_max_size = 10000;
+  _event_queues_total_size = 0;
   _module_dir.clear();
   _module_list.clear();
   _params.clear();
   _poller_id = 0;
   _poller_name.clear();
   _pool_size = 0;
+  _pool_feeders = false;
+  _pool_feeders_concurrency = 0;
+  _queue_files_mmap = false;
+  _queue_files_sync = "none";
 }
 
 /**
@@ -233,6 +253,24 @@ int state::event_queue_max_size() const noexcept {
   return _event_queue_max_size;
 }
 
+/**
+ *  Set the memory budget shared by all the event queues.
+ *
+ *  @param[in] val Size limit in bytes, 0 for no limit.
+ */
+void state::event_queues_total_size(int64_t val) noexcept {
+  _event_queues_total_size = val;
+}
+
+/**
+ *  Get the memory budget shared by all the event queues.
+ *
+ *  @return The size limit in bytes, 0 for no limit.
+ */
+int64_t state::event_queues_total_size() const noexcept {
+  return _event_queues_total_size;
+}
+
 /**
  *  Get the module directory.
  *
@@ -337,6 +375,83 @@ int state::pool_size() const noexcept {
   return _pool_size;
 }
 
+/**
+ * @brief Tell if feeders run their event loop as slices on the thread pool
+ * instead of having their own thread.
+ *
+ * @param enabled true to run feeders on the thread pool.
+ */
+void state::pool_feeders(bool enabled) noexcept {
+  _pool_feeders = enabled;
+}
+
+/**
+ * @brief Tell if feeders run on the thread pool.
+ *
+ * @return a boolean.
+ */
+bool state::pool_feeders() const noexcept {
+  return _pool_feeders;
+}
+
+/**
+ * @brief Set the maximum number of feeders running on the thread pool at the
+ * same time.
+ *
+ * @param val A non negative integer. If 0, it is half the pool size.
+ */
+void state::pool_feeders_concurrency(int val) noexcept {
+  _pool_feeders_concurrency = val;
+}
+
+/**
+ * @brief Get the maximum number of feeders running on the thread pool at the
+ * same time.
+ *
+ * @return an integer.
+ */
+int state::pool_feeders_concurrency() const noexcept {
+  return _pool_feeders_concurrency;
+}
+
+/**
+ * @brief Tell if the queue files are preallocated and mapped in memory
+ * instead of being written with stdio.
+ *
+ * @param enabled true to use mmap segments.
+ */
+void state::queue_files_mmap(bool enabled) noexcept {
+  _queue_files_mmap = enabled;
+}
+
+/**
+ * @brief Tell if the queue files use mmap segments.
+ *
+ * @return a boolean.
+ */
+bool state::queue_files_mmap() const noexcept {
+  return _queue_files_mmap;
+}
+
+/**
+ * @brief Set when the mmap segments of queue files are synced to disk.
+ *
+ * @param sync "none" to let the kernel do it, "batch" to sync after each
+ * block written, or a minimum duration in milliseconds between two syncs.
+ */
+void state::queue_files_sync(const std::string& sync) {
+  _queue_files_sync = sync;
+}
+
+/**
+ * @brief Get when the mmap segments of queue files are synced to disk.
+ *
+ * @return "none", "batch" or a duration in milliseconds.
+ */
+const std::string& state::queue_files_sync() const noexcept {
+  return _queue_files_sync;
+}
+
 /**
  *  Set the poller name.
  *
@@ -0,0 +1,290 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/file/segment.hh"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/exceptions/msg_fmt.hh"
+
+using namespace com::centreon::exceptions;
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::file;
+
+constexpr size_t segment::header_size;
+
+/* First integer of the header of a preallocated segment ("CCBS"), it is 0 in
+ * the files written with stdio. */
+constexpr uint32_t preallocated_magic = 0x43434253;
+
+/**
+ *  Make the file at least size bytes long, with its blocks allocated.
+ *
+ *  @param[in] fd    The file descriptor.
+ *  @param[in] from  The current size of the file, its content is kept.
+ *  @param[in] size  The wanted size.
+ *  @param[in] path  The file path, for error messages.
+ */
+static void preallocate(int fd,
+                        size_t from,
+                        size_t size,
+                        const std::string& path) {
+  if (::fallocate(fd, 0, 0, size) == 0)
+    return;
+  if (errno != EOPNOTSUPP)
+    throw msg_fmt("cannot preallocate {} bytes for '{}': {}", size, path,
+                  strerror(errno));
+
+  /* Some file systems do not support fallocate. Zeros are written instead:
+   * in a sparse file, a full disk would only be seen as a SIGBUS when the
+   * mapping is written. */
+  std::vector<char> zeros(65536);
+  while (from < size) {
+    ssize_t wb = ::pwrite(fd, zeros.data(), std::min(zeros.size(), size - from),
+                          from);
+    if (wb < 0) {
+      if (errno == EINTR)
+        continue;
+      throw msg_fmt("cannot preallocate {} bytes for '{}': {}", size, path,
+                    strerror(errno));
+    }
+    from += wb;
+  }
+}
+
+/**
+ *  Open a segment, create it if it does not exist.
+ *
+ *  @param[in] path           Path of the file.
+ *  @param[in] capacity       Size to preallocate. If the data already in the
+ *                            file are bigger, the capacity is their size.
+ *  @param[in] sync_on_close  True to sync the data to disk when the segment
+ *                            is closed.
+ */
+segment::segment(const std::string& path, size_t capacity, bool sync_on_close)
+    : _path{path},
+      _fd{-1},
+      _data{nullptr},
+      _capacity{0},
+      _end{header_size},
+      _synced{0},
+      _preallocated{false},
+      _sync_on_close{sync_on_close} {
+  _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (_fd < 0)
+    throw msg_fmt("cannot open '{}' to read/write: {}", path,
+                  strerror(errno));
+
+  try {
+    struct stat st;
+    if (::fstat(_fd, &st))
+      throw msg_fmt("cannot get the size of '{}': {}", path, strerror(errno));
+    size_t size = st.st_size;
+
+    // Find the end of the data, recorded in the header of preallocated files.
+    uint32_t header[2];
+    if (size >= header_size &&
+        ::pread(_fd, header, header_size, 0) ==
+            static_cast<ssize_t>(header_size) &&
+        ntohl(header[0]) == preallocated_magic)
+      _end = std::max(header_size,
+                      std::min<size_t>(ntohl(header[1]), size));
+    else
+      _end = std::max(size, header_size);
+    _synced = _end;
+
+    _capacity = std::max(capacity, _end);
+    if (_capacity > size)
+      preallocate(_fd, size, _capacity, path);
+    _preallocated = std::max(_capacity, size) > _end;
+
+    void* data = ::mmap(nullptr, _capacity, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED)
+      throw msg_fmt("cannot map '{}' in memory: {}", path, strerror(errno));
+    _data = static_cast<char*>(data);
+  } catch (...) {
+    ::close(_fd);
+    throw;
+  }
+  ::madvise(_data, _capacity, MADV_SEQUENTIAL);
+  _write_header();
+}
+
+/**
+ *  Destructor. The file is truncated to its data.
+ */
+segment::~segment() noexcept {
+  if (_preallocated) {
+    // Truncate first, the header still tells where the data end if we stop
+    // before the end.
+    if (::ftruncate(_fd, _end))
+      log_v2::bbdo()->error("file: cannot truncate '{}' to {} bytes: {}",
+                            _path, _end, strerror(errno));
+    _preallocated = false;
+    _write_header();
+  }
+  if (_sync_on_close && ::msync(_data, _end, MS_SYNC))
+    log_v2::bbdo()->error("file: cannot sync '{}': {}", _path,
+                          strerror(errno));
+  ::munmap(_data, _capacity);
+  ::close(_fd);
+}
+
+/**
+ *  Write the header at the beginning of the mapping.
+ */
+void segment::_write_header() {
+  uint32_t header[2];
+  if (_preallocated) {
+    header[0] = htonl(preallocated_magic);
+    header[1] = htonl(_end);
+  } else {
+    header[0] = 0;
+    header[1] = htonl(header_size);
+  }
+  memcpy(_data, header, header_size);
+}
+
+/**
+ *  Get the size of the mapping.
+ *
+ *  @return A size in bytes.
+ */
+size_t segment::capacity() const {
+  return _capacity;
+}
+
+/**
+ *  Get the offset of the end of the data.
+ *
+ *  @return An offset in bytes from the file beginning.
+ */
+size_t segment::end() const {
+  return _end;
+}
+
+/**
+ *  Read data.
+ *
+ *  @param[in]  offset  Offset in the file.
+ *  @param[out] buffer  Output buffer.
+ *  @param[in]  size    Maximum number of bytes to read.
+ *
+ *  @return Number of bytes read, 0 at the end of the data.
+ */
+size_t segment::read(size_t offset, void* buffer, size_t size) const {
+  if (offset >= _end)
+    return 0;
+  size = std::min(size, _end - offset);
+  memcpy(buffer, _data + offset, size);
+  return size;
+}
+
+/**
+ *  Make the segment able to contain capacity bytes.
+ *
+ *  @param[in] capacity  The new capacity.
+ */
+void segment::reserve(size_t capacity) {
+  if (capacity <= _capacity)
+    return;
+  preallocate(_fd, _capacity, capacity, _path);
+  void* data = ::mremap(_data, _capacity, capacity, MREMAP_MAYMOVE);
+  if (data == MAP_FAILED)
+    throw msg_fmt("cannot map '{}' in memory: {}", _path, strerror(errno));
+  _data = static_cast<char*>(data);
+  _capacity = capacity;
+  _preallocated = _capacity > _end;
+  _write_header();
+}
+
+/**
+ *  Sync the data written since the previous call to disk.
+ */
+void segment::sync() {
+  if (_synced >= _end)
+    return;
+  static const size_t page_size = ::sysconf(_SC_PAGESIZE);
+  size_t from = _synced / page_size * page_size;
+  if (::msync(_data + from, _end - from, MS_SYNC) ||
+      (from && ::msync(_data, header_size, MS_SYNC)))
+    throw msg_fmt("cannot sync '{}': {}", _path, strerror(errno));
+  _synced = _end;
+}
+
+/**
+ *  Write data. The segment grows if needed.
+ *
+ *  @param[in] offset  Offset in the file.
+ *  @param[in] buffer  Data.
+ *  @param[in] size    Number of bytes in buffer.
+ */
+void segment::write(size_t offset, const void* buffer, size_t size) {
+  reserve(offset + size);
+  memcpy(_data + offset, buffer, size);
+  if (offset + size > _end) {
+    _end = offset + size;
+    _write_header();
+  }
+}
+
+/**
+ *  Truncate to its data a file left preallocated, so that it can be read
+ *  and written with stdio.
+ *
+ *  @param[in] path  Path of the file.
+ */
+void segment::recover(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd < 0)
+    return;
+  uint32_t header[2];
+  struct stat st;
+  if (::pread(fd, header, header_size, 0) ==
+          static_cast<ssize_t>(header_size) &&
+      ntohl(header[0]) == preallocated_magic && !::fstat(fd, &st)) {
+    size_t end = std::max(
+        header_size, std::min<size_t>(ntohl(header[1]), st.st_size));
+    log_v2::bbdo()->info(
+        "file: '{}' was not closed, truncating it to its {} bytes of data",
+        path, end);
+    if (::ftruncate(fd, end))
+      log_v2::bbdo()->error("file: cannot truncate '{}' to {} bytes: {}",
+                            path, end, strerror(errno));
+    else {
+      header[0] = 0;
+      header[1] = htonl(header_size);
+      if (::pwrite(fd, header, header_size, 0) !=
+          static_cast<ssize_t>(header_size))
+        log_v2::bbdo()->error("file: cannot write the header of '{}': {}",
+                              path, strerror(errno));
+    }
+  }
+  ::close(fd);
+}
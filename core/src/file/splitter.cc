@@ -21,6 +21,7 @@
 #include <arpa/inet.h>
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
@@ -39,6 +40,10 @@ using namespace com::centreon::exceptions;
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::file;
 
+bool splitter::_mmap_segments = false;
+splitter::sync_mode splitter::_segments_sync = splitter::sync_none;
+uint32_t splitter::_segments_sync_interval = 0;
+
 /**
  *  Build a new splitter.
  *
@@ -63,7 +68,11 @@ splitter::splitter(std::string const& path,
       _wfile{},
       _wmutex{nullptr},
       _wid{0},
-      _woffset{0} {
+      _woffset{0},
+      _mmap{_mmap_segments},
+      _sync{_segments_sync},
+      _sync_interval{_segments_sync_interval},
+      _last_sync{std::chrono::steady_clock::now()} {
   (void)mode;
 
   // Set max file size.
@@ -73,6 +82,14 @@ splitter::splitter(std::string const& path,
   else if (_max_file_size < min_file_size)
     _max_file_size = min_file_size;
 
+  // Segment headers store offsets on 32 bits.
+  if (_mmap && _max_file_size > std::numeric_limits<uint32_t>::max()) {
+    log_v2::bbdo()->info(
+        "file: '{}' is too big to use mmap segments, stdio is used instead",
+        _base_path);
+    _mmap = false;
+  }
+
   // Get IDs of already existing file parts. File parts are suffixed
   // with their order number. A file named /var/lib/foo would have
   // parts named /var/lib/foo, /var/lib/foo1, /var/lib/foo2, ...
@@ -106,6 +123,10 @@ splitter::splitter(std::string const& path,
         continue;
     }
 
+    // A part left preallocated by mmap segments is truncated to its data.
+    if (!_mmap)
+      segment::recover(f);
+
     if (val < _rid)
       _rid = val;
     if (val > _wid)
@@ -142,6 +163,16 @@ void splitter::close() {
     _wfile.reset();
     _wmutex = nullptr;
   }
+  if (_rsegment) {
+    std::lock_guard<std::mutex> lck(*_rmutex);
+    _rsegment.reset();
+    _rmutex = nullptr;
+  }
+  if (_wsegment) {
+    std::lock_guard<std::mutex> lck(*_wmutex);
+    _wsegment.reset();
+    _wmutex = nullptr;
+  }
 }
 
 /**
@@ -153,6 +184,9 @@ void splitter::close() {
  *  @return Number of bytes read.
  */
 long splitter::read(void* buffer, long max_size) {
+  if (_mmap)
+    return _read_segment(buffer, max_size);
+
   if (!_rfile) {
     _open_read_file();
     if (!_rfile)
@@ -223,6 +257,9 @@ long splitter::tell() {
  *  @return Number of bytes written.
  */
 long splitter::write(void const* buffer, long size) {
+  if (_mmap)
+    return _write_segment(buffer, size);
+
   if (!_wfile)
     _open_write_file();
 
@@ -259,11 +296,38 @@ long splitter::write(void const* buffer, long size) {
  *  Flush the write stream.
  */
 void splitter::flush() {
+  if (_mmap) {
+    if (_wsegment && _sync != sync_none) {
+      std::lock_guard<std::mutex> lck(*_wmutex);
+      _wsegment->sync();
+      _last_sync = std::chrono::steady_clock::now();
+    }
+    return;
+  }
   if (fflush(_wfile.get()) == EOF)
     throw msg_fmt("error while writing the file '{}' content: {}",
                   get_file_path(_wid), strerror(errno));
 }
 
+/**
+ *  Continue writing in the next file, unless nothing has been written in the
+ *  current one yet.
+ */
+void splitter::switch_file() {
+  if (_mmap ? !_wsegment : !_wfile)
+    _open_write_file();
+
+  {
+    std::lock_guard<std::mutex> lck(*_wmutex);
+    // Both files and segments begin with an 8-bytes header.
+    if (_woffset <= static_cast<long>(2 * sizeof(uint32_t)))
+      return;
+    ++_wid;
+  }
+  // After this call, _wmutex may change.
+  _open_write_file();
+}
+
 /**
  *  Get the file path matching the ID.
  *
@@ -321,6 +385,32 @@ long splitter::get_woffset() const {
   return _woffset;
 }
 
+/**
+ *  Set how the splitters created from now store their files.
+ *
+ *  @param[in] enabled        True to use preallocated mmap segments instead
+ *                            of stdio.
+ *  @param[in] sync           When the segments are synced to disk.
+ *  @param[in] sync_interval  With sync_interval, the minimum duration in
+ *                            milliseconds between two syncs.
+ */
+void splitter::mmap_segments(bool enabled,
+                             sync_mode sync,
+                             uint32_t sync_interval) noexcept {
+  _mmap_segments = enabled;
+  _segments_sync = sync;
+  _segments_sync_interval = sync_interval;
+}
+
+/**
+ *  Tell if the splitters created from now use mmap segments.
+ *
+ *  @return A boolean.
+ */
+bool splitter::mmap_segments() noexcept {
+  return _mmap_segments;
+}
+
 /**
  *  Remove all the files the splitter is concerned by.
  */
@@ -350,6 +440,27 @@ void splitter::remove_all_files() {
  * @brief Open the splitter in read mode.
  */
 void splitter::_open_read_file() {
+  if (_mmap) {
+    {
+      std::lock_guard<std::mutex> lck(_id_m);
+      if (_rid == _wid && _wsegment) {
+        _rsegment = _wsegment;
+        _rmutex = _wmutex;
+      } else {
+        std::string fname(get_file_path(_rid));
+        _rsegment.reset();
+        if (!misc::filesystem::file_exists(fname))
+          return;
+        _rsegment =
+            std::make_shared<segment>(fname, 0, _sync != sync_none);
+        _rmutex = &_mutex1;
+      }
+    }
+    std::lock_guard<std::mutex> lck(*_rmutex);
+    _roffset = segment::header_size;
+    return;
+  }
+
   {
     std::lock_guard<std::mutex> lck(_id_m);
     if (_rid == _wid && _wfile) {
@@ -380,6 +491,23 @@ void splitter::_open_read_file() {
  * @brief Open the splitter in write mode.
  */
 void splitter::_open_write_file() {
+  if (_mmap) {
+    {
+      std::lock_guard<std::mutex> lck(_id_m);
+      if (_wid == _rid && _rsegment) {
+        _wsegment = _rsegment;
+        _wmutex = _rmutex;
+      } else {
+        _wsegment = std::make_shared<segment>(
+            get_file_path(_wid), _max_file_size, _sync != sync_none);
+        _wmutex = &_mutex2;
+      }
+    }
+    std::lock_guard<std::mutex> lck(*_wmutex);
+    _woffset = _wsegment->end();
+    return;
+  }
+
   {
     std::lock_guard<std::mutex> lck(_id_m);
     if (_wid == _rid && _rfile) {
@@ -417,3 +545,85 @@ void splitter::_open_write_file() {
     _woffset = 2 * sizeof(uint32_t);
   }
 }
+
+/**
+ *  Read data from the mapped segments.
+ *
+ *  @param[out] buffer    Output buffer.
+ *  @param[in]  max_size  Maximum number of bytes that can be read.
+ *
+ *  @return Number of bytes read.
+ */
+long splitter::_read_segment(void* buffer, long max_size) {
+  if (!_rsegment) {
+    _open_read_file();
+    if (!_rsegment)
+      return 0;
+  }
+
+  std::unique_lock<std::mutex> lck(*_rmutex);
+  long rb = _rsegment->read(_roffset, buffer, max_size);
+  std::string file_path(get_file_path(_rid));
+  log_v2::bbdo()->debug("file: read {} bytes from '{}'", rb, file_path);
+  _roffset += rb;
+  if (rb == 0) {
+    if (_auto_delete) {
+      log_v2::bbdo()->info("file: end of file '{}' reached, erasing it",
+                           file_path);
+      std::remove(file_path.c_str());
+    }
+    if (_rid < _wid) {
+      _rid++;
+      lck.unlock();
+      _open_read_file();
+      return _read_segment(buffer, max_size);
+    } else
+      throw exceptions::shutdown("No more data to read");
+  }
+  return rb;
+}
+
+/**
+ *  Write data to the mapped segments.
+ *
+ *  @param[in] buffer  Data.
+ *  @param[in] size    Number of bytes in buffer.
+ *
+ *  @return Number of bytes written.
+ */
+long splitter::_write_segment(void const* buffer, long size) {
+  if (!_wsegment)
+    _open_write_file();
+
+  {
+    std::unique_lock<std::mutex> lck(*_wmutex);
+    // Open next write file is max file size is reached.
+    if ((_woffset + size) > _max_file_size) {
+      ++_wid;
+      lck.unlock();
+      // After this call, _wmutex may change.
+      _open_write_file();
+    }
+  }
+  std::unique_lock<std::mutex> lck(*_wmutex);
+
+  log_v2::bbdo()->debug("file: write request of {} bytes for '{}'", size,
+                        get_file_path(_wid));
+
+  // A segment opened for reading is preallocated once it is written.
+  if (static_cast<size_t>(_woffset + size) > _wsegment->capacity())
+    _wsegment->reserve(std::max(_max_file_size, _woffset + size));
+  _wsegment->write(_woffset, buffer, size);
+  _woffset += size;
+
+  if (_sync == sync_batch)
+    _wsegment->sync();
+  else if (_sync == sync_interval) {
+    auto now = std::chrono::steady_clock::now();
+    if (now - _last_sync >= _sync_interval) {
+      _wsegment->sync();
+      _last_sync = now;
+    }
+  }
+  return size;
+}
@@ -51,6 +51,16 @@ stream::stream(splitter* file)
  */
 stream::~stream() {}
 
+/**
+ *  Give the data written to the system.
+ *
+ *  @return 0, acknowledgements are not counted by file streams.
+ */
+int stream::flush() {
+  _file->flush();
+  return 0;
+}
+
 /**
  *  Get peer name.
  *
@@ -75,9 +85,9 @@ bool stream::read(std::shared_ptr<io::data>& d, time_t deadline) {
 
   d.reset();
 
-  // Build data array.
+  // Build data array, large enough to get a compressed block in a few reads.
   std::unique_ptr<io::raw> data(new io::raw);
-  data->resize(BUFSIZ);
+  data->resize(65536);
 
   // Read data.
   long rb(_file->read(data->data(), data->size()));
@@ -89,6 +99,25 @@ bool stream::read(std::shared_ptr<io::data>& d, time_t deadline) {
   return true;
 }
 
+/**
+ *  Tell if writing some more bytes could make the splitter continue in a new
+ *  file.
+ *
+ *  @param[in] size  Number of bytes.
+ *
+ *  @return true if the current write file may be full after them.
+ */
+bool stream::may_switch_file(long size) const {
+  return _file->get_woffset() + size > _file->get_max_file_size();
+}
+
+/**
+ *  Continue writing in a new file.
+ */
+void stream::switch_file() {
+  _file->switch_file();
+}
+
 /**
  *  Generate statistics about file processing.
  *
@@ -0,0 +1,153 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/io/buffer_chain.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::io;
+
+/**
+ *  Append a buffer at the end of the chain. It is not copied.
+ *
+ *  @param[in] buffer  The buffer.
+ */
+void buffer_chain::push(std::shared_ptr<raw> buffer) {
+  if (buffer && !buffer->empty()) {
+    _size += buffer->size();
+    _segments.push_back({std::move(buffer), 0});
+  }
+}
+
+/**
+ *  Get the first bytes of the chain as a contiguous array. If they are split
+ *  among several buffers, they are copied into a new buffer placed at the
+ *  front of the chain.
+ *
+ *  @param[in] size  Number of bytes needed, not greater than size().
+ *
+ *  @return A pointer to the first byte, valid until the next modification
+ *  of the chain.
+ */
+const char* buffer_chain::contiguous(size_t size) {
+  assert(size <= _size);
+  if (_segments.empty())
+    return nullptr;
+
+  segment* front = &_segments.front();
+  if (front->buffer->size() - front->pos < size) {
+    auto joined = std::make_shared<raw>();
+    std::vector<char>& v = joined->get_buffer();
+    v.reserve(size);
+    while (v.size() < size) {
+      segment& s = _segments.front();
+      size_t len = std::min(s.buffer->size() - s.pos, size - v.size());
+      v.insert(v.end(), s.buffer->const_data() + s.pos,
+               s.buffer->const_data() + s.pos + len);
+      s.pos += len;
+      if (s.pos == s.buffer->size())
+        _segments.pop_front();
+    }
+    _segments.push_front({std::move(joined), 0});
+    front = &_segments.front();
+  }
+  return front->buffer->const_data() + front->pos;
+}
+
+/**
+ *  Remove bytes from the front of the chain.
+ *
+ *  @param[in] size  Number of bytes to remove, not greater than size().
+ */
+void buffer_chain::consume(size_t size) {
+  assert(size <= _size);
+  _size -= size;
+  while (size) {
+    segment& s = _segments.front();
+    size_t len = std::min(s.buffer->size() - s.pos, size);
+    s.pos += len;
+    size -= len;
+    if (s.pos == s.buffer->size())
+      _segments.pop_front();
+  }
+}
+
+/**
+ *  Remove bytes from the front of the chain and return them as a slice. No
+ *  copy is done if they are in one buffer.
+ *
+ *  @param[in] size  Number of bytes to take, not greater than size().
+ *
+ *  @return A slice sharing the buffer containing the bytes.
+ */
+slice buffer_chain::take(size_t size) {
+  if (!size)
+    return {nullptr, nullptr, 0};
+  const char* data = contiguous(size);
+  slice retval{_segments.front().buffer, data, size};
+  consume(size);
+  return retval;
+}
+
+/**
+ *  Get the bytes of the first buffer that are not consumed yet.
+ *
+ *  @param[out] size  Number of bytes available at the returned address.
+ *
+ *  @return A pointer to the first byte of the chain, nullptr if the chain is
+ *  empty.
+ */
+const char* buffer_chain::front(size_t& size) const {
+  if (_segments.empty()) {
+    size = 0;
+    return nullptr;
+  }
+  const segment& s = _segments.front();
+  size = s.buffer->size() - s.pos;
+  return s.buffer->const_data() + s.pos;
+}
+
+/**
+ *  Copy the first bytes of the chain without consuming them.
+ *
+ *  @param[out] dst   Destination, at least size bytes long.
+ *  @param[in]  size  Maximum number of bytes to copy.
+ *
+ *  @return The number of bytes copied.
+ */
+size_t buffer_chain::peek(char* dst, size_t size) const {
+  size_t retval = 0;
+  for (auto it = _segments.begin(); it != _segments.end() && retval < size;
+       ++it) {
+    size_t len = std::min(it->buffer->size() - it->pos, size - retval);
+    memcpy(dst + retval, it->buffer->const_data() + it->pos, len);
+    retval += len;
+  }
+  return retval;
+}
+
+/**
+ *  Remove all the buffers.
+ */
+void buffer_chain::clear() {
+  _segments.clear();
+  _size = 0;
+}
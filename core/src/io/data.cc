@@ -19,15 +19,23 @@
 #include "com/centreon/broker/io/data.hh"
 #include <cassert>
 
+#include "com/centreon/broker/io/events.hh"
+#include "com/centreon/broker/mapping/entry.hh"
+
+using namespace com::centreon::broker;
 using namespace com::centreon::broker::io;
 
+/* Size of a BBDO header, that is also a rough estimation of the memory used
+ * by an event outside of its fields. */
+static constexpr uint32_t header_size = 16;
+
 uint32_t data::broker_id(0);
 
 /**
  *  Constructor.
  */
 data::data(uint32_t type)
-    : _type(type), source_id(broker_id), destination_id(0) {
+    : _type(type), _memory_size(0), source_id(broker_id), destination_id(0) {
   assert(type);
 }
 
@@ -38,6 +46,7 @@ data::data(uint32_t type)
  */
 data::data(data const& other)
     : _type(other._type),
+      _memory_size(0),
       source_id(other.source_id),
       destination_id(other.destination_id) {}
 
@@ -55,6 +64,7 @@ data::~data() {}
  */
 data& data::operator=(data const& other) {
   if (this != &other) {
+    _memory_size = 0;
     source_id = other.source_id;
     destination_id = other.destination_id;
   }
@@ -69,3 +79,63 @@ data& data::operator=(data const& other) {
 uint32_t data::type() const noexcept {
   return _type;
 }
+
+/**
+ *  Get an estimation of the memory used by this event. It is the size of its
+ *  BBDO serialization, computed the first time it is asked and then cached,
+ *  so the event must not be modified after that.
+ *
+ *  @return A size in bytes.
+ */
+uint32_t data::memory_size() const {
+  uint32_t retval = _memory_size.load(std::memory_order_relaxed);
+  if (!retval) {
+    retval = _compute_memory_size();
+    _memory_size.store(retval, std::memory_order_relaxed);
+  }
+  return retval;
+}
+
+/**
+ *  Compute the size of the BBDO serialization of this event from its
+ *  mapping. Events without mapping are only counted for their header.
+ *
+ *  @return A size in bytes.
+ */
+uint32_t data::_compute_memory_size() const {
+  uint32_t retval = header_size;
+  const event_info* info = events::instance().get_event_info(_type);
+  if (info && info->get_mapping()) {
+    for (const mapping::entry* current_entry = info->get_mapping();
+         !current_entry->is_null(); ++current_entry) {
+      if (!current_entry->get_serialize())
+        continue;
+      switch (current_entry->get_type()) {
+        case mapping::source::BOOL:
+          retval += 1;
+          break;
+        case mapping::source::SHORT:
+        case mapping::source::USHORT:
+          retval += 2;
+          break;
+        case mapping::source::INT:
+        case mapping::source::UINT:
+        case mapping::source::TIME:
+          retval += 4;
+          break;
+        case mapping::source::ULONG:
+          retval += 8;
+          break;
+        case mapping::source::DOUBLE:
+          retval += 12;
+          break;
+        case mapping::source::STRING:
+          retval += current_entry->get_string(*this).size() + 1;
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  return retval;
+}
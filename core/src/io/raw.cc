@@ -90,3 +90,12 @@ bool raw::empty() const {
 // void raw::append(const char* msg) {
 //  _buffer.insert(_buffer.end(), msg, msg + strlen(msg));
 //}
+
+/**
+ *  The memory used by a raw event is mainly its buffer.
+ *
+ *  @return A size in bytes.
+ */
+uint32_t raw::_compute_memory_size() const {
+  return sizeof(raw) + _buffer.size();
+}
@@ -49,6 +49,20 @@ int stream::flush() {
   return 0;
 }
 
+/**
+ *  Write several events. The default implementation writes them one by one.
+ *
+ *  @param[in] d  Events to write.
+ *
+ *  @return Number of events acknowledged.
+ */
+int32_t stream::write_batch(const std::vector<std::shared_ptr<data>>& d) {
+  int32_t retval = 0;
+  for (auto& e : d)
+    retval += write(e);
+  return retval;
+}
+
 /**
  *  Get peer name.
  *
@@ -58,6 +72,47 @@ std::string stream::peer() const {
   return !_substream ? "(unknown)" : _substream->peer();
 }
 
+/**
+ *  Get the socket under this stream. Data already written are sent before
+ *  it is returned.
+ *
+ *  @return -1, streams do not have a socket by default.
+ */
+int stream::native_handle() {
+  return -1;
+}
+
+/**
+ *  Get the pool shard running the connection under this stream.
+ *
+ *  @return The shard of the substream, -1 if there is no substream.
+ */
+int stream::shard() const {
+  return _substream ? _substream->shard() : -1;
+}
+
+/**
+ *  Tell if a write would be accepted without waiting for the peer.
+ *
+ *  @return The answer of the substream, true if there is no substream.
+ */
+bool stream::write_ready() const {
+  return _substream ? _substream->write_ready() : true;
+}
+
+/**
+ *  Set the waker to notify when data is available for reading. Streams
+ *  that buffer data only get it from their substream, so the waker is
+ *  given to it.
+ *
+ *  @param[in] waker  The waker to notify, nullptr to stop notifications.
+ *
+ *  @return true if the waker will be notified, false otherwise.
+ */
+bool stream::set_read_waker(const std::shared_ptr<misc::waker>& waker) {
+  return _substream ? _substream->set_read_waker(waker) : false;
+}
+
 /**
  *  Set sub-stream.
  *
@@ -0,0 +1,132 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/misc/buffer_pool.hh"
+
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::misc;
+
+constexpr size_t buffer_pool::min_buffer_size;
+constexpr size_t buffer_pool::max_buffer_size;
+constexpr size_t buffer_pool::max_free_buffers;
+constexpr size_t buffer_pool::size_classes;
+
+/**
+ * @brief Constructor.
+ */
+buffer_pool::buffer_pool() : _allocated{0}, _reused{0} {}
+
+/**
+ * @brief Get the pool shared by all the connections. It is never destroyed:
+ * an io::raw made by make_raw() may be destroyed after the static objects,
+ * its buffer is still given back to the pool.
+ *
+ * @return The pool.
+ */
+buffer_pool& buffer_pool::instance() {
+  static buffer_pool* instance = new buffer_pool;
+  return *instance;
+}
+
+/**
+ * @brief Get a buffer of the given size. A free buffer of the same size
+ * class is reused if there is one, otherwise a new one is allocated. Its
+ * content is undefined.
+ *
+ * @param size The wanted size.
+ *
+ * @return A buffer of size bytes.
+ */
+std::vector<char> buffer_pool::get(size_t size) {
+  std::vector<char> retval;
+  if (size > max_buffer_size) {
+    ++_allocated;
+    retval.resize(size);
+    return retval;
+  }
+
+  size_t c = 0;
+  while ((min_buffer_size << c) < size)
+    ++c;
+  {
+    std::lock_guard<std::mutex> lck(_m);
+    if (!_free[c].empty()) {
+      retval = std::move(_free[c].back());
+      _free[c].pop_back();
+    }
+  }
+  if (retval.capacity())
+    ++_reused;
+  else {
+    ++_allocated;
+    retval.reserve(min_buffer_size << c);
+  }
+  retval.resize(size);
+  return retval;
+}
+
+/**
+ * @brief Wrap a buffer into an io::raw without copy. When the io::raw is
+ * destroyed, its buffer is given back to the pool.
+ *
+ * @param buffer The buffer, usually got from get() and shrunk to the
+ * received size.
+ *
+ * @return A new io::raw.
+ */
+std::shared_ptr<io::raw> buffer_pool::make_raw(std::vector<char>&& buffer) {
+  return std::shared_ptr<io::raw>(new io::raw(std::move(buffer)),
+                                  [this](io::raw* r) {
+                                    release(std::move(r->get_buffer()));
+                                    delete r;
+                                  });
+}
+
+/**
+ * @brief Give a buffer back to the pool, in the biggest size class it can
+ * hold. It is dropped if it is smaller than the first class, bigger than the
+ * last one or if its class is full.
+ *
+ * @param buffer The buffer to keep.
+ */
+void buffer_pool::release(std::vector<char>&& buffer) {
+  size_t capacity = buffer.capacity();
+  if (capacity < min_buffer_size || capacity > max_buffer_size)
+    return;
+  size_t c = 0;
+  while (c + 1 < size_classes && (min_buffer_size << (c + 1)) <= capacity)
+    ++c;
+  std::lock_guard<std::mutex> lck(_m);
+  if (_free[c].size() < max_free_buffers)
+    _free[c].emplace_back(std::move(buffer));
+}
+
+/**
+ * @brief Get statistics.
+ *
+ * @param tree The output tree.
+ */
+void buffer_pool::statistics(nlohmann::json& tree) const {
+  tree["read_buffers_allocated"] = static_cast<double>(_allocated);
+  tree["read_buffers_reused"] = static_cast<double>(_reused);
+  size_t free = 0;
+  std::lock_guard<std::mutex> lck(_m);
+  for (auto& buffers : _free)
+    free += buffers.size();
+  tree["read_buffers_free"] = static_cast<double>(free);
+}
@@ -56,28 +56,53 @@ std::string misc::temp_path() {
   return (path);
 }
 
-static const uint16_t crc_tbl[16] = {
-    0x0000, 0x1081, 0x2102, 0x3183, 0x4204, 0x5285, 0x6306, 0x7387,
-    0x8408, 0x9489, 0xa50a, 0xb58b, 0xc60c, 0xd68d, 0xe70e, 0xf78f};
+namespace {
+/**
+ *  Tables of the reflected CRC16-CCITT (polynomial 0x8408) used by the
+ *  slicing-by-8 algorithm. table[0][b] is the CRC of the byte b, table[k][b]
+ *  is the CRC of the byte b followed by k null bytes.
+ */
+struct crc16_tables {
+  uint16_t table[8][256];
+
+  crc16_tables() {
+    for (uint32_t b = 0; b < 256; ++b) {
+      uint16_t crc = b;
+      for (int i = 0; i < 8; ++i)
+        crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+      table[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; ++b)
+      for (int k = 1; k < 8; ++k)
+        table[k][b] =
+            (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+  }
+};
+
+const crc16_tables crc16;
+}  // namespace
 
 /**
  *
- * Return a crc16 checksum of the given string
+ * Return a crc16 checksum of the given string. Data are processed eight
+ * bytes at a time (slicing-by-8).
  * @param data The string to create the checksum from.
  * @param data_len The length of data to consider.
  *
  * @return The checksum
  */
 uint16_t misc::crc16_ccitt(char const* data, uint32_t data_len) {
+  const auto& t = crc16.table;
   uint16_t crc = 0xffff;
-  uint8_t c;
   const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
-  while (data_len--) {
-    c = *p++;
-    crc = ((crc >> 4) & 0x0fff) ^ crc_tbl[((crc ^ c) & 15)];
-    c >>= 4;
-    crc = ((crc >> 4) & 0x0fff) ^ crc_tbl[((crc ^ c) & 15)];
+  while (data_len >= 8) {
+    crc = t[7][(p[0] ^ crc) & 0xff] ^ t[6][p[1] ^ (crc >> 8)] ^ t[5][p[2]] ^
+          t[4][p[3]] ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    p += 8;
+    data_len -= 8;
   }
+  while (data_len--)
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
   return ~crc & 0xffff;
 }
 
@@ -25,6 +25,7 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -40,10 +41,17 @@ using namespace com::centreon::broker::multiplexing;
 engine* engine::_instance(nullptr);
 std::mutex engine::_load_m;
 
+constexpr size_t engine::ingest_ring_size;
+/* Maximum number of events dispatched while _engine_m is held. */
+constexpr size_t dispatch_batch_size = 1024;
+
 /**
  *  Clear events stored in the multiplexing engine.
  */
 void engine::clear() {
+  std::shared_ptr<io::data> d;
+  while (_ingest.try_pop(d))
+    ;
   while (!_kiew.empty())
     _kiew.pop();
 }
@@ -74,11 +82,15 @@ engine& engine::instance() {
 
 /**
  *  Load engine instance.
+ *
+ *  @param[in] ingest_size  Size of the ingest ring. When it is full,
+ *                          publishers take the locked path of the
+ *                          dispatcher.
  */
-void engine::load() {
+void engine::load(size_t ingest_size) {
   std::lock_guard<std::mutex> lk(_load_m);
   if (!_instance)
-    _instance = new engine;
+    _instance = new engine(ingest_size);
 }
 
 /**
@@ -87,20 +99,57 @@ void engine::load() {
  *  @param[in] e  Event to publish.
  */
 void engine::publish(const std::shared_ptr<io::data>& e) {
-  // Lock mutex.
-  std::lock_guard<std::mutex> lock(_engine_m);
-  _publish(e);
+  if (!_ingest.try_push(e))
+    _push_to_full_ingest(e);
+  _dispatch();
 }
 
 void engine::publish(const std::list<std::shared_ptr<io::data>>& to_publish) {
-  std::lock_guard<std::mutex> lock(_engine_m);
   for (auto& e : to_publish)
-    _publish(e);
+    if (!_ingest.try_push(e))
+      _push_to_full_ingest(e);
+  _dispatch();
+}
+
+/**
+ *  Push an event that does not fit in the full ingest ring. The publisher
+ *  waits for _engine_m instead of spinning, publishes the events of the ring
+ *  and pushes its event again. The drain stops at a slot reserved by another
+ *  publisher but not filled yet, previous events of this publisher may be
+ *  behind it, so the event is never published directly: going through the
+ *  ring keeps it after them.
+ *
+ *  @param[in] e  Event to push.
+ */
+void engine::_push_to_full_ingest(const std::shared_ptr<io::data>& e) {
+  std::lock_guard<std::mutex> lock(_engine_m);
+  for (;;) {
+    _drain_ingest();
+    if (_ingest.try_push(e))
+      return;
+    // The first slot is being filled by another publisher.
+    std::this_thread::yield();
+  }
+}
+
+/**
+ *  Publish all the events of the ingest ring, _engine_m must be locked.
+ */
+void engine::_drain_ingest() {
+  while (_ingest.pop_bulk(_batch, dispatch_batch_size)) {
+    for (auto& e : _batch)
+      _publish(e);
+    _batch.clear();
+    if (_write_func == &engine::_write)
+      _send_to_subscribers();
+  }
 }
 
 /**
  *  Send an event to all subscribers. It must be used from this class, and
  *  _engine_m must be locked previously. Otherwise use engine::publish().
+ *  Events are just queued in _kiew, _send_to_subscribers() has to be called
+ *  then to really send them.
  *
  *  @param[in] e  Event to publish.
  */
@@ -111,6 +160,35 @@ void engine::_publish(std::shared_ptr<io::data> const& e) {
   (this->*_write_func)(e);
 }
 
+/**
+ * @brief Drain the ingest ring if no other thread is already doing it.
+ *
+ * Events are taken by batches, each batch is published with _engine_m locked
+ * only once and sent to the subscribers with _muxers_m locked only once.
+ *
+ * When the dispatcher releases its role, it checks again the ring because a
+ * publisher could have pushed an event just after the last pop and failed to
+ * get the role.
+ */
+void engine::_dispatch() {
+  for (;;) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool expected = false;
+    if (!_dispatching.compare_exchange_strong(expected, true))
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(_engine_m);
+      _drain_ingest();
+    }
+
+    _dispatching.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_ingest.empty())
+      return;
+  }
+}
+
 /**
  *  Start multiplexing.
  */
@@ -174,6 +252,7 @@ void engine::start() {
       _publish(kiew.front());
       kiew.pop();
     }
+    _send_to_subscribers();
   }
 }
 
@@ -203,14 +282,15 @@ void engine::stop() {
     }
 
     do {
-      // Process events from hooks.
+      // Process events from hooks and from publishers.
+      _drain_ingest();
       _send_to_subscribers();
 
       // Make sure that no more data is available.
       lock.unlock();
       usleep(200000);
       lock.lock();
-    } while (!_kiew.empty());
+    } while (!_kiew.empty() || !_ingest.empty());
 
     // Open the cache file and start the transaction.
     // The cache file is used to cache all the events produced
@@ -240,6 +320,7 @@ void engine::stop() {
 void engine::subscribe(muxer* subscriber) {
   std::lock_guard<std::mutex> lock(_muxers_m);
   _muxers.push_back(subscriber);
+  _update_routes();
 }
 
 /**
@@ -284,17 +365,44 @@ void engine::unsubscribe(muxer* subscriber) {
       _muxers.erase(it);
       break;
     }
+  _update_routes();
 }
 
 /**
- *  Default constructor.
+ *  Rebuild the routing table. This method must be called each time the
+ *  write filters of a subscribed muxer change.
  */
-engine::engine()
-    : _hooks{},
+void engine::update_routes() {
+  std::lock_guard<std::mutex> lock(_muxers_m);
+  _update_routes();
+}
+
+/**
+ *  Rebuild the routing table from the muxers write filters. _muxers_m must
+ *  be locked before calling this method, each muxer filters are copied under
+ *  its own mutex.
+ */
+void engine::_update_routes() {
+  _routes.clear();
+  for (muxer* m : _muxers)
+    for (uint32_t type : m->get_write_filters())
+      _routes[type].push_back(m);
+}
+
+/**
+ *  Constructor.
+ *
+ *  @param[in] ingest_size  Size of the ingest ring.
+ */
+engine::engine(size_t ingest_size)
+    : _ingest{ingest_size},
+      _dispatching{false},
+      _hooks{},
       _hooks_begin{_hooks.begin()},
       _hooks_end{_hooks.end()},
       _engine_m{},
       _muxers{},
+      _routes{},
       _muxers_m{},
       _stats{stats::center::instance().register_engine()},
       _unprocessed_events{0u},
@@ -324,23 +432,29 @@ void engine::_nop(std::shared_ptr<io::data> const& d) {
 }
 
 /**
- *  Send queued events to subscribers.
+ *  Send queued events to subscribers. Each event is only given to the muxers
+ *  interested in its type.
  */
 void engine::_send_to_subscribers() {
   // Process all queued events.
   std::lock_guard<std::mutex> lock(_muxers_m);
   while (!_kiew.empty()) {
-    // Send object to every subscriber.
-    for (muxer* m : _muxers)
-      m->publish(_kiew.front());
+    const std::shared_ptr<io::data>& e = _kiew.front();
+    if (e) {
+      auto found = _routes.find(e->type());
+      if (found != _routes.end())
+        for (muxer* m : found->second)
+          m->publish(e);
+    }
     _kiew.pop();
   }
 }
 
 /**
  *  The real event publication is done here. This method is just called by
- *  the publish method. No need of a lock, it is already owned by the publish
- *  method.
+ *  the _publish method. No need of a lock, it is already owned by the
+ *  dispatcher. Hooks are fed with the event, events are sent to subscribers
+ *  once the whole batch is processed.
  *
  *  @param[in] e  Data to publish.
  */
@@ -358,9 +472,6 @@ void engine::_write(std::shared_ptr<io::data> const& e) {
         it->first->read(d);
       }
     }
-
-  // Send events to subscribers.
-  _send_to_subscribers();
 }
 
 /**
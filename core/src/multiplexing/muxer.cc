@@ -18,7 +18,9 @@
 
 #include "com/centreon/broker/multiplexing/muxer.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <limits>
 #include <memory>
 
@@ -30,11 +32,20 @@
 #include "com/centreon/broker/misc/string.hh"
 #include "com/centreon/broker/multiplexing/engine.hh"
 #include "com/centreon/broker/persistent_file.hh"
+#include "com/centreon/broker/stats/center.hh"
 
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::multiplexing;
 
 uint32_t muxer::_event_queue_max_size = std::numeric_limits<uint32_t>::max();
+constexpr size_t muxer::read_batch_size;
+constexpr size_t muxer::read_ahead_size;
+constexpr uint32_t muxer::max_spill_retry_delay;
+uint64_t muxer::_event_queues_total_size = 0;
+std::atomic<uint64_t> muxer::_total_resident_bytes{0};
+std::atomic<time_t> muxer::_last_election{0};
+std::mutex muxer::_muxers_m;
+std::vector<muxer*> muxer::_muxers;
 
 /**
  *  Constructor.
@@ -47,8 +58,15 @@ uint32_t muxer::_event_queue_max_size = std::numeric_limits<uint32_t>::max();
 muxer::muxer(std::string const& name, bool persistent)
     : io::stream("muxer"),
       _events_size(0),
+      _resident_bytes(0),
+      _last_progress(time(nullptr)),
+      _spill_elected(false),
+      _last_stats_update(0),
       _name(name),
-      _persistent(persistent) {
+      _persistent(persistent),
+      _pos(0),
+      _overflow(false),
+      _spill_exit(false) {
   // Load head queue file back in memory.
   if (_persistent) {
     try {
@@ -59,6 +77,7 @@ muxer::muxer(std::string const& name, bool persistent)
         e.reset();
         mf->read(e, 0);
         if (e) {
+          _add_resident_bytes(e->memory_size());
           _events.push_back(e);
           ++_events_size;
         }
@@ -81,6 +100,7 @@ muxer::muxer(std::string const& name, bool persistent)
       _get_event_from_file(e);
       if (!e)
         break;
+      _add_resident_bytes(e->memory_size());
       _events.push_back(e);
       ++_events_size;
     } while (_events_size < event_queue_max_size());
@@ -88,7 +108,18 @@ muxer::muxer(std::string const& name, bool persistent)
     // Queue file was entirely read back.
     (void)e;
   }
-  _pos = _events.begin();
+  _pos = 0;
+
+  // Remaining events in the queue file are read ahead by the spill thread.
+  if (_file) {
+    _overflow = true;
+    _start_spill_thread();
+  }
+
+  {
+    std::lock_guard<std::mutex> lck(_muxers_m);
+    _muxers.push_back(this);
+  }
 
   // Log messages.
   log_v2::perfdata()->info(
@@ -106,7 +137,10 @@ muxer::~muxer() noexcept {
 }
 
 /**
- *  Acknowledge events.
+ *  Acknowledge events. The muxer is locked once and the queue is refilled
+ *  from the read ahead events once, whatever the number of events, so it is
+ *  better to acknowledge a whole batch in one call. The queue file is never
+ *  read here, this is the job of the spill thread.
  *
  *  @param[in] count  Number of events to acknowledge.
  */
@@ -115,31 +149,35 @@ void muxer::ack_events(int count) {
   log_v2::perfdata()->debug(
       "multiplexing: acknowledging {} events from {} event queue", count,
       _name);
-  if (count) {
+  if (count > 0) {
     std::lock_guard<std::mutex> lock(_mutex);
-    for (int i = 0; i < count && !_events.empty(); ++i) {
-      if (_events.begin() == _pos) {
-        log_v2::perfdata()->error(
-            "multiplexing: attempt to acknowledge "
-            "more events than available in {} event queue: {} requested, {} "
-            "acknowledged",
-            _name, count, i);
-        break;
-      }
-      _events.pop_front();
-      --_events_size;
+    size_t acked = count;
+    if (acked > _pos) {
+      log_v2::perfdata()->error(
+          "multiplexing: attempt to acknowledge "
+          "more events than available in {} event queue: {} requested, {} "
+          "acknowledged",
+          _name, count, _pos);
+      acked = _pos;
     }
+    int64_t released = 0;
+    for (auto it = _events.begin(), end = _events.begin() + acked; it != end;
+         ++it)
+      released += (*it)->memory_size();
+    _events.erase(_events.begin(), _events.begin() + acked);
+    _pos -= acked;
+    _events_size -= acked;
+    _add_resident_bytes(-released);
+    _last_progress = time(nullptr);
     log_v2::perfdata()->trace("multiplexing: still {} events in {} event queue",
                               _events_size, _name);
 
-    // Fill memory from file.
-    std::shared_ptr<io::data> e;
-    while (_events_size < event_queue_max_size()) {
-      _get_event_from_file(e);
-      if (!e)
-        break;
-      _push_to_queue(e);
+    // Fill memory from the events read ahead.
+    if (_overflow) {
+      _fill_from_prefetched();
+      _spill_cv.notify_one();
     }
+    _update_stats(false);
   }
 }
 
@@ -176,24 +214,72 @@ uint32_t muxer::event_queue_max_size() noexcept {
 }
 
 /**
- *  Add a new event to the internal event list.
+ *  Set the memory budget shared by all the event queues.
+ *
+ *  @param[in] size  The size limit in bytes, 0 for no limit.
+ */
+void muxer::event_queues_total_size(uint64_t size) noexcept {
+  _event_queues_total_size = size;
+}
+
+/**
+ *  Get the memory budget shared by all the event queues.
+ *
+ *  @return The size limit in bytes, 0 for no limit.
+ */
+uint64_t muxer::event_queues_total_size() noexcept {
+  return _event_queues_total_size;
+}
+
+/**
+ *  Get the memory used by the events of all the muxers.
+ *
+ *  @return A size in bytes.
+ */
+uint64_t muxer::total_resident_bytes() noexcept {
+  return _total_resident_bytes;
+}
+
+/**
+ *  Get the memory used by the events of this muxer.
+ *
+ *  @return A size in bytes.
+ */
+uint64_t muxer::resident_bytes() const noexcept {
+  return _resident_bytes;
+}
+
+/**
+ *  Add a new event to the internal event list. If the event queue is full,
+ *  the event is appended to the spill buffer, the spill thread will write it
+ *  into the queue file, so the caller never waits for the disk.
  *
  *  @param[in] event Event to add.
  */
 void muxer::publish(std::shared_ptr<io::data> const event) {
   if (event) {
+    if (_event_queues_total_size)
+      _elect_spilling_muxers();
+
     std::lock_guard<std::mutex> lock(_mutex);
     // Check if we should process this event.
     if (_write_filters.find(event->type()) == _write_filters.end())
       return;
-    // Check if the event queue limit is reach.
-    if (_events_size >= event_queue_max_size()) {
-      // Try to create file if is necessary.
-      if (!_file)
-        _file.reset(new persistent_file(_queue_file()));
-      _file->write(event);
+    _add_resident_bytes(event->memory_size());
+    // Check if the event queue limit is reach or if older events are still
+    // outside of the queue.
+    if (_overflow || _events_size >= _queue_limit()) {
+      if (!_overflow) {
+        _overflow = true;
+        if (!_spill_thread.joinable())
+          _start_spill_thread();
+      }
+      _spill.push_back(event);
+      if (_spill.size() == 1)
+        _spill_cv.notify_one();
     } else
       _push_to_queue(event);
+    _update_stats(false);
   }
 }
 
@@ -210,7 +296,7 @@ bool muxer::read(std::shared_ptr<io::data>& event, time_t deadline) {
   std::unique_lock<std::mutex> lock(_mutex);
 
   // No data is directly available.
-  if (_pos == _events.end()) {
+  if (_pos == _events.size()) {
     // Wait a while if subscriber was not shutdown.
     if ((time_t)-1 == deadline)
       _cv.wait(lock);
@@ -219,8 +305,8 @@ bool muxer::read(std::shared_ptr<io::data>& event, time_t deadline) {
       timed_out = _cv.wait_for(lock, std::chrono::seconds(deadline - now)) ==
                   std::cv_status::timeout;
     }
-    if (_pos != _events.end()) {
-      event = *_pos;
+    if (_pos < _events.size()) {
+      event = _events[_pos];
       ++_pos;
       lock.unlock();
       if (event)
@@ -230,7 +316,7 @@ bool muxer::read(std::shared_ptr<io::data>& event, time_t deadline) {
   }
   // Data is available, no need to wait.
   else {
-    event = *_pos;
+    event = _events[_pos];
     ++_pos;
     lock.unlock();
   }
@@ -238,6 +324,48 @@ bool muxer::read(std::shared_ptr<io::data>& event, time_t deadline) {
   return !timed_out;
 }
 
+/**
+ *  Get the next available events without waiting more than timeout. The
+ *  muxer is locked only once for the whole batch. Events have then to be
+ *  acknowledged with ack_events().
+ *
+ *  @param[out] events     Cleared and then filled with the next available
+ *                         events.
+ *  @param[in]  max        Maximum number of events to get.
+ *  @param[in]  deadline   Date limit.
+ *
+ *  @return Respect io::stream::read()'s return value.
+ */
+bool muxer::read_batch(std::vector<std::shared_ptr<io::data>>& events,
+                       size_t max,
+                       time_t deadline) {
+  bool timed_out{false};
+  events.clear();
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  // No data is directly available.
+  if (_pos == _events.size()) {
+    // Wait a while if subscriber was not shutdown.
+    if ((time_t)-1 == deadline)
+      _cv.wait(lock);
+    else {
+      time_t now(time(nullptr));
+      timed_out = _cv.wait_for(lock, std::chrono::seconds(deadline - now)) ==
+                  std::cv_status::timeout;
+    }
+  }
+
+  while (_pos < _events.size() && events.size() < max) {
+    events.push_back(_events[_pos]);
+    ++_pos;
+  }
+  lock.unlock();
+
+  if (!events.empty())
+    timed_out = false;
+  return !timed_out;
+}
+
 /**
  *  Set the read filters.
  *
@@ -249,16 +377,30 @@ void muxer::set_read_filters(muxer::filters const& fltrs) {
   _read_filters_str = misc::dump_filters(_read_filters);
 }
 
+/**
+ *  Set the waker notified when events become available for reading.
+ *
+ *  @param[in] waker  The waker, nullptr to stop notifications.
+ */
+void muxer::set_waker(const std::shared_ptr<misc::waker>& waker) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _waker = waker;
+}
+
 /**
  *  Set the write filters.
  *
  *  @param[in] fltrs  Write filters. That is any submitted through
  *                    write() must be in this set otherwise it won't be
- *                    multiplexed.
+ *                    multiplexed. The engine routing table is updated.
  */
 void muxer::set_write_filters(muxer::filters const& fltrs) {
-  _write_filters = fltrs;
-  _write_filters_str = misc::dump_filters(_write_filters);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _write_filters = fltrs;
+    _write_filters_str = misc::dump_filters(_write_filters);
+  }
+  engine::instance().update_routes();
 }
 
 /**
@@ -271,11 +413,12 @@ muxer::filters const& muxer::get_read_filters() const {
 }
 
 /**
- *  Get the write filters.
+ *  Get a copy of the write filters, they may be changed by another thread.
  *
  *  @return  The write filters.
  */
-muxer::filters const& muxer::get_write_filters() const {
+muxer::filters muxer::get_write_filters() const {
+  std::lock_guard<std::mutex> lock(_mutex);
   return _write_filters;
 }
 
@@ -315,7 +458,7 @@ void muxer::nack_events() {
       "multiplexing: reprocessing unacknowledged events from {} event queue",
       _name);
   std::lock_guard<std::mutex> lock(_mutex);
-  _pos = _events.begin();
+  _pos = 0;
 }
 
 /**
@@ -324,10 +467,24 @@ void muxer::nack_events() {
  *  @param[out] buffer Output buffer.
  */
 void muxer::statistics(nlohmann::json& tree) const {
-  // Lock object.
-  std::lock_guard<std::mutex> lock(_mutex);
+  {
+    // Lock object.
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Unacknowledged events count.
+    tree["unacknowledged_events"] = static_cast<int>(_pos);
+
+    // Memory used by the events and memory budget.
+    tree["resident_bytes"] = _resident_bytes.load();
+    tree["spilling"] = _spill_elected.load();
+
+    // Events waiting to be written to or read from the queue file.
+    tree["spill_pending_events"] = static_cast<int>(_spill.size());
+    tree["read_ahead_events"] = static_cast<int>(_prefetched.size());
+  }
 
   // Queue file mode.
+  std::lock_guard<std::mutex> lock(_file_m);
   bool queue_file_enabled(_file.get());
   tree["queue_file_enabled"] = queue_file_enabled == true;
   if (queue_file_enabled) {
@@ -335,12 +492,6 @@ void muxer::statistics(nlohmann::json& tree) const {
     _file->statistics(queue_file);
     tree["queue_file"] = queue_file;
   }
-
-  // Unacknowledged events count.
-  int unacknowledged = 0;
-  for (auto it = _events.begin(); it != _pos; ++it)
-    ++unacknowledged;
-  tree["unacknowledged_events"] = unacknowledged;
 }
 
 /**
@@ -349,6 +500,8 @@ void muxer::statistics(nlohmann::json& tree) const {
 void muxer::wake() {
   std::lock_guard<std::mutex> lock(_mutex);
   _cv.notify_all();
+  if (_waker)
+    _waker->notify();
 }
 
 /**
@@ -389,14 +542,52 @@ std::string muxer::queue_file(std::string const& name) {
 }
 
 /**
- *  Release all events stored within the internal list.
+ *  Release all events stored within the internal list. The spill thread is
+ *  stopped, events it did not write yet are appended to the queue file and
+ *  events it read ahead are saved with the memory queue.
  */
 void muxer::_clean() {
+  {
+    std::lock_guard<std::mutex> lck(_muxers_m);
+    _muxers.erase(std::remove(_muxers.begin(), _muxers.end(), this),
+                  _muxers.end());
+  }
+  stats::center::instance().unregister_muxer(_name);
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _spill_exit = true;
+    _spill_cv.notify_all();
+  }
+  if (_spill_thread.joinable())
+    _spill_thread.join();
+
   std::lock_guard<std::mutex> lock(_mutex);
-  _file.reset();
-  if (_persistent && !_events.empty()) {
+  if (!_spill.empty()) {
     try {
-      log_v2::core()->trace("muxer: sending {} events to {}", _events_size,
+      log_v2::core()->trace("muxer: sending {} events to {}", _spill.size(),
+                            _queue_file());
+      std::vector<std::shared_ptr<io::data>> read_back;
+      for (auto& e : _spill)
+        _write_to_file(e, read_back);
+      for (auto& e : read_back)
+        _prefetched.push_back(std::move(e));
+    } catch (std::exception const& e) {
+      log_v2::perfdata()->error(
+          "multiplexing: could not write spilled events of '{}' to its queue "
+          "file: {}",
+          _name, e.what());
+    }
+    _spill.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lck(_file_m);
+    _file.reset();
+  }
+  if (_persistent && (!_events.empty() || !_prefetched.empty())) {
+    try {
+      log_v2::core()->trace("muxer: sending {} events to {}",
+                            _events_size + _prefetched.size(),
                             _memory_file());
       std::unique_ptr<io::stream> mf(new persistent_file(_memory_file()));
       while (!_events.empty()) {
@@ -404,6 +595,10 @@ void muxer::_clean() {
         _events.pop_front();
         --_events_size;
       }
+      while (!_prefetched.empty()) {
+        mf->write(_prefetched.front());
+        _prefetched.pop_front();
+      }
     } catch (std::exception const& e) {
       log_v2::perfdata()->error(
           "multiplexing: could not backup memory queue of '{}': {}", _name,
@@ -412,11 +607,81 @@ void muxer::_clean() {
   }
   _events.clear();
   _events_size = 0;
+  _prefetched.clear();
+  _overflow = false;
+  _total_resident_bytes -= _resident_bytes;
+  _resident_bytes = 0;
 }
 
 /**
- *  Get event from retention file. Warning: lock _mutex before using
- *  this function.
+ *  Account memory used by events of this muxer.
+ *
+ *  @param[in] size  Bytes to add, negative to release them.
+ */
+void muxer::_add_resident_bytes(int64_t size) {
+  _resident_bytes += size;
+  _total_resident_bytes += size;
+}
+
+/**
+ *  Decide which muxers have to spill to their queue files to respect the
+ *  memory budget. This is done at most once per second. Muxers are sorted by
+ *  their resident bytes weighted by the time elapsed since their last
+ *  acknowledgement, so stalled outputs with big queues are elected first,
+ *  until the others fit in the budget.
+ */
+void muxer::_elect_spilling_muxers() {
+  time_t now = time(nullptr);
+  if (_last_election == now)
+    return;
+
+  std::unique_lock<std::mutex> lck(_muxers_m, std::try_to_lock);
+  if (!lck.owns_lock() || _last_election == now)
+    return;
+  _last_election = now;
+
+  uint64_t total = _total_resident_bytes;
+  std::vector<std::pair<uint64_t, muxer*>> candidates;
+  candidates.reserve(_muxers.size());
+  for (muxer* m : _muxers) {
+    time_t progress = m->_last_progress;
+    uint64_t age = now > progress ? now - progress : 0;
+    candidates.emplace_back(m->_resident_bytes * (age + 1), m);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<uint64_t, muxer*>& a,
+               const std::pair<uint64_t, muxer*>& b) {
+              return a.first > b.first;
+            });
+
+  for (auto& c : candidates) {
+    muxer* m = c.second;
+    bool elect = total > _event_queues_total_size && c.first > 0;
+    if (elect)
+      total -= std::min<uint64_t>(total, m->_resident_bytes);
+    if (m->_spill_elected.exchange(elect) != elect)
+      log_v2::perfdata()->info(
+          "multiplexing: memory budget of {} bytes {}, '{}' {} to its queue "
+          "file",
+          _event_queues_total_size, elect ? "exceeded" : "respected", m->_name,
+          elect ? "spills" : "stops spilling");
+  }
+}
+
+/**
+ *  Move events read ahead from the queue file to the event queue while it is
+ *  not full (_mutex is locked when this method is called).
+ */
+void muxer::_fill_from_prefetched() {
+  while (!_prefetched.empty() && _events_size < _queue_limit()) {
+    _push_to_queue(_prefetched.front());
+    _prefetched.pop_front();
+  }
+}
+
+/**
+ *  Get event from retention file. Once the muxer is built, only the spill
+ *  thread calls this function, with _file_m locked.
  *
  *  @param[out] event  Last event available. Null if none is available.
  */
@@ -436,6 +701,33 @@ void muxer::_get_event_from_file(std::shared_ptr<io::data>& event) {
   }
 }
 
+/**
+ *  Write an event to the queue file, created if needed. A queue file
+ *  entirely read is removed and cannot be written anymore: the events it
+ *  still buffers are moved to read_back and a new queue file is started.
+ *  Like _get_event_from_file(), it is called with _file_m locked.
+ *
+ *  @param[in]  event      Event to write.
+ *  @param[out] read_back  Events still buffered by a queue file entirely
+ *                         read, they are appended.
+ */
+void muxer::_write_to_file(std::shared_ptr<io::data> const& event,
+                           std::vector<std::shared_ptr<io::data>>& read_back) {
+  if (_file) {
+    try {
+      _file->write(event);
+      return;
+    } catch (exceptions::shutdown const& e) {
+      (void)e;
+      std::shared_ptr<io::data> d;
+      for (_get_event_from_file(d); d; _get_event_from_file(d))
+        read_back.push_back(std::move(d));
+    }
+  }
+  _file.reset(new persistent_file(_queue_file()));
+  _file->write(event);
+}
+
 /**
  *  Get memory file path.
  *
@@ -451,16 +743,30 @@ std::string muxer::_memory_file() const {
  *  @param[in] event  New event.
  */
 void muxer::_push_to_queue(std::shared_ptr<io::data> const& event) {
-  bool pos_has_no_more_to_read(_pos == _events.end());
+  bool pos_has_no_more_to_read(_pos == _events.size());
   _events.push_back(event);
   ++_events_size;
 
   if (pos_has_no_more_to_read) {
-    _pos = --_events.end();
     _cv.notify_one();
+    if (_waker)
+      _waker->notify();
   }
 }
 
+/**
+ *  Get the maximum number of events kept in the event queue. When this muxer
+ *  is elected to respect the memory budget, only read_ahead_size events are
+ *  kept.
+ *
+ *  @return A number of events.
+ */
+uint32_t muxer::_queue_limit() const {
+  if (_spill_elected && event_queue_max_size() > read_ahead_size)
+    return read_ahead_size;
+  return event_queue_max_size();
+}
+
 /**
  *  Get queue file path.
  *
@@ -470,6 +776,193 @@ std::string muxer::_queue_file() const {
   return queue_file(_name);
 }
 
+/**
+ *  Start the spill thread (_mutex is locked when this method is called,
+ *  except from the constructor).
+ */
+void muxer::_start_spill_thread() {
+  _spill_thread = std::thread(&muxer::_spill_loop, this);
+  pthread_setname_np(_spill_thread.native_handle(), "muxer_spill");
+}
+
+/**
+ *  Spill thread main loop. It is the only one to access the queue file, so
+ *  the disk latency is never seen by publishers and readers. Batches of
+ *  events are taken from _spill and written to the queue file, and up to
+ *  read_ahead_size events are read back from it before the event queue has
+ *  room for them. When the queue file has been entirely read, the spilled
+ *  events go directly to the read ahead buffer.
+ *
+ *  If the queue file cannot be written or read, nothing is dropped: events
+ *  not written stay in memory in front of _spill, the queue file is kept,
+ *  and the spill thread retries with an increasing delay.
+ */
+void muxer::_spill_loop() {
+  std::deque<std::shared_ptr<io::data>> batch;
+  std::vector<std::shared_ptr<io::data>> read_ahead;
+  /* Consecutive errors on the queue file, the spill thread waits more and
+   * more before retrying. */
+  uint32_t failures = 0;
+  /* Events written to the queue file may still be in its last compression
+   * block, in memory. */
+  bool unflushed = false;
+  auto backoff = [this, &failures](std::unique_lock<std::mutex>& lock) {
+    std::chrono::milliseconds delay{std::min<uint32_t>(
+        max_spill_retry_delay, 100u << std::min(failures, 9u))};
+    ++failures;
+    _spill_cv.wait_for(lock, delay, [this] { return _spill_exit; });
+  };
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_spill_exit) {
+    // Elected by the memory budget, events not sent yet are moved out of the
+    // queue, it is possible as long as nothing is waiting on disk.
+    if (_spill_elected && !_file && _prefetched.empty()) {
+      size_t keep = std::max<size_t>(_pos, _queue_limit());
+      if (_events.size() > keep) {
+        _spill.insert(_spill.begin(), _events.begin() + keep, _events.end());
+        _events.erase(_events.begin() + keep, _events.end());
+        _events_size = _events.size();
+      }
+    }
+
+    _fill_from_prefetched();
+
+    if (!_spill.empty()) {
+      // Nothing waits in the queue file, events can stay in memory.
+      if (!_file)
+        while (!_spill.empty() && _prefetched.size() < read_ahead_size) {
+          _prefetched.push_back(std::move(_spill.front()));
+          _spill.pop_front();
+        }
+
+      if (!_spill.empty()) {
+        batch.swap(_spill);
+        lock.unlock();
+        log_v2::perfdata()->trace("multiplexing: writing {} events to {}",
+                                  batch.size(), _queue_file());
+        int64_t released = 0;
+        size_t written = 0;
+        bool failed = false;
+        try {
+          std::lock_guard<std::mutex> lck(_file_m);
+          for (auto& e : batch) {
+            _write_to_file(e, read_ahead);
+            released += e->memory_size();
+            ++written;
+          }
+        } catch (const std::exception& e) {
+          log_v2::perfdata()->error(
+              "multiplexing: could not write {} events to the queue file of "
+              "'{}', they are kept in memory: {}",
+              batch.size() - written, _name, e.what());
+          failed = true;
+        }
+        _add_resident_bytes(-released);
+        lock.lock();
+        // Events not written go back in front of the spill queue, they are
+        // still in memory and still accounted.
+        if (failed)
+          _spill.insert(_spill.begin(), batch.begin() + written, batch.end());
+        batch.clear();
+        // Events taken back from a queue file entirely read.
+        for (auto& e : read_ahead) {
+          _add_resident_bytes(e->memory_size());
+          _prefetched.push_back(std::move(e));
+        }
+        read_ahead.clear();
+        if (written)
+          unflushed = true;
+        if (failed)
+          backoff(lock);
+        else
+          failures = 0;
+      }
+      continue;
+    }
+
+    if (_file && _prefetched.size() < read_ahead_size) {
+      size_t count = read_ahead_size - _prefetched.size();
+      bool failed = false;
+      lock.unlock();
+      try {
+        std::lock_guard<std::mutex> lck(_file_m);
+        std::shared_ptr<io::data> e;
+        while (read_ahead.size() < count) {
+          _get_event_from_file(e);
+          if (!e)
+            break;
+          read_ahead.push_back(std::move(e));
+        }
+      } catch (const std::exception& e) {
+        // The queue file is kept, the remaining events are read once it
+        // works again.
+        log_v2::perfdata()->error(
+            "multiplexing: could not read the queue file of '{}', retrying: "
+            "{}",
+            _name, e.what());
+        failed = true;
+      }
+      lock.lock();
+      for (auto& e : read_ahead) {
+        _add_resident_bytes(e->memory_size());
+        _prefetched.push_back(std::move(e));
+      }
+      read_ahead.clear();
+      if (failed)
+        backoff(lock);
+      else
+        failures = 0;
+      continue;
+    }
+
+    // All the events are back in memory.
+    if (!_file && _prefetched.empty())
+      _overflow = false;
+
+    // Nothing more to write for a while, the last block goes to disk.
+    if (unflushed) {
+      if (_spill_cv.wait_for(
+              lock, std::chrono::seconds(persistent_file::max_buffer_delay)) ==
+          std::cv_status::timeout) {
+        lock.unlock();
+        try {
+          std::lock_guard<std::mutex> lck(_file_m);
+          if (_file)
+            _file->flush();
+        } catch (const exceptions::shutdown& e) {
+          // The queue file was entirely read, there is nothing to flush.
+          (void)e;
+        } catch (const std::exception& e) {
+          log_v2::perfdata()->error(
+              "multiplexing: could not flush the queue file of '{}': {}",
+              _name, e.what());
+        }
+        lock.lock();
+        unflushed = false;
+      }
+      continue;
+    }
+
+    _spill_cv.wait(lock);
+  }
+}
+
+/**
+ *  Send the statistics of this muxer to the stats center, at most once per
+ *  second unless force is true (_mutex is locked when this method is called).
+ *
+ *  @param[in] force  Update even if it was done less than a second ago.
+ */
+void muxer::_update_stats(bool force) {
+  time_t now = time(nullptr);
+  if (force || now != _last_stats_update) {
+    _last_stats_update = now;
+    stats::center::instance().update_muxer(_name, _resident_bytes,
+                                           _events.size(), _spill_elected,
+                                           _total_resident_bytes);
+  }
+}
+
 /**
  *  Remove all the queue files attached to this muxer.
  */
@@ -17,6 +17,7 @@
 */
 
 #include "com/centreon/broker/persistent_file.hh"
+#include <algorithm>
 #include <memory>
 #include "com/centreon/broker/bbdo/stream.hh"
 #include "com/centreon/broker/compression/stream.hh"
@@ -26,29 +27,49 @@
 
 using namespace com::centreon::broker;
 
+constexpr int persistent_file::max_buffer_delay;
+
+/* When a file is this close to its maximum size, the next events are
+ * written in a new file with a new string table, so that a file can still be
+ * read once the previous ones are removed. The margin is larger than the
+ * data that the compression and BBDO layers may still hold, so the splitter
+ * never switches before. */
+constexpr long file_switch_margin = 1048576;
+
+/* Events are packed in compressed blocks of this size. */
+constexpr size_t block_size = 262144;
+
 /**
  *  Constructor.
  *
- *  @param[in] path  Path of the persistent file.
+ *  @param[in] path           Path of the persistent file.
+ *  @param[in] max_file_size  Maximum size of each file.
  */
-persistent_file::persistent_file(const std::string& path)
-    : io::stream("persistent_file") {
+persistent_file::persistent_file(const std::string& path, long max_file_size)
+    : io::stream("persistent_file"),
+      _switch_margin{std::min(file_switch_margin, max_file_size / 2)},
+      _buffered_since{0},
+      _max_buffer_delay{max_buffer_delay} {
   // On-disk file.
   file::opener opnr;
   opnr.set_filename(path);
+  opnr.set_max_size(max_file_size);
   std::shared_ptr<io::stream> fs(opnr.open());
   _splitter = std::static_pointer_cast<file::stream>(fs);
 
   // Compression layer.
-  std::shared_ptr<compression::stream> cs(
-      std::make_shared<compression::stream>());
+  std::shared_ptr<compression::stream> cs(std::make_shared<compression::stream>(
+      -1, block_size, compression::stream::zstd_codec));
+  cs->set_independent_blocks();
   cs->set_substream(fs);
 
   // BBDO layer.
   std::shared_ptr<bbdo::stream> bs(std::make_shared<bbdo::stream>(true));
   bs->set_coarse(true);
   bs->set_negotiate(false);
+  bs->set_string_table(4096);
   bs->set_substream(cs);
+  _bbdo = bs;
 
   // Set stream.
   io::stream::set_substream(bs);
@@ -81,7 +102,45 @@ void persistent_file::statistics(nlohmann::json& tree) const {
  *  @param[in] d  Input data.
  */
 int32_t persistent_file::write(std::shared_ptr<io::data> const& d) {
-  return _substream->write(d);
+  int32_t retval = 0;
+  if (_splitter->may_switch_file(_switch_margin)) {
+    /* Pending events are written in the current file, the next ones start
+     * the new file with an empty string table. */
+    retval = flush();
+    _splitter->switch_file();
+    _bbdo->reset_string_table();
+  }
+  retval += _substream->write(d);
+
+  time_t now = time(nullptr);
+  if (!_buffered_since)
+    _buffered_since = now;
+  else if (now - _buffered_since >= _max_buffer_delay)
+    retval += flush();
+  return retval;
+}
+
+/**
+ *  Set the number of seconds after which write() writes a block that is not
+ *  full.
+ *
+ *  @param[in] delay  Delay in seconds.
+ */
+void persistent_file::set_max_buffer_delay(int delay) {
+  _max_buffer_delay = delay;
+}
+
+/**
+ *  Write the events kept in memory, even if their compression block is not
+ *  full.
+ *
+ *  @return The number of acknowledged events.
+ */
+int persistent_file::flush() {
+  int retval = _substream->flush();
+  _splitter->flush();
+  _buffered_since = 0;
+  return retval;
 }
 
 /**
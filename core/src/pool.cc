@@ -17,6 +17,8 @@
 */
 #include "com/centreon/broker/pool.hh"
 
+#include <pthread.h>
+
 #include "com/centreon/broker/log_v2.hh"
 #include "com/centreon/broker/stats/center.hh"
 
@@ -92,6 +94,85 @@ pool::pool(size_t size)
   }
 }
 
+/**
+ * @brief Start shards, each one being an io_context run by a thread pinned
+ * to a cpu. Shards already started are kept, so several sharded acceptors
+ * share them.
+ *
+ * @param count The wanted number of shards, 0 for one per cpu.
+ *
+ * @return The number of shards.
+ */
+size_t pool::start_shards(size_t count) {
+  size_t cpus = std::max(std::thread::hardware_concurrency(), 1u);
+  if (count == 0)
+    count = cpus;
+  std::lock_guard<std::mutex> lck(_shards_m);
+  while (_shards.size() < count) {
+    size_t index = _shards.size();
+    auto s = std::make_unique<shard>();
+    asio::io_context& ctx = s->io_context;
+    s->thread = std::thread([&ctx] { ctx.run(); });
+    pthread_setname_np(s->thread.native_handle(), "pool_shard");
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(index % cpus, &cpuset);
+    if (pthread_setaffinity_np(s->thread.native_handle(), sizeof(cpuset),
+                               &cpuset))
+      log_v2::core()->error("pool: cannot pin shard {} to cpu {}", index,
+                            index % cpus);
+    _shards.emplace_back(std::move(s));
+  }
+  log_v2::core()->info("pool: {} shards started", _shards.size());
+  return _shards.size();
+}
+
+/**
+ * @brief Get the io_context of a shard.
+ *
+ * @param index The shard index, it must be less than the number of shards.
+ *
+ * @return The io_context.
+ */
+asio::io_context& pool::shard_context(size_t index) {
+  std::lock_guard<std::mutex> lck(_shards_m);
+  return _shards[index]->io_context;
+}
+
+/**
+ * @brief Get the number of started shards.
+ *
+ * @return A size.
+ */
+size_t pool::get_shards_count() const {
+  std::lock_guard<std::mutex> lck(_shards_m);
+  return _shards.size();
+}
+
+/**
+ * @brief Account connections running on a shard.
+ *
+ * @param index The shard index.
+ * @param count The number of connections added, negative when they are
+ * removed.
+ */
+void pool::add_shard_connections(size_t index, int32_t count) {
+  std::lock_guard<std::mutex> lck(_shards_m);
+  _shards[index]->connections += count;
+}
+
+/**
+ * @brief Get the number of connections running on a shard.
+ *
+ * @param index The shard index.
+ *
+ * @return A number of connections.
+ */
+int32_t pool::get_shard_connections(size_t index) const {
+  std::lock_guard<std::mutex> lck(_shards_m);
+  return _shards[index]->connections;
+}
+
 /**
  * @brief Start the stats of the pool. This method is called by the stats engine
  * when it is ready.
@@ -143,6 +224,13 @@ void pool::_stop() {
       if (t.joinable())
         t.join();
   }
+  std::lock_guard<std::mutex> lck(_shards_m);
+  for (auto& s : _shards) {
+    s->worker.reset();
+    if (s->thread.joinable())
+      s->thread.join();
+  }
+  _shards.clear();
   log_v2::core()->trace("No remaining thread in the pool");
 }
 
@@ -50,7 +50,8 @@ failover::failover(std::shared_ptr<io::endpoint> endp,
       _next_timeout(0),
       _retry_interval(30),
       _subscriber(sbscrbr),
-      _update(false) {
+      _update(false),
+      _waker{std::make_shared<misc::waker>()} {
   log_v2::core()->trace("failover '{}' construction.", _name);
 }
 
@@ -79,6 +80,7 @@ void failover::exit() {
   if (_state != not_started) {
     if (!_should_exit) {
       _should_exit = true;
+      _waker->notify();
       log_v2::processing()->trace("Waiting for {} to be stopped", _name);
 
       _state_cv.wait(lck, [this] { return _state == stopped || _state == not_started; });
@@ -220,14 +222,25 @@ void failover::_run() {
       log_v2::processing()->debug(
           "failover: launching event loop of endpoint '{}'", _name);
       _subscriber->get_muxer().nack_events();
+      _subscriber->get_muxer().set_waker(_waker);
+      /* If the stream cannot notify us, it is still polled every 100ms. */
+      bool stream_notifies;
+      {
+        std::lock_guard<std::timed_mutex> stream_lock(_stream_m);
+        stream_notifies = _stream->set_read_waker(_waker);
+      }
       bool stream_can_read(true);
       bool muxer_can_read(true);
       bool should_commit(false);
       std::shared_ptr<io::data> d;
+      std::vector<std::shared_ptr<io::data>> events;
+      events.reserve(multiplexing::muxer::read_batch_size);
 
       time_t fill_stats_time = time(nullptr);
 
       while (!should_exit()) {
+        uint64_t sequence = _waker->sequence();
+
         // Check for update.
         if (_update) {
           std::lock_guard<std::timed_mutex> stream_lock(_stream_m);
@@ -272,17 +285,17 @@ void failover::_run() {
         }
 
         // Read from muxer stream.
-        d.reset();
         bool timed_out_muxer(true);
         if (muxer_can_read) {
           log_v2::processing()->debug(
-              "failover: reading event from "
+              "failover: reading events from "
               "multiplexing engine for endpoint '{}'",
               _name);
           _update_status("reading event from multiplexing engine");
           try {
-            timed_out_muxer = !_subscriber->get_muxer().read(d, 0);
-            should_commit = should_commit || d;
+            timed_out_muxer = !_subscriber->get_muxer().read_batch(
+                events, multiplexing::muxer::read_batch_size, 0);
+            should_commit = should_commit || !events.empty();
           } catch (exceptions::shutdown const& e) {
             log_v2::processing()->debug(
                 "failover: muxer of endpoint '{}' "
@@ -290,17 +303,17 @@ void failover::_run() {
                 _name, e.what());
             muxer_can_read = false;
           }
-          if (d) {
+          if (!events.empty()) {
             log_v2::processing()->debug(
-                "failover: writing event of multiplexing engine to endpoint "
-                "'{}'",
-                _name);
+                "failover: writing {} events of multiplexing engine to "
+                "endpoint '{}'",
+                events.size(), _name);
             _update_status("writing event to stream");
             int we(0);
 
             try {
               std::lock_guard<std::timed_mutex> stream_lock(_stream_m);
-              we = _stream->write(d);
+              we = _stream->write_batch(events);
             } catch (exceptions::shutdown const& e) {
               log_v2::processing()->debug(
                   "failover: stream of endpoint '{}' shutdown while writing: "
@@ -309,13 +322,13 @@ void failover::_run() {
               muxer_can_read = false;
             }
             _subscriber->get_muxer().ack_events(we);
-            tick();
+            tick(events.size());
             for (std::vector<std::shared_ptr<io::stream> >::iterator
                      it(secondaries.begin()),
                  end(secondaries.end());
                  it != end;) {
               try {
-                (*it)->write(d);
+                (*it)->write_batch(events);
                 ++it;
               } catch (std::exception const& e) {
                 log_v2::processing()->error(
@@ -325,11 +338,12 @@ void failover::_run() {
                 it = secondaries.erase(it);
               }
             }
+            events.clear();
             _update_status("");
           }
         }
 
-        // If both timed out, sleep a while.
+        // If both timed out, wait for one of them to have data.
         d.reset();
         if (timed_out_stream && timed_out_muxer) {
           time_t now(time(nullptr));
@@ -345,7 +359,9 @@ void failover::_run() {
             we = _stream->flush();
           }
           _subscriber->get_muxer().ack_events(we);
-          ::usleep(100000);
+          std::chrono::milliseconds timeout(
+              stream_notifies || !stream_can_read ? 1000 : 100);
+          _waker->wait_for(sequence, timeout);
         }
       }
     }
@@ -461,6 +477,8 @@ void failover::set_buffering_timeout(time_t secs) {
  */
 void failover::set_failover(std::shared_ptr<failover> fo) {
   _failover = fo;
+  if (_failover)
+    _failover->_waker = _waker;
 }
 
 /**
@@ -478,6 +496,7 @@ void failover::set_retry_interval(time_t retry_interval) {
  */
 void failover::update() {
   _update = true;
+  _waker->notify();
 }
 
 /**
@@ -20,17 +20,30 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "com/centreon/broker/exceptions/shutdown.hh"
 #include "com/centreon/broker/io/raw.hh"
 #include "com/centreon/broker/io/stream.hh"
 #include "com/centreon/broker/log_v2.hh"
 #include "com/centreon/broker/multiplexing/muxer.hh"
+#include "com/centreon/broker/pool.hh"
 #include "com/centreon/exceptions/msg_fmt.hh"
 
 using namespace com::centreon::exceptions;
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::processing;
 
+constexpr uint32_t feeder::slice_steps;
+bool feeder::_pool_mode = false;
+uint32_t feeder::_max_concurrent_slices = 0;
+std::mutex feeder::_sched_m;
+std::deque<feeder*> feeder::_ready;
+std::unordered_set<feeder*> feeder::_async_feeders;
+uint32_t feeder::_running_slices = 0;
+std::unique_ptr<asio::steady_timer> feeder::_sched_timer;
+uint32_t feeder::_sched_ticks = 0;
+
 /**
  *  Constructor.
  *
@@ -44,30 +57,96 @@ feeder::feeder(const std::string& name,
                const std::unordered_set<uint32_t>& read_filters,
                const std::unordered_set<uint32_t>& write_filters)
     : stat_visitable(name),
+      _async{_pool_mode},
+      _queued{false},
+      _slice_running{false},
+      _rerun{false},
+      _slice_context{nullptr},
       _state{feeder::stopped},
       _should_exit{false},
       _client(std::move(client)),
-      _subscriber(name, false) {
+      _subscriber(name, false),
+      _waker{std::make_shared<misc::waker>()},
+      _stream_can_read{true},
+      _muxer_can_read{true},
+      _stream_notifies{false},
+      _fill_stats_time{time(nullptr)},
+      _unflushed{false} {
   std::unique_lock<std::mutex> lck(_state_m);
   if (!_client)
     throw msg_fmt("could not process '{}' with no client stream", _name);
 
   _subscriber.get_muxer().set_read_filters(read_filters);
   _subscriber.get_muxer().set_write_filters(write_filters);
+  _subscriber.get_muxer().set_waker(_waker);
 
   set_last_connection_attempt(timestamp::now());
   set_last_connection_success(timestamp::now());
   set_state("connecting");
-  _thread = std::make_unique<std::thread>(&feeder::_callback, this);
-  pthread_setname_np(_thread->native_handle(), "proc_feeder");
-  _state_cv.wait(lck,
-                 [&state = this->_state] { return state != feeder::stopped; });
+  if (_async) {
+    int shard = _client->shard();
+    if (shard < 0) {
+      _slice_context = &pool::io_context();
+      log_v2::processing()->info("feeder: client '{}' runs on the thread pool",
+                                 _name);
+    } else {
+      _slice_context = &pool::instance().shard_context(shard);
+      log_v2::processing()->info(
+          "feeder: client '{}' runs on the shard {} of the thread pool", _name,
+          shard);
+    }
+    _start_loop();
+    _state = feeder::running;
+    lck.unlock();
+    {
+      std::lock_guard<std::mutex> sched_lck(_sched_m);
+      _async_feeders.insert(this);
+      if (!_sched_timer) {
+        _sched_timer = std::make_unique<asio::steady_timer>(pool::io_context());
+        _sched_timer->expires_after(std::chrono::milliseconds(100));
+        _sched_timer->async_wait(&feeder::_tick);
+      }
+    }
+    _waker->set_callback([this] { _schedule(); });
+    _schedule();
+  } else {
+    _thread = std::make_unique<std::thread>(&feeder::_callback, this);
+    pthread_setname_np(_thread->native_handle(), "proc_feeder");
+    _state_cv.wait(lck, [&state = this->_state] {
+      return state != feeder::stopped;
+    });
+  }
 }
 
 /**
  *  Destructor.
  */
 feeder::~feeder() {
+  if (_async) {
+    _should_exit = true;
+    _waker->set_callback(nullptr);
+    {
+      std::unique_lock<std::mutex> lck(_sched_m);
+      if (_queued)
+        _ready.erase(std::find(_ready.begin(), _ready.end(), this));
+      _queued = false;
+      _async_feeders.erase(this);
+      if (_async_feeders.empty())
+        _sched_timer.reset();
+      _slice_cv.wait(lck, [this] { return !_slice_running; });
+    }
+    if (_thread) {
+      _thread->join();
+      return;
+    }
+    std::unique_lock<std::mutex> lock(_state_m);
+    bool finished = _state == feeder::finished;
+    lock.unlock();
+    if (!finished)
+      _finish();
+    return;
+  }
+
   std::unique_lock<std::mutex> lock(_state_m);
   switch (_state) {
     case stopped:
@@ -75,6 +154,7 @@ feeder::~feeder() {
       break;
     case running:
       _should_exit = true;
+      _waker->notify();
       _state_cv.wait(lock, [this] { return _state == finished; });
       break;
     case finished:
@@ -115,6 +195,7 @@ std::string const& feeder::_get_write_filters() const {
  *  @param[in] tree  The statistic tree.
  */
 void feeder::_forward_statistic(nlohmann::json& tree) {
+  tree["execution"] = _async ? "pool" : "thread";
   if (_client_m.try_lock_shared_for(300)) {
     if (_client)
       _client->statistics(tree);
@@ -123,76 +204,122 @@ void feeder::_forward_statistic(nlohmann::json& tree) {
   _subscriber.get_muxer().statistics(tree);
 }
 
+/**
+ *  Prepare the event loop: the client stream is told to notify the waker
+ *  when it has data.
+ */
+void feeder::_start_loop() {
+  set_state("connected");
+  _events.reserve(multiplexing::muxer::read_batch_size);
+  /* If the client cannot notify us, it is still polled every 100ms. */
+  misc::read_lock lock(_client_m);
+  _stream_notifies = _client->set_read_waker(_waker);
+}
+
+/**
+ *  One step of the event loop: an event is read from the client stream and
+ *  sent to the muxer, or a batch of events is read from the muxer and sent
+ *  to the client stream.
+ *
+ *  @return false if neither the stream nor the muxer had something to read.
+ */
+bool feeder::_step() {
+  std::shared_ptr<io::data> d;
+
+  // Filling stats
+  if (time(nullptr) >= _fill_stats_time) {
+    _fill_stats_time += 5;
+    set_queued_events(_subscriber.get_muxer().get_event_queue_size());
+  }
+
+  // Read from stream.
+  bool timed_out_stream(true);
+  if (_stream_can_read) {
+    try {
+      misc::read_lock lock(_client_m);
+      timed_out_stream = !_client->read(d, 0);
+    } catch (exceptions::shutdown const& e) {
+      _stream_can_read = false;
+    }
+    if (d) {
+      log_v2::processing()->trace(
+          "feeder '{}': sending 1 event from stream to muxer", _name);
+      {
+        misc::read_lock lock(_client_m);
+        _subscriber.get_muxer().write(d);
+      }
+      tick();
+      return true;  // Stream read bias.
+    }
+  }
+
+  // Read from muxer, unless events are still waiting for the client.
+  bool timed_out_muxer(true);
+  if (_muxer_can_read && _events.empty())
+    try {
+      timed_out_muxer = !_subscriber.get_muxer().read_batch(
+          _events, multiplexing::muxer::read_batch_size, 0);
+    } catch (exceptions::shutdown const& e) {
+      _muxer_can_read = false;
+    }
+  if (!_events.empty() && _async && !_client->write_ready()) {
+    /* A slice cannot wait for the peer, the thread may be the one serving
+     * its connection. The events are kept, the waker is notified when
+     * credits come or when the write queue drains. */
+    log_v2::processing()->trace(
+        "feeder '{}': client not ready, {} events kept", _name,
+        _events.size());
+    return !timed_out_stream;
+  }
+  if (!_events.empty()) {
+    log_v2::processing()->trace(
+        "feeder '{}': sending {} events from muxer to client", _name,
+        _events.size());
+    {
+      misc::read_lock lock(_client_m);
+      _client->write_batch(_events);
+    }
+    _subscriber.get_muxer().ack_events(_events.size());
+    tick(_events.size());
+    _events.clear();
+    _unflushed = true;
+  } else if (_unflushed && (!_async || _client->write_ready())) {
+    /* The client may keep events to send them together, they are sent as
+     * soon as the muxer is empty. In pool mode, a flush would add them to a
+     * queue already full, they are sent by a later slice. */
+    misc::read_lock lock(_client_m);
+    _client->flush();
+    _unflushed = false;
+  }
+
+  return !timed_out_stream || !timed_out_muxer;
+}
+
+/**
+ *  Event loop of a feeder running in its own thread.
+ */
 void feeder::_callback() noexcept {
   log_v2::processing()->info("feeder: thread of client '{}' is starting",
                              _name);
-  time_t fill_stats_time = time(nullptr);
 
   try {
     std::unique_lock<std::mutex> lock(_state_m);
-    set_state("connected");
-    bool stream_can_read(true);
-    bool muxer_can_read(true);
-    std::shared_ptr<io::data> d;
+    _start_loop();
     _state = feeder::running;
     _state_cv.notify_all();
     lock.unlock();
     while (!_should_exit) {
-      // Read from stream.
-      bool timed_out_stream(true);
+      uint64_t sequence = _waker->sequence();
 
-      // Filling stats
-      if (time(nullptr) >= fill_stats_time) {
-        fill_stats_time += 5;
-        set_queued_events(_subscriber.get_muxer().get_event_queue_size());
-      }
-
-      if (stream_can_read) {
-        try {
-          misc::read_lock lock(_client_m);
-          timed_out_stream = !_client->read(d, 0);
-        } catch (exceptions::shutdown const& e) {
-          stream_can_read = false;
-        }
-        if (d) {
-          log_v2::processing()->trace(
-              "feeder '{}': sending 1 event from stream to muxer", _name);
-          {
-            misc::read_lock lock(_client_m);
-            _subscriber.get_muxer().write(d);
-          }
-          tick();
-          continue;  // Stream read bias.
-        }
-      }
-
-      // Read from muxer.
-      d.reset();
-      bool timed_out_muxer(true);
-      if (muxer_can_read)
-        try {
-          timed_out_muxer = !_subscriber.get_muxer().read(d, 0);
-        } catch (exceptions::shutdown const& e) {
-          muxer_can_read = false;
-        }
-      if (d) {
-        log_v2::processing()->trace(
-            "feeder '{}': sending 1 event from muxer to client", _name);
-        {
-          misc::read_lock lock(_client_m);
-          _client->write(d);
-        }
-        _subscriber.get_muxer().ack_events(1);
-        tick();
-      }
-
-      // If both timed out, sleep a while.
-      d.reset();
-      if (timed_out_stream && timed_out_muxer) {
+      // If both timed out, wait for one of them to have data.
+      if (!_step()) {
+        std::chrono::milliseconds timeout(
+            _stream_notifies || !_stream_can_read ? 1000 : 100);
         log_v2::processing()->trace(
-            "feeder '{}': timeout on stream and muxer, waiting for 100000µs",
-            _name);
-        ::usleep(100000);
+            "feeder '{}': timeout on stream and muxer, waiting for at most "
+            "{}ms",
+            _name, timeout.count());
+        _waker->wait_for(sequence, timeout);
       }
     }
   } catch (exceptions::shutdown const& e) {
@@ -207,9 +334,20 @@ void feeder::_callback() noexcept {
         "feeder: unknown error occured while processing client '{}'", _name);
   }
 
+  _finish();
+  log_v2::core()->info("feeder: thread of client '{}' will exit", _name);
+}
+
+/**
+ *  Stop the event loop: the client stream is stopped and released, and the
+ *  queue files are removed.
+ */
+void feeder::_finish() noexcept {
   /* If we are here, that is because the loop is finished, and if we want
    * is_finished() to return true, we have to set _should_exit to true. */
   _should_exit = true;
+  if (_async)
+    _waker->set_callback(nullptr);
   std::unique_lock<std::mutex> lock_stop(_state_m);
   _state = feeder::finished;
   _state_cv.notify_all();
@@ -231,7 +369,146 @@ void feeder::_callback() noexcept {
     log_v2::core()->info("feeder: queue files of client '{}' removed", _name);
     _subscriber.get_muxer().remove_queue_files();
   }
-  log_v2::core()->info("feeder: thread of client '{}' will exit", _name);
+}
+
+/**
+ *  Run a slice of the event loop on the thread pool.
+ *
+ *  @return true if the feeder still has work to do.
+ */
+bool feeder::_slice() noexcept {
+  try {
+    for (uint32_t i = 0; i < slice_steps; ++i) {
+      if (_should_exit || !_step())
+        return false;
+    }
+    return !_should_exit;
+  } catch (exceptions::shutdown const& e) {
+    // Normal termination.
+    (void)e;
+    log_v2::core()->info("feeder '{}' shut down", get_name());
+  } catch (const std::exception& e) {
+    set_last_error(e.what());
+    log_v2::core()->error("feeder '{}' error:{} ", _name, e.what());
+  } catch (...) {
+    log_v2::core()->error(
+        "feeder: unknown error occured while processing client '{}'", _name);
+  }
+  /* Stopping the client waits for the ack of the peer, it cannot be done on
+   * the pool, where the connection may need this very thread. No slice is
+   * scheduled anymore. */
+  _should_exit = true;
+  _thread = std::make_unique<std::thread>(&feeder::_finish, this);
+  pthread_setname_np(_thread->native_handle(), "proc_feeder");
+  return false;
+}
+
+/**
+ *  Queue this feeder for a slice, or ask the running slice to be followed by
+ *  another one. It is called when the stream or the muxer has data.
+ */
+void feeder::_schedule() {
+  std::lock_guard<std::mutex> lck(_sched_m);
+  if (_should_exit)
+    return;
+  if (_slice_running)
+    _rerun = true;
+  else if (!_queued) {
+    _queued = true;
+    _ready.push_back(this);
+    _pump();
+  }
+}
+
+/**
+ *  Post slices of the first queued feeders to the pool, as long as the
+ *  maximum number of concurrent slices is not reached (_sched_m must be
+ *  locked).
+ */
+void feeder::_pump() {
+  uint32_t max = _max_concurrent_slices;
+  if (!max)
+    max = std::max<uint32_t>(1, pool::instance().get_pool_size() / 2);
+  while (_running_slices < max && !_ready.empty()) {
+    feeder* f = _ready.front();
+    _ready.pop_front();
+    f->_queued = false;
+    f->_slice_running = true;
+    ++_running_slices;
+    asio::post(*f->_slice_context, [f] {
+      bool again = f->_slice();
+      _slice_done(f, again);
+    });
+  }
+}
+
+/**
+ *  Called at the end of a slice. The feeder goes back at the end of the
+ *  queue if it still has work to do.
+ *
+ *  @param[in] f      The feeder.
+ *  @param[in] again  true if the slice stopped before being idle.
+ */
+void feeder::_slice_done(feeder* f, bool again) {
+  std::lock_guard<std::mutex> lck(_sched_m);
+  f->_slice_running = false;
+  --_running_slices;
+  if ((again || f->_rerun) && !f->_should_exit) {
+    f->_queued = true;
+    _ready.push_back(f);
+  }
+  f->_rerun = false;
+  f->_slice_cv.notify_all();
+  _pump();
+}
+
+/**
+ *  Scheduler timer, every 100ms. Feeders whose stream cannot notify them are
+ *  polled, and all the idle feeders get a slice every second, to fill their
+ *  statistics.
+ *
+ *  @param[in] ec  Error if the timer was cancelled.
+ */
+void feeder::_tick(const asio::error_code& ec) {
+  if (ec)
+    return;
+  std::lock_guard<std::mutex> lck(_sched_m);
+  if (!_sched_timer)
+    return;
+  ++_sched_ticks;
+  for (feeder* f : _async_feeders)
+    if (!f->_should_exit && !f->_queued && !f->_slice_running &&
+        (!f->_stream_notifies || _sched_ticks % 10 == 0)) {
+      f->_queued = true;
+      _ready.push_back(f);
+    }
+  _pump();
+  _sched_timer->expires_after(std::chrono::milliseconds(100));
+  _sched_timer->async_wait(&feeder::_tick);
+}
+
+/**
+ *  Choose how the next feeders run their event loop.
+ *
+ *  @param[in] enabled                true to run them on the thread pool,
+ *                                    false for a thread per feeder.
+ *  @param[in] max_concurrent_slices  Maximum number of feeders running on
+ *                                    the pool at the same time, 0 for half
+ *                                    the pool size.
+ */
+void feeder::pool_mode(bool enabled, uint32_t max_concurrent_slices) {
+  std::lock_guard<std::mutex> lck(_sched_m);
+  _pool_mode = enabled;
+  _max_concurrent_slices = max_concurrent_slices;
+}
+
+/**
+ *  Tell if new feeders run on the thread pool.
+ *
+ *  @return true in pool mode.
+ */
+bool feeder::pool_mode() noexcept {
+  return _pool_mode;
 }
 
 uint32_t feeder::_get_queued_events() const {
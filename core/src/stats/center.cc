@@ -279,6 +279,42 @@ bool center::unregister_mysql_connection(SqlConnectionStats* connection) {
 //  return retval.get();
 //}
 
+/**
+ * @brief Update the statistics of a muxer. They are created the first time
+ * this function is called for the muxer. It does not wait for the update to
+ * be done.
+ *
+ * @param name The muxer name.
+ * @param resident_bytes Memory used by the events of the muxer.
+ * @param queued_events Number of events in the muxer queue.
+ * @param spilling True if the memory budget makes it spill to its queue file.
+ * @param total_resident_bytes Memory used by the events of all the muxers.
+ */
+void center::update_muxer(const std::string& name,
+                          uint64_t resident_bytes,
+                          uint32_t queued_events,
+                          bool spilling,
+                          uint64_t total_resident_bytes) {
+  _strand.post([this, name, resident_bytes, queued_events, spilling,
+                total_resident_bytes] {
+    auto& m = (*_stats.mutable_muxers())[name];
+    m.set_resident_bytes(resident_bytes);
+    m.set_queued_events(queued_events);
+    m.set_spilling(spilling);
+    _stats.set_event_queues_resident_bytes(total_resident_bytes);
+  });
+}
+
+/**
+ * @brief Remove the statistics of a muxer. It does not wait for the removal
+ * to be done.
+ *
+ * @param name The muxer name.
+ */
+void center::unregister_muxer(const std::string& name) {
+  _strand.post([this, name] { _stats.mutable_muxers()->erase(name); });
+}
+
 /**
  * @brief Convert the protobuf statistics object to a json string.
  *
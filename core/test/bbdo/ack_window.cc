@@ -0,0 +1,203 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "com/centreon/broker/bbdo/internal.hh"
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+#include "pipe_end.hh"
+
+using namespace com::centreon::broker;
+
+class BbdoAckWindow : public BbdoPipe {
+ public:
+  static std::list<std::shared_ptr<io::extension>> ack_window(
+      const std::string& max = "100000") {
+    auto ext = std::make_shared<io::extension>(BBDO_ACK_WINDOW_EXTENSION,
+                                               true, false);
+    ext->mutable_options()["ack_window_max"] = max;
+    return {ext};
+  }
+
+  static std::shared_ptr<neb::service_status> make_status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = 12;
+    ss->service_id = i;
+    ss->output = "OK";
+    return ss;
+  }
+};
+
+// Given two BBDO streams supporting credits and a slow reader
+// When many events are written
+// Then the writer waits for credits and never has more events in flight than
+// the maximum window
+// And all the events are read in order
+// And both peers know the window and the writer measured the ack round trip.
+TEST_F(BbdoAckWindow, CreditsBoundInFlight) {
+  constexpr uint32_t count = 20000;
+  bbdo::stream out(false, ack_window());
+  bbdo::stream in(true, ack_window("500"));
+  in.set_ack_limit(100);
+  connect(out, in);
+
+  // The reader sent its first window at the end of the negotiation.
+  std::shared_ptr<io::data> e;
+  ASSERT_FALSE(out.read(e, time(nullptr)));
+  nlohmann::json tree_out, tree_in;
+  out.statistics(tree_out);
+  ASSERT_EQ(tree_out["bbdo_peer_window"].get<double>(), 200);
+
+  std::thread reader([&in] {
+    std::shared_ptr<io::data> e;
+    for (uint32_t i = 0; i < count; ++i) {
+      ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+      ASSERT_EQ(std::static_pointer_cast<neb::service_status>(e)->service_id,
+                i);
+      if (i % 1000 == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  });
+
+  double max_in_flight = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    out.write(make_status(i));
+    nlohmann::json tree;
+    out.statistics(tree);
+    max_in_flight =
+        std::max(max_in_flight, tree["bbdo_events_in_flight"].get<double>());
+  }
+  reader.join();
+  ASSERT_LE(max_in_flight, 500);
+
+  out.statistics(tree_out);
+  in.statistics(tree_in);
+  ASSERT_TRUE(tree_out["bbdo_ack_window"].get<bool>());
+  ASSERT_GT(tree_out["bbdo_window_waits"].get<double>(), 0);
+  ASSERT_GT(tree_out["bbdo_ack_rtt_ms"].get<double>(), 0);
+  ASSERT_GE(tree_in["bbdo_window_advertised"].get<double>(), 200);
+  ASSERT_LE(tree_in["bbdo_window_advertised"].get<double>(), 500);
+}
+
+// Given a reader that received fewer events than its ack limit
+// When no event is received for a while
+// Then the events are acknowledged anyway.
+TEST_F(BbdoAckWindow, TimeBoundedAck) {
+  bbdo::stream out(false);
+  bbdo::stream in(true);
+  connect(out, in);
+
+  std::shared_ptr<io::data> e;
+  for (uint32_t i = 0; i < 10; ++i)
+    out.write(make_status(i));
+  for (uint32_t i = 0; i < 10; ++i)
+    ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  ASSERT_FALSE(in.read(e, time(nullptr)));
+  ASSERT_FALSE(out.read(e, time(nullptr) + 1));
+  ASSERT_EQ(out.flush(), 10);
+}
+
+// Given a BBDO stream supporting credits and a peer that does not
+// When they negotiate
+// Then the writer is not limited by a window and acks are still handled.
+TEST_F(BbdoAckWindow, PeerWithoutExtension) {
+  constexpr uint32_t count = 5000;
+  bbdo::stream out(false, ack_window());
+  bbdo::stream in(true);
+  in.set_ack_limit(100);
+  connect(out, in);
+
+  for (uint32_t i = 0; i < count; ++i)
+    out.write(make_status(i));
+  nlohmann::json tree;
+  out.statistics(tree);
+  ASSERT_FALSE(tree["bbdo_ack_window"].get<bool>());
+  ASSERT_EQ(tree["bbdo_events_in_flight"].get<double>(), count);
+
+  std::shared_ptr<io::data> e;
+  for (uint32_t i = 0; i < count; ++i)
+    ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+  ASSERT_FALSE(out.read(e, time(nullptr) + 1));
+  ASSERT_EQ(out.flush(), static_cast<int>(count));
+}
+
+// Given a writer that read events from its peer while waiting for credits
+// When it stops before they are read
+// Then they are not acknowledged to the peer.
+TEST_F(BbdoAckWindow, HeldEventsAreNotAcknowledged) {
+  bbdo::stream out(false, ack_window());
+  bbdo::stream in(true, ack_window("500"));
+  in.set_ack_limit(100);
+  connect(out, in);
+
+  std::shared_ptr<io::data> e;
+  ASSERT_FALSE(out.read(e, time(nullptr)));
+  for (uint32_t i = 0; i < 10; ++i)
+    in.write(make_status(i));
+  in.flush();
+
+  // The window of 200 events is full, the writer waits for credits and
+  // reads the 10 events of its peer meanwhile.
+  std::thread writer([&out] {
+    for (uint32_t i = 0; i < 201; ++i)
+      out.write(make_status(i));
+    out.flush();
+  });
+  for (uint32_t i = 0; i < 201; ++i)
+    ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+  writer.join();
+  nlohmann::json tree;
+  out.statistics(tree);
+  ASSERT_GT(tree["bbdo_window_waits"].get<double>(), 0);
+
+  std::thread stopping([&out] { out.stop(); });
+  ASSERT_FALSE(in.read(e, time(nullptr) + 2));
+  stopping.join();
+  ASSERT_EQ(in.flush(), 0);
+}
+
+// Given a peer that sent events the writer did not read
+// When the writer stops
+// Then these events are skipped and the ack of the peer is still received.
+TEST_F(BbdoAckWindow, StopSkipsEventsBeforeAck) {
+  bbdo::stream out(false);
+  bbdo::stream in(true);
+  connect(out, in);
+
+  for (uint32_t i = 0; i < 10; ++i)
+    in.write(make_status(i));
+  in.flush();
+  for (uint32_t i = 0; i < 5; ++i)
+    out.write(make_status(i));
+  std::shared_ptr<io::data> e;
+  for (uint32_t i = 0; i < 5; ++i)
+    ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+
+  int32_t acknowledged = 0;
+  std::thread stopping([&out, &acknowledged] { acknowledged = out.stop(); });
+  ASSERT_FALSE(in.read(e, time(nullptr) + 2));
+  stopping.join();
+  ASSERT_EQ(acknowledged, 5);
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "com/centreon/broker/bbdo/internal.hh"
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+#include "pipe_end.hh"
+
+using namespace com::centreon::broker;
+
+class BbdoBatch : public BbdoPipe {
+ public:
+  static std::list<std::shared_ptr<io::extension>> batch(
+      const std::string& size = "16384",
+      const std::string& delay = "50") {
+    auto ext =
+        std::make_shared<io::extension>(BBDO_BATCH_EXTENSION, true, false);
+    ext->mutable_options()["batch_size"] = size;
+    ext->mutable_options()["batch_delay"] = delay;
+    return {ext};
+  }
+
+  static std::shared_ptr<neb::service_status> make_status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = 12;
+    ss->service_id = i;
+    ss->output = "OK";
+    ss->latency = 0.25;
+    ss->check_interval = 5;
+    return ss;
+  }
+};
+
+// Given two BBDO streams supporting frames
+// When events of several sources and sizes are written in a batch
+// Then they are sent in a few frames
+// And they are read back in order, one by one
+// And acknowledgements count each event.
+TEST_F(BbdoBatch, RoundTrip) {
+  constexpr uint32_t count = 1000;
+  bbdo::stream out(false, batch());
+  bbdo::stream in(true, batch());
+  in.set_ack_limit(100);
+  connect(out, in);
+
+  std::vector<std::shared_ptr<io::data>> events;
+  for (uint32_t i = 0; i < count; ++i) {
+    auto ss = make_status(i);
+    if (i == 500)
+      ss->output = std::string(100000, 'x');
+    if (i >= 700 && i < 710)
+      ss->source_id = 3;
+    events.push_back(ss);
+  }
+  out.write_batch(events);
+  out.flush();
+
+  nlohmann::json tree_out, tree_in;
+  out.statistics(tree_out);
+  in.statistics(tree_in);
+  ASSERT_TRUE(tree_out["bbdo_batch"].get<bool>());
+  ASSERT_TRUE(tree_in["bbdo_batch"].get<bool>());
+  ASSERT_LT(tree_out["bbdo_frames_written"].get<double>(), count / 10);
+
+  std::shared_ptr<io::data> e;
+  for (uint32_t i = 0; i < count; ++i) {
+    ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+    auto ss = std::static_pointer_cast<neb::service_status>(e);
+    ASSERT_EQ(ss->service_id, i);
+    ASSERT_EQ(ss->source_id, i >= 700 && i < 710 ? 3u : 0u);
+    ASSERT_EQ(ss->output.size(), i == 500 ? 100000u : 2u);
+  }
+
+  // The writer gets the acknowledgements sent by the reader.
+  ASSERT_FALSE(out.read(e, time(nullptr) + 1));
+  ASSERT_EQ(out.flush(), static_cast<int>(count));
+}
+
+// Given a BBDO stream sending frames
+// When an event is written
+// Then it is kept until the size or the time threshold is reached, or until
+// the stream is flushed.
+TEST_F(BbdoBatch, Thresholds) {
+  bbdo::stream out(false, batch("200", "100"));
+  bbdo::stream in(true, batch());
+  connect(out, in);
+
+  std::shared_ptr<io::data> e;
+  out.write(make_status(0));
+  ASSERT_FALSE(in.read(e, time(nullptr)));
+  out.flush();
+  ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+
+  // Size threshold.
+  out.write(make_status(1));
+  ASSERT_FALSE(in.read(e, time(nullptr)));
+  for (uint32_t i = 2; i < 10; ++i)
+    out.write(make_status(i));
+  ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+  ASSERT_EQ(std::static_pointer_cast<neb::service_status>(e)->service_id, 1u);
+  out.flush();
+  for (uint32_t i = 2; i < 10; ++i) {
+    ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+    ASSERT_EQ(std::static_pointer_cast<neb::service_status>(e)->service_id,
+              i);
+  }
+
+  // Time threshold.
+  out.write(make_status(10));
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  out.write(make_status(11));
+  for (uint32_t i = 10; i < 12; ++i)
+    ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+}
+
+// Given a BBDO stream supporting frames and a peer that does not
+// When they negotiate
+// Then events are sent one per packet.
+TEST_F(BbdoBatch, PeerWithoutExtension) {
+  bbdo::stream out(false, batch());
+  bbdo::stream in(true);
+  connect(out, in);
+
+  nlohmann::json tree_out;
+  out.statistics(tree_out);
+  ASSERT_FALSE(tree_out["bbdo_batch"].get<bool>());
+
+  out.write(make_status(7));
+  std::shared_ptr<io::data> e;
+  ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+  ASSERT_EQ(std::static_pointer_cast<neb::service_status>(e)->service_id, 7u);
+}
+
+// Given two pairs of negotiated BBDO streams, with and without frames
+// When the same small events are written one by one, as a feeder would do
+// Then they are all read back
+// And frames need fewer bytes.
+TEST_F(BbdoBatch, FramesSaveBytes) {
+  constexpr uint32_t count = 1000;
+  auto run = [](bool frames) {
+    std::list<std::shared_ptr<io::extension>> ext;
+    if (frames)
+      ext = batch();
+    bbdo::stream out(false, ext);
+    bbdo::stream in(true, ext);
+    auto p = connect(out, in);
+    size_t before = p->written_bytes();
+    for (uint32_t i = 0; i < count; ++i)
+      out.write(make_status(i));
+    out.flush();
+    std::shared_ptr<io::data> e;
+    for (uint32_t i = 0; i < count; ++i)
+      EXPECT_TRUE(in.read(e, time(nullptr) + 5));
+    return p->written_bytes() - before;
+  };
+
+  size_t single_bytes = run(false);
+  size_t frame_bytes = run(true);
+  ASSERT_LT(frame_bytes, single_bytes);
+}
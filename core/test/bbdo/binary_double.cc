@@ -0,0 +1,125 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include "com/centreon/broker/bbdo/internal.hh"
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+#include "pipe_end.hh"
+
+using namespace com::centreon::broker;
+
+class BbdoBinaryDouble : public BbdoPipe {
+ public:
+  static std::list<std::shared_ptr<io::extension>> binary_double() {
+    return {std::make_shared<io::extension>(BBDO_BINARY_DOUBLE_EXTENSION, true,
+                                            false)};
+  }
+
+  static std::shared_ptr<neb::service_status> make_status(double latency,
+                                                          double exec_time) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = 12;
+    ss->service_id = 18;
+    ss->output = "OK";
+    ss->latency = latency;
+    ss->execution_time = exec_time;
+    ss->percent_state_change = -3.5e300;
+    ss->check_interval = 5;
+    return ss;
+  }
+};
+
+// Given two BBDO streams supporting binary doubles
+// When they negotiate
+// Then the extension is enabled on both sides
+// And doubles are received exactly as they were sent.
+TEST_F(BbdoBinaryDouble, RoundTrip) {
+  bbdo::stream out(false, binary_double());
+  bbdo::stream in(true, binary_double());
+  connect(out, in);
+
+  nlohmann::json tree_out, tree_in;
+  out.statistics(tree_out);
+  in.statistics(tree_in);
+  ASSERT_TRUE(tree_out["bbdo_binary_double"].get<bool>());
+  ASSERT_TRUE(tree_in["bbdo_binary_double"].get<bool>());
+
+  auto ss = make_status(1.5e-9, 0.1234567891234);
+  out.write(ss);
+  std::shared_ptr<io::data> e;
+  ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+  auto new_ss = std::static_pointer_cast<neb::service_status>(e);
+  ASSERT_EQ(new_ss->latency, ss->latency);
+  ASSERT_EQ(new_ss->execution_time, ss->execution_time);
+  ASSERT_EQ(new_ss->percent_state_change, ss->percent_state_change);
+  ASSERT_EQ(new_ss->check_interval, ss->check_interval);
+  ASSERT_EQ(new_ss->output, ss->output);
+}
+
+// Given a BBDO stream supporting binary doubles and a peer that does not
+// When they negotiate
+// Then doubles are still sent as strings.
+TEST_F(BbdoBinaryDouble, PeerWithoutExtension) {
+  bbdo::stream out(false, binary_double());
+  bbdo::stream in(true);
+  connect(out, in);
+
+  nlohmann::json tree_out;
+  out.statistics(tree_out);
+  ASSERT_FALSE(tree_out["bbdo_binary_double"].get<bool>());
+
+  auto ss = make_status(1.5e-9, 0.1234567891234);
+  out.write(ss);
+  std::shared_ptr<io::data> e;
+  ASSERT_TRUE(in.read(e, time(nullptr) + 5));
+  auto new_ss = std::static_pointer_cast<neb::service_status>(e);
+  ASSERT_EQ(new_ss->latency, 0.0);
+  ASSERT_EQ(new_ss->execution_time, 0.123457);
+  ASSERT_EQ(new_ss->check_interval, ss->check_interval);
+}
+
+// Given two pairs of negotiated BBDO streams, with and without the extension
+// When the same service statuses are written
+// Then they are all read back
+// And binary doubles need fewer bytes.
+TEST_F(BbdoBinaryDouble, BinaryDoublesSaveBytes) {
+  constexpr size_t count = 1000;
+  std::vector<std::shared_ptr<io::data>> events;
+  for (size_t i = 0; i < count; ++i)
+    events.push_back(make_status(0.001 * i, 12.5 + i));
+
+  auto run = [&events](bool binary) {
+    bbdo::stream out(false, binary ? binary_double()
+                                   : std::list<std::shared_ptr<io::extension>>());
+    bbdo::stream in(true, binary_double());
+    auto p = connect(out, in);
+    size_t before = p->written_bytes();
+    out.write_batch(events);
+    std::shared_ptr<io::data> e;
+    for (size_t i = 0; i < count; ++i)
+      EXPECT_TRUE(in.read(e, time(nullptr) + 5));
+    return p->written_bytes() - before;
+  };
+
+  size_t text_bytes = run(false);
+  size_t binary_bytes = run(true);
+  ASSERT_LT(binary_bytes, text_bytes);
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include "com/centreon/broker/bbdo/codec.hh"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+
+#include "com/centreon/broker/bbdo/internal.hh"
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/config/applier/modules.hh"
+#include "com/centreon/broker/io/events.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/misc/misc.hh"
+#include "com/centreon/broker/neb/host.hh"
+#include "com/centreon/broker/neb/service.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+#include "interpreted.hh"
+
+using namespace com::centreon::broker;
+
+/**
+ *  Stream keeping everything written to it.
+ */
+class capture : public io::stream {
+  std::vector<char> _memory;
+
+ public:
+  capture() : io::stream("capture") {}
+  bool read(std::shared_ptr<io::data>& d, time_t) override {
+    d.reset();
+    if (_memory.empty())
+      return false;
+    auto r = std::make_shared<io::raw>();
+    r->get_buffer() = std::move(_memory);
+    _memory.clear();
+    d = r;
+    return true;
+  }
+  int32_t write(const std::shared_ptr<io::data>& d) override {
+    auto& v = std::static_pointer_cast<io::raw>(d)->get_buffer();
+    _memory.insert(_memory.end(), v.begin(), v.end());
+    return 1;
+  }
+  int32_t stop() override { return 0; }
+  const std::vector<char>& memory() const { return _memory; }
+};
+
+/**
+ *  Previous serialization of a full BBDO packet, with its headers.
+ */
+static std::vector<char> interpreted_packet(const io::data& e) {
+  std::vector<char> content;
+  interpreted_payload(e, content);
+  std::vector<char> retval;
+  size_t pos = 0;
+  for (;;) {
+    size_t len = std::min<size_t>(content.size() - pos, 0xffff);
+    char header[BBDO_HEADER_SIZE];
+    *reinterpret_cast<uint16_t*>(header + 2) = htons(len);
+    *reinterpret_cast<uint32_t*>(header + 4) = htonl(e.type());
+    *reinterpret_cast<uint32_t*>(header + 8) = htonl(e.source_id);
+    *reinterpret_cast<uint32_t*>(header + 12) = htonl(e.destination_id);
+    *reinterpret_cast<uint16_t*>(header) =
+        htons(misc::crc16_ccitt(header + 2, BBDO_HEADER_SIZE - 2));
+    retval.insert(retval.end(), header, header + BBDO_HEADER_SIZE);
+    retval.insert(retval.end(), content.begin() + pos,
+                  content.begin() + pos + len);
+    pos += len;
+    if (len < 0xffff)
+      break;
+  }
+  return retval;
+}
+
+class BbdoCodec : public ::testing::Test {
+ protected:
+  std::unique_ptr<config::applier::modules> _modules;
+
+ public:
+  void SetUp() override {
+    config::applier::init(0, "broker_test");
+    _modules = std::make_unique<config::applier::modules>();
+    _modules->load_file("./neb/10-neb.so");
+  }
+
+  void TearDown() override {
+    _modules.reset();
+    config::applier::deinit();
+  }
+
+  static std::shared_ptr<neb::service_status> make_status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = 12;
+    ss->service_id = i;
+    ss->source_id = 3;
+    ss->destination_id = 4;
+    ss->acknowledged = i & 1;
+    ss->output = "CRITICAL - connection refused";
+    ss->perf_data = "time=0.012s;;;0";
+    ss->latency = 0.25 * i;
+    ss->execution_time = 1.5;
+    ss->last_check = timestamp(1600000000 + i);
+    ss->current_state = 2;
+    return ss;
+  }
+
+  /**
+   *  Serialize an event with a BBDO stream.
+   */
+  static std::vector<char> stream_packet(std::shared_ptr<io::data> e) {
+    auto memory = std::make_shared<capture>();
+    bbdo::stream stm(true);
+    stm.set_substream(memory);
+    stm.write(e);
+    return memory->memory();
+  }
+};
+
+// Given events of several types, one being split in several packets
+// When they are serialized by a BBDO stream with the generated codecs
+// Then the bytes are the same as with the mapping interpretation
+// And they are read back with their values.
+TEST_F(BbdoCodec, WireIdentical) {
+  auto ss = make_status(7);
+  ASSERT_EQ(stream_packet(ss), interpreted_packet(*ss));
+
+  auto h = std::make_shared<neb::host>();
+  h->host_id = 18;
+  h->host_name = "central";
+  h->address = "10.0.0.1";
+  h->check_interval = 5;
+  h->last_check = timestamp(1600000000);
+  h->notes = "multiple inheritance";
+  ASSERT_EQ(stream_packet(h), interpreted_packet(*h));
+
+  auto svc = std::make_shared<neb::service>();
+  svc->host_id = 12;
+  svc->service_id = 18;
+  svc->output = std::string(140000, 'x');
+  auto long_packet = stream_packet(svc);
+  ASSERT_GT(long_packet.size(), 2u * 0xffff);
+  ASSERT_EQ(long_packet, interpreted_packet(*svc));
+
+  auto memory = std::make_shared<capture>();
+  bbdo::stream stm(true);
+  stm.set_substream(memory);
+  stm.write(h);
+  stm.write(svc);
+  std::shared_ptr<io::data> e;
+  ASSERT_TRUE(stm.read(e, time(nullptr) + 5));
+  auto new_h = std::static_pointer_cast<neb::host>(e);
+  ASSERT_EQ(new_h->host_name, h->host_name);
+  ASSERT_EQ(new_h->address, h->address);
+  ASSERT_EQ(new_h->notes, h->notes);
+  ASSERT_EQ(new_h->check_interval, h->check_interval);
+  ASSERT_EQ(new_h->last_check, h->last_check);
+  ASSERT_TRUE(stm.read(e, time(nullptr) + 5));
+  ASSERT_EQ(std::static_pointer_cast<neb::service>(e)->output, svc->output);
+}
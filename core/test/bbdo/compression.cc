@@ -0,0 +1,129 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "com/centreon/broker/bbdo/internal.hh"
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+#include "pipe_end.hh"
+
+using namespace com::centreon::broker;
+
+class BbdoCompression : public BbdoPipe {
+ public:
+  static std::list<std::shared_ptr<io::extension>> compression(
+      const std::string& codecs) {
+    auto ext = std::make_shared<io::extension>(BBDO_COMPRESSION_EXTENSION,
+                                               true, false);
+    if (!codecs.empty())
+      ext->mutable_options()["codecs"] = codecs;
+    return {ext};
+  }
+
+  static std::shared_ptr<neb::service_status> make_status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = i / 20 + 1;
+    ss->service_id = i % 20 + 1;
+    ss->host_name = fmt::format("srv-linux-{:03}.example.com", ss->host_id);
+    ss->service_description = fmt::format("Service-{}", ss->service_id);
+    ss->check_command = "check_centreon_snmp";
+    ss->output = "OK: everything is fine";
+    ss->perf_data = fmt::format("used={}B;80;90;0;100", i % 1000);
+    return ss;
+  }
+
+  /**
+   *  Send count events from out to in, check them and return the number of
+   *  bytes written by out.
+   */
+  static size_t transfer(bbdo::stream& out,
+                         bbdo::stream& in,
+                         const pipe_end& pipe,
+                         uint32_t count) {
+    size_t before = pipe.written_bytes();
+    for (uint32_t i = 0; i < count; ++i) {
+      out.write(make_status(i));
+      if (i % 100 == 99)
+        out.flush();
+    }
+    out.flush();
+    std::shared_ptr<io::data> e;
+    for (uint32_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(in.read(e, time(nullptr) + 5));
+      EXPECT_EQ(std::static_pointer_cast<neb::service_status>(e)->perf_data,
+                make_status(i)->perf_data);
+    }
+    return pipe.written_bytes() - before;
+  }
+};
+
+// Given two peers announcing different codec lists
+// When they negotiate
+// Then the first codec of the preference order known by both is used
+// And events go through.
+TEST_F(BbdoCompression, CommonCodec) {
+  bbdo::stream out(false, compression("zstd lz4 zlib"));
+  bbdo::stream in(true, compression("lz4 zlib"));
+  auto pipe = connect(out, in);
+  transfer(out, in, *pipe, 1000);
+
+  nlohmann::json tree_out, tree_in;
+  out.statistics(tree_out);
+  in.statistics(tree_in);
+  ASSERT_EQ(tree_out["compression_codec"].get<std::string>(), "lz4");
+  ASSERT_EQ(tree_in["compression_codec"].get<std::string>(), "lz4");
+  ASSERT_LT(tree_out["compression_ratio"].get<double>(), 0.5);
+}
+
+// Given a peer announcing the compression extension without codecs, like
+// older versions do
+// When it negotiates with a new peer
+// Then no compression is applied.
+TEST_F(BbdoCompression, LegacyPeer) {
+  bbdo::stream out(false, compression("zstd lz4 zlib"));
+  bbdo::stream in(true, compression(""));
+  auto pipe = connect(out, in);
+  transfer(out, in, *pipe, 100);
+
+  nlohmann::json tree;
+  out.statistics(tree);
+  ASSERT_TRUE(tree.find("compression_codec") == tree.end());
+}
+
+// Given the same poller stream
+// When it is sent uncompressed and with each codec
+// Then each codec sends fewer bytes.
+TEST_F(BbdoCompression, Codecs) {
+  constexpr uint32_t count = 2000;
+  size_t reference = 0;
+  for (const char* codec : {"", "zlib", "zstd", "lz4"}) {
+    bbdo::stream out(false, compression(codec));
+    bbdo::stream in(true, compression(codec));
+    auto pipe = connect(out, in);
+    size_t bytes = transfer(out, in, *pipe, count);
+    if (!*codec)
+      reference = bytes;
+    else
+      ASSERT_LT(bytes, reference);
+  }
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/config/applier/modules.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+
+using namespace com::centreon::broker;
+
+constexpr size_t chunk_size = 65536;
+
+/**
+ *  Stream keeping everything written to it and giving it back by chunks,
+ *  like a retention file.
+ */
+class replay : public io::stream {
+  std::vector<char> _memory;
+  size_t _pos;
+
+ public:
+  replay() : io::stream("replay"), _pos{0} {}
+  bool read(std::shared_ptr<io::data>& d, time_t) override {
+    d.reset();
+    if (_pos >= _memory.size())
+      return false;
+    size_t len = std::min(chunk_size, _memory.size() - _pos);
+    d = std::make_shared<io::raw>(std::vector<char>(
+        _memory.begin() + _pos, _memory.begin() + _pos + len));
+    _pos += len;
+    return true;
+  }
+  int32_t write(const std::shared_ptr<io::data>& d) override {
+    auto& v = std::static_pointer_cast<io::raw>(d)->get_buffer();
+    _memory.insert(_memory.end(), v.begin(), v.end());
+    return 1;
+  }
+  int32_t stop() override { return 0; }
+  std::vector<char>& memory() { return _memory; }
+};
+
+class BbdoCorruption : public ::testing::Test {
+ protected:
+  std::unique_ptr<config::applier::modules> _modules;
+
+ public:
+  void SetUp() override {
+    config::applier::init(0, "broker_test");
+    _modules = std::make_unique<config::applier::modules>();
+    _modules->load_file("./neb/10-neb.so");
+  }
+
+  void TearDown() override {
+    _modules.reset();
+    config::applier::deinit();
+  }
+};
+
+// Given a retention file with several ranges overwritten with random bytes
+// When it is replayed by a BBDO stream
+// Then the events outside the damaged ranges are recovered, up to the last
+// one.
+TEST_F(BbdoCorruption, ReplayDamagedFile) {
+  constexpr uint32_t count = 100000;
+  constexpr uint32_t damaged_ranges = 8;
+  constexpr size_t damaged_size = 131072;
+
+  auto file = std::make_shared<replay>();
+  {
+    bbdo::stream out(false);
+    out.set_coarse(true);
+    out.set_negotiate(false);
+    out.set_substream(file);
+    for (uint32_t i = 0; i < count; ++i) {
+      auto ss = std::make_shared<neb::service_status>();
+      ss->host_id = 12;
+      ss->service_id = i;
+      ss->output = "CRITICAL - connection refused";
+      ss->perf_data = "time=0.012s;;;0";
+      ss->last_check = timestamp(1600000000 + i);
+      out.write(ss);
+    }
+  }
+
+  std::vector<char>& memory = file->memory();
+  size_t step = memory.size() / (damaged_ranges + 1);
+  ASSERT_GT(step, damaged_size);
+  std::mt19937 gen(42);
+  for (uint32_t r = 1; r <= damaged_ranges; ++r)
+    for (size_t i = r * step; i < r * step + damaged_size; ++i)
+      memory[i] = static_cast<char>(gen());
+
+  bbdo::stream in(true);
+  in.set_coarse(true);
+  in.set_negotiate(false);
+  in.set_substream(file);
+  uint32_t recovered = 0;
+  uint32_t last_id = 0;
+  for (;;) {
+    std::shared_ptr<io::data> e;
+    try {
+      if (!in.read(e, 0))
+        break;
+    } catch (const std::exception&) {
+      // A false positive header in the damaged data.
+      continue;
+    }
+    if (e && e->type() == neb::service_status::static_type()) {
+      ++recovered;
+      last_id = std::static_pointer_cast<neb::service_status>(e)->service_id;
+    }
+  }
+  ASSERT_EQ(last_id, count - 1);
+  ASSERT_GT(recovered, count * 8 / 10);
+}
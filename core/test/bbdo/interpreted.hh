@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#ifndef BBDO_INTERPRETED_HH
+#define BBDO_INTERPRETED_HH
+
+#include <arpa/inet.h>
+
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+#include "com/centreon/broker/io/data.hh"
+#include "com/centreon/broker/io/events.hh"
+#include "com/centreon/broker/mapping/entry.hh"
+
+using namespace com::centreon::broker;
+
+/**
+ *  Reproduction of the previous serialization, interpreting the mapping
+ *  through the virtual getters of each entry.
+ */
+inline void interpreted_payload(const io::data& e,
+                                std::vector<char>& content) {
+  const io::event_info* info = io::events::instance().get_event_info(e.type());
+  for (const mapping::entry* current_entry = info->get_mapping();
+       !current_entry->is_null(); ++current_entry) {
+    if (!current_entry->get_serialize())
+      continue;
+    switch (current_entry->get_type()) {
+      case mapping::source::BOOL:
+        content.push_back(current_entry->get_bool(e) ? 1 : 0);
+        break;
+      case mapping::source::DOUBLE: {
+        char str[32];
+        size_t strsz(
+            snprintf(str, sizeof(str), "%f", current_entry->get_double(e)) +
+            1);
+        if (strsz > sizeof(str))
+          strsz = sizeof(str);
+        std::copy(str, str + strsz, std::back_inserter(content));
+      } break;
+      case mapping::source::INT: {
+        uint32_t value(htonl(current_entry->get_int(e)));
+        char* v(reinterpret_cast<char*>(&value));
+        std::copy(v, v + sizeof(value), std::back_inserter(content));
+      } break;
+      case mapping::source::SHORT: {
+        uint16_t value(htons(current_entry->get_short(e)));
+        char* v(reinterpret_cast<char*>(&value));
+        std::copy(v, v + sizeof(value), std::back_inserter(content));
+      } break;
+      case mapping::source::STRING: {
+        const std::string& tmp(current_entry->get_string(e));
+        std::copy(tmp.c_str(), tmp.c_str() + tmp.size() + 1,
+                  std::back_inserter(content));
+      } break;
+      case mapping::source::TIME:
+      case mapping::source::ULONG: {
+        uint64_t value =
+            current_entry->get_type() == mapping::source::TIME
+                ? static_cast<uint64_t>(current_entry->get_time(e).get_time_t())
+                : current_entry->get_ulong(e);
+        uint32_t high{htonl(value >> 32)};
+        uint32_t low{htonl(value & 0xffffffff)};
+        char* vh{reinterpret_cast<char*>(&high)};
+        char* vl{reinterpret_cast<char*>(&low)};
+        std::copy(vh, vh + sizeof(high), std::back_inserter(content));
+        std::copy(vl, vl + sizeof(low), std::back_inserter(content));
+      } break;
+      case mapping::source::UINT: {
+        uint32_t value{htonl(current_entry->get_uint(e))};
+        char* v{reinterpret_cast<char*>(&value)};
+        std::copy(v, v + sizeof(value), std::back_inserter(content));
+      } break;
+    }
+  }
+}
+
+#endif  // !BBDO_INTERPRETED_HH
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#ifndef BBDO_PIPE_END_HH
+#define BBDO_PIPE_END_HH
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/config/applier/modules.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/io/stream.hh"
+
+using namespace com::centreon::broker;
+
+/**
+ *  One end of an in memory bidirectional pipe.
+ */
+class pipe_end : public io::stream {
+  struct channel {
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::vector<char>> data;
+    size_t bytes = 0;
+  };
+  std::shared_ptr<channel> _in;
+  std::shared_ptr<channel> _out;
+
+  pipe_end(std::shared_ptr<channel> in, std::shared_ptr<channel> out)
+      : io::stream("pipe_end"), _in{std::move(in)}, _out{std::move(out)} {}
+
+ public:
+  static std::pair<std::shared_ptr<pipe_end>, std::shared_ptr<pipe_end>>
+  create() {
+    auto a = std::make_shared<channel>();
+    auto b = std::make_shared<channel>();
+    return {std::shared_ptr<pipe_end>(new pipe_end(a, b)),
+            std::shared_ptr<pipe_end>(new pipe_end(b, a))};
+  }
+
+  bool read(std::shared_ptr<io::data>& d, time_t deadline) override {
+    d.reset();
+    std::unique_lock<std::mutex> lck(_in->m);
+    auto ready = [this] { return !_in->data.empty(); };
+    if (deadline == (time_t)-1)
+      _in->cv.wait(lck, ready);
+    else if (!_in->cv.wait_until(
+                 lck, std::chrono::system_clock::from_time_t(deadline), ready))
+      return false;
+    auto r = std::make_shared<io::raw>();
+    r->get_buffer() = std::move(_in->data.front());
+    _in->data.pop_front();
+    d = r;
+    return true;
+  }
+
+  int32_t write(const std::shared_ptr<io::data>& d) override {
+    auto& buffer = std::static_pointer_cast<io::raw>(d)->get_buffer();
+    std::lock_guard<std::mutex> lck(_out->m);
+    _out->bytes += buffer.size();
+    _out->data.push_back(buffer);
+    _out->cv.notify_all();
+    return 1;
+  }
+
+  int32_t stop() override { return 0; }
+
+  /**
+   *  Bytes written so far by this end.
+   */
+  size_t written_bytes() const {
+    std::lock_guard<std::mutex> lck(_out->m);
+    return _out->bytes;
+  }
+};
+
+/**
+ *  Fixture of the tests exchanging NEB events between two BBDO streams.
+ */
+class BbdoPipe : public ::testing::Test {
+ protected:
+  std::unique_ptr<config::applier::modules> _modules;
+
+ public:
+  void SetUp() override {
+    config::applier::init(0, "broker_test");
+    _modules = std::make_unique<config::applier::modules>();
+    _modules->load_file("./neb/10-neb.so");
+  }
+
+  void TearDown() override {
+    _modules.reset();
+    config::applier::deinit();
+  }
+
+  /**
+   *  Connect two BBDO streams through a pipe and negotiate them.
+   *
+   *  @return The end of the pipe written by out.
+   */
+  static std::shared_ptr<pipe_end> connect(bbdo::stream& out,
+                                           bbdo::stream& in) {
+    auto p = pipe_end::create();
+    out.set_substream(p.first);
+    in.set_substream(p.second);
+    std::thread t([&out] { out.negotiate(bbdo::stream::negotiate_first); });
+    in.negotiate(bbdo::stream::negotiate_second);
+    t.join();
+    return p.first;
+  }
+};
+
+#endif  // !BBDO_PIPE_END_HH
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include "com/centreon/broker/bbdo/string_table.hh"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <thread>
+
+#include "com/centreon/broker/bbdo/internal.hh"
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+#include "com/centreon/broker/persistent_file.hh"
+#include "pipe_end.hh"
+
+using namespace com::centreon::broker;
+
+class BbdoStringTable : public BbdoPipe {
+ public:
+  static std::list<std::shared_ptr<io::extension>> string_table() {
+    return {std::make_shared<io::extension>(BBDO_STRING_TABLE_EXTENSION, true,
+                                            false)};
+  }
+
+  /**
+   *  A service status as sent by a poller: 100 hosts of 20 services, most
+   *  of the services are OK.
+   */
+  static std::shared_ptr<neb::service_status> poller_status(uint32_t i) {
+    uint32_t host = i / 20 % 100;
+    uint32_t service = i % 20;
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = host + 1;
+    ss->service_id = host * 20 + service + 1;
+    ss->host_name = fmt::format("srv-linux-{:03}.example.com", host);
+    ss->service_description = fmt::format("Service-{}", service);
+    ss->check_command = fmt::format("check_centreon_snmp_{}", service % 5);
+    ss->check_period = "24x7";
+    ss->event_handler = "";
+    ss->last_check = timestamp(1600000000 + i);
+    if (i % 7 == 0) {
+      ss->current_state = 1;
+      ss->output = fmt::format("WARNING: load average {}", i % 100);
+    } else {
+      ss->current_state = 0;
+      ss->output = "OK: everything is fine";
+    }
+    ss->perf_data = fmt::format("used={}B;80;90;0;100", i % 1000);
+    return ss;
+  }
+};
+
+// Given a writer and a reader table
+// When strings are encoded and decoded
+// Then they are the same, including strings beginning with a tag, empty or
+// too long strings, and strings whose slot is reused.
+TEST_F(BbdoStringTable, EncodeDecode) {
+  bbdo::string_table writer(4);
+  bbdo::string_table reader(4);
+  std::vector<std::string> strings{"", "a", "\x01\x02 tagged", "central",
+                                   std::string(5000, 'x')};
+  for (int i = 0; i < 20; ++i)
+    strings.push_back(fmt::format("host-{}", i % 6));
+  for (auto& s : std::vector<std::string>(strings))
+    strings.push_back(s);
+
+  std::vector<char> buffer;
+  for (auto& s : strings)
+    writer.encode(s, buffer);
+  ASSERT_GT(writer.refs(), 0u);
+
+  const char* p = buffer.data();
+  uint32_t size = buffer.size();
+  for (auto& s : strings) {
+    std::string str;
+    uint32_t rb = reader.decode(str, p, size);
+    ASSERT_EQ(str, s);
+    p += rb;
+    size -= rb;
+  }
+  ASSERT_EQ(size, 0u);
+  ASSERT_EQ(reader.unresolved(), 0u);
+}
+
+// Given two BBDO streams supporting the strings table
+// When a poller stream is sent through them
+// Then the events are received unchanged
+// And fewer bytes are sent than without the extension.
+TEST_F(BbdoStringTable, PollerStream) {
+  constexpr uint32_t count = 20000;
+  auto run = [](bool strings, size_t& bytes) {
+    std::list<std::shared_ptr<io::extension>> ext;
+    if (strings)
+      ext = string_table();
+    bbdo::stream out(false, ext);
+    bbdo::stream in(true, ext);
+    auto p = connect(out, in);
+    size_t before = p->written_bytes();
+    std::shared_ptr<io::data> e;
+    for (uint32_t i = 0; i < count; ++i) {
+      auto ss = poller_status(i);
+      out.write(ss);
+      EXPECT_TRUE(in.read(e, time(nullptr) + 5));
+      auto new_ss = std::static_pointer_cast<neb::service_status>(e);
+      EXPECT_EQ(new_ss->host_name, ss->host_name);
+      EXPECT_EQ(new_ss->service_description, ss->service_description);
+      EXPECT_EQ(new_ss->check_command, ss->check_command);
+      EXPECT_EQ(new_ss->output, ss->output);
+      EXPECT_EQ(new_ss->perf_data, ss->perf_data);
+    }
+    bytes = p->written_bytes() - before;
+    nlohmann::json tree;
+    out.statistics(tree);
+    EXPECT_EQ(tree["bbdo_string_table"].get<bool>(), strings);
+  };
+
+  size_t plain_bytes, table_bytes;
+  run(false, plain_bytes);
+  run(true, table_bytes);
+  ASSERT_LT(static_cast<double>(table_bytes) / plain_bytes, 0.75);
+}
+
+// Given a retention file written by two successive persistent files
+// When it is read back
+// Then all the events are read with their strings.
+TEST_F(BbdoStringTable, PersistentFile) {
+  constexpr uint32_t count = 2000;
+  const std::string path("/tmp/bbdo_string_table");
+  {
+    persistent_file f(path);
+    f.remove_all_files();
+  }
+  for (uint32_t session = 0; session < 2; ++session) {
+    persistent_file f(path);
+    for (uint32_t i = session * count; i < (session + 1) * count; ++i)
+      f.write(poller_status(i));
+  }
+
+  persistent_file f(path);
+  std::shared_ptr<io::data> e;
+  for (uint32_t i = 0; i < 2 * count; ++i) {
+    do {
+      f.read(e, 0);
+    } while (!e);
+    auto ss = std::static_pointer_cast<neb::service_status>(e);
+    auto expected = poller_status(i);
+    ASSERT_EQ(ss->service_id, expected->service_id);
+    ASSERT_EQ(ss->host_name, expected->host_name);
+    ASSERT_EQ(ss->output, expected->output);
+  }
+  f.remove_all_files();
+}
+
+// Given a persistent file rolling over several files
+// When it is read back, and again once its first file is removed
+// Then every event read has its strings.
+TEST_F(BbdoStringTable, PersistentFileRollsFiles) {
+  constexpr uint32_t count = 6000;
+  constexpr long max_file_size = 2 * 1048576;
+  const std::string path("/tmp/bbdo_string_table_roll");
+  {
+    persistent_file f(path, max_file_size);
+    f.remove_all_files();
+  }
+  {
+    persistent_file f(path, max_file_size);
+    for (uint32_t i = 0; i < count; ++i) {
+      auto ss = poller_status(i);
+      // Outputs that do not compress, so that several files are needed.
+      std::string noise;
+      uint32_t seed = i * 2654435761u;
+      for (int j = 0; j < 256; ++j) {
+        seed = seed * 1103515245u + 12345u;
+        noise += fmt::format("{:08x}", seed);
+      }
+      ss->perf_data = noise;
+      f.write(ss);
+    }
+  }
+  std::string second_file(path + "2");
+  ASSERT_EQ(access(second_file.c_str(), F_OK), 0);
+
+  auto read_all = [&path, max_file_size](uint32_t& first, uint32_t& read) {
+    persistent_file f(path, max_file_size);
+    std::shared_ptr<io::data> e;
+    read = 0;
+    for (;;) {
+      f.read(e, 0);
+      if (!e)
+        break;
+      auto ss = std::static_pointer_cast<neb::service_status>(e);
+      uint32_t i = ss->last_check.get_time_t() - 1600000000;
+      if (!read)
+        first = i;
+      auto expected = poller_status(i);
+      ASSERT_EQ(i, first + read);
+      ASSERT_EQ(ss->host_name, expected->host_name);
+      ASSERT_EQ(ss->service_description, expected->service_description);
+      ASSERT_EQ(ss->output, expected->output);
+      ++read;
+    }
+    nlohmann::json tree;
+    f.statistics(tree);
+    ASSERT_EQ(tree["bbdo_unresolved_strings_read"].get<double>(), 0.0);
+  };
+
+  uint32_t first, read;
+  read_all(first, read);
+  ASSERT_EQ(first, 0u);
+  ASSERT_EQ(read, count);
+
+  ASSERT_EQ(std::remove(path.c_str()), 0);
+  read_all(first, read);
+  ASSERT_GT(first, 0u);
+  ASSERT_EQ(first + read, count);
+
+  persistent_file f(path, max_file_size);
+  f.remove_all_files();
+}
@@ -0,0 +1,483 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <arpa/inet.h>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "bbdo/pipe_end.hh"
+#include "bbdo/interpreted.hh"
+#include "com/centreon/broker/bbdo/codec.hh"
+#include "com/centreon/broker/bbdo/internal.hh"
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/io/events.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+
+using namespace com::centreon::broker;
+
+constexpr size_t chunk_size = 65536;
+
+/**
+ *  Stream keeping everything written to it and giving it back by chunks,
+ *  like a retention file.
+ */
+class replay : public io::stream {
+  std::vector<char> _memory;
+  size_t _pos;
+
+ public:
+  replay() : io::stream("replay"), _pos{0} {}
+  bool read(std::shared_ptr<io::data>& d, time_t) override {
+    d.reset();
+    if (_pos >= _memory.size())
+      return false;
+    size_t len = std::min(chunk_size, _memory.size() - _pos);
+    d = std::make_shared<io::raw>(std::vector<char>(
+        _memory.begin() + _pos, _memory.begin() + _pos + len));
+    _pos += len;
+    return true;
+  }
+  int32_t write(const std::shared_ptr<io::data>& d) override {
+    auto& v = std::static_pointer_cast<io::raw>(d)->get_buffer();
+    _memory.insert(_memory.end(), v.begin(), v.end());
+    return 1;
+  }
+  int32_t stop() override { return 0; }
+  std::vector<char>& memory() { return _memory; }
+};
+
+/**
+ *  Reproduction of the previous resynchronization: the CRC is computed one
+ *  nibble at a time and the first byte of the buffer is erased on each
+ *  mismatch.
+ *
+ *  @return The number of valid packets found.
+ */
+static uint32_t legacy_replay(const std::vector<char>& file, size_t size) {
+  static const uint16_t crc_tbl[16] = {
+      0x0000, 0x1081, 0x2102, 0x3183, 0x4204, 0x5285, 0x6306, 0x7387,
+      0x8408, 0x9489, 0xa50a, 0xb58b, 0xc60c, 0xd68d, 0xe70e, 0xf78f};
+  auto crc16 = [](const char* data, uint32_t len) {
+    uint16_t crc = 0xffff;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    while (len--) {
+      uint8_t c = *p++;
+      crc = ((crc >> 4) & 0x0fff) ^ crc_tbl[((crc ^ c) & 15)];
+      c >>= 4;
+      crc = ((crc >> 4) & 0x0fff) ^ crc_tbl[((crc ^ c) & 15)];
+    }
+    return static_cast<uint16_t>(~crc & 0xffff);
+  };
+
+  std::vector<char> packet;
+  size_t pos = 0;
+  auto fill = [&](size_t wanted) {
+    while (packet.size() < wanted && pos < size) {
+      size_t len = std::min(chunk_size, size - pos);
+      packet.insert(packet.end(), file.begin() + pos, file.begin() + pos + len);
+      pos += len;
+    }
+    return packet.size() >= wanted;
+  };
+
+  uint32_t retval = 0;
+  while (fill(BBDO_HEADER_SIZE)) {
+    uint16_t chksum = ntohs(*reinterpret_cast<uint16_t const*>(&packet[0]));
+    uint32_t packet_size =
+        ntohs(*reinterpret_cast<uint16_t const*>(&packet[2]));
+    if (chksum != crc16(&packet[2], BBDO_HEADER_SIZE - 2)) {
+      packet.erase(packet.begin());
+      continue;
+    }
+    if (!fill(BBDO_HEADER_SIZE + packet_size))
+      break;
+    packet.erase(packet.begin(),
+                 packet.begin() + BBDO_HEADER_SIZE + packet_size);
+    ++retval;
+  }
+  return retval;
+}
+
+/**
+ *  Previous unserialization, through the virtual setters of each entry.
+ */
+static void interpreted_unserialize(io::data& e,
+                                    const char* buffer,
+                                    uint32_t size) {
+  const io::event_info* info = io::events::instance().get_event_info(e.type());
+  for (const mapping::entry* current_entry = info->get_mapping();
+       !current_entry->is_null(); ++current_entry) {
+    if (!current_entry->get_serialize())
+      continue;
+    uint32_t rb = 0;
+    switch (current_entry->get_type()) {
+      case mapping::source::BOOL:
+        current_entry->set_bool(e, *buffer);
+        rb = 1;
+        break;
+      case mapping::source::DOUBLE:
+        current_entry->set_double(e, strtod(buffer, nullptr));
+        rb = strlen(buffer) + 1;
+        break;
+      case mapping::source::INT:
+        current_entry->set_int(
+            e, ntohl(*reinterpret_cast<const uint32_t*>(buffer)));
+        rb = sizeof(uint32_t);
+        break;
+      case mapping::source::SHORT:
+        current_entry->set_short(
+            e, ntohs(*reinterpret_cast<const uint16_t*>(buffer)));
+        rb = sizeof(uint16_t);
+        break;
+      case mapping::source::STRING:
+        current_entry->set_string(e, buffer);
+        rb = strlen(buffer) + 1;
+        break;
+      case mapping::source::TIME:
+      case mapping::source::ULONG: {
+        const uint32_t* ptr = reinterpret_cast<const uint32_t*>(buffer);
+        uint64_t val(ntohl(*ptr));
+        val <<= 32;
+        val |= ntohl(*(ptr + 1));
+        if (current_entry->get_type() == mapping::source::TIME)
+          current_entry->set_time(e, val);
+        else
+          current_entry->set_ulong(e, val);
+        rb = sizeof(uint64_t);
+      } break;
+      case mapping::source::UINT:
+        current_entry->set_uint(
+            e, ntohl(*reinterpret_cast<const uint32_t*>(buffer)));
+        rb = sizeof(uint32_t);
+        break;
+    }
+    buffer += rb;
+    size -= rb;
+  }
+}
+
+class BenchBbdo : public BbdoPipe {
+ public:
+  static std::shared_ptr<neb::service_status> make_status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = 12;
+    ss->service_id = i;
+    ss->output = "OK";
+    ss->latency = 0.25;
+    ss->check_interval = 5;
+    return ss;
+  }
+
+  static std::shared_ptr<neb::service_status> make_poller_status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = i / 20 + 1;
+    ss->service_id = i % 20 + 1;
+    ss->host_name = fmt::format("srv-linux-{:03}.example.com", ss->host_id);
+    ss->service_description = fmt::format("Service-{}", ss->service_id);
+    ss->check_command = "check_centreon_snmp";
+    ss->output = "OK: everything is fine";
+    ss->perf_data = fmt::format("used={}B;80;90;0;100", i % 1000);
+    return ss;
+  }
+
+  static std::shared_ptr<neb::service_status> make_codec_status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = 12;
+    ss->service_id = i;
+    ss->source_id = 3;
+    ss->destination_id = 4;
+    ss->acknowledged = i & 1;
+    ss->output = "CRITICAL - connection refused";
+    ss->perf_data = "time=0.012s;;;0";
+    ss->latency = 0.25 * i;
+    ss->execution_time = 1.5;
+    ss->last_check = timestamp(1600000000 + i);
+    ss->current_state = 2;
+    return ss;
+  }
+
+  static std::shared_ptr<neb::service_status> make_double_status(
+      double latency,
+      double exec_time) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = 12;
+    ss->service_id = 18;
+    ss->output = "OK";
+    ss->latency = latency;
+    ss->execution_time = exec_time;
+    ss->percent_state_change = -3.5e300;
+    ss->check_interval = 5;
+    return ss;
+  }
+};
+
+// Throughput benchmark: small events are sent through two negotiated
+// streams with and without frames, written one by one as a feeder would do.
+TEST_F(BenchBbdo, Batch) {
+  constexpr uint32_t count = 200000;
+  std::vector<std::shared_ptr<io::data>> events;
+  for (uint32_t i = 0; i < 1000; ++i)
+    events.push_back(make_status(i));
+
+  auto run = [&](bool frames, size_t& bytes) {
+    std::list<std::shared_ptr<io::extension>> ext;
+    if (frames) {
+      auto batch =
+          std::make_shared<io::extension>(BBDO_BATCH_EXTENSION, true, false);
+      batch->mutable_options()["batch_size"] = "16384";
+      batch->mutable_options()["batch_delay"] = "50";
+      ext.push_back(batch);
+    }
+    bbdo::stream out(false, ext);
+    bbdo::stream in(true, ext);
+    auto p = connect(out, in);
+    size_t before = p->written_bytes();
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<io::data> e;
+    for (uint32_t i = 0; i < count; i += events.size()) {
+      for (auto& ev : events)
+        out.write(ev);
+      out.flush();
+      for (size_t j = 0; j < events.size(); ++j)
+        EXPECT_TRUE(in.read(e, time(nullptr) + 5));
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    bytes = p->written_bytes() - before;
+    return count / elapsed.count();
+  };
+
+  size_t single_bytes, frame_bytes;
+  double single = run(false, single_bytes);
+  double frame = run(true, frame_bytes);
+  std::cout << "service_status round trip: one event per packet "
+            << static_cast<uint64_t>(single) << " events/s, "
+            << single_bytes / count << " bytes/event, frames "
+            << static_cast<uint64_t>(frame) << " events/s, "
+            << frame_bytes / count << " bytes/event\n";
+}
+
+// Corruption benchmark: a retention file is written, several ranges of it
+// are overwritten with random bytes and it is replayed by a BBDO stream. The
+// events outside the damaged ranges are recovered. The previous
+// resynchronization is replayed on the first damaged range for comparison.
+TEST_F(BenchBbdo, ReplayDamagedFile) {
+  constexpr uint32_t count = 100000;
+  constexpr uint32_t damaged_ranges = 8;
+  constexpr size_t damaged_size = 131072;
+
+  auto file = std::make_shared<replay>();
+  {
+    bbdo::stream out(false);
+    out.set_coarse(true);
+    out.set_negotiate(false);
+    out.set_substream(file);
+    for (uint32_t i = 0; i < count; ++i) {
+      auto ss = std::make_shared<neb::service_status>();
+      ss->host_id = 12;
+      ss->service_id = i;
+      ss->output = "CRITICAL - connection refused";
+      ss->perf_data = "time=0.012s;;;0";
+      ss->last_check = timestamp(1600000000 + i);
+      out.write(ss);
+    }
+  }
+
+  std::vector<char>& memory = file->memory();
+  size_t step = memory.size() / (damaged_ranges + 1);
+  ASSERT_GT(step, damaged_size);
+  std::mt19937 gen(42);
+  for (uint32_t r = 1; r <= damaged_ranges; ++r)
+    for (size_t i = r * step; i < r * step + damaged_size; ++i)
+      memory[i] = static_cast<char>(gen());
+
+  using clock = std::chrono::steady_clock;
+  auto start = clock::now();
+  bbdo::stream in(true);
+  in.set_coarse(true);
+  in.set_negotiate(false);
+  in.set_substream(file);
+  uint32_t recovered = 0;
+  uint32_t last_id = 0;
+  for (;;) {
+    std::shared_ptr<io::data> e;
+    try {
+      if (!in.read(e, 0))
+        break;
+    } catch (const std::exception&) {
+      // A false positive header in the damaged data.
+      continue;
+    }
+    if (e && e->type() == neb::service_status::static_type()) {
+      ++recovered;
+      last_id = std::static_pointer_cast<neb::service_status>(e)->service_id;
+    }
+  }
+  std::chrono::duration<double> scanner = clock::now() - start;
+  ASSERT_EQ(last_id, count - 1);
+  ASSERT_GT(recovered, count * 8 / 10);
+
+  size_t legacy_size = 2 * step;
+  start = clock::now();
+  uint32_t legacy_packets = legacy_replay(memory, legacy_size);
+  std::chrono::duration<double> legacy = clock::now() - start;
+  ASSERT_GT(legacy_packets, 0u);
+
+  std::cout << "damaged retention replay: " << recovered << "/" << count
+            << " events recovered, scanner "
+            << static_cast<uint64_t>(memory.size() / scanner.count() / 1e6)
+            << " MB/s, legacy resync "
+            << static_cast<uint64_t>(legacy_size / legacy.count() / 1e6)
+            << " MB/s\n";
+}
+
+// Throughput benchmark: service statuses are sent through two negotiated
+// streams with and without the extension, the time to write and read them
+// and the bytes sent are compared.
+TEST_F(BenchBbdo, BinaryDouble) {
+  constexpr size_t count = 100000;
+  constexpr size_t batch = 1000;
+  std::vector<std::shared_ptr<io::data>> events;
+  for (size_t i = 0; i < batch; ++i)
+    events.push_back(make_double_status(0.001 * i, 12.5 + i));
+
+  auto binary_double = [] {
+    return std::list<std::shared_ptr<io::extension>>{
+        std::make_shared<io::extension>(BBDO_BINARY_DOUBLE_EXTENSION, true,
+                                        false)};
+  };
+  auto run = [&](bool binary, size_t& bytes) {
+    bbdo::stream out(false, binary ? binary_double()
+                                   : std::list<std::shared_ptr<io::extension>>());
+    bbdo::stream in(true, binary_double());
+    auto p = connect(out, in);
+    size_t before = p->written_bytes();
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<io::data> e;
+    for (size_t i = 0; i < count; i += batch) {
+      out.write_batch(events);
+      for (size_t j = 0; j < batch; ++j)
+        EXPECT_TRUE(in.read(e, time(nullptr) + 5));
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    bytes = p->written_bytes() - before;
+    return count / elapsed.count();
+  };
+
+  size_t text_bytes, binary_bytes;
+  double text = run(false, text_bytes);
+  double binary = run(true, binary_bytes);
+  std::cout << "service_status round trip: text doubles "
+            << static_cast<uint64_t>(text) << " events/s, "
+            << text_bytes / count << " bytes/event, binary doubles "
+            << static_cast<uint64_t>(binary) << " events/s, "
+            << binary_bytes / count << " bytes/event\n";
+}
+
+// Throughput benchmark: service statuses are serialized and unserialized by
+// the mapping interpretation and by the generated codec.
+TEST_F(BenchBbdo, Codec) {
+  constexpr uint32_t count = 200000;
+  std::vector<std::shared_ptr<neb::service_status>> events;
+  for (uint32_t i = 0; i < 1000; ++i)
+    events.push_back(make_codec_status(i));
+  const io::event_info* info = io::events::instance().get_event_info(
+      neb::service_status::static_type());
+  bbdo::codec c(*info, false);
+
+  using clock = std::chrono::steady_clock;
+  std::vector<char> interpreted, generated;
+  auto start = clock::now();
+  for (uint32_t i = 0; i < count; ++i) {
+    interpreted.clear();
+    interpreted_payload(*events[i % events.size()], interpreted);
+  }
+  auto interpreted_write = clock::now();
+  for (uint32_t i = 0; i < count; ++i) {
+    generated.clear();
+    c.serialize(*events[i % events.size()], generated);
+  }
+  auto generated_write = clock::now();
+  ASSERT_EQ(generated, interpreted);
+
+  neb::service_status out;
+  for (uint32_t i = 0; i < count; ++i)
+    interpreted_unserialize(out, interpreted.data(), interpreted.size());
+  auto interpreted_read = clock::now();
+  for (uint32_t i = 0; i < count; ++i)
+    c.unserialize(out, generated.data(), generated.size());
+  auto generated_read = clock::now();
+  ASSERT_EQ(out.service_id, events[(count - 1) % events.size()]->service_id);
+  ASSERT_EQ(out.output, events[0]->output);
+
+  auto rate = [](clock::time_point a, clock::time_point b) {
+    return static_cast<uint64_t>(
+        count / std::chrono::duration<double>(b - a).count());
+  };
+  std::cout << "service_status serialization: interpreted "
+            << rate(start, interpreted_write) << " events/s, generated "
+            << rate(interpreted_write, generated_write)
+            << " events/s; unserialization: interpreted "
+            << rate(generated_write, interpreted_read)
+            << " events/s, generated "
+            << rate(interpreted_read, generated_read) << " events/s\n";
+}
+
+// Benchmark: the same poller stream is sent uncompressed and with each codec.
+TEST_F(BenchBbdo, Compression) {
+  constexpr uint32_t count = 20000;
+  auto compression = [](const std::string& codecs) {
+    auto ext = std::make_shared<io::extension>(BBDO_COMPRESSION_EXTENSION,
+                                               true, false);
+    if (!codecs.empty())
+      ext->mutable_options()["codecs"] = codecs;
+    return std::list<std::shared_ptr<io::extension>>{ext};
+  };
+  size_t reference = 0;
+  for (const char* codec : {"", "zlib", "zstd", "lz4"}) {
+    bbdo::stream out(false, compression(codec));
+    bbdo::stream in(true, compression(codec));
+    auto pipe = connect(out, in);
+    size_t before = pipe->written_bytes();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; ++i) {
+      out.write(make_poller_status(i));
+      if (i % 100 == 99)
+        out.flush();
+    }
+    out.flush();
+    std::shared_ptr<io::data> e;
+    for (uint32_t i = 0; i < count; ++i)
+      EXPECT_TRUE(in.read(e, time(nullptr) + 5));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    size_t bytes = pipe->written_bytes() - before;
+    if (!*codec)
+      reference = bytes;
+    std::cout << "bbdo " << count << " events with "
+              << (*codec ? codec : "no compression") << ": " << bytes
+              << " bytes (ratio " << static_cast<double>(bytes) / reference
+              << ") in " << elapsed.count() << "ms\n";
+  }
+}
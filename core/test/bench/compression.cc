@@ -0,0 +1,108 @@
+/*
+ * Copyright 2011 - 2019 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include "com/centreon/broker/compression/stream.hh"
+#include "com/centreon/broker/compression/zstd.hh"
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "compression/stream/memory_stream.hh"
+
+using namespace com::centreon::broker;
+
+class BenchCompression : public ::testing::Test {
+ public:
+  void SetUp() override {
+    try {
+      config::applier::init(0, "test_broker");
+    } catch (const std::exception& e) {
+      (void)e;
+    }
+  }
+
+  void TearDown() override { config::applier::deinit(); }
+
+  static std::shared_ptr<io::raw> new_data(uint32_t i) {
+    std::shared_ptr<io::raw> r(new io::raw);
+    std::string s;
+    while (s.size() < 10000)
+      s.append(fmt::format("host_{};service_{};OK: {} ", i % 100, s.size(),
+                           i * s.size()));
+    r->get_buffer().assign(s.begin(), s.end());
+    return r;
+  }
+
+  /**
+   *  Write count buffers, each one giving a block, and return the time spent.
+   */
+  static std::chrono::duration<double> write(compression::stream& s,
+                                             uint32_t count) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; ++i)
+      s.write(new_data(i));
+    s.flush();
+    return std::chrono::steady_clock::now() - start;
+  }
+};
+
+// The writer thread time with zlib, with and without pipeline.
+TEST_F(BenchCompression, WriterThroughput) {
+  constexpr uint32_t count = 2000;
+  compression::stream sequential(9, 10000);
+  sequential.set_substream(std::make_shared<CompressionStreamMemoryStream>());
+  compression::stream pipelined(9, 10000);
+  pipelined.set_pipelined(true);
+  pipelined.set_substream(std::make_shared<CompressionStreamMemoryStream>());
+
+  auto s = write(sequential, count);
+  auto p = write(pipelined, count);
+  std::cout << "zlib compression of " << count
+            << " blocks of 10kB: writer busy " << s.count() * 1000
+            << "ms sequential, " << p.count() * 1000 << "ms pipelined\n";
+}
+
+// The first block compressed by a new zstd context, without and with a
+// dictionary trained on blocks looking like the BBDO traffic of a poller.
+TEST_F(BenchCompression, ZstdDictionary) {
+  auto block = [](uint32_t i) {
+    std::string s{fmt::format(
+        "srv-linux-{:03}.example.com\\0Service-{}\\0check_centreon_snmp_{}"
+        "\\024x7\\0OK: everything is fine\\0used={}B;80;90;0;100",
+        i % 100, i % 20, i % 5, i % 1000)};
+    return std::vector<char>(s.begin(), s.end());
+  };
+  std::vector<std::string> samples;
+  for (uint32_t i = 0; i < 2000; ++i) {
+    std::vector<char> b(block(i));
+    samples.emplace_back(b.begin(), b.end());
+  }
+  std::string dictionary(compression::zstd::train_dictionary(samples, 16384));
+  ASSERT_FALSE(dictionary.empty());
+
+  compression::zstd plain(-1);
+  compression::zstd writer(-1, dictionary);
+  std::vector<char> data(block(5000));
+  std::vector<char> without(plain.compress(data));
+  std::vector<char> with(writer.compress(data));
+  std::cout << "zstd first block of " << data.size() << " bytes: "
+            << without.size() << " bytes without dictionary, " << with.size()
+            << " bytes with it\n";
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <queue>
+#include <thread>
+
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/multiplexing/engine.hh"
+#include "com/centreon/broker/multiplexing/muxer.hh"
+#include "com/centreon/broker/multiplexing/subscriber.hh"
+
+using namespace com::centreon::broker;
+
+constexpr uint32_t producers = 8;
+constexpr uint32_t events_per_producer = 20000;
+constexpr uint32_t outputs = 4;
+
+class BenchEngine : public testing::Test {
+ public:
+  void SetUp() override { config::applier::init(0, "test_broker"); }
+
+  void TearDown() override { config::applier::deinit(); }
+
+  static std::shared_ptr<io::data> make_event(uint32_t producer,
+                                              uint32_t seq) {
+    std::shared_ptr<io::raw> r{std::make_shared<io::raw>()};
+    r->resize(2 * sizeof(uint32_t));
+    memcpy(r->data(), &producer, sizeof(producer));
+    memcpy(r->data() + sizeof(producer), &seq, sizeof(seq));
+    return r;
+  }
+
+  /**
+   * @brief Read all the events available in the muxer, check that each
+   * producer events are in order and return how many events were read.
+   */
+  static uint32_t check_order(multiplexing::muxer& m) {
+    std::vector<int64_t> last(producers, -1);
+    uint32_t retval = 0;
+    std::shared_ptr<io::data> d;
+    for (;;) {
+      d.reset();
+      m.read(d, 0);
+      if (!d)
+        break;
+      uint32_t producer, seq;
+      auto r = std::static_pointer_cast<io::raw>(d);
+      memcpy(&producer, r->data(), sizeof(producer));
+      memcpy(&seq, r->data() + sizeof(producer), sizeof(seq));
+      EXPECT_LT(producer, producers);
+      EXPECT_EQ(last[producer] + 1, static_cast<int64_t>(seq));
+      last[producer] = seq;
+      ++retval;
+    }
+    return retval;
+  }
+
+  /**
+   * @brief Run the publish function from several threads and return the
+   * elapsed time.
+   */
+  template <typename F>
+  static std::chrono::duration<double> run(F&& publish) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t p = 0; p < producers; ++p)
+      threads.emplace_back([p, &publish] {
+        for (uint32_t i = 0; i < events_per_producer; ++i)
+          publish(make_event(p, i));
+      });
+    for (auto& t : threads)
+      t.join();
+    return std::chrono::steady_clock::now() - start;
+  }
+};
+
+// The same load is sent through a reproduction of the
+// previous engine path (global mutex, queue and fan-out under the muxers
+// mutex) and through the engine ingest ring.
+TEST_F(BenchEngine, Contention) {
+  multiplexing::muxer::filters f{io::raw::static_type()};
+
+  std::vector<std::unique_ptr<multiplexing::muxer>> legacy_muxers;
+  for (uint32_t i = 0; i < outputs; ++i) {
+    legacy_muxers.emplace_back(std::make_unique<multiplexing::muxer>(
+        fmt::format("core_multiplexing_engine_legacy_{}", i), false));
+    legacy_muxers.back()->set_read_filters(f);
+    legacy_muxers.back()->set_write_filters(f);
+  }
+  std::mutex engine_m;
+  std::mutex muxers_m;
+  std::queue<std::shared_ptr<io::data>> kiew;
+  auto legacy = run([&](const std::shared_ptr<io::data>& d) {
+    std::lock_guard<std::mutex> lck(engine_m);
+    kiew.push(d);
+    std::lock_guard<std::mutex> lck_muxers(muxers_m);
+    while (!kiew.empty()) {
+      for (auto& m : legacy_muxers)
+        m->publish(kiew.front());
+      kiew.pop();
+    }
+  });
+  for (auto& m : legacy_muxers)
+    ASSERT_EQ(check_order(*m), producers * events_per_producer);
+
+  std::vector<std::unique_ptr<multiplexing::subscriber>> subscribers;
+  for (uint32_t i = 0; i < outputs; ++i) {
+    subscribers.emplace_back(std::make_unique<multiplexing::subscriber>(
+        fmt::format("core_multiplexing_engine_ring_{}", i), false));
+    subscribers.back()->get_muxer().set_read_filters(f);
+    subscribers.back()->get_muxer().set_write_filters(f);
+  }
+  multiplexing::engine::instance().start();
+  auto ring = run([](const std::shared_ptr<io::data>& d) {
+    multiplexing::engine::instance().publish(d);
+  });
+  for (auto& s : subscribers)
+    ASSERT_EQ(check_order(s->get_muxer()), producers * events_per_producer);
+  multiplexing::engine::instance().stop();
+
+  double total = producers * events_per_producer;
+  std::cout << "engine publish with " << producers << " threads and "
+            << outputs << " outputs: legacy path "
+            << static_cast<uint64_t>(total / legacy.count())
+            << " events/s, ingest ring "
+            << static_cast<uint64_t>(total / ring.count()) << " events/s\n";
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "com/centreon/broker/config/applier/state.hh"
+#include "com/centreon/broker/io/events.hh"
+#include "com/centreon/broker/io/protocols.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/multiplexing/engine.hh"
+#include "com/centreon/broker/pool.hh"
+#include "com/centreon/broker/processing/feeder.hh"
+#include "com/centreon/broker/stats/center.hh"
+
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::processing;
+
+using clock_type = std::chrono::steady_clock;
+
+/**
+ *  Stream with nothing to read, that records when events are written to it.
+ */
+class LatencyStream : public io::stream {
+  mutable std::mutex _m;
+  std::vector<clock_type::time_point> _written;
+
+ public:
+  LatencyStream() : io::stream("LatencyStream") {}
+  bool read(std::shared_ptr<io::data>& d, time_t) override {
+    d.reset();
+    return false;
+  }
+
+  int32_t write(std::shared_ptr<io::data> const&) override {
+    std::lock_guard<std::mutex> lck(_m);
+    _written.push_back(clock_type::now());
+    return 1;
+  }
+  int32_t stop() override { return 0; }
+
+  std::vector<clock_type::time_point> written() const {
+    std::lock_guard<std::mutex> lck(_m);
+    return _written;
+  }
+};
+
+/**
+ *  Compute the p50 and p99 delays between publication and writing.
+ */
+static std::pair<double, double> percentiles(
+    const std::vector<clock_type::time_point>& published,
+    const std::vector<clock_type::time_point>& written) {
+  std::vector<double> delays;
+  for (size_t i = 0; i < published.size() && i < written.size(); ++i)
+    delays.push_back(
+        std::chrono::duration<double, std::milli>(written[i] - published[i])
+            .count());
+  std::sort(delays.begin(), delays.end());
+  return {delays[delays.size() / 2], delays[delays.size() * 99 / 100]};
+}
+
+class BenchFeeder : public ::testing::Test {
+ public:
+  void SetUp() override {
+    pool::load(0);
+    stats::center::load();
+    config::applier::state::load();
+    multiplexing::engine::load();
+    io::protocols::load();
+    io::events::load();
+  }
+
+  void TearDown() override {
+    multiplexing::engine::unload();
+    config::applier::state::unload();
+    io::events::unload();
+    io::protocols::unload();
+    stats::center::unload();
+    pool::unload();
+  }
+};
+
+// Latency benchmark: events are published one by one to a feeder and to a
+// reproduction of the previous feeder loop polling the muxer every 100ms.
+// The delay between each publication and the write to the client is
+// measured.
+TEST_F(BenchFeeder, Latency) {
+  constexpr size_t count = 100;
+  std::unordered_set<uint32_t> filters{io::raw::static_type()};
+
+  // Polling loop.
+  multiplexing::muxer m("bench-feeder-latency-polling", false);
+  m.set_read_filters(filters);
+  m.set_write_filters(filters);
+  LatencyStream polled;
+  std::thread poller([&m, &polled] {
+    std::vector<std::shared_ptr<io::data>> events;
+    size_t received = 0;
+    while (received < count) {
+      m.read_batch(events, multiplexing::muxer::read_batch_size, 0);
+      if (events.empty())
+        ::usleep(100000);
+      else {
+        polled.write_batch(events);
+        m.ack_events(events.size());
+        received += events.size();
+      }
+    }
+  });
+  std::vector<clock_type::time_point> published;
+  for (size_t i = 0; i < count; ++i) {
+    published.push_back(clock_type::now());
+    m.publish(std::make_shared<io::raw>());
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+  }
+  poller.join();
+  auto before = percentiles(published, polled.written());
+
+  // Feeder.
+  LatencyStream* s = new LatencyStream;
+  std::unique_ptr<io::stream> client(s);
+  feeder f("bench-feeder-latency", client, filters, filters);
+  multiplexing::engine::instance().start();
+  published.clear();
+  for (size_t i = 0; i < count; ++i) {
+    published.push_back(clock_type::now());
+    multiplexing::engine::instance().publish(std::make_shared<io::raw>());
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+  }
+  for (int i = 0; i < 100 && s->written().size() < count; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_EQ(s->written().size(), count);
+  auto after = percentiles(published, s->written());
+  multiplexing::engine::instance().stop();
+
+  std::cout << "per hop delay: polling p50 " << before.first << "ms, p99 "
+            << before.second << "ms, wakeups p50 " << after.first
+            << "ms, p99 " << after.second << "ms\n";
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/multiplexing/muxer.hh"
+
+using namespace com::centreon::broker;
+
+constexpr size_t queued_events = 500000;
+
+class BenchMuxer : public ::testing::Test {
+ public:
+  void SetUp() override { config::applier::init(0, "test_broker"); }
+
+  void TearDown() override { config::applier::deinit(); }
+};
+
+// Throughput benchmark: a large queue is filled, its statistics are
+// computed while all the events are unacknowledged, then everything is read
+// and acknowledged.
+TEST_F(BenchMuxer, Queue) {
+  multiplexing::muxer m("BenchMuxer_Queue", false);
+  multiplexing::muxer::filters f{io::raw::static_type()};
+  m.set_read_filters(f);
+  m.set_write_filters(f);
+  std::shared_ptr<io::data> e{std::make_shared<io::raw>()};
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < queued_events; ++i)
+    m.publish(e);
+  auto published = std::chrono::steady_clock::now();
+
+  std::vector<std::shared_ptr<io::data>> events;
+  size_t count = 0;
+  while (m.read_batch(events, multiplexing::muxer::read_batch_size, 0) &&
+         !events.empty())
+    count += events.size();
+  ASSERT_EQ(count, queued_events);
+  auto read = std::chrono::steady_clock::now();
+
+  nlohmann::json tree;
+  m.statistics(tree);
+  auto stats = std::chrono::steady_clock::now();
+  ASSERT_EQ(tree["unacknowledged_events"].get<size_t>(), queued_events);
+
+  m.nack_events();
+  count = 0;
+  while (m.read_batch(events, multiplexing::muxer::read_batch_size, 0) &&
+         !events.empty())
+    count += events.size();
+  ASSERT_EQ(count, queued_events);
+  for (size_t remaining = queued_events; remaining;) {
+    size_t n = remaining < 1000 ? remaining : 1000;
+    m.ack_events(n);
+    remaining -= n;
+  }
+  auto acked = std::chrono::steady_clock::now();
+  ASSERT_EQ(m.get_event_queue_size(), 0u);
+
+  using us = std::chrono::microseconds;
+  std::cout << "muxer queue of " << queued_events << " events: publish "
+            << std::chrono::duration_cast<us>(published - start).count()
+            << "us, read "
+            << std::chrono::duration_cast<us>(read - published).count()
+            << "us, statistics "
+            << std::chrono::duration_cast<us>(stats - read).count()
+            << "us, nack/reread/ack "
+            << std::chrono::duration_cast<us>(acked - stats).count()
+            << "us\n";
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/compression/stream.hh"
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/config/applier/modules.hh"
+#include "com/centreon/broker/file/opener.hh"
+#include "com/centreon/broker/misc/filesystem.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+#include "com/centreon/broker/persistent_file.hh"
+
+using namespace com::centreon::broker;
+
+class BenchPersistentFile : public ::testing::Test {
+ protected:
+  std::unique_ptr<config::applier::modules> _modules;
+
+ public:
+  void SetUp() override {
+    config::applier::init(0, "broker_test");
+    _modules = std::make_unique<config::applier::modules>();
+    _modules->load_file("./neb/10-neb.so");
+  }
+
+  void TearDown() override {
+    _modules.reset();
+    config::applier::deinit();
+  }
+
+  static std::shared_ptr<neb::service_status> status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = i / 20 % 100 + 1;
+    ss->service_id = i;
+    ss->host_name = fmt::format("srv-linux-{:03}.example.com", ss->host_id);
+    ss->service_description = fmt::format("Service-{}", i % 20);
+    ss->check_command = "check_centreon_snmp";
+    ss->output = "OK: everything is fine";
+    ss->perf_data = fmt::format("used={}B;80;90;0;100", i % 1000);
+    return ss;
+  }
+
+  /**
+   *  The stack used by previous versions to write retention files: one zlib
+   *  block per event.
+   */
+  static std::shared_ptr<io::stream> legacy_file(const std::string& path) {
+    file::opener opnr;
+    opnr.set_filename(path);
+    std::shared_ptr<io::stream> fs(opnr.open());
+    auto cs = std::make_shared<compression::stream>();
+    cs->set_substream(fs);
+    auto bs = std::make_shared<bbdo::stream>(true);
+    bs->set_coarse(true);
+    bs->set_negotiate(false);
+    bs->set_substream(cs);
+    return bs;
+  }
+
+  static void check(io::stream& f, uint32_t from, uint32_t to) {
+    std::shared_ptr<io::data> e;
+    for (uint32_t i = from; i < to; ++i) {
+      do {
+        f.read(e, 0);
+      } while (!e);
+      auto ss = std::static_pointer_cast<neb::service_status>(e);
+      ASSERT_EQ(ss->service_id, i);
+      ASSERT_EQ(ss->perf_data, status(i)->perf_data);
+    }
+  }
+
+  static void remove(const std::string& path) {
+    persistent_file f(path);
+    f.remove_all_files();
+  }
+};
+
+// Benchmark: the same events are written and replayed with the previous
+// format and in blocks.
+TEST_F(BenchPersistentFile, Blocks) {
+  constexpr uint32_t count = 100000;
+  const std::string legacy_path("/tmp/persistent_file_bench_legacy");
+  const std::string path("/tmp/persistent_file_bench");
+  remove(legacy_path);
+  remove(path);
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    auto legacy = legacy_file(legacy_path);
+    for (uint32_t i = 0; i < count; ++i)
+      legacy->write(status(i));
+  }
+  auto legacy_written = std::chrono::steady_clock::now();
+  int64_t legacy_size = misc::filesystem::file_size(legacy_path);
+  {
+    auto legacy = legacy_file(legacy_path);
+    check(*legacy, 0, count);
+  }
+  auto legacy_read = std::chrono::steady_clock::now();
+  {
+    persistent_file f(path);
+    for (uint32_t i = 0; i < count; ++i)
+      f.write(status(i));
+  }
+  auto written = std::chrono::steady_clock::now();
+  int64_t size = misc::filesystem::file_size(path);
+  {
+    persistent_file f(path);
+    check(f, 0, count);
+  }
+  auto read = std::chrono::steady_clock::now();
+
+  using ms = std::chrono::milliseconds;
+  std::cout << "retention of " << count << " events: legacy "
+            << legacy_size / 1024 << "kB written in "
+            << std::chrono::duration_cast<ms>(legacy_written - start).count()
+            << "ms and read in "
+            << std::chrono::duration_cast<ms>(legacy_read - legacy_written)
+                   .count()
+            << "ms, blocks " << size / 1024 << "kB written in "
+            << std::chrono::duration_cast<ms>(written - legacy_read).count()
+            << "ms and read in "
+            << std::chrono::duration_cast<ms>(read - written).count()
+            << "ms\n";
+  ASSERT_LT(size, legacy_size / 2);
+  remove(legacy_path);
+  remove(path);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "com/centreon/broker/exceptions/shutdown.hh"
+#include "com/centreon/broker/file/splitter.hh"
+#include "com/centreon/broker/misc/filesystem.hh"
+
+using namespace com::centreon::broker;
+
+class BenchSplitter : public ::testing::Test {
+ public:
+  void SetUp() override {
+    _path = "/tmp/bench_splitter";
+    _remove_files();
+  }
+
+  void TearDown() override {
+    file::splitter::mmap_segments(false);
+    _remove_files();
+  }
+
+ protected:
+  std::string _path;
+
+  static void _remove_files() {
+    std::list<std::string> parts{
+        misc::filesystem::dir_content_with_filter("/tmp/", "bench_splitter*")};
+    for (std::string const& f : parts)
+      std::remove(f.c_str());
+  }
+
+  static double _cpu_seconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+           (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+  }
+};
+
+// Throughput benchmark: the same retention is written then read back through
+// stdio and through mmap segments, with the wall time and the CPU time spent.
+TEST_F(BenchSplitter, StdioAndMmap) {
+  constexpr long block_size = 262144;
+  constexpr long blocks = 512;
+  constexpr double gb = 1073741824.0;
+  std::vector<char> block(block_size);
+  for (long i = 0; i < block_size; ++i)
+    block[i] = i % 251;
+  std::vector<char> read_buffer(65536);
+
+  for (bool mmap : {false, true}) {
+    file::splitter::mmap_segments(mmap);
+    auto start = std::chrono::steady_clock::now();
+    double cpu_start = _cpu_seconds();
+    {
+      file::splitter s(_path, file::fs_file::open_read_write_truncate,
+                       100000000, true);
+      for (long i = 0; i < blocks; ++i)
+        s.write(block.data(), block_size);
+      s.flush();
+    }
+    std::chrono::duration<double> write_time =
+        std::chrono::steady_clock::now() - start;
+    double write_cpu = _cpu_seconds() - cpu_start;
+
+    start = std::chrono::steady_clock::now();
+    cpu_start = _cpu_seconds();
+    long total = 0;
+    {
+      file::splitter s(_path, file::fs_file::open_read_write_truncate,
+                       100000000, true);
+      for (;;) {
+        try {
+          total += s.read(read_buffer.data(), read_buffer.size());
+        } catch (const exceptions::shutdown& e) {
+          break;
+        }
+      }
+    }
+    std::chrono::duration<double> read_time =
+        std::chrono::steady_clock::now() - start;
+    double read_cpu = _cpu_seconds() - cpu_start;
+    ASSERT_EQ(total, block_size * blocks);
+
+    double size = static_cast<double>(total);
+    std::cout << "splitter " << (mmap ? "mmap" : "stdio") << ": write "
+              << static_cast<uint64_t>(size / write_time.count() / 1048576)
+              << " MB/s, " << write_cpu * gb / size << " s CPU/GB, read "
+              << static_cast<uint64_t>(size / read_time.count() / 1048576)
+              << " MB/s, " << read_cpu * gb / size << " s CPU/GB\n";
+    _remove_files();
+  }
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2011 - 2019 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include "com/centreon/broker/compression/lz4.hh"
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include "com/centreon/broker/exceptions/corruption.hh"
+
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::compression;
+
+class CompressionLz4 : public ::testing::Test {
+ public:
+  static std::vector<char> block(uint32_t i, size_t size = 0) {
+    std::string s{fmt::format(
+        "srv-linux-{:03}.example.com\\0Service-{}\\0OK: everything is fine\\0"
+        "used={}B;80;90;0;100",
+        i % 100, i % 20, i % 1000)};
+    while (s.size() < size)
+      s.append(fmt::format("{};", s.size() * i));
+    return std::vector<char>(s.begin(), s.end());
+  }
+};
+
+// Given two lz4 contexts
+// When blocks are compressed and uncompressed in order, more than the size
+// of their history buffers
+// Then we get the same blocks
+// And a block already seen is smaller the second time thanks to the history.
+TEST_F(CompressionLz4, History) {
+  lz4 writer;
+  lz4 reader;
+  std::vector<char> data(block(1));
+  std::vector<char> first(writer.compress(data));
+  std::vector<char> second(writer.compress(data));
+  ASSERT_LT(second.size(), first.size() / 2);
+  ASSERT_EQ(reader.uncompress(
+                reinterpret_cast<const unsigned char*>(first.data()),
+                first.size()),
+            data);
+  ASSERT_EQ(reader.uncompress(
+                reinterpret_cast<const unsigned char*>(second.data()),
+                second.size()),
+            data);
+
+  size_t total = 0;
+  for (uint32_t i = 0; total < 5000000; ++i) {
+    std::vector<char> b(block(i, i % 100 == 0 ? 300000 : 0));
+    total += b.size();
+    std::vector<char> c(writer.compress(b));
+    ASSERT_EQ(
+        reader.uncompress(reinterpret_cast<const unsigned char*>(c.data()),
+                          c.size()),
+        b);
+  }
+}
+
+// Given a lz4 context
+// When an empty block is compressed
+// Then we get as result a buffer containing "\0\0\0\0"
+TEST_F(CompressionLz4, Empty) {
+  lz4 writer;
+  std::vector<char> expected(4, '\0');
+  ASSERT_EQ(writer.compress(std::vector<char>()), expected);
+}
+
+// Given a lz4 context
+// When a block with a wrong size is uncompressed
+// Then a corruption exception is thrown.
+TEST_F(CompressionLz4, Corrupted) {
+  lz4 writer;
+  lz4 reader;
+  std::vector<char> c(writer.compress(block(1)));
+  c[3] += 1;
+  ASSERT_THROW(reader.uncompress(
+                   reinterpret_cast<const unsigned char*>(c.data()), c.size()),
+               exceptions::corruption);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2011 - 2019 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include "com/centreon/broker/compression/stream.hh"
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/pool.hh"
+#include "memory_stream.hh"
+
+using namespace com::centreon::broker;
+
+class CompressionStreamPipeline : public ::testing::Test {
+ public:
+  void SetUp() override {
+    try {
+      config::applier::init(0, "test_broker");
+    } catch (const std::exception& e) {
+      (void)e;
+    }
+  }
+
+  void TearDown() override { config::applier::deinit(); }
+
+  static std::shared_ptr<io::raw> new_data(uint32_t i) {
+    std::shared_ptr<io::raw> r(new io::raw);
+    std::string s;
+    while (s.size() < 10000)
+      s.append(fmt::format("host_{};service_{};OK: {} ", i % 100, s.size(),
+                           i * s.size()));
+    r->get_buffer().assign(s.begin(), s.end());
+    return r;
+  }
+
+  /**
+   *  Write count buffers, each one giving a block.
+   */
+  static void write(compression::stream& s, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i)
+      s.write(new_data(i));
+    s.flush();
+  }
+};
+
+// Given a pipelined compression stream for each codec
+// When many blocks are written and read by another pipelined stream
+// Then the blocks are read in order and unchanged.
+TEST_F(CompressionStreamPipeline, BlocksKeepOrder) {
+  constexpr uint32_t count = 200;
+  for (auto codec : {compression::stream::zlib_codec,
+                     compression::stream::zstd_codec,
+                     compression::stream::lz4_codec}) {
+    auto memory = std::make_shared<CompressionStreamMemoryStream>();
+    compression::stream writer(-1, 10000, codec);
+    writer.set_pipelined(true);
+    writer.set_substream(memory);
+    write(writer, count);
+
+    compression::stream reader(-1, 10000, codec);
+    reader.set_pipelined(true);
+    reader.set_substream(memory);
+    for (uint32_t i = 0; i < count; ++i) {
+      std::shared_ptr<io::data> d;
+      ASSERT_TRUE(reader.read(d));
+      ASSERT_EQ(std::static_pointer_cast<io::raw>(d)->get_buffer(),
+                new_data(i)->get_buffer());
+    }
+  }
+}
+
+// Given a pipelined zlib stream
+// When a block is corrupted
+// Then it is skipped as without pipeline and the next blocks are read.
+TEST_F(CompressionStreamPipeline, CorruptedBlockIsSkipped) {
+  auto memory = std::make_shared<CompressionStreamMemoryStream>();
+  compression::stream writer(-1, 10000);
+  writer.set_substream(memory);
+  write(writer, 3);
+  std::vector<char>& buffer = memory->get_buffer()->get_buffer();
+  // Corrupt the second block, just after the size of the first one.
+  uint32_t size = (static_cast<unsigned char>(buffer[0]) << 24) |
+                  (static_cast<unsigned char>(buffer[1]) << 16) |
+                  (static_cast<unsigned char>(buffer[2]) << 8) |
+                  static_cast<unsigned char>(buffer[3]);
+  for (size_t i = size + 10; i < size + 30; ++i)
+    buffer[i] ^= 0x5a;
+
+  compression::stream reader(-1, 10000);
+  reader.set_pipelined(true);
+  reader.set_substream(memory);
+  std::shared_ptr<io::data> d;
+  ASSERT_TRUE(reader.read(d));
+  ASSERT_EQ(std::static_pointer_cast<io::raw>(d)->get_buffer(),
+            new_data(0)->get_buffer());
+  ASSERT_TRUE(reader.read(d));
+  ASSERT_EQ(std::static_pointer_cast<io::raw>(d)->get_buffer(),
+            new_data(2)->get_buffer());
+}
+
+// Given a pool of one thread
+// When pipelined streams of each codec are used from this thread
+// Then they do not wait for jobs queued behind it
+// And the blocks are read in order and unchanged.
+TEST_F(CompressionStreamPipeline, OnPoolThread) {
+  constexpr uint32_t count = 50;
+  pool::unload();
+  pool::load(1);
+  std::promise<bool> done;
+  asio::post(pool::io_context(), [&done] {
+    bool ok = true;
+    try {
+      for (auto codec : {compression::stream::zlib_codec,
+                         compression::stream::zstd_codec,
+                         compression::stream::lz4_codec}) {
+        auto memory = std::make_shared<CompressionStreamMemoryStream>();
+        {
+          compression::stream writer(-1, 10000, codec);
+          writer.set_pipelined(true);
+          writer.set_substream(memory);
+          write(writer, count);
+        }
+        compression::stream reader(-1, 10000, codec);
+        reader.set_pipelined(true);
+        reader.set_substream(memory);
+        for (uint32_t i = 0; ok && i < count; ++i) {
+          std::shared_ptr<io::data> d;
+          ok = reader.read(d) && d &&
+               std::static_pointer_cast<io::raw>(d)->get_buffer() ==
+                   new_data(i)->get_buffer();
+        }
+      }
+    } catch (const std::exception&) {
+      ok = false;
+    }
+    done.set_value(ok);
+  });
+  std::future<bool> f{done.get_future()};
+  ASSERT_EQ(f.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+  ASSERT_TRUE(f.get());
+  pool::unload();
+  pool::load(0);
+}
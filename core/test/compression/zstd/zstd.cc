@@ -0,0 +1,118 @@
+/*
+ * Copyright 2011 - 2019 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include "com/centreon/broker/compression/zstd.hh"
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include "com/centreon/broker/exceptions/corruption.hh"
+
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::compression;
+
+class CompressionZstd : public ::testing::Test {
+ public:
+  /**
+   *  A small block looking like the BBDO traffic of a poller.
+   */
+  static std::vector<char> block(uint32_t i) {
+    std::string s{fmt::format(
+        "srv-linux-{:03}.example.com\\0Service-{}\\0check_centreon_snmp_{}"
+        "\\024x7\\0OK: everything is fine\\0used={}B;80;90;0;100",
+        i % 100, i % 20, i % 5, i % 1000)};
+    return std::vector<char>(s.begin(), s.end());
+  }
+};
+
+// Given two zstd contexts
+// When blocks are compressed and uncompressed in order
+// Then we get the same blocks
+// And a block already seen is smaller the second time thanks to the history.
+TEST_F(CompressionZstd, History) {
+  zstd writer(-1);
+  zstd reader(-1);
+  std::vector<char> data(block(1));
+  std::vector<char> first(writer.compress(data));
+  std::vector<char> second(writer.compress(data));
+  ASSERT_LT(second.size(), first.size() / 2);
+
+  ASSERT_EQ(reader.uncompress(
+                reinterpret_cast<const unsigned char*>(first.data()),
+                first.size()),
+            data);
+  ASSERT_EQ(reader.uncompress(
+                reinterpret_cast<const unsigned char*>(second.data()),
+                second.size()),
+            data);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    std::vector<char> b(block(i));
+    std::vector<char> c(writer.compress(b));
+    ASSERT_EQ(
+        reader.uncompress(reinterpret_cast<const unsigned char*>(c.data()),
+                          c.size()),
+        b);
+  }
+}
+
+// Given a zstd context
+// When an empty block is compressed
+// Then we get as result a buffer containing "\0\0\0\0"
+TEST_F(CompressionZstd, Empty) {
+  zstd writer(-1);
+  std::vector<char> expected(4, '\0');
+  ASSERT_EQ(writer.compress(std::vector<char>()), expected);
+}
+
+// Given a zstd context
+// When a corrupted block is uncompressed
+// Then a corruption exception is thrown.
+TEST_F(CompressionZstd, Corrupted) {
+  zstd writer(-1);
+  zstd reader(-1);
+  std::vector<char> c(writer.compress(block(1)));
+  c[c.size() / 2] ^= 0x5a;
+  c[c.size() / 2 + 1] ^= 0x5a;
+  ASSERT_THROW(reader.uncompress(
+                   reinterpret_cast<const unsigned char*>(c.data()), c.size()),
+               exceptions::corruption);
+}
+
+// Given a dictionary trained on recorded blocks
+// When new contexts use it
+// Then the first blocks are compressed better than without dictionary
+// And contexts with the dictionary uncompress them.
+TEST_F(CompressionZstd, Dictionary) {
+  std::vector<std::string> samples;
+  for (uint32_t i = 0; i < 2000; ++i) {
+    std::vector<char> b(block(i));
+    samples.emplace_back(b.begin(), b.end());
+  }
+  std::string dictionary(zstd::train_dictionary(samples, 16384));
+  ASSERT_FALSE(dictionary.empty());
+  ASSERT_NE(zstd::dictionary_id(dictionary), 0u);
+
+  zstd plain(-1);
+  zstd writer(-1, dictionary);
+  zstd reader(-1, dictionary);
+  std::vector<char> data(block(5000));
+  std::vector<char> without(plain.compress(data));
+  std::vector<char> with(writer.compress(data));
+  ASSERT_LT(with.size(), without.size());
+  ASSERT_EQ(reader.uncompress(reinterpret_cast<const unsigned char*>(with.data()),
+                              with.size()),
+            data);
+}
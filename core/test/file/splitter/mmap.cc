@@ -0,0 +1,136 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "com/centreon/broker/exceptions/shutdown.hh"
+#include "com/centreon/broker/file/segment.hh"
+#include "com/centreon/broker/file/splitter.hh"
+#include "com/centreon/broker/misc/filesystem.hh"
+
+using namespace com::centreon::broker;
+
+class FileSplitterMmap : public ::testing::Test {
+ public:
+  void SetUp() override {
+    _path = "/tmp/mmap_queue";
+    _remove_files();
+    file::splitter::mmap_segments(true);
+  }
+
+  void TearDown() override {
+    file::splitter::mmap_segments(false);
+    _remove_files();
+  }
+
+ protected:
+  std::string _path;
+
+  static void _remove_files() {
+    std::list<std::string> parts{
+        misc::filesystem::dir_content_with_filter("/tmp/", "mmap_queue*")};
+    for (std::string const& f : parts)
+      std::remove(f.c_str());
+  }
+
+  static void _copy(const std::string& from, const std::string& to) {
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary);
+    out << in.rdbuf();
+  }
+};
+
+// Given a splitter using mmap segments with a max_size of 10008
+// When write() is called 10001 times with 10 bytes of data
+// Then once closed, the files have the same sizes as with stdio
+// And the data are read back in order.
+TEST_F(FileSplitterMmap, SplitAndReadBack) {
+  char buffer[10];
+  for (int i = 0; i < 10; ++i)
+    buffer[i] = i;
+  {
+    file::splitter s(_path, file::fs_file::open_read_write_truncate, 10008,
+                     true);
+    for (int i = 0; i < 10001; ++i)
+      s.write(buffer, sizeof(buffer));
+    ASSERT_EQ(misc::filesystem::file_size(_path + "10"), 10008u);
+  }
+  ASSERT_EQ(misc::filesystem::file_size(_path), 10008u);
+  for (int i = 1; i < 10; ++i)
+    ASSERT_EQ(misc::filesystem::file_size(fmt::format("{}{}", _path, i)),
+              10008u);
+  ASSERT_EQ(misc::filesystem::file_size(_path + "10"), 18u);
+
+  file::splitter s(_path, file::fs_file::open_read_write_truncate, 10008,
+                   true);
+  long total = 0;
+  char read_buffer[1000];
+  for (;;) {
+    long rb;
+    try {
+      rb = s.read(read_buffer, sizeof(read_buffer));
+    } catch (const exceptions::shutdown& e) {
+      break;
+    }
+    for (long i = 0; i < rb; ++i)
+      ASSERT_EQ(read_buffer[i], (total + i) % 10);
+    total += rb;
+  }
+  ASSERT_EQ(total, 100010);
+}
+
+// Given a segment file left preallocated, as if broker was stopped
+// When it is opened by a splitter using mmap segments
+// Then its data are read and new data are written after them
+// And when it is opened by a splitter using stdio
+// Then it is truncated to its data.
+TEST_F(FileSplitterMmap, ResumePreallocated) {
+  std::string mmap_image(_path + "_mmap");
+  std::string stdio_image(_path + "_stdio");
+  {
+    file::segment seg(_path, 1000000);
+    seg.write(file::segment::header_size, "abcdef", 6);
+    ASSERT_EQ(misc::filesystem::file_size(_path), 1000000u);
+    _copy(_path, mmap_image);
+    _copy(_path, stdio_image);
+  }
+  ASSERT_EQ(misc::filesystem::file_size(_path), 14u);
+
+  char buffer[100];
+  {
+    file::splitter s(mmap_image, file::fs_file::open_read_write_truncate,
+                     100000, false);
+    ASSERT_EQ(s.get_woffset(), 14);
+    s.write("gh", 2);
+    ASSERT_EQ(s.read(buffer, sizeof(buffer)), 8);
+    ASSERT_EQ(memcmp(buffer, "abcdefgh", 8), 0);
+  }
+  ASSERT_EQ(misc::filesystem::file_size(mmap_image), 16u);
+
+  file::splitter::mmap_segments(false);
+  file::splitter s(stdio_image, file::fs_file::open_read_write_truncate,
+                   100000, false);
+  ASSERT_EQ(misc::filesystem::file_size(stdio_image), 14u);
+  ASSERT_EQ(s.read(buffer, sizeof(buffer)), 6);
+  ASSERT_EQ(memcmp(buffer, "abcdef", 6), 0);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+
+#include "com/centreon/broker/io/buffer_chain.hh"
+
+#include <gtest/gtest.h>
+
+using namespace com::centreon::broker;
+
+static std::shared_ptr<io::raw> make_raw(const std::string& s) {
+  return std::make_shared<io::raw>(std::vector<char>(s.begin(), s.end()));
+}
+
+// Given a chain made of one buffer
+// When its content is taken
+// Then the slice points into the buffer without copy.
+TEST(IoBufferChain, TakeDoesNotCopy) {
+  io::buffer_chain chain;
+  auto r = make_raw("0123456789");
+  chain.push(r);
+  ASSERT_EQ(chain.size(), 10u);
+  chain.consume(2);
+  io::slice s = chain.take(5);
+  ASSERT_EQ(s.buffer, r);
+  ASSERT_EQ(s.data, r->data() + 2);
+  ASSERT_EQ(std::string(s.data, s.size), "23456");
+  ASSERT_EQ(chain.size(), 3u);
+  ASSERT_EQ(std::string(chain.contiguous(3), 3), "789");
+}
+
+// Given a chain made of several buffers
+// When a range spanning them is needed
+// Then only this range is copied and the following bytes are kept in order.
+TEST(IoBufferChain, ContiguousAcrossBuffers) {
+  io::buffer_chain chain;
+  chain.push(make_raw("abc"));
+  chain.push(make_raw("de"));
+  chain.push(make_raw("fghij"));
+  ASSERT_EQ(chain.size(), 10u);
+  ASSERT_EQ(std::string(chain.contiguous(7), 7), "abcdefg");
+  chain.consume(4);
+  io::slice s = chain.take(4);
+  ASSERT_EQ(std::string(s.data, s.size), "efgh");
+  ASSERT_EQ(chain.size(), 2u);
+  chain.consume(2);
+  ASSERT_TRUE(chain.empty());
+}
+
+// Given a chain with data
+// When it is cleared
+// Then it is empty and new buffers can be pushed.
+TEST(IoBufferChain, Clear) {
+  io::buffer_chain chain;
+  chain.push(make_raw("abc"));
+  chain.push(std::make_shared<io::raw>());
+  chain.clear();
+  ASSERT_TRUE(chain.empty());
+  chain.push(make_raw("xyz"));
+  ASSERT_EQ(std::string(chain.contiguous(3), 3), "xyz");
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include "com/centreon/broker/misc/buffer_pool.hh"
+
+#include <gtest/gtest.h>
+
+using namespace com::centreon::broker;
+
+// Given a buffer wrapped in an io::raw by the pool
+// When the io::raw is destroyed
+// Then the next buffer of the same size class got from the pool is the same
+// memory.
+TEST(MiscBufferPool, BufferIsReused) {
+  auto& pool = misc::buffer_pool::instance();
+  std::vector<char> b = pool.get(16384);
+  ASSERT_EQ(b.size(), 16384u);
+  b.resize(100);
+  const char* data = b.data();
+  {
+    std::shared_ptr<io::raw> r = pool.make_raw(std::move(b));
+    ASSERT_EQ(r->size(), 100u);
+    ASSERT_EQ(r->const_data(), data);
+  }
+  std::vector<char> other = pool.get(10000);
+  ASSERT_EQ(other.size(), 10000u);
+  ASSERT_EQ(other.data(), data);
+  pool.release(std::move(other));
+}
+
+// Given buffers too big to be kept
+// When they are released
+// Then they are not given back.
+TEST(MiscBufferPool, BigBuffersAreDropped) {
+  auto& pool = misc::buffer_pool::instance();
+  nlohmann::json before;
+  pool.statistics(before);
+  pool.release(std::vector<char>(misc::buffer_pool::max_buffer_size + 1));
+  nlohmann::json after;
+  pool.statistics(after);
+  ASSERT_EQ(after["read_buffers_free"], before["read_buffers_free"]);
+}
+
+// Given a free buffer of the biggest size class
+// When a small buffer is wanted
+// Then the big one is not used for it.
+TEST(MiscBufferPool, SmallReadsDoNotTakeBigBuffers) {
+  auto& pool = misc::buffer_pool::instance();
+  std::vector<char> big = pool.get(misc::buffer_pool::max_buffer_size);
+  const char* data = big.data();
+  pool.release(std::move(big));
+  std::vector<char> small = pool.get(misc::buffer_pool::min_buffer_size);
+  ASSERT_EQ(small.size(), misc::buffer_pool::min_buffer_size);
+  ASSERT_LT(small.capacity(), misc::buffer_pool::max_buffer_size);
+  ASSERT_NE(small.data(), data);
+  pool.release(std::move(small));
+}
+
+// Given a buffer bigger than the last size class got from the pool
+// When it is wrapped in an io::raw and destroyed
+// Then it is not kept.
+TEST(MiscBufferPool, OversizedBuffersAreNotKept) {
+  auto& pool = misc::buffer_pool::instance();
+  nlohmann::json before;
+  pool.statistics(before);
+  std::vector<char> b = pool.get(misc::buffer_pool::max_buffer_size + 1);
+  ASSERT_EQ(b.size(), misc::buffer_pool::max_buffer_size + 1);
+  pool.make_raw(std::move(b));
+  nlohmann::json after;
+  pool.statistics(after);
+  ASSERT_EQ(after["read_buffers_free"], before["read_buffers_free"]);
+}
@@ -53,3 +53,9 @@ TEST(MiscTest, BadLengthFromHex) {
   std::string const str = "abcde";
   ASSERT_THROW(from_hex(str), std::exception);
 }
+
+TEST(MiscTest, Crc16Ccitt) {
+  std::string const str = "123456789";
+  ASSERT_EQ(crc16_ccitt(str.data(), str.size()), 0x906e);
+  ASSERT_EQ(crc16_ccitt(str.data(), 0), 0x0000);
+}
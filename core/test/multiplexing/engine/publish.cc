@@ -0,0 +1,149 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/multiplexing/engine.hh"
+#include "com/centreon/broker/multiplexing/muxer.hh"
+#include "com/centreon/broker/multiplexing/subscriber.hh"
+
+using namespace com::centreon::broker;
+
+constexpr uint32_t producers = 8;
+constexpr uint32_t events_per_producer = 20000;
+constexpr uint32_t outputs = 4;
+
+class EnginePublish : public testing::Test {
+ public:
+  void SetUp() override { config::applier::init(0, "test_broker"); }
+
+  void TearDown() override { config::applier::deinit(); }
+
+  static std::shared_ptr<io::data> make_event(uint32_t producer,
+                                              uint32_t seq) {
+    std::shared_ptr<io::raw> r{std::make_shared<io::raw>()};
+    r->resize(2 * sizeof(uint32_t));
+    memcpy(r->data(), &producer, sizeof(producer));
+    memcpy(r->data() + sizeof(producer), &seq, sizeof(seq));
+    return r;
+  }
+
+  /**
+   * @brief Read all the events available in the muxer, check that each
+   * producer events are in order and return how many events were read.
+   */
+  static uint32_t check_order(multiplexing::muxer& m) {
+    std::vector<int64_t> last(producers, -1);
+    uint32_t retval = 0;
+    std::shared_ptr<io::data> d;
+    for (;;) {
+      d.reset();
+      m.read(d, 0);
+      if (!d)
+        break;
+      uint32_t producer, seq;
+      auto r = std::static_pointer_cast<io::raw>(d);
+      memcpy(&producer, r->data(), sizeof(producer));
+      memcpy(&seq, r->data() + sizeof(producer), sizeof(seq));
+      EXPECT_LT(producer, producers);
+      EXPECT_EQ(last[producer] + 1, static_cast<int64_t>(seq));
+      last[producer] = seq;
+      ++retval;
+    }
+    return retval;
+  }
+
+  /**
+   * @brief Publish events from several threads to several subscribers of a
+   * started engine, and check that each subscriber receives all of them, in
+   * order for each producer.
+   */
+  static void publish_and_check() {
+    multiplexing::muxer::filters f{io::raw::static_type()};
+    std::vector<std::unique_ptr<multiplexing::subscriber>> subscribers;
+    for (uint32_t i = 0; i < outputs; ++i) {
+      subscribers.emplace_back(std::make_unique<multiplexing::subscriber>(
+          fmt::format("core_multiplexing_engine_publish_{}", i), false));
+      subscribers.back()->get_muxer().set_read_filters(f);
+      subscribers.back()->get_muxer().set_write_filters(f);
+    }
+    multiplexing::engine::instance().start();
+
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; ++p)
+      threads.emplace_back([p] {
+        for (uint32_t i = 0; i < events_per_producer; ++i)
+          multiplexing::engine::instance().publish(make_event(p, i));
+      });
+    for (auto& t : threads)
+      t.join();
+
+    for (auto& s : subscribers)
+      ASSERT_EQ(check_order(s->get_muxer()), producers * events_per_producer);
+    multiplexing::engine::instance().stop();
+  }
+};
+
+// Given several subscribers and a started engine
+// When several threads publish events concurrently
+// Then each subscriber receives all the events
+// And the events of each publisher are received in order.
+TEST_F(EnginePublish, ConcurrentPublishersKeepOrder) {
+  publish_and_check();
+}
+
+// Given an engine with a small ingest ring, often full
+// When several threads publish events concurrently
+// Then the events of each publisher are still received in order.
+TEST_F(EnginePublish, FullRingKeepsOrder) {
+  multiplexing::engine::unload();
+  multiplexing::engine::load(16);
+  publish_and_check();
+}
+
+// Given two subscribers, one interested in raw events and the other not
+// When raw events are published
+// Then only the first subscriber receives them
+// And when the write filters of the second one change, it receives the next
+// raw events.
+TEST_F(EnginePublish, EventsAreRoutedByType) {
+  multiplexing::subscriber interested("core_multiplexing_engine_route_raw",
+                                      false);
+  multiplexing::subscriber other("core_multiplexing_engine_route_other",
+                                 false);
+  interested.get_muxer().set_read_filters({io::raw::static_type()});
+  interested.get_muxer().set_write_filters({io::raw::static_type()});
+  other.get_muxer().set_read_filters({io::raw::static_type() + 1});
+  other.get_muxer().set_write_filters({io::raw::static_type() + 1});
+  multiplexing::engine::instance().start();
+
+  multiplexing::engine::instance().publish(make_event(0, 0));
+  ASSERT_EQ(check_order(interested.get_muxer()), 1u);
+  ASSERT_EQ(check_order(other.get_muxer()), 0u);
+
+  other.get_muxer().set_write_filters({io::raw::static_type()});
+  multiplexing::engine::instance().publish(make_event(1, 0));
+  ASSERT_EQ(check_order(interested.get_muxer()), 1u);
+  ASSERT_EQ(check_order(other.get_muxer()), 1u);
+  multiplexing::engine::instance().stop();
+}
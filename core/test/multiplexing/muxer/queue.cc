@@ -0,0 +1,295 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <deque>
+#include <list>
+#include <memory>
+#include <thread>
+
+#include "com/centreon/broker/bbdo/ack.hh"
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/instance_broadcast.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/misc/filesystem.hh"
+#include "com/centreon/broker/multiplexing/muxer.hh"
+
+using namespace com::centreon::broker;
+
+constexpr size_t queued_events = 500000;
+
+/**
+ * @brief Allocator counting the bytes currently allocated by a container.
+ */
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+  size_t* allocated;
+
+  explicit counting_allocator(size_t* a) : allocated(a) {}
+  template <typename U>
+  counting_allocator(const counting_allocator<U>& other)
+      : allocated(other.allocated) {}
+
+  T* allocate(size_t n) {
+    *allocated += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, size_t n) {
+    *allocated -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+  template <typename U>
+  bool operator==(const counting_allocator<U>& other) const {
+    return allocated == other.allocated;
+  }
+  template <typename U>
+  bool operator!=(const counting_allocator<U>& other) const {
+    return allocated != other.allocated;
+  }
+};
+
+template <template <typename, typename> class C>
+static size_t bytes_per_queued_event() {
+  using value = std::shared_ptr<io::data>;
+  size_t allocated = 0;
+  C<value, counting_allocator<value>> queue{
+      counting_allocator<value>(&allocated)};
+  std::shared_ptr<io::data> e{std::make_shared<io::raw>()};
+  for (size_t i = 0; i < queued_events; ++i)
+    queue.push_back(e);
+  return allocated / queued_events;
+}
+
+class MultiplexingMuxerQueue : public ::testing::Test {
+ public:
+  void SetUp() override { config::applier::init(0, "test_broker"); }
+
+  void TearDown() override { config::applier::deinit(); }
+};
+
+// Given a std::list, as the muxer queue used to be, and a segmented container
+// When they are filled with the same events
+// Then the segmented container allocates fewer bytes (the events themselves
+// are not counted).
+TEST_F(MultiplexingMuxerQueue, MemoryPerEvent) {
+  size_t list_bytes = bytes_per_queued_event<std::list>();
+  size_t deque_bytes = bytes_per_queued_event<std::deque>();
+  ASSERT_LT(deque_bytes, list_bytes);
+}
+
+// Given a muxer with a small event queue
+// When many more events are published
+// Then they are spilled to the queue file by the spill thread
+// And they are read back in order.
+TEST_F(MultiplexingMuxerQueue, SpillAndReadAhead) {
+  constexpr uint32_t count = 20000;
+  multiplexing::muxer::event_queue_max_size(100);
+  {
+    multiplexing::muxer m("MultiplexingMuxerQueue_SpillAndReadAhead", false);
+    multiplexing::muxer::filters f{bbdo::ack::static_type()};
+    m.set_read_filters(f);
+    m.set_write_filters(f);
+
+    for (uint32_t i = 0; i < count; ++i)
+      m.publish(std::make_shared<bbdo::ack>(i));
+    ASSERT_LE(m.get_event_queue_size(), 100u);
+
+    std::vector<std::shared_ptr<io::data>> events;
+    uint32_t expected = 0;
+    while (expected < count) {
+      ASSERT_TRUE(m.read_batch(events, multiplexing::muxer::read_batch_size,
+                               time(nullptr) + 5));
+      for (auto& e : events) {
+        ASSERT_EQ(e->type(), bbdo::ack::static_type());
+        ASSERT_EQ(std::static_pointer_cast<bbdo::ack>(e)->acknowledged_events,
+                  expected);
+        ++expected;
+      }
+      m.ack_events(events.size());
+    }
+  }
+  multiplexing::muxer::event_queue_max_size(0);
+  multiplexing::muxer m("MultiplexingMuxerQueue_SpillAndReadAhead", false);
+  m.remove_queue_files();
+}
+
+// Given a muxer whose queue file was entirely read
+// When more events are spilled and the muxer is destroyed
+// Then they are all read back in order by the next muxer.
+TEST_F(MultiplexingMuxerQueue, SpillAfterCatchUp) {
+  constexpr uint32_t count = 2000;
+  const std::string name("MultiplexingMuxerQueue_SpillAfterCatchUp");
+  multiplexing::muxer::filters f{bbdo::ack::static_type()};
+  auto read = [](multiplexing::muxer& m, uint32_t from, uint32_t to) {
+    std::vector<std::shared_ptr<io::data>> events;
+    uint32_t expected = from;
+    while (expected < to) {
+      ASSERT_TRUE(m.read_batch(events, multiplexing::muxer::read_batch_size,
+                               time(nullptr) + 5));
+      for (auto& e : events) {
+        ASSERT_EQ(std::static_pointer_cast<bbdo::ack>(e)->acknowledged_events,
+                  expected);
+        ++expected;
+      }
+      m.ack_events(events.size());
+    }
+  };
+  multiplexing::muxer::event_queue_max_size(100);
+  {
+    multiplexing::muxer m(name, true);
+    m.set_read_filters(f);
+    m.set_write_filters(f);
+    for (uint32_t i = 0; i < count; ++i)
+      m.publish(std::make_shared<bbdo::ack>(i));
+    read(m, 0, count);
+    for (uint32_t i = count; i < 2 * count; ++i)
+      m.publish(std::make_shared<bbdo::ack>(i));
+  }
+  {
+    multiplexing::muxer m(name, true);
+    m.set_read_filters(f);
+    m.set_write_filters(f);
+    read(m, count, 2 * count);
+  }
+  multiplexing::muxer::event_queue_max_size(0);
+  multiplexing::muxer m(name, false);
+  m.remove_queue_files();
+}
+
+// Given a memory budget shared by all the muxers
+// And a stalled muxer using most of it and a healthy one
+// When the budget is exceeded
+// Then only the stalled muxer is elected to spill to its queue file
+// And its resident bytes decrease while its events are kept in order.
+TEST_F(MultiplexingMuxerQueue, MemoryBudget) {
+  constexpr uint32_t count = 5000;
+  multiplexing::muxer::event_queues_total_size(1000000);
+  {
+    auto make_event = [](uint32_t id, size_t len) {
+      auto ib = std::make_shared<instance_broadcast>();
+      ib->broker_id = id;
+      ib->poller_name = std::string(len, 'x');
+      return ib;
+    };
+    ASSERT_GT(make_event(0, 1000)->memory_size(), 1000u);
+
+    multiplexing::muxer stalled("MultiplexingMuxerQueue_MemoryBudget_Stalled",
+                                false);
+    multiplexing::muxer healthy("MultiplexingMuxerQueue_MemoryBudget_Healthy",
+                                false);
+    multiplexing::muxer::filters f{instance_broadcast::static_type()};
+    stalled.set_read_filters(f);
+    stalled.set_write_filters(f);
+    healthy.set_read_filters(f);
+    healthy.set_write_filters(f);
+
+    for (uint32_t i = 0; i < count; ++i)
+      stalled.publish(make_event(i, 1000));
+    healthy.publish(make_event(0, 10));
+    ASSERT_GT(stalled.resident_bytes(), count * 1000u);
+    ASSERT_GE(multiplexing::muxer::total_resident_bytes(),
+              stalled.resident_bytes() + healthy.resident_bytes());
+
+    // Elections are done at most once per second.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    healthy.publish(make_event(1, 10));
+    nlohmann::json stalled_tree, healthy_tree;
+    stalled.statistics(stalled_tree);
+    healthy.statistics(healthy_tree);
+    ASSERT_TRUE(stalled_tree["spilling"].get<bool>());
+    ASSERT_FALSE(healthy_tree["spilling"].get<bool>());
+
+    stalled.publish(make_event(count, 1000));
+    for (int i = 0; i < 50 && stalled.resident_bytes() > count * 1000u / 2;
+         ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_LT(stalled.resident_bytes(), count * 1000u / 2);
+
+    std::vector<std::shared_ptr<io::data>> events;
+    uint32_t expected = 0;
+    while (expected <= count) {
+      ASSERT_TRUE(stalled.read_batch(
+          events, multiplexing::muxer::read_batch_size, time(nullptr) + 5));
+      for (auto& e : events) {
+        ASSERT_EQ(std::static_pointer_cast<instance_broadcast>(e)->broker_id,
+                  expected);
+        ++expected;
+      }
+      stalled.ack_events(events.size());
+    }
+  }
+  multiplexing::muxer::event_queues_total_size(0);
+  multiplexing::muxer stalled("MultiplexingMuxerQueue_MemoryBudget_Stalled",
+                              false);
+  stalled.remove_queue_files();
+}
+
+// Given a muxer whose queue file cannot be written
+// When more events than its event queue can contain are published
+// Then they are kept in memory and still accounted
+// And once the queue file works again, they are all read back in order
+// And their memory is released when they are acknowledged.
+TEST_F(MultiplexingMuxerQueue, SpillWriteFailure) {
+  constexpr uint32_t count = 5000;
+  // The queue file is in a directory that we remove to make it fail.
+  std::string dir{
+      multiplexing::muxer::queue_file("MultiplexingMuxerQueue_SpillFailure")};
+  auto remove_dir = [&dir] {
+    for (auto& f : misc::filesystem::dir_content(dir, false))
+      std::remove(f.c_str());
+    rmdir(dir.c_str());
+  };
+  remove_dir();
+  ASSERT_TRUE(misc::filesystem::mkpath(dir));
+  multiplexing::muxer::event_queue_max_size(100);
+  {
+    multiplexing::muxer m("MultiplexingMuxerQueue_SpillFailure/queue", false);
+    multiplexing::muxer::filters f{bbdo::ack::static_type()};
+    m.set_read_filters(f);
+    m.set_write_filters(f);
+    remove_dir();
+
+    for (uint32_t i = 0; i < count; ++i)
+      m.publish(std::make_shared<bbdo::ack>(i));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_GE(m.resident_bytes(),
+              count * std::make_shared<bbdo::ack>(0)->memory_size());
+
+    ASSERT_TRUE(misc::filesystem::mkpath(dir));
+    std::vector<std::shared_ptr<io::data>> events;
+    uint32_t expected = 0;
+    while (expected < count) {
+      ASSERT_TRUE(m.read_batch(events, multiplexing::muxer::read_batch_size,
+                               time(nullptr) + 10));
+      for (auto& e : events) {
+        ASSERT_EQ(std::static_pointer_cast<bbdo::ack>(e)->acknowledged_events,
+                  expected);
+        ++expected;
+      }
+      m.ack_events(events.size());
+    }
+    ASSERT_EQ(m.resident_bytes(), 0u);
+  }
+  multiplexing::muxer::event_queue_max_size(0);
+  remove_dir();
+}
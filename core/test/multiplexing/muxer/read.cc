@@ -134,3 +134,36 @@ TEST_F(MultiplexingMuxerRead, AckEventsPartial) {
   _m->read(d, 0);
   ASSERT_TRUE(!d);
 }
+
+// Given a muxer object with all filters
+// And some events were given to write()
+// When I call read_batch() several times
+// Then I get the events in order by batches of the requested size
+// And after a partial ack_events() followed by a nack_events() I can
+// read_batch() the unacknowledged events back
+TEST_F(MultiplexingMuxerRead, ReadBatch) {
+  setup("MultiplexingMuxerRead_ReadBatch");
+  publish_events();
+  std::vector<std::shared_ptr<io::data>> events;
+  int expected = 0;
+  while (_m->read_batch(events, 300, 0) && !events.empty()) {
+    ASSERT_LE(events.size(), 300u);
+    for (auto& d : events) {
+      int reread;
+      memcpy(&reread, std::static_pointer_cast<io::raw>(d)->data(),
+             sizeof(reread));
+      ASSERT_EQ(reread, expected++);
+    }
+  }
+  ASSERT_EQ(expected, 10000);
+  ASSERT_TRUE(events.empty());
+
+  _m->ack_events(7000);
+  _m->nack_events();
+  ASSERT_TRUE(_m->read_batch(events, 10000, 0));
+  ASSERT_EQ(events.size(), 3000u);
+  int first;
+  memcpy(&first, std::static_pointer_cast<io::raw>(events[0])->data(),
+         sizeof(first));
+  ASSERT_EQ(first, 7000);
+}
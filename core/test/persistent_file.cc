@@ -0,0 +1,175 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include "com/centreon/broker/persistent_file.hh"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include "com/centreon/broker/bbdo/stream.hh"
+#include "com/centreon/broker/compression/stream.hh"
+#include "com/centreon/broker/config/applier/init.hh"
+#include "com/centreon/broker/config/applier/modules.hh"
+#include "com/centreon/broker/exceptions/shutdown.hh"
+#include "com/centreon/broker/file/opener.hh"
+#include "com/centreon/broker/misc/filesystem.hh"
+#include "com/centreon/broker/neb/service_status.hh"
+
+using namespace com::centreon::broker;
+
+class PersistentFile : public ::testing::Test {
+ protected:
+  std::unique_ptr<config::applier::modules> _modules;
+
+ public:
+  void SetUp() override {
+    config::applier::init(0, "broker_test");
+    _modules = std::make_unique<config::applier::modules>();
+    _modules->load_file("./neb/10-neb.so");
+  }
+
+  void TearDown() override {
+    _modules.reset();
+    config::applier::deinit();
+  }
+
+  static std::shared_ptr<neb::service_status> status(uint32_t i) {
+    auto ss = std::make_shared<neb::service_status>();
+    ss->host_id = i / 20 % 100 + 1;
+    ss->service_id = i;
+    ss->host_name = fmt::format("srv-linux-{:03}.example.com", ss->host_id);
+    ss->service_description = fmt::format("Service-{}", i % 20);
+    ss->check_command = "check_centreon_snmp";
+    ss->output = "OK: everything is fine";
+    ss->perf_data = fmt::format("used={}B;80;90;0;100", i % 1000);
+    return ss;
+  }
+
+  /**
+   *  The stack used by previous versions to write retention files: one zlib
+   *  block per event.
+   */
+  static std::shared_ptr<io::stream> legacy_file(const std::string& path) {
+    file::opener opnr;
+    opnr.set_filename(path);
+    std::shared_ptr<io::stream> fs(opnr.open());
+    auto cs = std::make_shared<compression::stream>();
+    cs->set_substream(fs);
+    auto bs = std::make_shared<bbdo::stream>(true);
+    bs->set_coarse(true);
+    bs->set_negotiate(false);
+    bs->set_substream(cs);
+    return bs;
+  }
+
+  static void check(io::stream& f, uint32_t from, uint32_t to) {
+    std::shared_ptr<io::data> e;
+    for (uint32_t i = from; i < to; ++i) {
+      do {
+        f.read(e, 0);
+      } while (!e);
+      auto ss = std::static_pointer_cast<neb::service_status>(e);
+      ASSERT_EQ(ss->service_id, i);
+      ASSERT_EQ(ss->perf_data, status(i)->perf_data);
+    }
+  }
+
+  static void remove(const std::string& path) {
+    persistent_file f(path);
+    f.remove_all_files();
+  }
+};
+
+// Given a retention file written by a previous version
+// When it is read by a persistent file and then more events are appended
+// Then all the events are read in order.
+TEST_F(PersistentFile, LegacyFileIsRead) {
+  const std::string path("/tmp/persistent_file_legacy");
+  remove(path);
+  {
+    auto legacy = legacy_file(path);
+    for (uint32_t i = 0; i < 1000; ++i)
+      legacy->write(status(i));
+  }
+  {
+    persistent_file f(path);
+    for (uint32_t i = 1000; i < 2000; ++i)
+      f.write(status(i));
+  }
+  persistent_file f(path);
+  check(f, 0, 2000);
+  remove(path);
+}
+
+// Given a persistent file
+// When its reading catches up with its writing
+// Then the events not written yet are read
+// And it cannot be written anymore, the next events go to a new file
+// And they are read back once this file is closed and reopened.
+TEST_F(PersistentFile, ReadCatchesUpWrite) {
+  const std::string path("/tmp/persistent_file_catch_up");
+  remove(path);
+  {
+    persistent_file f(path);
+    for (uint32_t i = 0; i < 100; ++i)
+      f.write(status(i));
+    check(f, 0, 100);
+    ASSERT_THROW(f.write(status(100)), exceptions::shutdown);
+    std::shared_ptr<io::data> e;
+    ASSERT_THROW(f.read(e, 0), exceptions::shutdown);
+
+    persistent_file next(path);
+    for (uint32_t i = 100; i < 200; ++i)
+      next.write(status(i));
+  }
+  {
+    persistent_file f(path);
+    check(f, 100, 200);
+  }
+  remove(path);
+}
+
+// Given a persistent file
+// When events are written in a block that is not full
+// Then they are on disk after flush()
+// Or after the maximum buffer delay, when the next event is written.
+TEST_F(PersistentFile, PartialBlocks) {
+  const std::string path("/tmp/persistent_file_partial");
+  remove(path);
+  {
+    persistent_file f(path);
+    int64_t empty = misc::filesystem::file_size(path);
+    for (uint32_t i = 0; i < 100; ++i)
+      f.write(status(i));
+    ASSERT_EQ(misc::filesystem::file_size(path), empty);
+    f.flush();
+    int64_t flushed = misc::filesystem::file_size(path);
+    ASSERT_GT(flushed, empty);
+
+    for (uint32_t i = 100; i < 200; ++i)
+      f.write(status(i));
+    ASSERT_EQ(misc::filesystem::file_size(path), flushed);
+    f.set_max_buffer_delay(0);
+    f.write(status(200));
+    ASSERT_GT(misc::filesystem::file_size(path), flushed);
+
+    persistent_file reader(path);
+    check(reader, 0, 201);
+  }
+  remove(path);
+}
@@ -19,14 +19,24 @@
 
 #include "com/centreon/broker/processing/feeder.hh"
 #include <gtest/gtest.h>
+#include <fmt/format.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <thread>
 #include "com/centreon/broker/config/applier/state.hh"
 #include "com/centreon/broker/io/events.hh"
 #include "com/centreon/broker/io/protocols.hh"
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/misc/waker.hh"
 #include "com/centreon/broker/multiplexing/engine.hh"
+#include "com/centreon/broker/pool.hh"
 #include "com/centreon/broker/stats/center.hh"
+#include "com/centreon/exceptions/msg_fmt.hh"
 
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::processing;
@@ -40,6 +50,100 @@ class TestStream : public io::stream {
   int32_t stop() override { return 0; }
 };
 
+/**
+ *  Stream with nothing to read, that counts the events written to it.
+ */
+class CountingStream : public io::stream {
+  std::atomic<size_t> _written;
+
+ public:
+  CountingStream() : io::stream("CountingStream"), _written{0} {}
+  bool read(std::shared_ptr<io::data>& d, time_t) override {
+    d.reset();
+    return false;
+  }
+
+  int32_t write(std::shared_ptr<io::data> const&) override {
+    ++_written;
+    return 1;
+  }
+  int32_t stop() override { return 0; }
+
+  size_t written() const { return _written; }
+};
+
+/**
+ *  Run a job on a shard and tell if it was done before the timeout.
+ */
+static bool run_on_shard(size_t shard, std::function<void()> job) {
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> f = done->get_future();
+  asio::post(pool::instance().shard_context(shard), [job, done] {
+    job();
+    done->set_value();
+  });
+  return f.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+}
+
+/**
+ *  Stream running on the shard 0, not ready for writes until the shard opens
+ *  it, as a connection waiting for credits. Its stop() needs the shard, as a
+ *  stop waiting for the ack of the peer.
+ */
+class ShardStream : public io::stream {
+ public:
+  struct gate {
+    std::atomic_bool ready{false};
+    std::atomic_bool closed{false};
+    std::atomic<uint32_t> written{0};
+    std::atomic<uint32_t> written_not_ready{0};
+    std::atomic<uint32_t> flushed_not_ready{0};
+    std::atomic_bool stopped_with_shard{false};
+    std::mutex waker_m;
+    std::shared_ptr<misc::waker> waker;
+
+    void notify() {
+      std::lock_guard<std::mutex> lck(waker_m);
+      if (waker)
+        waker->notify();
+    }
+  };
+
+ private:
+  gate& _gate;
+
+ public:
+  ShardStream(gate& g) : io::stream("ShardStream"), _gate(g) {}
+  bool read(std::shared_ptr<io::data>& d, time_t) override {
+    if (_gate.closed)
+      throw com::centreon::exceptions::msg_fmt("connection closed");
+    d.reset();
+    return false;
+  }
+  bool set_read_waker(const std::shared_ptr<misc::waker>& waker) override {
+    std::lock_guard<std::mutex> lck(_gate.waker_m);
+    _gate.waker = waker;
+    return true;
+  }
+  int flush() override {
+    if (!_gate.ready)
+      ++_gate.flushed_not_ready;
+    return 0;
+  }
+  int shard() const override { return 0; }
+  bool write_ready() const override { return _gate.ready; }
+  int32_t write(std::shared_ptr<io::data> const&) override {
+    if (!_gate.ready)
+      ++_gate.written_not_ready;
+    ++_gate.written;
+    return 1;
+  }
+  int32_t stop() override {
+    _gate.stopped_with_shard = run_on_shard(0, [] {});
+    return 0;
+  }
+};
+
 class TestFeeder : public ::testing::Test {
  protected:
   std::unique_ptr<feeder> _feeder;
@@ -82,3 +186,122 @@ TEST_F(TestFeeder, isFinished) {
   _feeder->stats(tree);
   ASSERT_EQ(tree["state"].get<std::string>(), "connected");
 }
+
+// Given a muxer with a waker, as feeders set it
+// When an event is published
+// Then the waker is notified at once, the feeder does not wait for a timeout
+// to write it.
+TEST_F(TestFeeder, PublishWakesUp) {
+  std::unordered_set<uint32_t> filters{io::raw::static_type()};
+  multiplexing::muxer m("test-feeder-wakeup", false);
+  m.set_read_filters(filters);
+  m.set_write_filters(filters);
+  auto waker = std::make_shared<misc::waker>();
+  std::atomic<uint32_t> callbacks{0};
+  waker->set_callback([&callbacks] { ++callbacks; });
+  m.set_waker(waker);
+
+  uint64_t sequence = waker->sequence();
+  m.publish(std::make_shared<io::raw>());
+  ASSERT_GT(waker->sequence(), sequence);
+  ASSERT_EQ(callbacks, 1u);
+  std::vector<std::shared_ptr<io::data>> events;
+  m.read_batch(events, multiplexing::muxer::read_batch_size, 0);
+  ASSERT_EQ(events.size(), 1u);
+  waker->set_callback(nullptr);
+}
+
+/**
+ *  Number of threads of the process.
+ */
+static uint32_t thread_count() {
+  std::ifstream f("/proc/self/status");
+  std::string line;
+  while (std::getline(f, line))
+    if (line.compare(0, 8, "Threads:") == 0)
+      return std::stoul(line.substr(8));
+  return 0;
+}
+
+// Given many feeders running in pool mode
+// When events are published
+// Then each feeder writes all of them to its client
+// And no thread is started for the feeders.
+TEST_F(TestFeeder, PoolMode) {
+  constexpr size_t feeders = 50;
+  constexpr size_t count = 100;
+  std::unordered_set<uint32_t> filters{io::raw::static_type()};
+  multiplexing::engine::instance().start();
+
+  feeder::pool_mode(true, 2);
+  uint32_t threads_before = thread_count();
+  std::vector<CountingStream*> streams;
+  std::vector<std::unique_ptr<feeder>> fs;
+  for (size_t i = 0; i < feeders; ++i) {
+    streams.push_back(new CountingStream);
+    std::unique_ptr<io::stream> client(streams.back());
+    fs.emplace_back(std::make_unique<feeder>(
+        fmt::format("test-feeder-pool-{}", i), client, filters, filters));
+  }
+  ASSERT_EQ(thread_count(), threads_before);
+  nlohmann::json tree;
+  fs.front()->stats(tree);
+  ASSERT_EQ(tree["execution"].get<std::string>(), "pool");
+
+  for (size_t i = 0; i < count; ++i)
+    multiplexing::engine::instance().publish(std::make_shared<io::raw>());
+
+  for (auto* s : streams) {
+    for (int i = 0; i < 100 && s->written() < count; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(s->written(), count);
+  }
+  fs.clear();
+  feeder::pool_mode(false);
+  multiplexing::engine::instance().stop();
+}
+
+// Given a feeder in pool mode whose client runs on a shard
+// When the client is not ready for writes
+// Then the events are kept without blocking the shard nor flushing the
+// client
+// And they are written once the shard makes the client ready
+// And the client is stopped while the shard keeps running.
+TEST_F(TestFeeder, PoolModeShardNotReady) {
+  constexpr uint32_t count = 100;
+  std::unordered_set<uint32_t> filters{io::raw::static_type()};
+  multiplexing::engine::instance().start();
+  pool::instance().start_shards(1);
+
+  feeder::pool_mode(true, 2);
+  ShardStream::gate g;
+  std::unique_ptr<io::stream> client(new ShardStream(g));
+  auto f = std::make_unique<feeder>("test-feeder-shard", client, filters,
+                                    filters);
+
+  for (uint32_t i = 0; i < count; ++i)
+    multiplexing::engine::instance().publish(std::make_shared<io::raw>());
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  ASSERT_EQ(g.written, 0u);
+  ASSERT_TRUE(run_on_shard(0, [] {}));
+
+  ASSERT_TRUE(run_on_shard(0, [&g] {
+    g.ready = true;
+    g.notify();
+  }));
+  for (int i = 0; i < 100 && g.written < count; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_EQ(g.written, count);
+  ASSERT_EQ(g.written_not_ready, 0u);
+  ASSERT_EQ(g.flushed_not_ready, 0u);
+
+  g.closed = true;
+  g.notify();
+  for (int i = 0; i < 100 && !f->is_finished(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_TRUE(f->is_finished());
+  f.reset();
+  ASSERT_TRUE(g.stopped_with_shard);
+  feeder::pool_mode(false);
+  multiplexing::engine::instance().stop();
+}
@@ -100,6 +100,8 @@ class stream : public io::stream {
   ~stream();
   bool read(std::shared_ptr<io::data>& d, time_t deadline) override;
   int write(std::shared_ptr<io::data> const& d) override;
+  int32_t write_batch(
+      const std::vector<std::shared_ptr<io::data>>& d) override;
   int32_t flush() override;
   int32_t stop() override;
   bool stats_mean_square(double& a, double& b) const noexcept;
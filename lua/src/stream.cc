@@ -237,6 +237,28 @@ int stream::write(std::shared_ptr<io::data> const& data) {
   return retval;
 }
 
+/**
+ *  Write several events, the exposed queue is locked only once.
+ *
+ *  @param[in] d Events.
+ *
+ *  @return Number of events acknowledged.
+ */
+int32_t stream::write_batch(const std::vector<std::shared_ptr<io::data>>& d) {
+  {
+    std::lock_guard<std::mutex> lck(_exposed_events_m);
+    _exposed_events.insert(_exposed_events.end(), d.begin(), d.end());
+  }
+
+  int32_t retval = _acks_count;
+  _acks_count -= retval;
+  log_v2::lua()->debug(
+      "stream: {} events will be acknowledged at the end of the write_batch "
+      "function",
+      retval);
+  return retval;
+}
+
 /**
  *  Events have been transmitted to the Lua connector, several of them have
  *  been treated and can now be acknowledged by broker. This function returns
@@ -71,6 +71,8 @@ class stream : public io::stream {
   bool read(std::shared_ptr<io::data>& d, time_t deadline) override;
   void update() override;
   int write(std::shared_ptr<io::data> const& d) override;
+  int32_t write_batch(
+      const std::vector<std::shared_ptr<io::data>>& d) override;
   void statistics(nlohmann::json& tree) const override;
 };
 }  // namespace sql
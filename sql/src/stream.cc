@@ -163,6 +163,22 @@ int32_t stream::write(std::shared_ptr<io::data> const& data) {
   return ack;
 }
 
+/**
+ *  Write several events.
+ *
+ *  @param[in] d Events.
+ *
+ *  @return Number of events acknowledged.
+ */
+int32_t stream::write_batch(const std::vector<std::shared_ptr<io::data>>& d) {
+  _pending_events += d.size();
+
+  int32_t ack = storage::conflict_manager::instance().send_events(
+      storage::conflict_manager::sql, d);
+  _pending_events -= ack;
+  return ack;
+}
+
 /**
  *  Get endpoint statistics.
  *
@@ -355,6 +355,8 @@ class conflict_manager {
   nlohmann::json get_statistics();
 
   int32_t send_event(stream_type c, std::shared_ptr<io::data> const& e);
+  int32_t send_events(stream_type c,
+                      const std::vector<std::shared_ptr<io::data>>& events);
   int32_t get_acks(stream_type c);
   void update_metric_info_cache(uint64_t index_id,
                                 uint32_t metric_id,
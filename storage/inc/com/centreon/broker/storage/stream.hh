@@ -92,6 +92,8 @@ class stream : public io::stream {
   bool read(std::shared_ptr<io::data>& d, time_t deadline) override;
   void statistics(nlohmann::json& tree) const override;
   int32_t write(std::shared_ptr<io::data> const& d) override;
+  int32_t write_batch(
+      const std::vector<std::shared_ptr<io::data>>& d) override;
 };
 }  // namespace storage
 
@@ -675,6 +675,26 @@ int32_t conflict_manager::send_event(conflict_manager::stream_type c,
   return _fifo.push(c, e);
 }
 
+/**
+ *  Send several events to the conflict manager at once.
+ *
+ * @param c a stream_type.
+ * @param events The events to send.
+ *
+ * @return the number of events to ack.
+ */
+int32_t conflict_manager::send_events(
+    conflict_manager::stream_type c,
+    const std::vector<std::shared_ptr<io::data>>& events) {
+  if (_broken)
+    throw msg_fmt("conflict_manager: events loop interrupted");
+
+  log_v2::sql()->trace("conflict_manager: send_events {} events from {}",
+                       events.size(), c == 0 ? "sql" : "storage");
+
+  return _fifo.push(c, events);
+}
+
 /**
  *  This method is called from the stream and returns how many events should
  *  be released. By the way, it removes those objects from the queue.
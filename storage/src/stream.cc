@@ -163,6 +163,22 @@ int32_t stream::write(std::shared_ptr<io::data> const& data) {
   return ack;
 }
 
+/**
+ *  Write several events.
+ *
+ *  @param[in] d Events.
+ *
+ *  @return Number of events acknowledged.
+ */
+int32_t stream::write_batch(const std::vector<std::shared_ptr<io::data>>& d) {
+  _pending_events += d.size();
+
+  int32_t ack =
+      conflict_manager::instance().send_events(conflict_manager::storage, d);
+  _pending_events -= ack;
+  return ack;
+}
+
 /**************************************
  *                                     *
  *           Private Methods           *
@@ -23,6 +23,7 @@
 #include <list>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "com/centreon/broker/io/endpoint.hh"
 #include "com/centreon/broker/namespace.hh"
@@ -39,13 +40,23 @@ namespace tcp {
 class acceptor : public io::endpoint {
   const uint16_t _port;
   const int32_t _read_timeout;
+  /* Limits of the bytes waiting to be written by each stream, 0 for none. */
+  size_t _write_high_watermark;
+  size_t _write_low_watermark;
+
+  /* Number of SO_REUSEPORT listeners, 0 for a single classic listener. */
+  const size_t _shards;
 
   std::list<std::string> _children;
   std::mutex _childrenm;
   std::shared_ptr<asio::ip::tcp::acceptor> _acceptor;
+  /* Listeners of each shard, _acceptor is the first one. */
+  std::vector<std::shared_ptr<asio::ip::tcp::acceptor>> _shard_acceptors;
+  /* Connections accepted by each shard, protected by _childrenm. */
+  std::vector<uint64_t> _shard_accepted;
 
  public:
-  acceptor(uint16_t port, int32_t read_timeout);
+  acceptor(uint16_t port, int32_t read_timeout, size_t shards = 0);
   ~acceptor() noexcept;
 
   acceptor(const acceptor&) = delete;
@@ -54,6 +65,7 @@ class acceptor : public io::endpoint {
   void add_child(std::string const& child);
   void listen();
   std::unique_ptr<io::stream> open() override;
+  void set_write_watermarks(size_t high, size_t low);
   void remove_child(std::string const& child);
   void stats(nlohmann::json& tree) override;
   bool is_ready() const override;
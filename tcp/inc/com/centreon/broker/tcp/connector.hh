@@ -37,6 +37,9 @@ class connector : public io::endpoint {
   const std::string _host;
   const uint16_t _port;
   const int32_t _read_timeout;
+  /* Limits of the bytes waiting to be written by each stream, 0 for none. */
+  size_t _write_high_watermark;
+  size_t _write_low_watermark;
 
   /* How many consecutive calls to is_ready() */
   mutable int16_t _is_ready_count;
@@ -51,6 +54,7 @@ class connector : public io::endpoint {
   connector(const connector&) = delete;
 
   std::unique_ptr<io::stream> open() override;
+  void set_write_watermarks(size_t high, size_t low);
   bool is_ready() const override;
 };
 }  // namespace tcp
@@ -53,12 +53,18 @@ class stream : public io::stream {
   ~stream() noexcept;
   stream& operator=(const stream&) = delete;
   stream(const stream&) = delete;
+  int native_handle() override;
   std::string peer() const override final;
   bool read(std::shared_ptr<io::data>& d, time_t deadline) override;
+  bool set_read_waker(const std::shared_ptr<misc::waker>& waker) override;
   void set_parent(acceptor* parent);
+  void set_write_watermarks(size_t high, size_t low);
+  int shard() const override;
+  void statistics(nlohmann::json& tree) const override;
   int32_t flush() override;
   int32_t stop() override;
   int32_t write(std::shared_ptr<io::data> const& d) override;
+  bool write_ready() const override;
 };
 }  // namespace tcp
 
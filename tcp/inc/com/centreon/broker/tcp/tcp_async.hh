@@ -57,6 +57,12 @@ namespace tcp {
  * the negotiation fails. The connector throws away the connection but not the
  * acceptor because it does not know about this negotiation attempt).
  *
+ * Sharded acceptors open several listeners on the same port with
+ * SO_REUSEPORT, each one on its own pool shard. The kernel spreads the
+ * incoming connections over them and each connection runs on the shard of
+ * its listener. All these listeners store their connections under the same
+ * key, the first listener, so the broker gets them as from one acceptor.
+ *
  * Then each time an acceptor is started, a timer is started, it asynchronously
  * waits for 10s, and then looks if there are not used connections established
  * for more than 4s. In that case, it removes them.
@@ -89,13 +95,20 @@ class tcp_async {
   tcp_async(const tcp_async&) = delete;
   tcp_async& operator=(const tcp_async&) = delete;
   std::shared_ptr<asio::ip::tcp::acceptor> create_acceptor(uint16_t port);
-  void start_acceptor(std::shared_ptr<asio::ip::tcp::acceptor> acceptor);
+  std::shared_ptr<asio::ip::tcp::acceptor> create_shard_acceptor(
+      uint16_t port,
+      size_t shard);
+  void start_acceptor(std::shared_ptr<asio::ip::tcp::acceptor> acceptor,
+                      asio::ip::tcp::acceptor* key = nullptr,
+                      int shard = -1);
   void stop_acceptor(std::shared_ptr<asio::ip::tcp::acceptor> acceptor);
 
   std::shared_ptr<tcp_connection> create_connection(std::string const& address,
                                                     uint16_t port);
   void remove_acceptor(std::shared_ptr<asio::ip::tcp::acceptor> acceptor);
   void handle_accept(std::shared_ptr<asio::ip::tcp::acceptor> acceptor,
+                     asio::ip::tcp::acceptor* key,
+                     int shard,
                      tcp_connection::pointer new_connection,
                      const asio::error_code& error);
   tcp_connection::pointer get_connection(
@@ -19,9 +19,13 @@
 #define CENTREON_BROKER_TCP_CONNECTION_HH
 #include <asio.hpp>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
 #include <queue>
 
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/misc/waker.hh"
 #include "com/centreon/broker/namespace.hh"
 
 CCB_BEGIN()
@@ -29,7 +33,13 @@ CCB_BEGIN()
 namespace tcp {
 
 class tcp_connection : public std::enable_shared_from_this<tcp_connection> {
+  /* Size of the first read, then it adapts to the traffic between
+   * min_read_size and max_read_size. */
   constexpr static std::size_t async_buf_size = 16384;
+  constexpr static std::size_t min_read_size = 4096;
+  constexpr static std::size_t max_read_size = 262144;
+  /* Maximum bytes gathered in one async_write. */
+  constexpr static std::size_t max_gathered_bytes = 1048576;
   asio::ip::tcp::socket _socket;
   asio::io_context::strand _strand;
 
@@ -37,29 +47,53 @@ class tcp_connection : public std::enable_shared_from_this<tcp_connection> {
   asio::error_code _current_error;
 
   std::mutex _exposed_write_queue_m;
-  std::queue<std::vector<char>> _exposed_write_queue;
-  std::queue<std::vector<char>> _write_queue;
+  /* Buffers to write are shared with the streams above, they are not
+   * copied. */
+  std::deque<std::shared_ptr<io::raw>> _exposed_write_queue;
+  std::deque<std::shared_ptr<io::raw>> _write_queue;
   std::atomic_bool _write_queue_has_events;
   std::atomic_bool _writing;
+  /* Buffers of the front of _write_queue sent by the current async_write. */
+  std::vector<asio::const_buffer> _gathered;
+  std::atomic<uint64_t> _write_operations;
+  std::atomic<uint64_t> _written_buffers;
+  /* Bytes given to write() and not yet written on the socket. Above
+   * _write_high_watermark, write() waits for them to go under
+   * _write_low_watermark. 0 means no limit. */
+  std::atomic<size_t> _write_queue_bytes;
+  std::atomic<size_t> _write_high_watermark;
+  std::atomic<size_t> _write_low_watermark;
+  std::condition_variable _write_queue_cv;
+  std::atomic<uint64_t> _write_blocked;
 
   std::atomic<int32_t> _acks;
   std::atomic_bool _reading;
   std::atomic_bool _closing;
-  std::array<char, async_buf_size> _read_buffer;
+  /* Pooled buffer given to async_read_some, then moved to the read queue. */
+  std::vector<char> _read_buffer;
+  std::atomic<size_t> _read_size;
   std::queue<std::vector<char>> _exposed_read_queue;
   std::mutex _read_queue_m;
   std::condition_variable _read_queue_cv;
   std::queue<std::vector<char>> _read_queue;
+  std::shared_ptr<misc::waker> _read_waker;
 
   std::atomic_bool _closed;
   std::string _address;
   uint16_t _port;
+  /* The pool shard running this connection, -1 for the shared io_context. */
+  const int _shard;
+  bool _accepted;
+
+  void _gather_and_write();
+  void _wait_write_queue();
 
  public:
   typedef std::shared_ptr<tcp_connection> pointer;
   tcp_connection(asio::io_context& io_context,
                  const std::string& host = "",
-                 uint16_t port = 0);
+                 uint16_t port = 0,
+                 int shard = -1);
   ~tcp_connection() noexcept;
 
   pointer ptr();
@@ -69,20 +103,31 @@ class tcp_connection : public std::enable_shared_from_this<tcp_connection> {
   int32_t flush();
 
   void writing();
-  void handle_write(const asio::error_code& ec);
-  int32_t write(const std::vector<char>& v);
+  void handle_write(const asio::error_code& ec, size_t written_bytes);
+  int32_t write(std::shared_ptr<io::raw> buffer);
+  bool write_ready() const;
+  void set_write_watermarks(size_t high, size_t low);
+  size_t write_queue_bytes() const;
+  uint64_t write_blocked() const;
 
   void start_reading();
   void handle_read(const asio::error_code& ec, size_t read_bytes);
   std::vector<char> read(time_t timeout_time, bool* timeout);
+  void set_read_waker(const std::shared_ptr<misc::waker>& waker);
 
   void close();
+  int native_handle();
 
   bool is_closed() const;
   void update_peer(asio::error_code& ec);
   const std::string peer() const;
   const std::string& address() const;
   uint16_t port() const;
+  int shard() const { return _shard; }
+  void set_accepted();
+  uint64_t write_operations() const;
+  uint64_t written_buffers() const;
+  size_t read_size() const;
 };
 
 }  // namespace tcp
@@ -22,6 +22,7 @@
 #include <fmt/format.h>
 
 #include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/broker/pool.hh"
 #include "com/centreon/broker/tcp/stream.hh"
 #include "com/centreon/broker/tcp/tcp_async.hh"
 
@@ -32,18 +33,32 @@ using namespace com::centreon::broker::tcp;
  * @brief Acceptor constructor. It needs the port used to listen and a read
  * timeout duration given in seconds that can be -1 if no timeout is wanted.
  *
+ * If shards is not 0, the acceptor opens as many listeners on the port with
+ * SO_REUSEPORT, each one on its own shard of the pool, and each accepted
+ * connection runs on the shard of its listener.
+ *
  * @param port A port.
  * @param read_timeout A duration in seconds.
+ * @param shards The number of listeners, 0 for a single listener on the
+ * shared pool.
  */
-acceptor::acceptor(uint16_t port, int32_t read_timeout)
-    : io::endpoint(true), _port(port), _read_timeout(read_timeout) {}
+acceptor::acceptor(uint16_t port, int32_t read_timeout, size_t shards)
+    : io::endpoint(true),
+      _port(port),
+      _read_timeout(read_timeout),
+      _write_high_watermark(0),
+      _write_low_watermark(0),
+      _shards(shards) {}
 
 /**
  *  Destructor.
  */
 acceptor::~acceptor() noexcept {
   log_v2::tcp()->trace("acceptor destroyed");
-  if (_acceptor) {
+  if (!_shard_acceptors.empty()) {
+    for (auto& a : _shard_acceptors)
+      tcp_async::instance().stop_acceptor(a);
+  } else if (_acceptor) {
     tcp_async::instance().stop_acceptor(_acceptor);
   }
 }
@@ -64,8 +79,27 @@ void acceptor::add_child(std::string const& child) {
  */
 std::unique_ptr<io::stream> acceptor::open() {
   if (!_acceptor) {
-    _acceptor = tcp_async::instance().create_acceptor(_port);
-    tcp_async::instance().start_acceptor(_acceptor);
+    if (_shards) {
+      pool::instance().start_shards(_shards);
+      std::vector<std::shared_ptr<asio::ip::tcp::acceptor>> acceptors;
+      for (size_t i = 0; i < _shards; ++i)
+        acceptors.emplace_back(
+            tcp_async::instance().create_shard_acceptor(_port, i));
+      {
+        std::lock_guard<std::mutex> lock(_childrenm);
+        _shard_acceptors = std::move(acceptors);
+        _shard_accepted.assign(_shards, 0);
+      }
+      _acceptor = _shard_acceptors.front();
+      for (size_t i = 0; i < _shards; ++i)
+        tcp_async::instance().start_acceptor(_shard_acceptors[i],
+                                             _acceptor.get(), i);
+      log_v2::tcp()->info("TCP: {} sharded listeners on port {}", _shards,
+                          _port);
+    } else {
+      _acceptor = tcp_async::instance().create_acceptor(_port);
+      tcp_async::instance().start_acceptor(_acceptor);
+    }
   }
 
   /* Timeout in seconds during get_connection */
@@ -75,11 +109,28 @@ std::unique_ptr<io::stream> acceptor::open() {
     assert(conn->port());
     log_v2::tcp()->debug("acceptor gets a new connection from {}",
                          conn->peer());
-    return std::make_unique<stream>(conn, -1);
+    if (conn->shard() >= 0) {
+      std::lock_guard<std::mutex> lock(_childrenm);
+      ++_shard_accepted[conn->shard()];
+    }
+    auto retval = std::make_unique<stream>(conn, -1);
+    retval->set_write_watermarks(_write_high_watermark, _write_low_watermark);
+    return retval;
   }
   return nullptr;
 }
 
+/**
+ *  Set the write watermarks of the streams opened from now.
+ *
+ *  @param[in] high  High watermark in bytes, 0 for no limit.
+ *  @param[in] low   Low watermark in bytes, 0 for high / 2.
+ */
+void acceptor::set_write_watermarks(size_t high, size_t low) {
+  _write_high_watermark = high;
+  _write_low_watermark = low;
+}
+
 bool acceptor::is_ready() const {
   return tcp_async::instance().contains_available_acceptor_connections(
       _acceptor.get());
@@ -104,4 +155,13 @@ void acceptor::stats(nlohmann::json& tree) {
   std::lock_guard<std::mutex> children_lock(_childrenm);
   tree["peers"] =
       fmt::format("{}: {}", _children.size(), fmt::join(_children, ", "));
+  if (!_shard_acceptors.empty()) {
+    tree["shards"] = static_cast<double>(_shard_acceptors.size());
+    for (size_t i = 0; i < _shard_acceptors.size(); ++i) {
+      tree[fmt::format("shard_{}_accepted", i)] =
+          static_cast<double>(_shard_accepted[i]);
+      tree[fmt::format("shard_{}_connections", i)] =
+          pool::instance().get_shard_connections(i);
+    }
+  }
 }
@@ -46,6 +46,8 @@ connector::connector(const std::string& host,
       _host(host),
       _port(port),
       _read_timeout(read_timeout),
+      _write_high_watermark(0),
+      _write_low_watermark(0),
       _is_ready_count(0),
       _is_ready_now(0) {}
 
@@ -65,6 +67,7 @@ std::unique_ptr<io::stream> connector::open() {
   try {
     std::unique_ptr<stream> retval =
         std::make_unique<stream>(_host, _port, _read_timeout);
+    retval->set_write_watermarks(_write_high_watermark, _write_low_watermark);
     _is_ready_count = 0;
     return retval;
   } catch (const std::exception& e) {
@@ -77,6 +80,17 @@ std::unique_ptr<io::stream> connector::open() {
   }
 }
 
+/**
+ * @brief Set the write watermarks of the streams opened from now.
+ *
+ * @param high High watermark in bytes, 0 for no limit.
+ * @param low Low watermark in bytes, 0 for high / 2.
+ */
+void connector::set_write_watermarks(size_t high, size_t low) {
+  _write_high_watermark = high;
+  _write_low_watermark = low;
+}
+
 /**
  * @brief Return true when it is time to attempt a new connection. The idea is
  * to increase the duration between two calls each time this function is called
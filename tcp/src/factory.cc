@@ -19,8 +19,12 @@
 
 #include "com/centreon/broker/tcp/factory.hh"
 
+#include <strings.h>
+
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include "com/centreon/broker/config/parser.hh"
 #include "com/centreon/broker/log_v2.hh"
@@ -110,11 +114,40 @@ io::endpoint* factory::new_endpoint(
       read_timeout = std::stoul(it->second);
   }
 
+  // Sharded acceptor: one listener per shard, "auto" for one per cpu.
+  size_t shards(0);
+  {
+    std::map<std::string, std::string>::const_iterator it{
+        cfg.params.find("accept_shards")};
+    if (it != cfg.params.end()) {
+      if (strcasecmp(it->second.c_str(), "auto") == 0)
+        shards = std::max(std::thread::hardware_concurrency(), 1u);
+      else
+        shards = std::stoul(it->second);
+    }
+  }
+
+  // Bytes waiting to be written above which writes block, and under which
+  // they are released.
+  size_t write_high_watermark(0);
+  size_t write_low_watermark(0);
+  {
+    std::map<std::string, std::string>::const_iterator it{
+        cfg.params.find("write_queue_high_watermark")};
+    if (it != cfg.params.end())
+      write_high_watermark = std::stoul(it->second);
+    it = cfg.params.find("write_queue_low_watermark");
+    if (it != cfg.params.end())
+      write_low_watermark = std::stoul(it->second);
+  }
+
   // Acceptor.
   std::unique_ptr<io::endpoint> endp;
   if (host.empty()) {
     is_acceptor = true;
-    std::unique_ptr<tcp::acceptor> a(new tcp::acceptor(port, read_timeout));
+    std::unique_ptr<tcp::acceptor> a(
+        new tcp::acceptor(port, read_timeout, shards));
+    a->set_write_watermarks(write_high_watermark, write_low_watermark);
     endp.reset(a.release());
   }
   // Connector.
@@ -122,6 +155,7 @@ io::endpoint* factory::new_endpoint(
     is_acceptor = false;
     std::unique_ptr<tcp::connector> c(
         new tcp::connector(host, port, read_timeout));
+    c->set_write_watermarks(write_high_watermark, write_low_watermark);
     endp.reset(c.release());
   }
 
@@ -31,6 +31,7 @@
 
 #include "com/centreon/broker/io/raw.hh"
 #include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/broker/misc/buffer_pool.hh"
 #include "com/centreon/broker/pool.hh"
 #include "com/centreon/broker/tcp/acceptor.hh"
 #include "com/centreon/broker/tcp/tcp_async.hh"
@@ -105,6 +106,15 @@ stream::~stream() noexcept {
     _parent->remove_child(peer());
 }
 
+/**
+ *  Get the socket of the connection, once the data written are sent.
+ *
+ *  @return The socket file descriptor, -1 if the connection is closed.
+ */
+int stream::native_handle() {
+  return _connection->native_handle();
+}
+
 /**
  *  Get peer name.
  *
@@ -140,12 +150,27 @@ bool stream::read(std::shared_ptr<io::data>& d, time_t deadline) {
   }
 
   bool timeout = false;
-  d.reset(new io::raw(_connection->read(deadline, &timeout)));
+  // The received buffer goes back to the pool once consumed.
+  d = misc::buffer_pool::instance().make_raw(
+      _connection->read(deadline, &timeout));
   std::shared_ptr<io::raw> data{std::static_pointer_cast<io::raw>(d)};
   log_v2::tcp()->trace("TCP Read done : {} bytes", data->get_buffer().size());
   return !timeout;
 }
 
+/**
+ *  Give the waker to the connection, it is notified each time data is
+ *  received.
+ *
+ *  @param[in] waker  The waker to notify.
+ *
+ *  @return true.
+ */
+bool stream::set_read_waker(const std::shared_ptr<misc::waker>& waker) {
+  _connection->set_read_waker(waker);
+  return true;
+}
+
 /**
  *  Set parent socket.
  *
@@ -155,6 +180,44 @@ void stream::set_parent(acceptor* parent) {
   _parent = parent;
 }
 
+/**
+ *  Limit the bytes waiting to be written to the socket. Above the high
+ *  watermark, write() blocks until they go under the low watermark, except
+ *  on the threads of the io_context, where write_ready() must be checked.
+ *
+ *  @param[in] high  High watermark in bytes, 0 for no limit.
+ *  @param[in] low   Low watermark in bytes, 0 for high / 2.
+ */
+void stream::set_write_watermarks(size_t high, size_t low) {
+  _connection->set_write_watermarks(high, low);
+}
+
+/**
+ *  Get the pool shard running the connection.
+ *
+ *  @return A shard index, -1 if the connection runs on the shared pool.
+ */
+int stream::shard() const {
+  return _connection->shard();
+}
+
+/**
+ *  Get statistics.
+ *
+ *  @param[out] tree  Output tree.
+ */
+void stream::statistics(nlohmann::json& tree) const {
+  tree["tcp_write_operations"] = static_cast<double>(
+      _connection->write_operations());
+  tree["tcp_written_buffers"] = static_cast<double>(
+      _connection->written_buffers());
+  tree["tcp_read_size"] = static_cast<double>(_connection->read_size());
+  tree["tcp_write_queue_bytes"] =
+      static_cast<double>(_connection->write_queue_bytes());
+  tree["tcp_write_blocked"] = static_cast<double>(_connection->write_blocked());
+  misc::buffer_pool::instance().statistics(tree);
+}
+
 int32_t stream::flush() {
   return _connection->flush();
 }
@@ -191,7 +254,7 @@ int32_t stream::write(std::shared_ptr<io::data> const& d) {
     log_v2::tcp()->trace("write {} bytes", r->size());
     std::error_code err;
     try {
-      return _connection->write(r->get_buffer());
+      return _connection->write(r);
     } catch (std::exception const& e) {
       log_v2::tcp()->error("Socket gone");
       throw;
@@ -199,3 +262,12 @@ int32_t stream::write(std::shared_ptr<io::data> const& d) {
   }
   return 1;
 }
+
+/**
+ *  Tell if a write would not exceed the high watermark of the connection.
+ *
+ *  @return true if the write would be accepted without waiting.
+ */
+bool stream::write_ready() const {
+  return _connection->write_ready();
+}
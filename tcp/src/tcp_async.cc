@@ -167,6 +167,31 @@ std::shared_ptr<asio::ip::tcp::acceptor> tcp_async::create_acceptor(
   return retval;
 }
 
+/**
+ * @brief Create an ASIO acceptor listening on the given port with
+ * SO_REUSEPORT, run by a shard of the pool. Several of them can listen on
+ * the same port, the kernel balancing the connections between them.
+ *
+ * @param port The port to listen on.
+ * @param shard The index of the pool shard.
+ *
+ * @return The created acceptor as a shared_ptr.
+ */
+std::shared_ptr<asio::ip::tcp::acceptor> tcp_async::create_shard_acceptor(
+    uint16_t port,
+    size_t shard) {
+  asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port);
+  auto retval(std::make_shared<asio::ip::tcp::acceptor>(
+      pool::instance().shard_context(shard)));
+  retval->open(endpoint.protocol());
+  retval->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+  retval->set_option(
+      asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+  retval->bind(endpoint);
+  retval->listen();
+  return retval;
+}
+
 /**
  * @brief this function works
  *
@@ -204,9 +229,15 @@ void tcp_async::_clear_available_con(asio::error_code ec) {
  * not used connections will be erased.
  *
  * @param acceptor The acceptor that you want it to accept.
+ * @param key The acceptor under which connections are stored, acceptor
+ * itself if nullptr.
+ * @param shard The pool shard running the acceptor and its connections, -1
+ * for the shared io_context.
  */
 void tcp_async::start_acceptor(
-    std::shared_ptr<asio::ip::tcp::acceptor> acceptor) {
+    std::shared_ptr<asio::ip::tcp::acceptor> acceptor,
+    asio::ip::tcp::acceptor* key,
+    int shard) {
   log_v2::tcp()->trace("Start acceptor");
   if (!_timer)
     _timer =
@@ -220,13 +251,17 @@ void tcp_async::start_acceptor(
   _timer->async_wait(
       std::bind(&tcp_async::_clear_available_con, this, std::placeholders::_1));
 
-  tcp_connection::pointer new_connection =
-      std::make_shared<tcp_connection>(pool::io_context());
+  if (!key)
+    key = acceptor.get();
+  tcp_connection::pointer new_connection = std::make_shared<tcp_connection>(
+      shard < 0 ? pool::io_context() : pool::instance().shard_context(shard),
+      "", 0, shard);
 
   log_v2::tcp()->debug("Waiting for a connection");
-  acceptor->async_accept(new_connection->socket(),
-                         std::bind(&tcp_async::handle_accept, this, acceptor,
-                                   new_connection, std::placeholders::_1));
+  acceptor->async_accept(
+      new_connection->socket(),
+      std::bind(&tcp_async::handle_accept, this, acceptor, key, shard,
+                new_connection, std::placeholders::_1));
 }
 
 /**
@@ -249,10 +284,14 @@ void tcp_async::stop_acceptor(
  * @brief The handler called after an async_accept.
  *
  * @param acceptor The acceptor accepting a connection.
+ * @param key The acceptor under which the connection is stored.
+ * @param shard The pool shard running the acceptor.
  * @param new_connection The established connection.
  * @param ec An error code if any.
  */
 void tcp_async::handle_accept(std::shared_ptr<asio::ip::tcp::acceptor> acceptor,
+                              asio::ip::tcp::acceptor* key,
+                              int shard,
                               tcp_connection::pointer new_connection,
                               const asio::error_code& ec) {
   /* If we got a connection, we store it */
@@ -268,11 +307,12 @@ void tcp_async::handle_accept(std::shared_ptr<asio::ip::tcp::acceptor> acceptor,
       asio::ip::tcp::socket& sock = new_connection->socket();
       asio::socket_base::keep_alive option{true};
       sock.set_option(option);
-      _strand.post([new_connection, now, acceptor, this] {
-        _acceptor_available_con.insert(std::make_pair(
-            acceptor.get(), std::make_pair(new_connection, now)));
+      new_connection->set_accepted();
+      _strand.post([new_connection, now, key, this] {
+        _acceptor_available_con.insert(
+            std::make_pair(key, std::make_pair(new_connection, now)));
       });
-      start_acceptor(acceptor);
+      start_acceptor(acceptor, key, shard);
     }
   } else
     log_v2::tcp()->info("TCP acceptor interrupted: {}", ec.message());
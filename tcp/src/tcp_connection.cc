@@ -20,6 +20,8 @@
 #include <functional>
 
 #include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/broker/misc/buffer_pool.hh"
+#include "com/centreon/broker/pool.hh"
 #include "com/centreon/exceptions/msg_fmt.hh"
 
 using namespace com::centreon::exceptions;
@@ -34,20 +36,32 @@ using namespace com::centreon::broker::tcp;
  *        established yet.
  * @param port The port on the peer side. If 0, the connection is on an acceptor
  *        side and no connection has been established yet.
+ * @param shard The pool shard owning io_context, -1 if it is the shared
+ *        io_context of the pool.
  */
 tcp_connection::tcp_connection(asio::io_context& io_context,
                                const std::string& host,
-                               uint16_t port)
+                               uint16_t port,
+                               int shard)
     : _socket(io_context),
       _strand(io_context),
       _write_queue_has_events(false),
       _writing(false),
+      _write_operations{0},
+      _written_buffers{0},
+      _write_queue_bytes{0},
+      _write_high_watermark{0},
+      _write_low_watermark{0},
+      _write_blocked{0},
       _acks{0},
       _reading(false),
       _closing(false),
+      _read_size{async_buf_size},
       _closed(false),
       _address(host),
-      _port(port) {}
+      _port(port),
+      _shard(shard),
+      _accepted(false) {}
 
 /**
  * @brief Destructor
@@ -55,6 +69,8 @@ tcp_connection::tcp_connection(asio::io_context& io_context,
 tcp_connection::~tcp_connection() noexcept {
   log_v2::tcp()->trace("Connection to {}:{} destroyed.", _address, _port);
   close();
+  if (_accepted && _shard >= 0)
+    pool::instance().add_shard_connections(_shard, -1);
 }
 
 /**
@@ -163,12 +179,17 @@ static std::string debug_buf(const char* data, int32_t size) {
  * The return value is the current value of the _ack counter, which is also
  * updated.
  *
- * @param v A vector of char.
+ * If a high watermark is set and the bytes waiting to be written exceed it,
+ * this function blocks until they go under the low watermark, so that the
+ * caller stops pulling events and lets its muxer retain them.
+ *
+ * @param buffer The data to write. It is shared, not copied, so it must not be
+ * modified after this call.
  *
  * @return The ack counter, the number of events to acknowledge on the broker
  * side.
  */
-int32_t tcp_connection::write(const std::vector<char>& v) {
+int32_t tcp_connection::write(std::shared_ptr<io::raw> buffer) {
   {
     std::lock_guard<std::mutex> lck(_error_m);
     if (_current_error) {
@@ -180,7 +201,8 @@ int32_t tcp_connection::write(const std::vector<char>& v) {
 
   {
     std::lock_guard<std::mutex> lck(_exposed_write_queue_m);
-    _exposed_write_queue.push(v);
+    _write_queue_bytes += buffer->size();
+    _exposed_write_queue.push_back(std::move(buffer));
   }
 
   // If the queue is not empty and the writing work is not started, we start
@@ -191,6 +213,10 @@ int32_t tcp_connection::write(const std::vector<char>& v) {
     _strand.context().post(std::bind(&tcp_connection::writing, ptr()));
   }
 
+  size_t high = _write_high_watermark;
+  if (high && _write_queue_bytes > high)
+    _wait_write_queue();
+
   int32_t retval = _acks;
   /* Do not set it to zero directly, maybe it has already been incremented by
    * another operation */
@@ -199,6 +225,72 @@ int32_t tcp_connection::write(const std::vector<char>& v) {
   return retval;
 }
 
+/**
+ * @brief Block until the bytes waiting to be written go under the low
+ * watermark, the connection is closed or its io_context is stopped.
+ *
+ * On a thread of the io_context running this connection (a feeder slice for
+ * example), the writes could not complete while we wait, so there is no
+ * wait: the buffer is kept since a part of a byte stream cannot be dropped,
+ * but write_ready() returns false until the queue drains and such callers
+ * must check it before writing. The queue then exceeds the high watermark by
+ * at most one write.
+ */
+void tcp_connection::_wait_write_queue() {
+  ++_write_blocked;
+  if (_strand.context().get_executor().running_in_this_thread()) {
+    log_v2::tcp()->debug(
+        "{} bytes waiting to be written to {}:{}, write not accepted from an "
+        "io_context thread until they go under {} bytes",
+        _write_queue_bytes.load(), _address, _port,
+        _write_low_watermark.load());
+    return;
+  }
+
+  log_v2::tcp()->debug(
+      "{} bytes waiting to be written to {}:{}, write blocked until they go "
+      "under {} bytes",
+      _write_queue_bytes.load(), _address, _port, _write_low_watermark.load());
+  std::unique_lock<std::mutex> lck(_exposed_write_queue_m);
+  while (!_write_queue_cv.wait_for(lck, std::chrono::seconds(1), [this] {
+    return !_write_high_watermark ||
+           _write_queue_bytes <= _write_low_watermark || _closed ||
+           _strand.context().stopped();
+  }))
+    log_v2::tcp()->warn(
+        "{}:{} does not read fast enough, {} bytes are waiting to be written",
+        _address, _port, _write_queue_bytes.load());
+}
+
+/**
+ * @brief Tell if a write would not exceed the high watermark. Writers running
+ * on the io_context of the connection cannot wait in write(), they check this
+ * first and come back when the read waker is notified.
+ *
+ * @return true if the queue is under the high watermark or if there is no
+ * limit.
+ */
+bool tcp_connection::write_ready() const {
+  size_t high = _write_high_watermark;
+  return !high || _write_queue_bytes <= high || _closed;
+}
+
+/**
+ * @brief Set the limits of the bytes waiting to be written.
+ *
+ * @param high Above this number of bytes, write() blocks. 0 for no limit.
+ * @param low write() is released when the bytes go under this value. If it is
+ * 0 or not lower than high, high / 2 is used.
+ */
+void tcp_connection::set_write_watermarks(size_t high, size_t low) {
+  if (low == 0 || low >= high)
+    low = high / 2;
+  std::lock_guard<std::mutex> lck(_exposed_write_queue_m);
+  _write_low_watermark = low;
+  _write_high_watermark = high;
+  _write_queue_cv.notify_all();
+}
+
 /**
  * @brief Execute the real writing on the socket. Infact, this function:
  *  * checks if the _write_queue is empty, and then exchanges its content with
@@ -213,15 +305,37 @@ void tcp_connection::writing() {
     std::lock_guard<std::mutex> lck(_exposed_write_queue_m);
     std::swap(_write_queue, _exposed_write_queue);
     _write_queue_has_events = !_write_queue.empty();
-  }
-  if (!_write_queue_has_events) {
-    _writing = false;
-    return;
+    if (!_write_queue_has_events) {
+      _writing = false;
+      // native_handle() waits for all the data to be written.
+      _write_queue_cv.notify_all();
+      return;
+    }
   }
 
-  asio::async_write(_socket, asio::buffer(_write_queue.front()),
+  _gather_and_write();
+}
+
+/**
+ * @brief Launch one async_write of the buffers at the front of _write_queue,
+ * up to max_gathered_bytes (at least one buffer). The socket gets them with
+ * scatter/gather writes, so a burst of small packets costs a few system
+ * calls and one handler instead of one of each per packet.
+ */
+void tcp_connection::_gather_and_write() {
+  _gathered.clear();
+  size_t bytes = 0;
+  for (auto& b : _write_queue) {
+    if (!_gathered.empty() && bytes + b->size() > max_gathered_bytes)
+      break;
+    _gathered.emplace_back(asio::buffer(b->get_buffer()));
+    bytes += b->size();
+  }
+  ++_write_operations;
+  asio::async_write(_socket, _gathered,
                     _strand.wrap(std::bind(&tcp_connection::handle_write, ptr(),
-                                           std::placeholders::_1)));
+                                           std::placeholders::_1,
+                                           std::placeholders::_2)));
 }
 
 /**
@@ -229,24 +343,41 @@ void tcp_connection::writing() {
  * vectors to write, this handler continues to call async_write.
  *
  * @param ec
+ * @param written_bytes Bytes written by the async_write.
  */
-void tcp_connection::handle_write(const asio::error_code& ec) {
+void tcp_connection::handle_write(const asio::error_code& ec,
+                                  size_t written_bytes) {
   if (ec) {
     log_v2::tcp()->error("Error while writing on tcp socket: {}", ec.message());
-    std::lock_guard<std::mutex> lck(_error_m);
-    _current_error = ec;
-    _writing = false;
-    _closed = true;
+    {
+      std::lock_guard<std::mutex> lck(_error_m);
+      _current_error = ec;
+      _writing = false;
+      _closed = true;
+    }
+    std::lock_guard<std::mutex> lck(_exposed_write_queue_m);
+    _write_queue_cv.notify_all();
   } else {
-    ++_acks;
-    _write_queue.pop();
+    size_t count = _gathered.size();
+    _acks += count;
+    _written_buffers += count;
+    _write_queue.erase(_write_queue.begin(), _write_queue.begin() + count);
+    size_t low = _write_low_watermark;
+    size_t before = _write_queue_bytes.fetch_sub(written_bytes);
+    if (before > low && before - written_bytes <= low) {
+      {
+        std::lock_guard<std::mutex> lck(_exposed_write_queue_m);
+        _write_queue_cv.notify_all();
+      }
+      std::lock_guard<std::mutex> lck(_read_queue_m);
+      if (_read_waker)
+        _read_waker->notify();
+    }
     _write_queue_has_events = !_write_queue.empty();
-    if (_write_queue_has_events) {
+    if (_write_queue_has_events)
       // The strand is useful because of the flush() method.
-      asio::async_write(_socket, asio::buffer(_write_queue.front()),
-                        _strand.wrap(std::bind(&tcp_connection::handle_write,
-                                               ptr(), std::placeholders::_1)));
-    } else
+      _gather_and_write();
+    else
       writing();
   }
 }
@@ -263,6 +394,9 @@ void tcp_connection::start_reading() {
   if (!_reading) {
     _reading = true;
   }
+  if (_read_buffer.capacity())
+    misc::buffer_pool::instance().release(std::move(_read_buffer));
+  _read_buffer = misc::buffer_pool::instance().get(_read_size);
   _socket.async_read_some(
       asio::buffer(_read_buffer),
       _strand.wrap(std::bind(&tcp_connection::handle_read, ptr(),
@@ -274,20 +408,128 @@ void tcp_connection::handle_read(const asio::error_code& ec,
   log_v2::tcp()->trace("Incoming data: {} bytes: {}", read_bytes,
                        debug_buf(&_read_buffer[0], read_bytes));
   if (read_bytes > 0) {
+    /* Full reads mean more data are waiting in the socket, so the next read
+     * is bigger. Small reads give back memory. */
+    size_t size = _read_size;
+    if (read_bytes == _read_buffer.size() && size < max_read_size)
+      _read_size = size * 2;
+    else if (read_bytes < size / 4 && size > min_read_size)
+      _read_size = size / 2;
+
+    _read_buffer.resize(read_bytes);
     std::lock_guard<std::mutex> lock(_read_queue_m);
-    _read_queue.emplace(_read_buffer.begin(),
-                        _read_buffer.begin() + read_bytes);
+    _read_queue.emplace(std::move(_read_buffer));
     _read_queue_cv.notify_one();
+    if (_read_waker)
+      _read_waker->notify();
   }
   if (ec) {
     log_v2::tcp()->error("Error while reading on socket: {}", ec.message());
     std::lock_guard<std::mutex> lck(_read_queue_m);
     _closing = true;
     _read_queue_cv.notify_one();
+    if (_read_waker)
+      _read_waker->notify();
   } else
     start_reading();
 }
 
+/**
+ * @brief Set the waker notified each time data is received, when the
+ * connection is closed by the peer, or when the bytes waiting to be written
+ * go under the low watermark.
+ *
+ * @param waker The waker to notify, nullptr to stop notifications.
+ */
+void tcp_connection::set_read_waker(const std::shared_ptr<misc::waker>& waker) {
+  std::lock_guard<std::mutex> lck(_read_queue_m);
+  _read_waker = waker;
+}
+
+/**
+ * @brief Number of async_write launched on the socket since the connection
+ * creation.
+ *
+ * @return A number of operations.
+ */
+uint64_t tcp_connection::write_operations() const {
+  return _write_operations;
+}
+
+/**
+ * @brief Number of buffers written on the socket since the connection
+ * creation.
+ *
+ * @return A number of buffers.
+ */
+uint64_t tcp_connection::written_buffers() const {
+  return _written_buffers;
+}
+
+/**
+ * @brief Bytes given to write() and not yet written on the socket.
+ *
+ * @return A number of bytes.
+ */
+size_t tcp_connection::write_queue_bytes() const {
+  return _write_queue_bytes;
+}
+
+/**
+ * @brief Number of times write() waited for the queue to drain because the
+ * high watermark was exceeded.
+ *
+ * @return A number of waits.
+ */
+uint64_t tcp_connection::write_blocked() const {
+  return _write_blocked;
+}
+
+/**
+ * @brief Mark the connection as accepted, from then it is counted in the
+ * connections of its shard.
+ */
+void tcp_connection::set_accepted() {
+  _accepted = true;
+  if (_shard >= 0)
+    pool::instance().add_shard_connections(_shard, 1);
+}
+
+/**
+ * @brief Size of the next read on the socket.
+ *
+ * @return A size in bytes.
+ */
+size_t tcp_connection::read_size() const {
+  return _read_size;
+}
+
+/**
+ * @brief Get the socket file descriptor once all the data queued are
+ * written, so that the caller can configure it.
+ *
+ * The writes could not complete while we wait on a thread of the io_context
+ * running this connection, so there -1 is returned if data are queued.
+ *
+ * @return The file descriptor or -1 if the connection is closed.
+ */
+int tcp_connection::native_handle() {
+  std::unique_lock<std::mutex> lck(_exposed_write_queue_m);
+  /* write() starts the writing work whenever it queues data, and writing()
+   * clears _writing once both queues are empty. */
+  auto written = [this] {
+    return _closed || (!_writing && _exposed_write_queue.empty());
+  };
+  if (!written() && _strand.context().get_executor().running_in_this_thread())
+    return -1;
+  while (!_write_queue_cv.wait_for(lck, std::chrono::seconds(1), written))
+    if (_strand.context().stopped())
+      return -1;
+  if (_closed || !_socket.is_open())
+    return -1;
+  return _socket.native_handle();
+}
+
 /**
  * @brief Shutdown the socket. If there are data to write, they are written
  * before the socket to be closed.
@@ -306,6 +548,10 @@ void tcp_connection::close() {
       std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
     _closed = true;
+    {
+      std::lock_guard<std::mutex> lck(_exposed_write_queue_m);
+      _write_queue_cv.notify_all();
+    }
     std::error_code ec;
     _socket.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
     log_v2::tcp()->trace("socket shutdown with message: {}", ec.message());
@@ -1086,3 +1086,53 @@ TEST_F(TcpAcceptor, MultipleBigSend) {
 
   t.join();
 }
+
+// Given an acceptor with four SO_REUSEPORT listeners
+// When many connectors connect to it
+// Then each connection runs on a shard
+// And the statistics give the connections of each shard.
+TEST_F(TcpAcceptor, Sharded) {
+  constexpr uint32_t shards = 4;
+  constexpr uint32_t clients = 32;
+  tcp::acceptor acc(4150, -1, shards);
+  /* The listeners are created by the first open(). */
+  ASSERT_FALSE(acc.open());
+
+  std::vector<std::unique_ptr<io::stream>> connectors;
+  for (uint32_t i = 0; i < clients; ++i) {
+    tcp::connector con(test_addr, 4150, -1);
+    connectors.emplace_back(con.open());
+    auto data = std::make_shared<io::raw>();
+    data->append(std::string("PING"));
+    connectors.back()->write(data);
+  }
+
+  std::vector<std::unique_ptr<io::stream>> accepted;
+  while (accepted.size() < clients) {
+    std::unique_ptr<io::stream> s{acc.open()};
+    if (s) {
+      ASSERT_GE(s->shard(), 0);
+      ASSERT_LT(s->shard(), static_cast<int>(shards));
+      std::shared_ptr<io::data> d;
+      while (!d)
+        s->read(d, time(nullptr) + 5);
+      ASSERT_EQ(std::static_pointer_cast<io::raw>(d)->size(), 4u);
+      accepted.emplace_back(std::move(s));
+    }
+  }
+
+  nlohmann::json tree;
+  acc.stats(tree);
+  ASSERT_EQ(tree["shards"].get<uint32_t>(), shards);
+  uint32_t total = 0;
+  uint32_t used_shards = 0;
+  for (uint32_t i = 0; i < shards; ++i) {
+    uint32_t n = tree[fmt::format("shard_{}_accepted", i)].get<uint32_t>();
+    ASSERT_EQ(tree[fmt::format("shard_{}_connections", i)].get<uint32_t>(), n);
+    total += n;
+    if (n)
+      ++used_shards;
+  }
+  ASSERT_EQ(total, clients);
+  ASSERT_GT(used_shards, 1u);
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2011 - 2019 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include "com/centreon/broker/tcp/tcp_connection.hh"
+
+#include <gtest/gtest.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/pool.hh"
+#include "com/centreon/broker/tcp/acceptor.hh"
+#include "com/centreon/broker/tcp/connector.hh"
+#include "com/centreon/broker/tcp/tcp_async.hh"
+
+using namespace com::centreon::broker;
+
+constexpr static uint16_t test_port(4146);
+constexpr static size_t bursts = 400;
+constexpr static size_t burst_size = 500;
+constexpr static size_t packet_size = 100;
+constexpr static size_t total = bursts * burst_size * packet_size;
+
+class TcpConnection : public ::testing::Test {
+ public:
+  void SetUp() override {
+    pool::load(0);
+    tcp::tcp_async::load();
+  }
+
+  void TearDown() override {
+    tcp::tcp_async::instance().stop_timer();
+    tcp::tcp_async::unload();
+    pool::unload();
+  }
+};
+
+// Given a connection on the loopback
+// When bursts of small packets are written
+// Then they are all received in order
+// And they are sent with much fewer write operations than packets.
+TEST_F(TcpConnection, GatherWrites) {
+  std::thread reader([] {
+    tcp::acceptor acc(test_port, -1);
+    std::unique_ptr<io::stream> s;
+    while (!s)
+      s = acc.open();
+    size_t received = 0;
+    uint8_t expected = 0;
+    std::shared_ptr<io::data> d;
+    while (received < total) {
+      ASSERT_NO_THROW(s->read(d, time(nullptr) + 10));
+      if (!d)
+        continue;
+      for (char c : std::static_pointer_cast<io::raw>(d)->get_buffer()) {
+        ASSERT_EQ(static_cast<uint8_t>(c), expected);
+        ++expected;
+      }
+      received += std::static_pointer_cast<io::raw>(d)->size();
+    }
+    ASSERT_EQ(received, total);
+  });
+
+  tcp::connector con("localhost", test_port, -1);
+  std::unique_ptr<io::stream> s;
+  while (!s) {
+    try {
+      s = con.open();
+    } catch (const std::exception&) {
+    }
+  }
+
+  uint8_t c = 0;
+  for (size_t i = 0; i < bursts; ++i)
+    for (size_t j = 0; j < burst_size; ++j) {
+      auto packet = std::make_shared<io::raw>();
+      packet->resize(packet_size);
+      for (char& b : packet->get_buffer())
+        b = c++;
+      s->write(packet);
+    }
+  reader.join();
+
+  nlohmann::json tree;
+  for (int i = 0; i < 100; ++i) {
+    tree.clear();
+    s->statistics(tree);
+    if (tree["tcp_written_buffers"].get<size_t>() == bursts * burst_size)
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  size_t buffers = tree["tcp_written_buffers"].get<size_t>();
+  size_t operations = tree["tcp_write_operations"].get<size_t>();
+  ASSERT_EQ(buffers, bursts * burst_size);
+  ASSERT_LT(operations * 4, buffers);
+}
+
+// Given a connection on the loopback
+// When big packets are sent
+// Then the reader increases its read size
+// And its buffers come from the pool once consumed.
+TEST_F(TcpConnection, AdaptiveReadSize) {
+  constexpr size_t big_packet_size = 1048576;
+  constexpr size_t big_packets = 64;
+
+  std::thread writer([] {
+    tcp::connector con("localhost", test_port + 1, -1);
+    std::unique_ptr<io::stream> s;
+    while (!s) {
+      try {
+        s = con.open();
+      } catch (const std::exception&) {
+      }
+    }
+    auto packet = std::make_shared<io::raw>();
+    packet->resize(big_packet_size);
+    for (size_t i = 0; i < big_packets; ++i)
+      s->write(packet);
+    s->flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  });
+
+  tcp::acceptor acc(test_port + 1, -1);
+  std::unique_ptr<io::stream> s;
+  while (!s)
+    s = acc.open();
+  size_t received = 0;
+  std::shared_ptr<io::data> d;
+  while (received < big_packet_size * big_packets) {
+    ASSERT_NO_THROW(s->read(d, time(nullptr) + 10));
+    if (d)
+      received += std::static_pointer_cast<io::raw>(d)->size();
+  }
+  d.reset();
+  writer.join();
+
+  nlohmann::json tree;
+  s->statistics(tree);
+  ASSERT_GT(tree["tcp_read_size"].get<size_t>(), 16384u);
+  ASSERT_GT(tree["read_buffers_reused"].get<size_t>(), 0u);
+}
+
+// Given a connection with write watermarks and a slow reader
+// When many big packets are written
+// Then writes block when the high watermark is exceeded
+// And the bytes waiting to be written stay bounded.
+TEST_F(TcpConnection, WriteQueueWatermarks) {
+  constexpr size_t high = 1048576;
+  constexpr size_t low = 262144;
+  constexpr size_t big_packet_size = 262144;
+  constexpr size_t big_packets = 64;
+
+  std::thread reader([] {
+    tcp::acceptor acc(test_port + 2, -1);
+    std::unique_ptr<io::stream> s;
+    while (!s)
+      s = acc.open();
+    size_t received = 0;
+    std::shared_ptr<io::data> d;
+    while (received < big_packet_size * big_packets) {
+      ASSERT_NO_THROW(s->read(d, time(nullptr) + 10));
+      if (d)
+        received += std::static_pointer_cast<io::raw>(d)->size();
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  });
+
+  tcp::connector con("localhost", test_port + 2, -1);
+  con.set_write_watermarks(high, low);
+  std::unique_ptr<io::stream> s;
+  while (!s) {
+    try {
+      s = con.open();
+    } catch (const std::exception&) {
+    }
+  }
+
+  auto packet = std::make_shared<io::raw>();
+  packet->resize(big_packet_size);
+  size_t max_queued = 0;
+  nlohmann::json tree;
+  for (size_t i = 0; i < big_packets; ++i) {
+    s->write(packet);
+    tree.clear();
+    s->statistics(tree);
+    max_queued =
+        std::max(max_queued, tree["tcp_write_queue_bytes"].get<size_t>());
+  }
+  reader.join();
+
+  tree.clear();
+  s->statistics(tree);
+  ASSERT_GT(tree["tcp_write_blocked"].get<size_t>(), 0u);
+  ASSERT_LE(max_queued, high + big_packet_size);
+}
+
+// Given a connection to a peer that does not read its socket
+// When a thread writes many big packets
+// Then it stays blocked, the bytes waiting to be written never exceed the
+// high watermark by more than one packet and the stream is not ready for
+// writes
+// And everything is written once the peer reads.
+TEST_F(TcpConnection, WriteQueueStalledPeer) {
+  constexpr size_t high = 1048576;
+  constexpr size_t low = 262144;
+  constexpr size_t big_packet_size = 262144;
+  constexpr size_t big_packets = 64;
+
+  int srv = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(srv, 0);
+  int opt = 1;
+  setsockopt(srv, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+  opt = 65536;
+  setsockopt(srv, SOL_SOCKET, SO_RCVBUF, &opt, sizeof(opt));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(test_port + 3);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(srv, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(listen(srv, 1), 0);
+
+  tcp::connector con("localhost", test_port + 3, -1);
+  con.set_write_watermarks(high, low);
+  std::unique_ptr<io::stream> s;
+  while (!s) {
+    try {
+      s = con.open();
+    } catch (const std::exception&) {
+    }
+  }
+  int peer = accept(srv, nullptr, nullptr);
+  ASSERT_GE(peer, 0);
+
+  std::atomic<size_t> written{0};
+  std::atomic<size_t> max_queued{0};
+  std::thread writer([&] {
+    auto packet = std::make_shared<io::raw>();
+    packet->resize(big_packet_size);
+    nlohmann::json tree;
+    for (size_t i = 0; i < big_packets; ++i) {
+      s->write(packet);
+      ++written;
+      tree.clear();
+      s->statistics(tree);
+      max_queued = std::max(max_queued.load(),
+                            tree["tcp_write_queue_bytes"].get<size_t>());
+    }
+  });
+
+  /* The writer fills the socket buffers and then stays blocked. */
+  size_t last;
+  do {
+    last = written;
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  } while (written != last);
+  ASSERT_LT(written.load(), big_packets);
+  ASSERT_LE(max_queued.load(), high + big_packet_size);
+  ASSERT_FALSE(s->write_ready());
+
+  std::vector<char> buffer(65536);
+  size_t received = 0;
+  while (received < big_packet_size * big_packets) {
+    ssize_t r = recv(peer, buffer.data(), buffer.size(), 0);
+    ASSERT_GT(r, 0);
+    received += r;
+  }
+  writer.join();
+  ASSERT_EQ(written.load(), big_packets);
+  ASSERT_LE(max_queued.load(), high + big_packet_size);
+  ASSERT_TRUE(s->write_ready());
+  close(peer);
+  close(srv);
+}
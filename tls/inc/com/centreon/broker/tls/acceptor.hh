@@ -43,12 +43,16 @@ class acceptor : public io::endpoint {
   std::string _cert;
   std::string _key;
   std::string _tls_hostname;
+  bool _session_resumption;
+  bool _ktls;
 
  public:
   acceptor(const std::string& cert = std::string(),
            const std::string& key = std::string(),
            const std::string& ca = std::string(),
-           const std::string& tls_hostname = std::string());
+           const std::string& tls_hostname = std::string(),
+           bool session_resumption = true,
+           bool ktls = false);
   ~acceptor() = default;
   acceptor(acceptor const& right) = delete;
   acceptor& operator=(acceptor const&) = delete;
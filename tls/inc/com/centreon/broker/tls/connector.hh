@@ -38,12 +38,16 @@ class connector : public io::endpoint {
   std::string _cert;
   std::string _key;
   std::string _tls_hostname;
+  bool _session_resumption;
+  bool _ktls;
 
  public:
   connector(std::string const& cert = std::string(),
             std::string const& key = std::string(),
             std::string const& ca = std::string(),
-            std::string const& tls_hostname = std::string());
+            std::string const& tls_hostname = std::string(),
+            bool session_resumption = true,
+            bool ktls = false);
   ~connector() = default;
   connector(const connector&) = delete;
   connector& operator=(const connector&) = delete;
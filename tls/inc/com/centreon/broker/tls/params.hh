@@ -51,6 +51,7 @@ class params {
     gnutls_anon_server_credentials_t server;
   } _cred;
   bool _init;
+  bool _ktls;
   std::string _key;
   connection_type _type;
 
@@ -67,6 +68,7 @@ class params {
   void reset();
   void set_cert(std::string const& cert, std::string const& key);
   void set_compression(bool compress = false);
+  void set_ktls(bool ktls);
   void set_trusted_ca(std::string const& ca_cert);
   void set_tls_hostname(std::string const& tls_hostname);
   void validate_cert(gnutls_session_t session);
@@ -0,0 +1,100 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#ifndef CCB_TLS_SESSION_CACHE_HH
+#define CCB_TLS_SESSION_CACHE_HH
+
+#include <gnutls/gnutls.h>
+
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+
+#include "com/centreon/broker/namespace.hh"
+
+CCB_BEGIN()
+
+namespace tls {
+/**
+ *  @class session_cache session_cache.hh
+ *  "com/centreon/broker/tls/session_cache.hh"
+ *  @brief Data used to resume TLS sessions instead of doing full handshakes.
+ *
+ *  Acceptors encrypt session tickets with a key shared by all the
+ *  connections and renewed every ticket_key_rotation seconds, and keep the
+ *  TLS 1.2 sessions of clients not supporting tickets. Connectors keep the
+ *  session data of the last connection to each peer, so that when many
+ *  pollers reconnect at once, the central broker only does abbreviated
+ *  handshakes.
+ *
+ *  It also counts the handshakes done by the module and their durations.
+ */
+class session_cache {
+  struct server_session {
+    std::string data;
+    std::chrono::steady_clock::time_point expiry;
+  };
+
+  mutable std::mutex _m;
+  std::unordered_map<std::string, server_session> _server_sessions;
+  std::list<std::string> _server_order;
+  std::unordered_map<std::string, std::string> _client_sessions;
+
+  gnutls_datum_t _ticket_key;
+  std::chrono::steady_clock::time_point _ticket_key_time;
+  std::chrono::seconds _ticket_key_rotation;
+  uint32_t _ticket_keys;
+
+  uint64_t _full_handshakes;
+  uint64_t _resumed_handshakes;
+  std::chrono::microseconds _full_duration;
+  std::chrono::microseconds _resumed_duration;
+
+  session_cache();
+  void _rotate_ticket_key();
+
+  static int _store(void* ptr, gnutls_datum_t key, gnutls_datum_t data);
+  static gnutls_datum_t _retrieve(void* ptr, gnutls_datum_t key);
+  static int _remove(void* ptr, gnutls_datum_t key);
+
+ public:
+  static constexpr size_t max_server_sessions = 10000;
+  static constexpr uint32_t default_ticket_key_rotation = 3600;
+
+  ~session_cache() noexcept;
+  session_cache(const session_cache&) = delete;
+  session_cache& operator=(const session_cache&) = delete;
+  static session_cache& instance();
+
+  void apply_client(gnutls_session_t session, const std::string& peer);
+  void apply_server(gnutls_session_t session);
+  void clear();
+  void handshake_done(bool resumed, std::chrono::microseconds duration);
+  void save_client(gnutls_session_t session, const std::string& peer);
+  void set_ticket_key_rotation(uint32_t seconds);
+  uint32_t ticket_key_rotation() const;
+  void statistics(nlohmann::json& tree) const;
+};
+}  // namespace tls
+
+CCB_END()
+
+#endif  // !CCB_TLS_SESSION_CACHE_HH
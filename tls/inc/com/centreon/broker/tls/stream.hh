@@ -21,6 +21,7 @@
 
 #include <gnutls/gnutls.h>
 
+#include <chrono>
 #include <vector>
 
 #include "com/centreon/broker/io/stream.hh"
@@ -42,14 +43,24 @@ class stream : public io::stream {
   std::vector<char> _buffer;
   time_t _deadline;
   gnutls_session_t* _session;
+  std::string _resumption_key;
+  std::chrono::microseconds _handshake_duration;
+  bool _resumed;
+  bool _ktls;
+
+  void _ktls_close_notify();
 
  public:
   stream(gnutls_session_t* session);
   ~stream();
   stream(const stream&) = delete;
   stream& operator=(const stream&) = delete;
+  bool enable_ktls();
+  void handshake();
   bool read(std::shared_ptr<io::data>& d, time_t deadline) override;
   long long read_encrypted(void* buffer, long long size);
+  void set_resumption_key(const std::string& key);
+  void statistics(nlohmann::json& tree) const override;
   int32_t write(std::shared_ptr<io::data> const& d) override;
   int32_t stop() override { return 0; }
   long long write_encrypted(void const* buffer, long long size);
@@ -23,6 +23,7 @@
 #include "com/centreon/broker/log_v2.hh"
 #include "com/centreon/broker/tls/internal.hh"
 #include "com/centreon/broker/tls/params.hh"
+#include "com/centreon/broker/tls/session_cache.hh"
 #include "com/centreon/broker/tls/stream.hh"
 #include "com/centreon/exceptions/msg_fmt.hh"
 
@@ -42,16 +43,24 @@ using namespace com::centreon::broker::tls;
  *  @param[in] cert Certificate.
  *  @param[in] key  Key file.
  *  @param[in] ca   Trusted CA's certificate.
+ *  @param[in] tls_hostname        Name checked in the peer certificate.
+ *  @param[in] session_resumption  True to resume previous sessions.
+ *  @param[in] ktls                True to let the kernel encrypt the data
+ *                                 sent when it can.
  */
 acceptor::acceptor(std::string const& cert,
                    std::string const& key,
                    std::string const& ca,
-                   std::string const& tls_hostname)
+                   std::string const& tls_hostname,
+                   bool session_resumption,
+                   bool ktls)
     : io::endpoint(true),
       _ca(ca),
       _cert(cert),
       _key(key),
-      _tls_hostname(tls_hostname) {}
+      _tls_hostname(tls_hostname),
+      _session_resumption(session_resumption),
+      _ktls(ktls) {}
 
 /**
  *  @brief Try to accept a new connection.
@@ -95,6 +104,7 @@ std::unique_ptr<io::stream> acceptor::open(std::shared_ptr<io::stream> lower) {
     p.set_cert(_cert, _key);
     p.set_trusted_ca(_ca);
     p.set_tls_hostname(_tls_hostname);
+    p.set_ktls(_ktls);
     p.load();
 
     gnutls_session_t* session(new gnutls_session_t);
@@ -117,6 +127,10 @@ std::unique_ptr<io::stream> acceptor::open(std::shared_ptr<io::stream> lower) {
       // Apply TLS parameters.
       p.apply(*session);
 
+      // Resume previous sessions.
+      if (_session_resumption)
+        session_cache::instance().apply_server(*session);
+
       // Create stream object.
       u.reset(new stream(session));
     } catch (...) {
@@ -135,23 +149,14 @@ std::unique_ptr<io::stream> acceptor::open(std::shared_ptr<io::stream> lower) {
     gnutls_transport_set_ptr(*session, u.get());
 
     // Perform the TLS handshake.
-    log_v2::tls()->debug("TLS: performing handshake");
-    do {
-      ret = gnutls_handshake(*session);
-    } while (GNUTLS_E_AGAIN == ret || GNUTLS_E_INTERRUPTED == ret);
-    if (ret != GNUTLS_E_SUCCESS) {
-      log_v2::tls()->error("TLS: handshake failed: {}", gnutls_strerror(ret));
-      throw msg_fmt("TLS: handshake failed: {} ", gnutls_strerror(ret));
-    }
-    log_v2::tls()->debug("TLS: successful handshake");
-    gnutls_protocol_t prot = gnutls_protocol_get_version(*session);
-    gnutls_cipher_algorithm_t ciph = gnutls_cipher_get(*session);
-    log_v2::tls()->debug("TLS: protocol and cipher  {} {} used",
-                         gnutls_protocol_get_name(prot),
-                         gnutls_cipher_get_name(ciph));
+    static_cast<stream*>(u.get())->handshake();
 
     // Check certificate.
     p.validate_cert(*session);
+
+    // Let the kernel encrypt the data sent.
+    if (_ktls)
+      static_cast<stream*>(u.get())->enable_ktls();
   }
 
   return u;
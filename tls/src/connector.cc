@@ -21,6 +21,7 @@
 #include "com/centreon/broker/log_v2.hh"
 #include "com/centreon/broker/tls/internal.hh"
 #include "com/centreon/broker/tls/params.hh"
+#include "com/centreon/broker/tls/session_cache.hh"
 #include "com/centreon/broker/tls/stream.hh"
 #include "com/centreon/exceptions/msg_fmt.hh"
 
@@ -40,16 +41,24 @@ using namespace com::centreon::exceptions;
  *  @param[in] cert Certificate.
  *  @param[in] key  Key file.
  *  @param[in] ca   Trusted CA's certificate.
+ *  @param[in] tls_hostname        Name checked in the peer certificate.
+ *  @param[in] session_resumption  True to resume previous sessions.
+ *  @param[in] ktls                True to let the kernel encrypt the data
+ *                                 sent when it can.
  */
 connector::connector(std::string const& cert,
                      std::string const& key,
                      std::string const& ca,
-                     std::string const& tls_hostname)
+                     std::string const& tls_hostname,
+                     bool session_resumption,
+                     bool ktls)
     : io::endpoint(false),
       _ca(ca),
       _cert(cert),
       _key(key),
-      _tls_hostname(tls_hostname) {}
+      _tls_hostname(tls_hostname),
+      _session_resumption(session_resumption),
+      _ktls(ktls) {}
 
 /**
  *  Connect to the remote TLS peer.
@@ -80,6 +89,7 @@ std::unique_ptr<io::stream> connector::open(std::shared_ptr<io::stream> lower) {
     p.set_cert(_cert, _key);
     p.set_trusted_ca(_ca);
     p.set_tls_hostname(_tls_hostname);
+    p.set_ktls(_ktls);
     p.load();
 
     gnutls_session_t* session(new gnutls_session_t);
@@ -101,8 +111,17 @@ std::unique_ptr<io::stream> connector::open(std::shared_ptr<io::stream> lower) {
       // Apply TLS parameters to the current session.
       p.apply(*session);
 
+      // Resume the previous session with this peer.
+      std::string resumption_key;
+      if (_session_resumption) {
+        resumption_key = fmt::format("{}|{}|{}|{}|{}", lower->peer(), _cert,
+                                     _key, _ca, _tls_hostname);
+        session_cache::instance().apply_client(*session, resumption_key);
+      }
+
       // Create stream object.
       u.reset(new stream(session));
+      static_cast<stream*>(u.get())->set_resumption_key(resumption_key);
     } catch (...) {
       gnutls_deinit(*session);
       delete session;
@@ -119,24 +138,14 @@ std::unique_ptr<io::stream> connector::open(std::shared_ptr<io::stream> lower) {
     gnutls_transport_set_ptr(*session, u.get());
 
     // Perform the TLS handshake.
-    log_v2::tls()->debug("TLS: performing handshake");
-    do {
-      ret = gnutls_handshake(*session);
-    } while (GNUTLS_E_AGAIN == ret || GNUTLS_E_INTERRUPTED == ret);
-    if (ret != GNUTLS_E_SUCCESS) {
-      log_v2::tls()->error("TLS: handshake failed: {}", gnutls_strerror(ret));
-      throw msg_fmt("TLS: handshake failed: {}", gnutls_strerror(ret));
-    }
-
-    log_v2::tls()->debug("TLS: successful handshake");
-    gnutls_protocol_t prot = gnutls_protocol_get_version(*session);
-    gnutls_cipher_algorithm_t ciph = gnutls_cipher_get(*session);
-    log_v2::tls()->debug("TLS: protocol and cipher  {} {} used",
-                         gnutls_protocol_get_name(prot),
-                         gnutls_cipher_get_name(ciph));
+    static_cast<stream*>(u.get())->handshake();
 
     // Check certificate if necessary.
     p.validate_cert(*session);
+
+    // Let the kernel encrypt the data sent.
+    if (_ktls)
+      static_cast<stream*>(u.get())->enable_ktls();
   }
 
   return u;
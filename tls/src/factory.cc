@@ -18,17 +18,42 @@
 
 #include "com/centreon/broker/tls/factory.hh"
 
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <memory>
 
 #include "com/centreon/broker/config/parser.hh"
 #include "com/centreon/broker/log_v2.hh"
 #include "com/centreon/broker/tls/acceptor.hh"
 #include "com/centreon/broker/tls/connector.hh"
+#include "com/centreon/broker/tls/session_cache.hh"
 
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::tls;
 
+/**
+ *  Apply the tls_ticket_key_rotation parameter. An invalid value is logged
+ *  and the current period is kept.
+ *
+ *  @param[in] value  The ticket key lifetime in seconds.
+ */
+static void set_ticket_key_rotation(const std::string& value) {
+  char* endptr = nullptr;
+  errno = 0;
+  unsigned long seconds = strtoul(value.c_str(), &endptr, 10);
+  if (value.empty() || *endptr || value[0] == '-' || errno == ERANGE ||
+      seconds == 0 || seconds > std::numeric_limits<uint32_t>::max()) {
+    log_v2::tls()->error(
+        "TLS: bad value '{}' for tls_ticket_key_rotation, it must be a "
+        "positive number of seconds, {}s is kept",
+        value, session_cache::instance().ticket_key_rotation());
+    return;
+  }
+  session_cache::instance().set_ticket_key_rotation(seconds);
+}
+
 /**
  *  Check if an endpoint configuration match the TLS layer.
  *
@@ -73,6 +98,19 @@ bool factory::has_endpoint(config::endpoint& cfg, io::extension* ext) {
       it = cfg.params.find("tls_hostname");
       if (it != cfg.params.end())
         ext->mutable_options()["tls_hostname"] = it->second;
+
+      // Session resumption.
+      it = cfg.params.find("tls_session_resumption");
+      if (it != cfg.params.end())
+        ext->mutable_options()["tls_session_resumption"] = it->second;
+      it = cfg.params.find("tls_ticket_key_rotation");
+      if (it != cfg.params.end())
+        ext->mutable_options()["tls_ticket_key_rotation"] = it->second;
+
+      // Kernel TLS.
+      it = cfg.params.find("tls_ktls");
+      if (it != cfg.params.end())
+        ext->mutable_options()["tls_ktls"] = it->second;
     }
   }
   return false;
@@ -100,6 +138,8 @@ io::endpoint* factory::new_endpoint(
   std::string public_cert;
   std::string ca_cert;
   std::string tls_hostname;
+  bool session_resumption{true};
+  bool ktls{false};
   {
     // Is TLS enabled ?
     std::map<std::string, std::string>::const_iterator it{
@@ -126,6 +166,19 @@ io::endpoint* factory::new_endpoint(
         it = cfg.params.find("tls_hostname");
         if (it != cfg.params.end())
           tls_hostname = it->second;
+
+        // Session resumption.
+        it = cfg.params.find("tls_session_resumption");
+        if (it != cfg.params.end())
+          session_resumption = config::parser::parse_boolean(it->second);
+        it = cfg.params.find("tls_ticket_key_rotation");
+        if (it != cfg.params.end())
+          set_ticket_key_rotation(it->second);
+
+        // Kernel TLS.
+        it = cfg.params.find("tls_ktls");
+        if (it != cfg.params.end())
+          ktls = config::parser::parse_boolean(it->second);
       }
     }
   }
@@ -133,10 +186,12 @@ io::endpoint* factory::new_endpoint(
   // Acceptor.
   std::unique_ptr<io::endpoint> endp;
   if (is_acceptor)
-    endp.reset(new acceptor(public_cert, private_key, ca_cert, tls_hostname));
+    endp.reset(new acceptor(public_cert, private_key, ca_cert, tls_hostname,
+                            session_resumption, ktls));
   // Connector.
   else
-    endp.reset(new connector(public_cert, private_key, ca_cert, tls_hostname));
+    endp.reset(new connector(public_cert, private_key, ca_cert, tls_hostname,
+                             session_resumption, ktls));
   return endp.release();
 }
 
@@ -174,9 +229,23 @@ std::shared_ptr<io::stream> factory::new_stream(
   if (found != options.end())
     tls_hostname = found->second;
 
-  return is_acceptor
-             ? acceptor(public_cert, private_key, ca_cert, tls_hostname)
-                   .open(to)
-             : connector(public_cert, private_key, ca_cert, tls_hostname)
-                   .open(to);
+  bool session_resumption{true};
+  found = options.find("tls_session_resumption");
+  if (found != options.end())
+    session_resumption = config::parser::parse_boolean(found->second);
+  found = options.find("tls_ticket_key_rotation");
+  if (found != options.end())
+    set_ticket_key_rotation(found->second);
+
+  bool ktls{false};
+  found = options.find("tls_ktls");
+  if (found != options.end())
+    ktls = config::parser::parse_boolean(found->second);
+
+  return is_acceptor ? acceptor(public_cert, private_key, ca_cert,
+                                tls_hostname, session_resumption, ktls)
+                           .open(to)
+                     : connector(public_cert, private_key, ca_cert,
+                                 tls_hostname, session_resumption, ktls)
+                           .open(to);
 }
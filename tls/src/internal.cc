@@ -29,6 +29,7 @@
 #include "com/centreon/broker/io/stream.hh"
 #include "com/centreon/broker/log_v2.hh"
 #include "com/centreon/broker/tls/internal.hh"
+#include "com/centreon/broker/tls/session_cache.hh"
 #include "com/centreon/broker/tls/stream.hh"
 #include "com/centreon/exceptions/msg_fmt.hh"
 
@@ -65,6 +66,9 @@ GCRY_THREAD_OPTION_PTHREAD_IMPL;
  *  Deinit the TLS library.
  */
 void tls::destroy() {
+  // Forget sessions and ticket keys.
+  tls::session_cache::instance().clear();
+
   // Unload Diffie-Hellman parameters.
   gnutls_dh_params_deinit(dh_params);
 
@@ -38,7 +38,7 @@ using namespace com::centreon::exceptions;
  *                  construction.
  */
 params::params(params::connection_type type)
-    : _compress(false), _init(false), _type(type) {}
+    : _compress(false), _init(false), _ktls(false), _type(type) {}
 
 /**
  *  Destructor.
@@ -56,14 +56,18 @@ void params::apply(gnutls_session_t session) {
   // Set the encryption method (normal ciphers with anonymous
   // Diffie-Hellman and optionnally compression).
   int ret;
-  ret = gnutls_priority_set_direct(
-      session,
-      (_compress ? "NORMAL:-VERS-DTLS1.0:-VERS-DTLS1.2:-VERS-SSL3.0:-VERS-TLS1."
-                   "0:-VERS-TLS1.1:+ANON-DH:%COMPAT"
-                 : "NORMAL:-VERS-DTLS1.0:-VERS-DTLS1.2:-VERS-SSL3.0:-VERS-TLS1."
-                   "0:-VERS-TLS1.1:+ANON-DH:+COMP-"
-                   "DEFLATE:%COMPAT"),
-      nullptr);
+  std::string priorities(
+      _compress ? "NORMAL:-VERS-DTLS1.0:-VERS-DTLS1.2:-VERS-SSL3.0:-VERS-TLS1."
+                  "0:-VERS-TLS1.1:+ANON-DH:%COMPAT"
+                : "NORMAL:-VERS-DTLS1.0:-VERS-DTLS1.2:-VERS-SSL3.0:-VERS-TLS1."
+                  "0:-VERS-TLS1.1:+ANON-DH:+COMP-"
+                  "DEFLATE:%COMPAT");
+#if GNUTLS_VERSION_NUMBER >= 0x030605
+  // The kernel only encrypts TLS 1.2 records for us.
+  if (_ktls)
+    priorities.append(":-VERS-TLS1.3");
+#endif  // GNU TLS >= 3.6.5
+  ret = gnutls_priority_set_direct(session, priorities.c_str(), nullptr);
 
   if (ret != GNUTLS_E_SUCCESS) {
     log_v2::tls()->error("TLS: encryption parameter application failed: {}",
@@ -188,6 +192,16 @@ void params::set_compression(bool compress) {
   _compress = compress;
 }
 
+/**
+ *  Prepare the sessions for kTLS: the kernel can only encrypt TLS 1.2
+ *  records without help from GNU TLS, so TLS 1.3 is not negotiated.
+ *
+ *  @param[in] ktls  True if the kernel will encrypt the data sent.
+ */
+void params::set_ktls(bool ktls) {
+  _ktls = ktls;
+}
+
 /**
  *  @brief Set the hostname.
  *
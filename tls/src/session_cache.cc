@@ -0,0 +1,282 @@
+/*
+** Copyright 2021 Centreon
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+** For more information : contact@centreon.com
+*/
+
+#include "com/centreon/broker/tls/session_cache.hh"
+
+#include <cstring>
+
+#include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/exceptions/msg_fmt.hh"
+
+using namespace com::centreon::broker;
+using namespace com::centreon::broker::tls;
+using namespace com::centreon::exceptions;
+
+constexpr size_t session_cache::max_server_sessions;
+constexpr uint32_t session_cache::default_ticket_key_rotation;
+
+/**
+ *  Constructor.
+ */
+session_cache::session_cache()
+    : _ticket_key{nullptr, 0},
+      _ticket_key_rotation{default_ticket_key_rotation},
+      _ticket_keys{0},
+      _full_handshakes{0},
+      _resumed_handshakes{0},
+      _full_duration{0},
+      _resumed_duration{0} {}
+
+/**
+ *  Destructor.
+ */
+session_cache::~session_cache() noexcept {
+  clear();
+}
+
+/**
+ *  Get the session cache of the module.
+ *
+ *  @return The session cache.
+ */
+session_cache& session_cache::instance() {
+  static session_cache instance;
+  return instance;
+}
+
+/**
+ *  Give to a client session the data of the last session with the same peer,
+ *  so that it is resumed.
+ *
+ *  @param[in] session  The session before its handshake.
+ *  @param[in] peer     The peer and the parameters of the connection.
+ */
+void session_cache::apply_client(gnutls_session_t session,
+                                 const std::string& peer) {
+  std::lock_guard<std::mutex> lck(_m);
+  auto found = _client_sessions.find(peer);
+  if (found != _client_sessions.end()) {
+    int ret = gnutls_session_set_data(session, found->second.data(),
+                                      found->second.size());
+    if (ret != GNUTLS_E_SUCCESS) {
+      log_v2::tls()->debug("TLS: cannot resume session with '{}': {}", peer,
+                           gnutls_strerror(ret));
+      _client_sessions.erase(found);
+    }
+  }
+}
+
+/**
+ *  Enable session tickets and the session cache on a server session.
+ *
+ *  @param[in] session  The session before its handshake.
+ */
+void session_cache::apply_server(gnutls_session_t session) {
+  std::lock_guard<std::mutex> lck(_m);
+  if (!_ticket_key.data ||
+      std::chrono::steady_clock::now() - _ticket_key_time >=
+          _ticket_key_rotation)
+    _rotate_ticket_key();
+
+  int ret = gnutls_session_ticket_enable_server(session, &_ticket_key);
+  if (ret != GNUTLS_E_SUCCESS)
+    log_v2::tls()->error("TLS: cannot enable session tickets: {}",
+                         gnutls_strerror(ret));
+
+  gnutls_db_set_cache_expiration(session, _ticket_key_rotation.count());
+  gnutls_db_set_retrieve_function(session, _retrieve);
+  gnutls_db_set_store_function(session, _store);
+  gnutls_db_set_remove_function(session, _remove);
+  gnutls_db_set_ptr(session, this);
+}
+
+/**
+ *  Forget all the sessions and the ticket keys, and reset the counters.
+ */
+void session_cache::clear() {
+  std::lock_guard<std::mutex> lck(_m);
+  _server_sessions.clear();
+  _server_order.clear();
+  _client_sessions.clear();
+  if (_ticket_key.data) {
+    gnutls_memset(_ticket_key.data, 0, _ticket_key.size);
+    gnutls_free(_ticket_key.data);
+    _ticket_key = {nullptr, 0};
+  }
+  _full_handshakes = 0;
+  _resumed_handshakes = 0;
+  _full_duration = std::chrono::microseconds{0};
+  _resumed_duration = std::chrono::microseconds{0};
+}
+
+/**
+ *  Account a successful handshake.
+ *
+ *  @param[in] resumed   True if the session was resumed.
+ *  @param[in] duration  The handshake duration.
+ */
+void session_cache::handshake_done(bool resumed,
+                                   std::chrono::microseconds duration) {
+  std::lock_guard<std::mutex> lck(_m);
+  if (resumed) {
+    ++_resumed_handshakes;
+    _resumed_duration += duration;
+  } else {
+    ++_full_handshakes;
+    _full_duration += duration;
+  }
+}
+
+/**
+ *  Keep the data of a client session to resume it on the next connection
+ *  to the same peer. With TLS 1.3, the ticket is only received after the
+ *  handshake, this is why it is also called when the session is closed.
+ *
+ *  @param[in] session  The session.
+ *  @param[in] peer     The peer and the parameters of the connection.
+ */
+void session_cache::save_client(gnutls_session_t session,
+                                const std::string& peer) {
+  gnutls_datum_t data;
+  if (gnutls_session_get_data2(session, &data) != GNUTLS_E_SUCCESS)
+    return;
+  std::string d(reinterpret_cast<char*>(data.data), data.size);
+  gnutls_free(data.data);
+  std::lock_guard<std::mutex> lck(_m);
+  _client_sessions[peer] = std::move(d);
+}
+
+/**
+ *  Set the ticket key lifetime, it is also the lifetime of the sessions kept
+ *  by acceptors.
+ *
+ *  @param[in] seconds  The lifetime in seconds.
+ */
+void session_cache::set_ticket_key_rotation(uint32_t seconds) {
+  std::lock_guard<std::mutex> lck(_m);
+  _ticket_key_rotation = std::chrono::seconds(seconds);
+}
+
+/**
+ *  Get the ticket key lifetime.
+ *
+ *  @return The lifetime in seconds.
+ */
+uint32_t session_cache::ticket_key_rotation() const {
+  std::lock_guard<std::mutex> lck(_m);
+  return _ticket_key_rotation.count();
+}
+
+/**
+ *  Get statistics.
+ *
+ *  @param[out] tree  Output tree.
+ */
+void session_cache::statistics(nlohmann::json& tree) const {
+  std::lock_guard<std::mutex> lck(_m);
+  tree["tls_full_handshakes"] = static_cast<double>(_full_handshakes);
+  tree["tls_resumed_handshakes"] = static_cast<double>(_resumed_handshakes);
+  tree["tls_full_handshake_avg_ms"] =
+      _full_handshakes ? _full_duration.count() / 1000.0 / _full_handshakes
+                       : 0.0;
+  tree["tls_resumed_handshake_avg_ms"] =
+      _resumed_handshakes
+          ? _resumed_duration.count() / 1000.0 / _resumed_handshakes
+          : 0.0;
+  tree["tls_cached_sessions"] = static_cast<double>(_server_sessions.size());
+  tree["tls_ticket_keys"] = static_cast<double>(_ticket_keys);
+}
+
+/**
+ *  Replace the ticket key, _m must be locked. Tickets encrypted with the
+ *  previous key can no more be used to resume sessions. GNU TLS copies the
+ *  key in each session, so the previous one is wiped at once. If no key can
+ *  be generated, the previous one is kept.
+ */
+void session_cache::_rotate_ticket_key() {
+  gnutls_datum_t key{nullptr, 0};
+  int ret = gnutls_session_ticket_key_generate(&key);
+  if (ret != GNUTLS_E_SUCCESS)
+    throw msg_fmt("TLS: cannot generate session ticket key: {}",
+                  gnutls_strerror(ret));
+  if (_ticket_key.data) {
+    gnutls_memset(_ticket_key.data, 0, _ticket_key.size);
+    gnutls_free(_ticket_key.data);
+  }
+  _ticket_key = key;
+  _ticket_key_time = std::chrono::steady_clock::now();
+  ++_ticket_keys;
+  log_v2::tls()->info("TLS: new session ticket key, renewed in {}s",
+                      _ticket_key_rotation.count());
+}
+
+/**
+ *  GnuTLS callback storing a server session.
+ */
+int session_cache::_store(void* ptr, gnutls_datum_t key, gnutls_datum_t data) {
+  session_cache* cache = static_cast<session_cache*>(ptr);
+  std::string k(reinterpret_cast<char*>(key.data), key.size);
+  std::lock_guard<std::mutex> lck(cache->_m);
+  auto& s = cache->_server_sessions[k];
+  if (s.data.empty())
+    cache->_server_order.push_back(k);
+  s.data.assign(reinterpret_cast<char*>(data.data), data.size);
+  s.expiry = std::chrono::steady_clock::now() + cache->_ticket_key_rotation;
+
+  // The oldest sessions are forgotten first.
+  while (cache->_server_sessions.size() > max_server_sessions) {
+    cache->_server_sessions.erase(cache->_server_order.front());
+    cache->_server_order.pop_front();
+  }
+  return 0;
+}
+
+/**
+ *  GnuTLS callback retrieving a server session.
+ */
+gnutls_datum_t session_cache::_retrieve(void* ptr, gnutls_datum_t key) {
+  session_cache* cache = static_cast<session_cache*>(ptr);
+  gnutls_datum_t retval{nullptr, 0};
+  std::string k(reinterpret_cast<char*>(key.data), key.size);
+  std::lock_guard<std::mutex> lck(cache->_m);
+  auto found = cache->_server_sessions.find(k);
+  if (found != cache->_server_sessions.end() &&
+      found->second.expiry > std::chrono::steady_clock::now()) {
+    retval.data = static_cast<unsigned char*>(
+        gnutls_malloc(found->second.data.size()));
+    if (retval.data) {
+      memcpy(retval.data, found->second.data.data(),
+             found->second.data.size());
+      retval.size = found->second.data.size();
+    }
+  }
+  return retval;
+}
+
+/**
+ *  GnuTLS callback removing a server session.
+ */
+int session_cache::_remove(void* ptr, gnutls_datum_t key) {
+  session_cache* cache = static_cast<session_cache*>(ptr);
+  std::string k(reinterpret_cast<char*>(key.data), key.size);
+  std::lock_guard<std::mutex> lck(cache->_m);
+  if (!cache->_server_sessions.erase(k))
+    return -1;
+  cache->_server_order.remove(k);
+  return 0;
+}
@@ -18,6 +18,13 @@
 
 #include "com/centreon/broker/tls/stream.hh"
 
+#ifdef __linux__
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif  // __linux__
+
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
@@ -26,12 +33,50 @@
 #include "com/centreon/broker/io/events.hh"
 #include "com/centreon/broker/io/raw.hh"
 #include "com/centreon/broker/log_v2.hh"
+#include "com/centreon/broker/tls/session_cache.hh"
 #include "com/centreon/exceptions/msg_fmt.hh"
 
 using namespace com::centreon::broker;
 using namespace com::centreon::broker::tls;
 using namespace com::centreon::exceptions;
 
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif  // !SOL_TLS
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif  // !TCP_ULP
+
+// kTLS with AES-256-GCM and record types appeared with Linux 5.1.
+#if defined(TLS_CIPHER_AES_GCM_256) && defined(TLS_SET_RECORD_TYPE) && \
+    GNUTLS_VERSION_NUMBER >= 0x030600
+#define CCB_TLS_KTLS
+/**
+ *  Fill the kernel crypto info of a TLS 1.2 AES GCM cipher from the GNU TLS
+ *  record state.
+ *
+ *  @return false if the state does not match the kernel structure.
+ */
+template <typename T>
+static bool fill_crypto_info(T& info,
+                             uint16_t cipher_type,
+                             const gnutls_datum_t& iv,
+                             const gnutls_datum_t& key,
+                             const unsigned char* seq) {
+  if (key.size != sizeof(info.key) || iv.size < sizeof(info.salt))
+    return false;
+  memset(&info, 0, sizeof(info));
+  info.info.cipher_type = cipher_type;
+  info.info.version = TLS_1_2_VERSION;
+  // The explicit part of the nonce is the sequence number.
+  memcpy(info.iv, seq, sizeof(info.iv));
+  memcpy(info.salt, iv.data, sizeof(info.salt));
+  memcpy(info.rec_seq, seq, sizeof(info.rec_seq));
+  memcpy(info.key, key.data, sizeof(info.key));
+  return true;
+}
+#endif  // TLS_CIPHER_AES_GCM_256 && TLS_SET_RECORD_TYPE && GNU TLS >= 3.6.0
+
 /**************************************
  *                                     *
  *           Public Methods            *
@@ -48,7 +93,12 @@ using namespace com::centreon::exceptions;
  *                   encryption that should be used.
  */
 stream::stream(gnutls_session_t* sess)
-    : io::stream("TLS"), _deadline((time_t)-1), _session(sess) {}
+    : io::stream("TLS"),
+      _deadline((time_t)-1),
+      _session(sess),
+      _handshake_duration{0},
+      _resumed{false},
+      _ktls{false} {}
 
 /**
  *  @brief Destructor.
@@ -60,7 +110,15 @@ stream::~stream() {
   if (_session) {
     try {
       _deadline = time(nullptr) + 30;  // XXX : use connection timeout
-      gnutls_bye(*_session, GNUTLS_SHUT_RDWR);
+      // TLS 1.3 tickets are received after the handshake.
+      if (!_resumption_key.empty())
+        session_cache::instance().save_client(*_session, _resumption_key);
+      // GNU TLS does not know the kernel sequence numbers anymore, the
+      // close notify alert is given to the kernel.
+      if (_ktls)
+        _ktls_close_notify();
+      else
+        gnutls_bye(*_session, GNUTLS_SHUT_RDWR);
       gnutls_deinit(*_session);
       delete (_session);
       _session = nullptr;
@@ -71,6 +129,158 @@ stream::~stream() {
   }
 }
 
+/**
+ *  Perform the TLS handshake, resuming a previous session when possible.
+ */
+void stream::handshake() {
+  log_v2::tls()->debug("TLS: performing handshake");
+  auto start = std::chrono::steady_clock::now();
+  int ret;
+  do {
+    ret = gnutls_handshake(*_session);
+  } while (GNUTLS_E_AGAIN == ret || GNUTLS_E_INTERRUPTED == ret);
+  if (ret != GNUTLS_E_SUCCESS) {
+    log_v2::tls()->error("TLS: handshake failed: {}", gnutls_strerror(ret));
+    throw msg_fmt("TLS: handshake failed: {}", gnutls_strerror(ret));
+  }
+  _handshake_duration = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  _resumed = gnutls_session_is_resumed(*_session);
+  session_cache::instance().handshake_done(_resumed, _handshake_duration);
+  if (!_resumption_key.empty())
+    session_cache::instance().save_client(*_session, _resumption_key);
+
+  log_v2::tls()->debug("TLS: successful {} handshake in {}us",
+                       _resumed ? "resumed" : "full",
+                       _handshake_duration.count());
+  gnutls_protocol_t prot = gnutls_protocol_get_version(*_session);
+  gnutls_cipher_algorithm_t ciph = gnutls_cipher_get(*_session);
+  log_v2::tls()->debug("TLS: protocol and cipher  {} {} used",
+                       gnutls_protocol_get_name(prot),
+                       gnutls_cipher_get_name(ciph));
+}
+
+/**
+ *  @brief Hand the sending keys to the kernel (kTLS).
+ *
+ *  The handshake is done by GNU TLS, then the kernel encrypts the data
+ *  written on the socket, so they are given as is to the lower stream. Data
+ *  are still decrypted by GNU TLS: the TCP layer always has a read pending,
+ *  records could reach it before the kernel takes them over.
+ *
+ *  It must be called just after the handshake. If the kernel, the protocol
+ *  or the cipher does not allow it, GNU TLS keeps on encrypting.
+ *
+ *  Records built by GNU TLS cannot be sent anymore, so only TLS 1.2 is
+ *  offloaded: with TLS 1.3, GNU TLS answers a key update of the peer with
+ *  its own and changes its sending keys. Renegotiation requests of the peer
+ *  are then ignored, and the close notify alert is sent through the kernel.
+ *
+ *  @return true if the kernel encrypts the data sent.
+ */
+bool stream::enable_ktls() {
+#ifdef CCB_TLS_KTLS
+  gnutls_protocol_t version = gnutls_protocol_get_version(*_session);
+  gnutls_cipher_algorithm_t cipher = gnutls_cipher_get(*_session);
+  if (version != GNUTLS_TLS1_2 ||
+      (cipher != GNUTLS_CIPHER_AES_128_GCM &&
+       cipher != GNUTLS_CIPHER_AES_256_GCM)) {
+    log_v2::tls()->info("TLS: no kernel TLS with {} {}",
+                        gnutls_protocol_get_name(version),
+                        gnutls_cipher_get_name(cipher));
+    return false;
+  }
+
+  gnutls_datum_t mac_key, iv, cipher_key;
+  unsigned char seq[8];
+  int ret = gnutls_record_get_state(*_session, 0, &mac_key, &iv, &cipher_key,
+                                    seq);
+  if (ret != GNUTLS_E_SUCCESS) {
+    log_v2::tls()->info("TLS: no kernel TLS, cannot get the record state: {}",
+                        gnutls_strerror(ret));
+    return false;
+  }
+
+  union {
+    tls12_crypto_info_aes_gcm_128 aes_128;
+    tls12_crypto_info_aes_gcm_256 aes_256;
+  } info;
+  socklen_t info_size;
+  bool filled;
+  if (cipher == GNUTLS_CIPHER_AES_128_GCM) {
+    filled = fill_crypto_info(info.aes_128, TLS_CIPHER_AES_GCM_128, iv,
+                              cipher_key, seq);
+    info_size = sizeof(info.aes_128);
+  } else {
+    filled = fill_crypto_info(info.aes_256, TLS_CIPHER_AES_GCM_256, iv,
+                              cipher_key, seq);
+    info_size = sizeof(info.aes_256);
+  }
+  if (!filled) {
+    log_v2::tls()->info("TLS: no kernel TLS, unexpected record state");
+    return false;
+  }
+
+  // Encrypted records already written must be sent before the switch.
+  int fd = _substream ? _substream->native_handle() : -1;
+  if (fd < 0) {
+    log_v2::tls()->info("TLS: no kernel TLS, no socket under the stream");
+    gnutls_memset(&info, 0, sizeof(info));
+    return false;
+  }
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) < 0 ||
+      setsockopt(fd, SOL_TLS, TLS_TX, &info, info_size) < 0) {
+    char const* msg = strerror(errno);
+    log_v2::tls()->info("TLS: kernel TLS not available: {}", msg);
+    gnutls_memset(&info, 0, sizeof(info));
+    return false;
+  }
+  gnutls_memset(&info, 0, sizeof(info));
+  _ktls = true;
+  log_v2::tls()->info("TLS: data sent to {} are encrypted by the kernel",
+                      peer());
+  return true;
+#else
+  log_v2::tls()->info("TLS: kernel TLS not supported by this build");
+  return false;
+#endif  // CCB_TLS_KTLS
+}
+
+/**
+ *  Send the close notify alert once the kernel encrypts the data: the
+ *  kernel builds the record, as for data, but with the alert type.
+ */
+void stream::_ktls_close_notify() {
+#ifdef CCB_TLS_KTLS
+  int fd = _substream ? _substream->native_handle() : -1;
+  if (fd < 0)
+    return;
+
+  // Warning level, close notify.
+  char alert[2] = {1, 0};
+  iovec iov{alert, sizeof(alert)};
+  char control[CMSG_SPACE(sizeof(unsigned char))];
+  memset(control, 0, sizeof(control));
+  msghdr hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = control;
+  hdr.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+  // Alert content type.
+  *CMSG_DATA(cmsg) = 21;
+  if (sendmsg(fd, &hdr, MSG_DONTWAIT) < 0) {
+    char const* msg = strerror(errno);
+    log_v2::tls()->debug("TLS: cannot send the close notify alert to {}: {}",
+                         peer(), msg);
+  }
+#endif  // CCB_TLS_KTLS
+}
+
 /**
  *  @brief Receive data from the TLS session.
  *
@@ -93,6 +303,11 @@ bool stream::read(std::shared_ptr<io::data>& d, time_t deadline) {
   std::shared_ptr<io::raw> buffer(new io::raw);
   buffer->resize(BUFSIZ);
   int ret(gnutls_record_recv(*_session, buffer->data(), buffer->size()));
+  if (ret == GNUTLS_E_REHANDSHAKE && _ktls) {
+    // A new handshake could not be sent, the request is ignored.
+    log_v2::tls()->info("TLS: renegotiation requested by {} ignored", peer());
+    return false;
+  }
   if (ret < 0) {
     if ((ret != GNUTLS_E_INTERRUPTED) && (ret != GNUTLS_E_AGAIN)) {
       log_v2::tls()->error("TLS: could not receive data: {}",
@@ -156,6 +371,31 @@ long long stream::read_encrypted(void* buffer, long long size) {
   }
 }
 
+/**
+ *  Set the key under which the client session is kept to be resumed on the
+ *  next connection.
+ *
+ *  @param[in] key  The peer and the parameters of the connection, empty if
+ *                  the session must not be kept.
+ */
+void stream::set_resumption_key(const std::string& key) {
+  _resumption_key = key;
+}
+
+/**
+ *  Get statistics.
+ *
+ *  @param[out] tree  Output tree.
+ */
+void stream::statistics(nlohmann::json& tree) const {
+  tree["tls_handshake_ms"] = _handshake_duration.count() / 1000.0;
+  tree["tls_session_resumed"] = _resumed;
+  tree["tls_ktls"] = _ktls;
+  session_cache::instance().statistics(tree);
+  if (_substream)
+    _substream->statistics(tree);
+}
+
 /**
  *  @brief Send data across the TLS session.
  *
@@ -171,6 +411,11 @@ int stream::write(std::shared_ptr<io::data> const& d) {
 
   // Send data.
   if (d->type() == io::raw::static_type()) {
+    // The kernel encrypts them, the buffer is shared with the lower stream.
+    if (_ktls) {
+      _substream->write(d);
+      return 1;
+    }
     io::raw const* packet(static_cast<io::raw const*>(d.get()));
     char const* ptr(packet->const_data());
     int size(packet->size());
@@ -198,6 +443,15 @@ int stream::write(std::shared_ptr<io::data> const& d) {
  *  @return Number of bytes written.
  */
 long long stream::write_encrypted(void const* buffer, long long size) {
+  /* Records built by GNU TLS would be encrypted again by the kernel. With
+   * TLS 1.2 and no renegotiation, GNU TLS only builds fatal alerts once the
+   * kernel encrypts data, the connection is lost anyway. */
+  if (_ktls) {
+    log_v2::tls()->error(
+        "TLS: cannot send a control record once the kernel encrypts data");
+    gnutls_transport_set_errno(*_session, EIO);
+    return -1;
+  }
   std::shared_ptr<io::raw> r(new io::raw);
   std::vector<char> tmp(const_cast<char*>(static_cast<char const*>(buffer)),
                         const_cast<char*>(static_cast<char const*>(buffer)) +
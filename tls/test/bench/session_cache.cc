@@ -0,0 +1,45 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "../session_storm.hh"
+
+using namespace com::centreon::broker;
+
+class BenchTlsSessionCache : public TlsSessionStorm {};
+
+// Benchmark: pollers connect a first time with full handshakes and then
+// reconnect all at the same time, resuming their sessions.
+TEST_F(BenchTlsSessionCache, ReconnectStorm) {
+  constexpr uint32_t count = 100;
+  using ms = std::chrono::milliseconds;
+  auto start = std::chrono::steady_clock::now();
+  storm(count);
+  auto full = std::chrono::steady_clock::now();
+  storm(count);
+  auto resumed = std::chrono::steady_clock::now();
+  std::cout << "reconnection of " << count << " TLS clients: full handshakes "
+            << std::chrono::duration_cast<ms>(full - start).count()
+            << "ms, resumed handshakes "
+            << std::chrono::duration_cast<ms>(resumed - full).count()
+            << "ms\n";
+}
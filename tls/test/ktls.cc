@@ -0,0 +1,121 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/pool.hh"
+#include "com/centreon/broker/tcp/acceptor.hh"
+#include "com/centreon/broker/tcp/connector.hh"
+#include "com/centreon/broker/tcp/tcp_async.hh"
+#include "com/centreon/broker/tls/acceptor.hh"
+#include "com/centreon/broker/tls/connector.hh"
+#include "com/centreon/broker/tls/internal.hh"
+
+using namespace com::centreon::broker;
+
+constexpr static uint16_t test_port(4243);
+constexpr static size_t packet_size = 16384;
+constexpr static size_t packets = 64;
+
+class TlsKtls : public ::testing::Test {
+ public:
+  void SetUp() override {
+    pool::load(0);
+    tcp::tcp_async::load();
+    tls::initialize();
+  }
+
+  void TearDown() override {
+    tls::destroy();
+    tcp::tcp_async::instance().stop_timer();
+    tcp::tcp_async::unload();
+    pool::unload();
+  }
+
+  /**
+   * @brief Byte j of packet i.
+   */
+  static char byte(size_t i, size_t j) {
+    return static_cast<char>((i + j) % 251);
+  }
+};
+
+// Given two TLS streams with kTLS enabled (the kernel encrypts the data sent
+// when its tls module is loaded)
+// When packets are sent and the sender is closed
+// Then the receiver gets all of them unchanged
+// And then the end of the session, as a close notify alert is received.
+TEST_F(TlsKtls, RoundTrip) {
+  size_t received = 0;
+  bool unchanged = true;
+  std::string end;
+  std::thread reader([&] {
+    auto lower = std::make_shared<tcp::acceptor>(test_port, -1);
+    std::shared_ptr<io::stream> tcp_stream;
+    while (!tcp_stream)
+      tcp_stream = lower->open();
+    std::unique_ptr<io::stream> s{
+        tls::acceptor("", "", "", "", true, true).open(tcp_stream)};
+    std::shared_ptr<io::data> d;
+    try {
+      while (received <= packet_size * packets) {
+        if (!s->read(d, time(nullptr) + 10))
+          break;
+        if (!d)
+          continue;
+        for (char c : std::static_pointer_cast<io::raw>(d)->get_buffer()) {
+          size_t i = received / packet_size, j = received % packet_size;
+          unchanged = unchanged && c == byte(i, j);
+          ++received;
+        }
+      }
+    } catch (const std::exception& e) {
+      end = e.what();
+    }
+  });
+
+  tcp::connector lower("localhost", test_port, -1);
+  std::shared_ptr<io::stream> tcp_stream;
+  while (!tcp_stream) {
+    try {
+      tcp_stream = lower.open();
+    } catch (const std::exception&) {
+    }
+  }
+  {
+    std::unique_ptr<io::stream> s{
+        tls::connector("", "", "", "", true, true).open(tcp_stream)};
+    tcp_stream.reset();
+    for (size_t i = 0; i < packets; ++i) {
+      auto packet = std::make_shared<io::raw>();
+      auto& buffer = packet->get_buffer();
+      buffer.resize(packet_size);
+      for (size_t j = 0; j < packet_size; ++j)
+        buffer[j] = byte(i, j);
+      s->write(packet);
+    }
+  }
+  reader.join();
+  ASSERT_EQ(received, packet_size * packets);
+  ASSERT_TRUE(unchanged);
+  ASSERT_EQ(end, "TLS session is terminated");
+}
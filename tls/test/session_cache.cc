@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+
+#include "com/centreon/broker/tls/session_cache.hh"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "com/centreon/broker/config/endpoint.hh"
+#include "com/centreon/broker/tls/factory.hh"
+#include "session_storm.hh"
+
+using namespace com::centreon::broker;
+
+class TlsSessionCache : public TlsSessionStorm {};
+
+// Given pollers that already connected once to the central broker
+// When they all reconnect at the same time
+// Then their sessions are resumed instead of doing full handshakes.
+TEST_F(TlsSessionCache, ReconnectStorm) {
+  constexpr uint32_t count = 100;
+  storm(count);
+  nlohmann::json tree;
+  tls::session_cache::instance().statistics(tree);
+  ASSERT_EQ(tree["tls_resumed_handshakes"].get<uint64_t>(), 0u);
+
+  storm(count);
+  tree.clear();
+  tls::session_cache::instance().statistics(tree);
+  /* Each connection counts one handshake on each side. */
+  ASSERT_EQ(tree["tls_resumed_handshakes"].get<uint64_t>(), 2 * count);
+}
+
+// Given a short ticket key rotation period
+// When connections are made after it has expired
+// Then a new ticket key is generated.
+TEST_F(TlsSessionCache, TicketKeyRotation) {
+  tls::session_cache::instance().set_ticket_key_rotation(1);
+  storm(1);
+  nlohmann::json tree;
+  tls::session_cache::instance().statistics(tree);
+  uint32_t keys = tree["tls_ticket_keys"].get<uint32_t>();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  storm(1);
+  tree.clear();
+  tls::session_cache::instance().statistics(tree);
+  ASSERT_EQ(tree["tls_ticket_keys"].get<uint32_t>(), keys + 1);
+  tls::session_cache::instance().set_ticket_key_rotation(
+      tls::session_cache::default_ticket_key_rotation);
+}
+
+// Given TLS endpoints configured with a ticket key rotation period
+// When the value is not a positive number of seconds
+// Then it is rejected and the current period is kept.
+TEST_F(TlsSessionCache, TicketKeyRotationParameter) {
+  auto& cache = tls::session_cache::instance();
+  tls::factory f;
+  auto configure = [&f](const std::string& value) {
+    config::endpoint cfg(config::endpoint::output);
+    cfg.params["tls"] = "yes";
+    cfg.params["tls_ticket_key_rotation"] = value;
+    bool is_acceptor = false;
+    std::unique_ptr<io::endpoint> e(f.new_endpoint(cfg, is_acceptor));
+  };
+
+  configure("60");
+  ASSERT_EQ(cache.ticket_key_rotation(), 60u);
+  for (const char* value : {"0", "-1", "", "1h", "99999999999"}) {
+    configure(value);
+    ASSERT_EQ(cache.ticket_key_rotation(), 60u) << value;
+  }
+  cache.set_ticket_key_rotation(
+      tls::session_cache::default_ticket_key_rotation);
+}
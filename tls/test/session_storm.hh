@@ -0,0 +1,136 @@
+/*
+ * Copyright 2021 Centreon (https://www.centreon.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * For more information : contact@centreon.com
+ *
+ */
+#ifndef TLS_SESSION_STORM_HH
+#define TLS_SESSION_STORM_HH
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "com/centreon/broker/io/raw.hh"
+#include "com/centreon/broker/pool.hh"
+#include "com/centreon/broker/tls/acceptor.hh"
+#include "com/centreon/broker/tls/connector.hh"
+#include "com/centreon/broker/tls/internal.hh"
+
+using namespace com::centreon::broker;
+
+/**
+ * @brief One direction of an in-memory connection.
+ */
+struct channel {
+  std::mutex m;
+  std::condition_variable cv;
+  std::deque<std::shared_ptr<io::data>> queue;
+};
+
+/**
+ * @brief An end of an in-memory connection, it writes in one channel and
+ * reads the other one.
+ */
+class pipe_stream : public io::stream {
+  std::shared_ptr<channel> _in;
+  std::shared_ptr<channel> _out;
+
+ public:
+  pipe_stream(std::shared_ptr<channel> in, std::shared_ptr<channel> out)
+      : io::stream("pipe"), _in(std::move(in)), _out(std::move(out)) {}
+
+  bool read(std::shared_ptr<io::data>& d, time_t deadline) override {
+    d.reset();
+    std::unique_lock<std::mutex> lck(_in->m);
+    while (_in->queue.empty()) {
+      if (deadline != (time_t)-1 && time(nullptr) >= deadline)
+        return false;
+      _in->cv.wait_for(lck, std::chrono::milliseconds(100));
+    }
+    d = std::move(_in->queue.front());
+    _in->queue.pop_front();
+    return true;
+  }
+
+  int write(std::shared_ptr<io::data> const& d) override {
+    std::lock_guard<std::mutex> lck(_out->m);
+    _out->queue.push_back(d);
+    _out->cv.notify_one();
+    return 1;
+  }
+
+  int32_t stop() override { return 0; }
+
+  std::string peer() const override { return "pipe"; }
+};
+
+/**
+ * @brief Fixture connecting TLS clients to an acceptor through in-memory
+ * connections.
+ */
+class TlsSessionStorm : public ::testing::Test {
+ public:
+  void SetUp() override {
+    pool::load(0);
+    tls::initialize();
+  }
+
+  void TearDown() override {
+    tls::destroy();
+    pool::unload();
+  }
+
+  /**
+   * @brief Connect count clients at once to an acceptor and exchange a few
+   * bytes on each connection.
+   */
+  static void storm(uint32_t count) {
+    tls::acceptor acc;
+    tls::connector con;
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < count; ++i) {
+      auto up = std::make_shared<channel>();
+      auto down = std::make_shared<channel>();
+      threads.emplace_back([&acc, up, down] {
+        std::unique_ptr<io::stream> s{
+            acc.open(std::make_shared<pipe_stream>(up, down))};
+        std::shared_ptr<io::data> d;
+        while (!d)
+          s->read(d, time(nullptr) + 5);
+        s->write(d);
+      });
+      threads.emplace_back([&con, up, down] {
+        std::unique_ptr<io::stream> s{
+            con.open(std::make_shared<pipe_stream>(down, up))};
+        auto r = std::make_shared<io::raw>();
+        r->get_buffer().assign(4, 'x');
+        s->write(r);
+        std::shared_ptr<io::data> d;
+        while (!d)
+          s->read(d, time(nullptr) + 5);
+        EXPECT_EQ(std::static_pointer_cast<io::raw>(d)->size(), 4u);
+      });
+    }
+    for (auto& t : threads)
+      t.join();
+  }
+};
+
+#endif  // !TLS_SESSION_STORM_HH